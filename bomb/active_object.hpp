@@ -0,0 +1,497 @@
+// 基于策略的活动对象框架
+//
+// ActiveObject<Engine, QueuePolicy, TimerPolicy> 把状态机引擎、事件队列和时间源组合成一个
+// 活动对象：其他线程通过 Post 投递信号，Run 在活动对象自己的线程上循环取事件、产生滴答
+// 并分发给引擎。三者都是编译期策略，没有虚函数，调用全部可以内联；
+// 换一种队列（互斥锁队列/无锁队列）、换一种分发方式（状态表/状态函数/switch）或者换成虚拟时间，
+// 只需要换一个模板参数，业务代码不用改。
+//
+// 引擎需要提供：
+//   void Init();                        在运行线程上执行初始转换
+//   void Dispatch(uintptr_t signal);    分发一个用户信号
+//   void Tick();                        分发一个滴答
+//   bool NeedTick() const;              当前状态是否需要滴答
+// 队列策略需要提供：
+//   bool Post(uintptr_t item);          任意线程投递，队列满返回 false
+//   bool TryTake(uintptr_t &item);      运行线程非阻塞取
+//   uintptr_t Take();                   运行线程阻塞取
+//   bool TakeUntil(uintptr_t &item, const timespec &deadline);  等到单调时钟上的截止时间，超时返回 false
+// 时间策略需要提供：
+//   template <typename Queue> bool Next(Queue &queue, uint32_t tickMs, uintptr_t &item);
+//                                       取事件返回 true，到滴答时间返回 false；tickMs 为0表示不需要滴答
+//   uint64_t Now();                     当前时间（毫秒）
+//   template <typename Queue> bool Idle(Queue &queue, uint32_t ms);
+//                                       生产者声明接下来 ms 毫秒空闲，虚拟时间据此推进
+
+#ifndef ACTIVE_OBJECT_HPP
+#define ACTIVE_OBJECT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <time.h>
+#include <type_traits>
+#include <utility>
+#include "statetbl.h"
+#include "qfsm.h"
+#include "sync_queue.h"
+#include "vclock.h"
+
+// 停止运行循环的保留信号
+constexpr uintptr_t AO_STOP = UINTPTR_MAX;
+// 虚拟时间的空闲标记（与 VCLOCK_IDLE 取值相同），由时间策略消费，不会分发给引擎
+constexpr uintptr_t AO_IDLE = UINTPTR_MAX - 1;
+
+// ---------------------------------------------------------------------------
+// 活动对象
+// ---------------------------------------------------------------------------
+template <typename Engine, typename QueuePolicy, typename TimerPolicy>
+class ActiveObject
+{
+public:
+    // 构造参数原样转发给引擎
+    template <typename... Args>
+    explicit ActiveObject(Args &&...args) : engine_(std::forward<Args>(args)...)
+    {
+    }
+
+    ActiveObject(const ActiveObject &) = delete;
+    ActiveObject &operator=(const ActiveObject &) = delete;
+
+    // 投递一个信号（任意线程），队列满返回 false
+    bool Post(uintptr_t signal)
+    {
+        return queue_.Post(signal);
+    }
+
+    // 声明投递方接下来 ms 毫秒不再投递信号（场景驱动调用），只有虚拟时间据此推进
+    bool Idle(uint32_t ms)
+    {
+        return timer_.Idle(queue_, ms);
+    }
+
+    // 请求运行循环在处理完之前投递的信号后退出
+    bool Stop()
+    {
+        return queue_.Post(AO_STOP);
+    }
+
+    // 运行循环，在活动对象自己的线程上调用，收到 Stop 后返回
+    void Run()
+    {
+        engine_.Init();
+        for (;;) {
+            uintptr_t item = 0;
+            // 当前状态不需要滴答时一直等待事件
+            uint32_t tickMs = engine_.NeedTick() ? tickMs_ : 0;
+            if (!timer_.Next(queue_, tickMs, item)) {
+                engine_.Tick();
+            } else if (item == AO_STOP) {
+                return;
+            } else {
+                engine_.Dispatch(item);
+            }
+        }
+    }
+
+    // 设置滴答间隔（毫秒），在 Run 之前调用
+    void SetTick(uint32_t tickMs)
+    {
+        tickMs_ = tickMs;
+    }
+
+    Engine &GetEngine()
+    {
+        return engine_;
+    }
+
+    QueuePolicy &GetQueue()
+    {
+        return queue_;
+    }
+
+    TimerPolicy &GetTimer()
+    {
+        return timer_;
+    }
+
+private:
+    Engine engine_;
+    QueuePolicy queue_;
+    TimerPolicy timer_;
+    uint32_t tickMs_ = 100;
+};
+
+// ---------------------------------------------------------------------------
+// 队列策略
+// ---------------------------------------------------------------------------
+
+// 互斥锁加条件变量的 SyncQueue，缓冲区内嵌
+template <uint32_t N>
+class SyncQueuePolicy
+{
+public:
+    SyncQueuePolicy()
+    {
+        QueueCtor(&queue_, buffer_, N);
+    }
+
+    bool Post(uintptr_t item)
+    {
+        return QueueEnqueue(&queue_, (void *)item) == 0;
+    }
+
+    bool TryTake(uintptr_t &item)
+    {
+        void *p = nullptr;
+        if (!QueueTryDequeue(&queue_, &p)) {
+            return false;
+        }
+        item = (uintptr_t)p;
+        return true;
+    }
+
+    uintptr_t Take()
+    {
+        return (uintptr_t)QueueDequeueForever(&queue_);
+    }
+
+    bool TakeUntil(uintptr_t &item, const timespec &deadline)
+    {
+        bool isTimeout = false;
+        void *p = QueueDequeueUntil(&queue_, &deadline, &isTimeout);
+        if (isTimeout) {
+            return false;
+        }
+        item = (uintptr_t)p;
+        return true;
+    }
+
+    SyncQueue *Get()
+    {
+        return &queue_;
+    }
+
+private:
+    SyncQueue queue_;
+    void *buffer_[N];
+};
+
+// 有界无锁多生产者/单消费者环形队列（每个槽位带序号），
+// 投递和取事件都不加锁；只有消费者准备睡眠时生产者才去拿锁通知
+template <uint32_t N>
+class LockFreeQueuePolicy
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    LockFreeQueuePolicy()
+    {
+        for (uint32_t i = 0; i < N; i++) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool Post(uintptr_t item)
+    {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & (N - 1)];
+            uint64_t seq = cell.seq.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)seq - (int64_t)pos;
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        // 与消费者设置 waiting_ 之后的再次检查配对，保证不会漏掉唤醒
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cond_.notify_one();
+        }
+        return true;
+    }
+
+    bool TryTake(uintptr_t &item)
+    {
+        Cell &cell = cells_[head_ & (N - 1)];
+        if (cell.seq.load(std::memory_order_acquire) != head_ + 1) {
+            return false;
+        }
+        item = cell.item;
+        cell.seq.store(head_ + N, std::memory_order_release);
+        head_++;
+        return true;
+    }
+
+    uintptr_t Take()
+    {
+        uintptr_t item = 0;
+        while (!TakeOrWait(item, nullptr)) {
+        }
+        return item;
+    }
+
+    bool TakeUntil(uintptr_t &item, const timespec &deadline)
+    {
+        return TakeOrWait(item, &deadline);
+    }
+
+private:
+    // 先无锁取，取不到再登记等待并睡眠，deadline 为空表示不超时
+    bool TakeOrWait(uintptr_t &item, const timespec *deadline)
+    {
+        if (TryTake(item)) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            waiting_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (TryTake(item)) {
+                waiting_.store(false, std::memory_order_relaxed);
+                return true;
+            }
+            if (deadline == nullptr) {
+                cond_.wait(lock);
+            } else {
+                timespec now = {0, 0};
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                int64_t leftNs = (int64_t)(deadline->tv_sec - now.tv_sec) * 1000000000LL +
+                                 (deadline->tv_nsec - now.tv_nsec);
+                if (leftNs <= 0) {
+                    waiting_.store(false, std::memory_order_relaxed);
+                    return TryTake(item);
+                }
+                // steady_clock 与 CLOCK_MONOTONIC 同源，按剩余时间等待
+                cond_.wait_for(lock, std::chrono::nanoseconds(leftNs));
+            }
+            waiting_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    struct alignas(64) Cell
+    {
+        std::atomic<uint64_t> seq;
+        uintptr_t item;
+    };
+
+    Cell cells_[N];
+    alignas(64) std::atomic<uint64_t> tail_{0};     // 生产者端
+    alignas(64) uint64_t head_ = 0;                 // 消费者端，只由运行线程访问
+    std::atomic<bool> waiting_{false};              // 消费者是否准备睡眠
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+// ---------------------------------------------------------------------------
+// 时间策略
+// ---------------------------------------------------------------------------
+
+// 真实时间：滴答按单调时钟上的绝对截止时间产生，不随事件处理漂移
+class RealTimer
+{
+public:
+    template <typename Queue>
+    bool Next(Queue &queue, uint32_t tickMs, uintptr_t &item)
+    {
+        if (tickMs == 0) {
+            deadlineMs_ = 0;
+            item = queue.Take();
+            return true;
+        }
+        if (deadlineMs_ == 0) {
+            deadlineMs_ = Now() + tickMs;
+        }
+        timespec deadline = {(time_t)(deadlineMs_ / 1000), (long)(deadlineMs_ % 1000) * 1000000L};
+        if (queue.TakeUntil(item, deadline)) {
+            return true;
+        }
+        deadlineMs_ += tickMs;
+        return false;
+    }
+
+    uint64_t Now()
+    {
+        timespec ts = {0, 0};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+    }
+
+    // 真实时间自己流逝，不需要空闲声明
+    template <typename Queue>
+    bool Idle(Queue &, uint32_t)
+    {
+        return true;
+    }
+
+private:
+    uint64_t deadlineMs_ = 0;   // 下一个滴答截止时间，0 表示未设置
+};
+
+// 虚拟时间：只在投递方声明空闲后推进，推进时直接跳到下一个滴答，与 VClock 的虚拟时间模式相同
+class SimTimer
+{
+public:
+    template <typename Queue>
+    bool Next(Queue &queue, uint32_t tickMs, uintptr_t &item)
+    {
+        if (tickMs == 0) {
+            deadlineMs_ = 0;
+            // 没有滴答要产生，时间直接走完空闲时长
+            while ((item = queue.Take()) == AO_IDLE) {
+                TakeIdle();
+                nowMs_ = idleUntilMs_;
+            }
+            return true;
+        }
+        if (deadlineMs_ == 0) {
+            deadlineMs_ = nowMs_ + tickMs;
+        }
+        for (;;) {
+            if (queue.TryTake(item)) {
+                if (item != AO_IDLE) {
+                    return true;
+                }
+                TakeIdle();
+                continue;
+            }
+            // 截止时间在声明的空闲时间内才推进，队列暂时为空不会让时间前进
+            if (deadlineMs_ <= idleUntilMs_) {
+                nowMs_ = deadlineMs_;
+                deadlineMs_ += tickMs;
+                return false;
+            }
+            item = queue.Take();
+            if (item != AO_IDLE) {
+                return true;
+            }
+            TakeIdle();
+        }
+    }
+
+    // 先登记时长再投递标记，运行线程取到标记时一定能看到这次的时长
+    template <typename Queue>
+    bool Idle(Queue &queue, uint32_t ms)
+    {
+        idleMs_.fetch_add(ms, std::memory_order_relaxed);
+        return queue.Post(AO_IDLE);
+    }
+
+    uint64_t Now()
+    {
+        return nowMs_;
+    }
+
+private:
+    void TakeIdle()
+    {
+        if (idleUntilMs_ < nowMs_) {
+            idleUntilMs_ = nowMs_;
+        }
+        idleUntilMs_ += idleMs_.exchange(0, std::memory_order_relaxed);
+    }
+
+    uint64_t nowMs_ = 0;        // 已推进到的虚拟时间
+    uint64_t deadlineMs_ = 0;   // 下一个滴答截止时间，0 表示未设置
+    uint64_t idleUntilMs_ = 0;  // 虚拟时间可以推进到的时间
+    std::atomic<uint32_t> idleMs_{0};   // 已声明但运行线程尚未取走的空闲时长
+};
+
+// 与 VCLOCK_DEFAULT_SIMULATED 一致的默认时间策略（CMake 选项 BOMB_SIM_CLOCK）
+using DefaultTimer = std::conditional_t<VCLOCK_DEFAULT_SIMULATED, SimTimer, RealTimer>;
+
+// ---------------------------------------------------------------------------
+// 引擎适配器
+// ---------------------------------------------------------------------------
+
+// StateTable 状态表引擎，Machine 以 StateTable 为第一个成员（super），由调用者构造
+template <typename Machine, uint16_t TickSignal>
+class StateTableEngine
+{
+public:
+    explicit StateTableEngine(Machine *machine) : machine_(machine)
+    {
+    }
+
+    void Init()
+    {
+        StateTableInit(&machine_->super);
+    }
+
+    void Dispatch(uintptr_t signal)
+    {
+        const Event e = {(uint16_t)signal};
+        StateTableDispatch(&machine_->super, &e);
+    }
+
+    void Tick()
+    {
+        Dispatch(TickSignal);
+    }
+
+    bool NeedTick() const
+    {
+        return StateTableNeedTick(&machine_->super);
+    }
+
+    Machine *Get()
+    {
+        return machine_;
+    }
+
+private:
+    Machine *machine_;
+};
+
+// QFsm 状态函数引擎，Machine 以 QFsm 为第一个成员（super），由调用者构造；
+// 用户信号从0开始编号，分发时加上 Q_USER_SIGNAL
+template <typename Machine, uint8_t TickSignal>
+class QFsmEngine
+{
+public:
+    explicit QFsmEngine(Machine *machine) : machine_(machine)
+    {
+    }
+
+    void Init()
+    {
+        QFsmInit(&machine_->super, nullptr);
+    }
+
+    void Dispatch(uintptr_t signal)
+    {
+        QEvent e = {(QSignal)(signal + Q_USER_SIGNAL), 0};
+        QFsmDispatch(&machine_->super, &e);
+    }
+
+    void Tick()
+    {
+        Dispatch(TickSignal);
+    }
+
+    bool NeedTick() const
+    {
+        return QFsmNeedTick(&machine_->super);
+    }
+
+    Machine *Get()
+    {
+        return machine_;
+    }
+
+private:
+    Machine *machine_;
+};
+
+#endif // !ACTIVE_OBJECT_HPP
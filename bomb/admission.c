@@ -0,0 +1,404 @@
+/**
+ * @file admission.c
+ * @brief 队列入口的准入控制实现文件
+ *
+ * 令牌桶按 GCRA 实现：理论到达时间 tat 每准入一个事件前进 intervalNs，
+ * tat 超前当前时间不超过 burstNs 时允许准入。信号限额先原子加一，超过上限再减回去。
+ * 两者都不加锁，只有真正入队时才进入队列的锁。
+ */
+
+#include "admission.h"
+#include "timespec_util.h"
+#include <time.h>
+
+/**
+ * @brief 初始化准入控制
+ *
+ * @param me 指向准入控制的指针
+ * @param queue 主队列
+ * @param signalOf 取事件的信号
+ * @param buckets 令牌桶数组
+ * @param sourceNum 生产者数
+ * @param quotas 限额数组
+ * @param signalNum 信号数
+ */
+void AdmissionCtor(Admission *me, SyncQueue *queue, QueueKeyOf signalOf, AdmissionBucket *buckets,
+                   uint32_t sourceNum, AdmissionQuota *quotas, uint32_t signalNum)
+{
+    static const AdmissionCounters zero = {0};
+
+    me->queue = queue;
+    me->lowQueue = NULL;
+    me->doorbellItem = NULL;
+    me->signalOf = signalOf;
+    me->buckets = buckets;
+    me->sourceNum = sourceNum;
+    me->quotas = quotas;
+    me->signalNum = signalNum;
+    me->doorbell = 0;
+    for (uint32_t i = 0; i < sourceNum; i++) {
+        buckets[i].intervalNs = 0;
+        buckets[i].burstNs = 0;
+        buckets[i].tat = 0;
+        buckets[i].action = ADMISSION_REJECT;
+        buckets[i].stats = zero;
+    }
+    for (uint32_t i = 0; i < signalNum; i++) {
+        quotas[i].limit = 0;
+        quotas[i].queued = 0;
+        quotas[i].action = ADMISSION_REJECT;
+        quotas[i].stats = zero;
+    }
+}
+
+/**
+ * @brief 设置低优先级队列
+ *
+ * @param me 指向准入控制的指针
+ * @param lowQueue 低优先级队列
+ * @param doorbell 门铃
+ */
+void AdmissionSetLowQueue(Admission *me, SyncQueue *lowQueue, void *doorbell)
+{
+    me->lowQueue = lowQueue;
+    me->doorbellItem = doorbell;
+}
+
+/**
+ * @brief 设置生产者限速
+ *
+ * @param me 指向准入控制的指针
+ * @param source 生产者编号
+ * @param ratePerSec 每秒令牌数
+ * @param burst 允许的突发事件数
+ * @param action 超限动作
+ */
+void AdmissionSetRate(Admission *me, uint32_t source, uint32_t ratePerSec, uint32_t burst, AdmissionAction action)
+{
+    if (source >= me->sourceNum) {
+        return;
+    }
+    AdmissionBucket *bucket = &me->buckets[source];
+    bucket->intervalNs = ratePerSec != 0 ? NSEC_PER_SEC / ratePerSec : 0;
+    bucket->burstNs = burst > 1 ? (uint64_t)(burst - 1) * bucket->intervalNs : 0;
+    bucket->action = (uint8_t)action;
+    __atomic_store_n(&bucket->tat, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 设置信号限额
+ *
+ * @param me 指向准入控制的指针
+ * @param signal 信号
+ * @param limit 事件数上限
+ * @param action 超限动作
+ */
+void AdmissionSetQuota(Admission *me, uint32_t signal, uint32_t limit, AdmissionAction action)
+{
+    if (signal >= me->signalNum) {
+        return;
+    }
+    me->quotas[signal].limit = limit;
+    me->quotas[signal].action = (uint8_t)action;
+}
+
+/**
+ * @brief 从令牌桶取一个令牌
+ *
+ * @param bucket 令牌桶
+ * @param now 当前时间
+ * @return true 取到令牌
+ */
+static bool AdmissionTakeToken(AdmissionBucket *bucket, uint64_t now)
+{
+    uint64_t tat = __atomic_load_n(&bucket->tat, __ATOMIC_ACQUIRE);
+    for (;;) {
+        // 桶已满（长时间没有事件）时从当前时间算起
+        uint64_t base = tat > now ? tat : now;
+        if (base - now > bucket->burstNs) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&bucket->tat, &tat, base + bucket->intervalNs, true, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief 事件对应的信号限额
+ *
+ * @param me 指向准入控制的指针
+ * @param item 事件
+ * @return 信号限额，事件不受信号限额约束时返回NULL
+ */
+static AdmissionQuota *AdmissionQuotaOf(Admission *me, const void *item)
+{
+    if (me->signalOf == NULL) {
+        return NULL;
+    }
+    int signal = me->signalOf(item);
+    if (signal < 0 || (uint32_t)signal >= me->signalNum) {
+        return NULL;
+    }
+    return &me->quotas[signal];
+}
+
+/**
+ * @brief 在信号限额中占一个位置，不限额的信号也计数，便于运行中修改上限
+ *
+ * @param quota 信号限额
+ * @return true 没有超过上限
+ */
+static bool AdmissionReserve(AdmissionQuota *quota)
+{
+    uint32_t queued = __atomic_add_fetch(&quota->queued, 1, __ATOMIC_ACQ_REL);
+    uint32_t limit = __atomic_load_n(&quota->limit, __ATOMIC_RELAXED);
+    if (limit != 0 && queued > limit) {
+        __atomic_sub_fetch(&quota->queued, 1, __ATOMIC_ACQ_REL);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 按结果累加统计
+ *
+ * @param stats 统计，可以为 NULL
+ * @param result 入队结果
+ */
+static void AdmissionCount(AdmissionCounters *stats, AdmissionResult result)
+{
+    if (stats == NULL) {
+        return;
+    }
+    uint64_t *counter = &stats->admitted;
+    switch (result) {
+    case ADMISSION_COALESCED:
+        counter = &stats->coalesced;
+        break;
+    case ADMISSION_DEPRIORITIZED:
+        counter = &stats->deprioritized;
+        break;
+    case ADMISSION_REJECTED:
+        counter = &stats->rejected;
+        break;
+    case ADMISSION_FULL:
+        counter = &stats->full;
+        break;
+    default:
+        break;
+    }
+    __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 在主队列中放一个门铃，已有门铃时不重复放
+ *
+ * @param me 指向准入控制的指针
+ */
+static void AdmissionRing(Admission *me)
+{
+    if (__atomic_exchange_n(&me->doorbell, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+    if (QueueEnqueue(me->queue, me->doorbellItem) != 0) {
+        // 主队列已满，消费者取到下一个事件时补放
+        __atomic_store_n(&me->doorbell, 0, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief 超出限制时按动作处理
+ *
+ * @param me 指向准入控制的指针
+ * @param item 事件
+ * @param action 超限动作
+ * @return 入队结果
+ */
+static AdmissionResult AdmissionOverflow(Admission *me, void *item, uint8_t action)
+{
+    if (action == ADMISSION_COALESCE && QueueEnqueueCoalesce(me->queue, item, true) == 1) {
+        return ADMISSION_COALESCED;
+    }
+    if (action == ADMISSION_DEPRIORITIZE && me->lowQueue != NULL) {
+        if (QueueEnqueue(me->lowQueue, item) != 0) {
+            return ADMISSION_FULL;
+        }
+        AdmissionRing(me);
+        return ADMISSION_DEPRIORITIZED;
+    }
+    return ADMISSION_REJECTED;
+}
+
+/**
+ * @brief 经过准入检查后入队
+ *
+ * @param me 指向准入控制的指针
+ * @param source 生产者编号
+ * @param item 事件
+ * @return 入队结果
+ */
+AdmissionResult AdmissionEnqueue(Admission *me, uint32_t source, void *item)
+{
+    AdmissionBucket *bucket = source < me->sourceNum ? &me->buckets[source] : NULL;
+    AdmissionQuota *quota = AdmissionQuotaOf(me, item);
+    AdmissionResult result;
+
+    if (bucket != NULL && bucket->intervalNs != 0 && !AdmissionTakeToken(bucket, TimespecNowNs())) {
+        result = AdmissionOverflow(me, item, bucket->action);
+    } else if (quota != NULL && !AdmissionReserve(quota)) {
+        result = AdmissionOverflow(me, item, quota->action);
+    } else {
+        int ret = QueueEnqueueCoalesce(me->queue, item, false);
+        // 被队列合并或队列已满时没有新占位置
+        if (ret != 0 && quota != NULL) {
+            __atomic_sub_fetch(&quota->queued, 1, __ATOMIC_ACQ_REL);
+        }
+        result = ret < 0 ? ADMISSION_FULL : ADMISSION_ADMITTED;
+    }
+
+    AdmissionCount(bucket != NULL ? &bucket->stats : NULL, result);
+    AdmissionCount(quota != NULL ? &quota->stats : NULL, result);
+    return result;
+}
+
+/**
+ * @brief 处理从主队列取出的元素
+ *
+ * @param me 指向准入控制的指针
+ * @param item 输入为主队列取出的元素，输出为交给消费者的事件
+ * @return true 得到事件，false 取到门铃但低优先级队列已空
+ */
+static bool AdmissionTake(Admission *me, void **item)
+{
+    if (me->lowQueue == NULL || *item != me->doorbellItem) {
+        AdmissionQuota *quota = AdmissionQuotaOf(me, *item);
+        if (quota != NULL) {
+            __atomic_sub_fetch(&quota->queued, 1, __ATOMIC_ACQ_REL);
+        }
+        // 门铃因主队列满没放进去时补放，只读计数作为提示
+        if (me->lowQueue != NULL && __atomic_load_n(&me->doorbell, __ATOMIC_ACQUIRE) == 0 &&
+            __atomic_load_n(&me->lowQueue->currentSize, __ATOMIC_RELAXED) != 0) {
+            AdmissionRing(me);
+        }
+        return true;
+    }
+
+    // 先清门铃再取，之后降级的事件会放新的门铃
+    __atomic_store_n(&me->doorbell, 0, __ATOMIC_RELEASE);
+    if (!QueueTryDequeue(me->lowQueue, item)) {
+        return false;
+    }
+    // 还有低优先级事件时重新排到主队列队尾
+    if (!QueueIsEmpty(me->lowQueue)) {
+        AdmissionRing(me);
+    }
+    return true;
+}
+
+/**
+ * @brief 带超时的出队操作
+ *
+ * @param me 指向准入控制的指针
+ * @param timeoutMs 超时时间（毫秒）
+ * @param isTimeout 输出参数，标识是否超时
+ * @return 取出的事件，超时时返回NULL
+ */
+void *AdmissionDequeueWithTimeout(Admission *me, uint32_t timeoutMs, bool *isTimeout)
+{
+    struct timespec deadline = {0};
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    TimespecAddNs(&deadline, (int64_t)timeoutMs * 1000000);
+
+    for (;;) {
+        bool timeout = false;
+        void *item = QueueDequeueUntil(me->queue, &deadline, &timeout);
+        if (timeout || item == NULL) {
+            // 主队列一直为空，最后再看一次低优先级队列
+            if (me->lowQueue != NULL && QueueTryDequeue(me->lowQueue, &item)) {
+                return item;
+            }
+            *isTimeout = timeout;
+            return NULL;
+        }
+        if (AdmissionTake(me, &item)) {
+            return item;
+        }
+    }
+}
+
+/**
+ * @brief 非阻塞出队操作
+ *
+ * @param me 指向准入控制的指针
+ * @param item 输出参数，取出的事件
+ * @return true 成功取出事件，false 两个队列都为空
+ */
+bool AdmissionTryDequeue(Admission *me, void **item)
+{
+    while (QueueTryDequeue(me->queue, item)) {
+        if (AdmissionTake(me, item)) {
+            return true;
+        }
+    }
+    return me->lowQueue != NULL && QueueTryDequeue(me->lowQueue, item);
+}
+
+/**
+ * @brief 累加统计
+ */
+static void AdmissionAdd(AdmissionCounters *total, const AdmissionCounters *stats)
+{
+    total->admitted += __atomic_load_n(&stats->admitted, __ATOMIC_RELAXED);
+    total->coalesced += __atomic_load_n(&stats->coalesced, __ATOMIC_RELAXED);
+    total->deprioritized += __atomic_load_n(&stats->deprioritized, __ATOMIC_RELAXED);
+    total->rejected += __atomic_load_n(&stats->rejected, __ATOMIC_RELAXED);
+    total->full += __atomic_load_n(&stats->full, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 汇总所有生产者的统计
+ *
+ * @param me 指向准入控制的指针
+ * @param total 输出参数，汇总的统计
+ */
+void AdmissionTotals(const Admission *me, AdmissionCounters *total)
+{
+    static const AdmissionCounters zero = {0};
+    *total = zero;
+    for (uint32_t i = 0; i < me->sourceNum; i++) {
+        AdmissionAdd(total, &me->buckets[i].stats);
+    }
+}
+
+/**
+ * @brief 打印一行统计，没有事件时不打印
+ */
+static void AdmissionReportRow(FILE *out, const char *kind, uint32_t id, const AdmissionCounters *stats)
+{
+    AdmissionCounters s = {0};
+    AdmissionAdd(&s, stats);
+    if (s.admitted + s.coalesced + s.deprioritized + s.rejected + s.full == 0) {
+        return;
+    }
+    fprintf(out, "%-6s %3u  admitted %9llu  coalesced %8llu  deprioritized %8llu  rejected %8llu  full %8llu\n",
+            kind, id, (unsigned long long)s.admitted, (unsigned long long)s.coalesced,
+            (unsigned long long)s.deprioritized, (unsigned long long)s.rejected, (unsigned long long)s.full);
+}
+
+/**
+ * @brief 打印每个生产者和每个信号的统计
+ *
+ * @param me 指向准入控制的指针
+ * @param out 输出文件
+ */
+void AdmissionReport(const Admission *me, FILE *out)
+{
+    for (uint32_t i = 0; i < me->sourceNum; i++) {
+        AdmissionReportRow(out, "source", i, &me->buckets[i].stats);
+    }
+    for (uint32_t i = 0; i < me->signalNum; i++) {
+        AdmissionReportRow(out, "signal", i, &me->quotas[i].stats);
+    }
+}
@@ -0,0 +1,197 @@
+/**
+ * @file admission.h
+ * @brief 队列入口的准入控制头文件
+ *
+ * 在同步队列前面按生产者限速、按信号限额：每个生产者一个令牌桶（按 GCRA 实现，
+ * 状态只有一个理论到达时间，用一次 CAS 更新），每个信号一个在队列中的事件数上限（原子计数）。
+ * 两项检查都不加锁，通过后才进入队列的锁。
+ *
+ * 超出限制时按规则上配置的动作处理：
+ * - 拒绝：直接返回，由生产者决定丢弃还是稍后重试；
+ * - 合并：只尝试按队列的合并策略并入队列中的同键事件，不能合并时拒绝；
+ * - 降级：放入低优先级队列，消费者每轮只在主队列中排在它前面的事件之后取一个低优先级事件。
+ *
+ * 每个生产者和每个信号都统计准入、拒绝、合并和降级的次数，可以随时读出或打印。
+ */
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "sync_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 超出限制时的动作
+ */
+typedef enum {
+    ADMISSION_REJECT,           ///< 拒绝
+    ADMISSION_COALESCE,         ///< 只合并到队列中已有的同键事件，不能合并时拒绝
+    ADMISSION_DEPRIORITIZE,     ///< 放入低优先级队列，没有低优先级队列时拒绝
+} AdmissionAction;
+
+/**
+ * @brief 入队结果
+ */
+typedef enum {
+    ADMISSION_ADMITTED,         ///< 已进入主队列（包括被队列合并）
+    ADMISSION_COALESCED,        ///< 超限后合并到了队列中的同键事件
+    ADMISSION_DEPRIORITIZED,    ///< 超限后进入了低优先级队列
+    ADMISSION_REJECTED,         ///< 超限被拒绝
+    ADMISSION_FULL,             ///< 没有超限，但队列已满
+} AdmissionResult;
+
+/**
+ * @brief 准入统计（原子访问）
+ */
+typedef struct AdmissionCountersTag {
+    uint64_t admitted;          ///< 进入主队列的事件数
+    uint64_t coalesced;         ///< 超限后被合并的事件数
+    uint64_t deprioritized;     ///< 超限后降级的事件数
+    uint64_t rejected;          ///< 超限被拒绝的事件数
+    uint64_t full;              ///< 队列已满被丢弃的事件数
+} AdmissionCounters;
+
+/**
+ * @brief 生产者令牌桶
+ */
+typedef struct AdmissionBucketTag {
+    uint64_t intervalNs;        ///< 每个令牌的间隔（纳秒），0 表示不限速
+    uint64_t burstNs;           ///< 允许提前的时间，(突发数 - 1) * intervalNs
+    uint64_t tat;               ///< 理论到达时间（CLOCK_MONOTONIC 纳秒，原子访问）
+    uint8_t action;             ///< 超限动作（AdmissionAction）
+    AdmissionCounters stats;    ///< 该生产者的统计
+} AdmissionBucket;
+
+/**
+ * @brief 信号限额
+ */
+typedef struct AdmissionQuotaTag {
+    uint32_t limit;             ///< 主队列中该信号的事件数上限，0 表示不限
+    uint32_t queued;            ///< 主队列中该信号的事件数（原子访问）
+    uint8_t action;             ///< 超限动作（AdmissionAction）
+    AdmissionCounters stats;    ///< 该信号的统计
+} AdmissionQuota;
+
+/**
+ * @brief 准入控制
+ */
+typedef struct AdmissionTag {
+    SyncQueue *queue;           ///< 主队列
+    SyncQueue *lowQueue;        ///< 低优先级队列，NULL 表示不支持降级
+    void *doorbellItem;         ///< 门铃，放在主队列中提醒消费者去取低优先级事件
+    QueueKeyOf signalOf;        ///< 取事件的信号，返回-1表示不受信号限额约束
+    AdmissionBucket *buckets;   ///< 生产者令牌桶
+    uint32_t sourceNum;         ///< 生产者数
+    AdmissionQuota *quotas;     ///< 信号限额
+    uint32_t signalNum;         ///< 信号数
+    uint8_t doorbell;           ///< 主队列中已有门铃（原子访问）
+} Admission;
+
+/**
+ * @brief 初始化准入控制，所有生产者和信号默认不限制
+ *
+ * @param me 指向准入控制的指针
+ * @param queue 主队列
+ * @param signalOf 取事件的信号
+ * @param buckets 令牌桶数组，长度为生产者数
+ * @param sourceNum 生产者数
+ * @param quotas 限额数组，长度为信号数
+ * @param signalNum 信号数
+ */
+void AdmissionCtor(Admission *me, SyncQueue *queue, QueueKeyOf signalOf, AdmissionBucket *buckets,
+                   uint32_t sourceNum, AdmissionQuota *quotas, uint32_t signalNum);
+
+/**
+ * @brief 设置低优先级队列，降级动作需要
+ *
+ * 低优先级队列不为空时主队列中最多有一个门铃，消费者取到门铃时改从低优先级队列取一个事件，
+ * 因此低优先级事件总是排在降级时主队列中已有的事件之后。门铃会占用主队列的一个位置，
+ * 主队列的合并键函数对它必须返回-1
+ *
+ * @param me 指向准入控制的指针
+ * @param lowQueue 低优先级队列
+ * @param doorbell 门铃，不能与任何事件相同
+ */
+void AdmissionSetLowQueue(Admission *me, SyncQueue *lowQueue, void *doorbell);
+
+/**
+ * @brief 设置生产者限速，应在生产者启动前调用
+ *
+ * @param me 指向准入控制的指针
+ * @param source 生产者编号
+ * @param ratePerSec 每秒令牌数，0 表示不限速
+ * @param burst 允许的突发事件数，至少为 1
+ * @param action 超限动作
+ */
+void AdmissionSetRate(Admission *me, uint32_t source, uint32_t ratePerSec, uint32_t burst, AdmissionAction action);
+
+/**
+ * @brief 设置信号限额，应在生产者启动前调用
+ *
+ * @param me 指向准入控制的指针
+ * @param signal 信号
+ * @param limit 主队列中该信号的事件数上限，0 表示不限
+ * @param action 超限动作
+ */
+void AdmissionSetQuota(Admission *me, uint32_t signal, uint32_t limit, AdmissionAction action);
+
+/**
+ * @brief 经过准入检查后入队（任意线程）
+ *
+ * 先检查生产者令牌桶，再检查信号限额；超限时按先超出的那条规则的动作处理
+ *
+ * @param me 指向准入控制的指针
+ * @param source 生产者编号，超出范围时不限速
+ * @param item 事件
+ * @return 入队结果
+ */
+AdmissionResult AdmissionEnqueue(Admission *me, uint32_t source, void *item);
+
+/**
+ * @brief 带超时的出队操作，主队列优先
+ *
+ * 消费者必须通过本组函数出队，信号限额的计数在出队时减少
+ *
+ * @param me 指向准入控制的指针
+ * @param timeoutMs 超时时间（毫秒）
+ * @param isTimeout 输出参数，标识是否超时
+ * @return 取出的事件，超时时返回NULL
+ */
+void *AdmissionDequeueWithTimeout(Admission *me, uint32_t timeoutMs, bool *isTimeout);
+
+/**
+ * @brief 非阻塞出队操作，主队列优先
+ *
+ * @param me 指向准入控制的指针
+ * @param item 输出参数，取出的事件
+ * @return true 成功取出事件，false 两个队列都为空
+ */
+bool AdmissionTryDequeue(Admission *me, void **item);
+
+/**
+ * @brief 汇总所有生产者的统计
+ *
+ * @param me 指向准入控制的指针
+ * @param total 输出参数，汇总的统计
+ */
+void AdmissionTotals(const Admission *me, AdmissionCounters *total);
+
+/**
+ * @brief 打印每个生产者和每个信号的统计，只打印有事件的行
+ *
+ * @param me 指向准入控制的指针
+ * @param out 输出文件
+ */
+void AdmissionReport(const Admission *me, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !ADMISSION_H
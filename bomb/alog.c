@@ -0,0 +1,477 @@
+/**
+ * @file alog.c
+ * @brief 异步日志实现文件
+ * 
+ * 每个写日志的线程第一次写日志时从全局数组中领取一个单生产者/单消费者
+ * 无锁环形缓冲区，线程退出时由线程私有数据的析构函数归还，缓冲区中剩余的日志
+ * 仍由后台线程写出，下一个领取的线程接着写；没有空闲缓冲区的线程同步输出。
+ * 后台线程取空所有缓冲区后在条件变量上休眠，
+ * 写日志的线程只在后台线程休眠时（所有缓冲区都为空）才加锁唤醒它。
+ *
+ * 每个缓冲区有一个写入中标志，停止时先关闭 g_running，再等所有已经看到
+ * g_running 为 true 的写入完成，最后才写出剩余日志，保证停止后不会有日志留在缓冲区中。
+ */
+
+#include "alog.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define ALOG_BATCH_SIZE 4096    ///< 后台线程批量写出的缓冲区大小
+#define ALOG_LINE_SIZE 256      ///< 单条日志格式化后的最大长度
+
+/**
+ * @brief 日志记录，只保存格式id和原始参数
+ */
+typedef struct {
+    const char *fmt;                    ///< 格式串指针（格式id）
+    uint8_t argc;                       ///< 参数个数
+    intptr_t args[ALOG_MAX_ARGS];       ///< 原始参数
+} ALogRecord;
+
+/**
+ * @brief 单生产者/单消费者无锁环形缓冲区
+ */
+typedef struct {
+    atomic_uint head;                   ///< 读位置，只由后台线程修改
+    atomic_uint tail;                   ///< 写位置，只由所属线程修改
+    atomic_bool busy;                   ///< 所属线程正在写入，只由所属线程修改
+    atomic_bool owned;                  ///< 已被某个线程领取，线程退出时清除
+    ALogRecord records[ALOG_RING_SIZE]; ///< 记录数组
+} ALogRing;
+
+static ALogRing g_rings[ALOG_MAX_THREADS];      ///< 所有线程的环形缓冲区
+static atomic_uint g_ringCount;                 ///< 用到过的缓冲区个数（最大下标加1），只增不减
+static _Thread_local ALogRing *t_ring;          ///< 当前线程的缓冲区
+static pthread_once_t g_ringKeyOnce = PTHREAD_ONCE_INIT;   ///< 线程私有数据键只创建一次
+static pthread_key_t g_ringKey;                 ///< 线程退出时归还缓冲区的线程私有数据键
+static bool g_ringKeyReady;                     ///< 线程私有数据键是否创建成功
+static atomic_bool g_running;                   ///< 是否接受异步写入
+static atomic_bool g_quit;                      ///< 通知后台线程写出剩余日志后退出
+static atomic_bool g_sleeping;                  ///< 后台线程在条件变量上休眠
+static atomic_uint_fast64_t g_dropped;          ///< 丢弃的日志条数
+static ALogOverflow g_overflow;                 ///< 缓冲区满时的处理策略
+static pthread_t g_thread;                      ///< 后台线程
+static pthread_mutex_t g_syncMutex = PTHREAD_MUTEX_INITIALIZER; ///< 同步输出时的互斥锁
+static pthread_mutex_t g_wakeMutex = PTHREAD_MUTEX_INITIALIZER; ///< 后台线程休眠用的互斥锁
+static pthread_cond_t g_wakeCond = PTHREAD_COND_INITIALIZER;    ///< 后台线程休眠用的条件变量
+
+/**
+ * @brief 格式化单个转换说明
+ * 
+ * @param out 输出缓冲区
+ * @param size 输出缓冲区大小
+ * @param spec 转换说明，例如 "%02x"
+ * @param conv 转换字符
+ * @param lenMod 长度修饰符：0 无，'l' long，'L' long long，'z' size_t
+ * @param arg 原始参数
+ * @return 写入的字符数
+ */
+static int FormatOne(char *out, size_t size, const char *spec, char conv, char lenMod, intptr_t arg)
+{
+    switch (conv) {
+    case 'd':
+    case 'i':
+        if (lenMod == 'l') {
+            return snprintf(out, size, spec, (long)arg);
+        } else if (lenMod == 'L') {
+            return snprintf(out, size, spec, (long long)arg);
+        } else if (lenMod == 'z') {
+            return snprintf(out, size, spec, (size_t)arg);
+        }
+        return snprintf(out, size, spec, (int)arg);
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        if (lenMod == 'l') {
+            return snprintf(out, size, spec, (unsigned long)arg);
+        } else if (lenMod == 'L') {
+            return snprintf(out, size, spec, (unsigned long long)arg);
+        } else if (lenMod == 'z') {
+            return snprintf(out, size, spec, (size_t)arg);
+        }
+        return snprintf(out, size, spec, (unsigned int)arg);
+    case 'c':
+        return snprintf(out, size, spec, (int)arg);
+    case 's':
+        return snprintf(out, size, spec, (const char *)arg);
+    case 'p':
+        return snprintf(out, size, spec, (void *)arg);
+    default:
+        return snprintf(out, size, "%s", spec);
+    }
+}
+
+/**
+ * @brief 将一条日志记录格式化为文本
+ * 
+ * 逐个解析格式串中的转换说明，每个转换说明单独调用 snprintf，
+ * 这样参数可以按整数统一保存
+ * 
+ * @param r 日志记录
+ * @param out 输出缓冲区
+ * @param size 输出缓冲区大小
+ * @return 写入的字符数（不含结尾的'\0'）
+ */
+static size_t FormatRecord(const ALogRecord *r, char *out, size_t size)
+{
+    const char *p = r->fmt;
+    size_t len = 0;
+    uint8_t argIdx = 0;
+
+    while (*p != '\0' && len + 1 < size) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // 复制转换说明：标志、宽度、精度、长度修饰符、转换字符
+        char spec[16];
+        size_t n = 0;
+        char lenMod = 0;
+        spec[n++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL && n < sizeof(spec) - 4) {
+            spec[n++] = *p++;
+        }
+        while (*p == 'h' || *p == 'l' || *p == 'z') {
+            if (*p == 'l') {
+                lenMod = (lenMod == 'l') ? 'L' : 'l';
+            } else if (*p == 'z') {
+                lenMod = 'z';
+            }
+            if (n < sizeof(spec) - 2) {
+                spec[n++] = *p;
+            }
+            p++;
+        }
+        char conv = *p;
+        if (conv == '\0') {
+            break;
+        }
+        spec[n++] = *p++;
+        spec[n] = '\0';
+
+        intptr_t arg = (argIdx < r->argc) ? r->args[argIdx] : 0;
+        argIdx++;
+        int ret = FormatOne(out + len, size - len, spec, conv, lenMod, arg);
+        if (ret > 0) {
+            len += (size_t)ret < size - len ? (size_t)ret : size - len - 1;
+        }
+    }
+
+    out[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief 同步输出一条日志（后台线程未运行或没有空闲缓冲区时使用）
+ * 
+ * @param r 日志记录
+ */
+static void WriteSync(const ALogRecord *r)
+{
+    char line[ALOG_LINE_SIZE];
+    size_t len = FormatRecord(r, line, sizeof(line));
+    pthread_mutex_lock(&g_syncMutex);
+    fwrite(line, 1, len, stdout);
+    fflush(stdout);
+    pthread_mutex_unlock(&g_syncMutex);
+}
+
+/**
+ * @brief 线程退出时归还环形缓冲区
+ * 
+ * 缓冲区中剩余的日志仍由后台线程写出，下一个领取者从当前 tail 接着写
+ * 
+ * @param arg 当前线程的缓冲区
+ */
+static void ReleaseRing(void *arg)
+{
+    ALogRing *ring = (ALogRing *)arg;
+    // 其它线程私有数据的析构函数中再写日志时重新领取
+    t_ring = NULL;
+    atomic_store_explicit(&ring->owned, false, memory_order_release);
+}
+
+/**
+ * @brief 创建归还缓冲区用的线程私有数据键
+ */
+static void CreateRingKey(void)
+{
+    g_ringKeyReady = pthread_key_create(&g_ringKey, ReleaseRing) == 0;
+}
+
+/**
+ * @brief 获取当前线程的环形缓冲区
+ * 
+ * 用 CAS 领取一个未被占用的缓冲区，并登记到线程私有数据中，线程退出时归还
+ * 
+ * @return 当前线程的缓冲区，没有空闲缓冲区时返回NULL
+ */
+static ALogRing *ThreadRing(void)
+{
+    if (t_ring != NULL) {
+        return t_ring;
+    }
+    pthread_once(&g_ringKeyOnce, CreateRingKey);
+    if (!g_ringKeyReady) {
+        return NULL;
+    }
+    for (unsigned i = 0; i < ALOG_MAX_THREADS; i++) {
+        ALogRing *ring = &g_rings[i];
+        bool expected = false;
+        if (atomic_load_explicit(&ring->owned, memory_order_relaxed) ||
+            !atomic_compare_exchange_strong(&ring->owned, &expected, true)) {
+            continue;
+        }
+        if (pthread_setspecific(g_ringKey, ring) != 0) {
+            atomic_store_explicit(&ring->owned, false, memory_order_release);
+            return NULL;
+        }
+        // 先让后台线程和 ALogStop 能遍历到这个缓冲区，再往里写
+        unsigned count = atomic_load(&g_ringCount);
+        while (count < i + 1 && !atomic_compare_exchange_weak(&g_ringCount, &count, i + 1)) {
+        }
+        t_ring = ring;
+        return ring;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 唤醒休眠的后台线程
+ * 
+ * 后台线程只在所有缓冲区都为空时休眠，所以只有缓冲区由空变为非空的那次写入会走到加锁，
+ * 清除休眠标志的线程负责发信号，其它线程直接返回
+ */
+static void WakeLogger(void)
+{
+    if (atomic_load(&g_sleeping) && atomic_exchange(&g_sleeping, false)) {
+        pthread_mutex_lock(&g_wakeMutex);
+        pthread_cond_signal(&g_wakeCond);
+        pthread_mutex_unlock(&g_wakeMutex);
+    }
+}
+
+/**
+ * @brief 写一条日志
+ * 
+ * @param fmt printf 风格的格式串，必须是静态字符串
+ * @param argc 参数个数
+ * @param ... argc 个 intptr_t 类型的参数
+ */
+void ALogWrite(const char *fmt, int argc, ...)
+{
+    ALogRecord r;
+    va_list ap;
+
+    r.fmt = fmt;
+    r.argc = (uint8_t)(argc > ALOG_MAX_ARGS ? ALOG_MAX_ARGS : argc);
+    va_start(ap, argc);
+    for (uint8_t i = 0; i < r.argc; i++) {
+        r.args[i] = va_arg(ap, intptr_t);
+    }
+    va_end(ap);
+
+    // 后台线程未运行，直接同步输出
+    if (!atomic_load_explicit(&g_running, memory_order_acquire)) {
+        WriteSync(&r);
+        return;
+    }
+    // 同时写日志的线程数超过上限，没有空闲缓冲区，同步输出
+    ALogRing *ring = ThreadRing();
+    if (ring == NULL) {
+        WriteSync(&r);
+        return;
+    }
+
+    // 先置写入中标志再检查 g_running（都是顺序一致），ALogStop 要么让这里看到 false，
+    // 要么在关闭 g_running 之后看到写入中标志并等待本次写入完成
+    atomic_store(&ring->busy, true);
+    if (!atomic_load(&g_running)) {
+        atomic_store_explicit(&ring->busy, false, memory_order_release);
+        WriteSync(&r);
+        return;
+    }
+
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == ALOG_RING_SIZE) {
+        // 缓冲区已满
+        if (g_overflow == ALOG_OVERFLOW_DROP) {
+            atomic_store_explicit(&ring->busy, false, memory_order_release);
+            atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+            return;
+        }
+        if (!atomic_load_explicit(&g_running, memory_order_acquire)) {
+            atomic_store_explicit(&ring->busy, false, memory_order_release);
+            WriteSync(&r);
+            return;
+        }
+        sched_yield();
+    }
+
+    ring->records[tail & (ALOG_RING_SIZE - 1)] = r;
+    // 顺序一致的写入与后台线程休眠前的检查配对，二者至少有一方能看到对方
+    atomic_store(&ring->tail, tail + 1);
+    WakeLogger();
+    atomic_store_explicit(&ring->busy, false, memory_order_release);
+}
+
+/**
+ * @brief 取出所有缓冲区中的日志并批量写出
+ * 
+ * @return 本次写出的日志条数
+ */
+static unsigned Drain(void)
+{
+    static char batch[ALOG_BATCH_SIZE];
+    size_t batchLen = 0;
+    unsigned total = 0;
+    unsigned ringNum = atomic_load(&g_ringCount);
+
+    for (unsigned i = 0; i < ringNum; i++) {
+        ALogRing *ring = &g_rings[i];
+        unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        for (; head != tail; head++) {
+            if (batchLen + ALOG_LINE_SIZE > sizeof(batch)) {
+                fwrite(batch, 1, batchLen, stdout);
+                batchLen = 0;
+            }
+            batchLen += FormatRecord(&ring->records[head & (ALOG_RING_SIZE - 1)],
+                                     batch + batchLen, ALOG_LINE_SIZE);
+            total++;
+        }
+        atomic_store_explicit(&ring->head, head, memory_order_release);
+    }
+
+    if (batchLen > 0) {
+        fwrite(batch, 1, batchLen, stdout);
+    }
+    if (total > 0) {
+        fflush(stdout);
+    }
+    return total;
+}
+
+/**
+ * @brief 所有缓冲区是否都为空
+ * 
+ * @return true 都为空
+ */
+static bool RingsEmpty(void)
+{
+    unsigned ringNum = atomic_load(&g_ringCount);
+
+    for (unsigned i = 0; i < ringNum; i++) {
+        if (atomic_load(&g_rings[i].tail) != atomic_load_explicit(&g_rings[i].head, memory_order_relaxed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 后台线程在条件变量上休眠，直到有新日志或者要退出
+ * 
+ * 先置休眠标志再检查缓冲区（都是顺序一致），与写日志线程先写 tail 再检查休眠标志配对，
+ * 不会丢失唤醒
+ */
+static void Park(void)
+{
+    pthread_mutex_lock(&g_wakeMutex);
+    atomic_store(&g_sleeping, true);
+    if (!atomic_load(&g_quit) && RingsEmpty()) {
+        while (atomic_load(&g_sleeping)) {
+            pthread_cond_wait(&g_wakeCond, &g_wakeMutex);
+        }
+    }
+    atomic_store(&g_sleeping, false);
+    pthread_mutex_unlock(&g_wakeMutex);
+}
+
+/**
+ * @brief 后台日志线程
+ * 
+ * @param arg 线程参数（未使用）
+ * @return 线程返回值
+ */
+static void *ALogThread(void *arg)
+{
+    (void)arg;
+
+    while (!atomic_load(&g_quit)) {
+        if (Drain() == 0) {
+            Park();
+        }
+    }
+    // 退出前写出剩余日志，此时已经没有正在进行的异步写入
+    Drain();
+    return NULL;
+}
+
+/**
+ * @brief 启动后台日志线程
+ * 
+ * @param overflow 缓冲区满时的处理策略
+ * @return 0 成功，-1 失败
+ */
+int ALogStart(ALogOverflow overflow)
+{
+    if (atomic_load(&g_running)) {
+        return -1;
+    }
+    g_overflow = overflow;
+    atomic_store(&g_quit, false);
+    atomic_store(&g_running, true);
+    if (pthread_create(&g_thread, NULL, ALogThread, NULL) != 0) {
+        atomic_store(&g_running, false);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 停止后台日志线程
+ * 
+ * 关闭 g_running 后等待所有正在写入的线程完成（后台线程仍在取日志，缓冲区满而等待的写入也能完成），
+ * 然后通知后台线程写出剩余日志并退出
+ */
+void ALogStop(void)
+{
+    if (!atomic_exchange(&g_running, false)) {
+        return;
+    }
+    unsigned ringNum = atomic_load(&g_ringCount);
+    for (unsigned i = 0; i < ringNum; i++) {
+        while (atomic_load(&g_rings[i].busy)) {
+            sched_yield();
+        }
+    }
+
+    pthread_mutex_lock(&g_wakeMutex);
+    atomic_store(&g_quit, true);
+    atomic_store(&g_sleeping, false);
+    pthread_cond_signal(&g_wakeCond);
+    pthread_mutex_unlock(&g_wakeMutex);
+    pthread_join(g_thread, NULL);
+}
+
+/**
+ * @brief 获取因缓冲区满而丢弃的日志条数
+ * 
+ * @return 丢弃的日志条数
+ */
+uint64_t ALogDropped(void)
+{
+    return atomic_load(&g_dropped);
+}
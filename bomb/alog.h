@@ -0,0 +1,93 @@
+/**
+ * @file alog.h
+ * @brief 异步日志头文件
+ * 
+ * 状态处理函数中的打印只把格式串指针（即格式id）和原始参数拷贝到
+ * 当前线程私有的无锁环形缓冲区，由后台线程统一格式化并批量写出，
+ * 避免在运行到完成（RTC）步骤中执行格式化和 write 系统调用。
+ * 
+ * 使用限制：
+ * - 格式串必须是字符串字面量（或生命周期足够长的静态字符串）
+ * - 最多 ALOG_MAX_ARGS 个参数，参数按整数或指针保存
+ * - %s 参数同样只保存指针，必须指向静态字符串
+ */
+
+#ifndef ALOG_H
+#define ALOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define ALOG_MAX_ARGS 4         ///< 单条日志最多参数个数
+#define ALOG_RING_SIZE 256      ///< 每个线程环形缓冲区的记录数（2的幂）
+#define ALOG_MAX_THREADS 16     ///< 同时持有缓冲区的写日志线程数上限，线程退出时归还，超出的线程同步输出
+
+/**
+ * @brief 缓冲区满时的处理策略
+ */
+typedef enum {
+    ALOG_OVERFLOW_DROP,         ///< 丢弃新日志并计数
+    ALOG_OVERFLOW_BLOCK,        ///< 等待后台线程腾出空间
+} ALogOverflow;
+
+/**
+ * @brief 启动后台日志线程
+ * 
+ * 启动之前和停止之后，ALOG 直接在调用线程中同步格式化输出
+ * 
+ * @param overflow 缓冲区满时的处理策略
+ * @return 0 成功，-1 失败
+ */
+int ALogStart(ALogOverflow overflow);
+
+/**
+ * @brief 停止后台日志线程
+ * 
+ * 等待正在进行的写入完成，写出所有缓冲区中剩余的日志后返回
+ */
+void ALogStop(void);
+
+/**
+ * @brief 写一条日志（一般通过 ALOG 宏调用）
+ * 
+ * @param fmt printf 风格的格式串，必须是静态字符串
+ * @param argc 参数个数
+ * @param ... argc 个 intptr_t 类型的参数
+ */
+void ALogWrite(const char *fmt, int argc, ...);
+
+/**
+ * @brief 获取因缓冲区满（ALOG_OVERFLOW_DROP）而丢弃的日志条数
+ * 
+ * @return 丢弃的日志条数
+ */
+uint64_t ALogDropped(void);
+
+// 参数计数辅助宏
+#define ALOG_NARGS(...) ALOG_NARGS_(__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define ALOG_NARGS_(_1, _2, _3, _4, _5, N, ...) N
+#define ALOG_CAT(a, b) ALOG_CAT_(a, b)
+#define ALOG_CAT_(a, b) a##b
+
+#define ALOG_1(fmt) ALogWrite((fmt), 0)
+#define ALOG_2(fmt, a) ALogWrite((fmt), 1, (intptr_t)(a))
+#define ALOG_3(fmt, a, b) ALogWrite((fmt), 2, (intptr_t)(a), (intptr_t)(b))
+#define ALOG_4(fmt, a, b, c) ALogWrite((fmt), 3, (intptr_t)(a), (intptr_t)(b), (intptr_t)(c))
+#define ALOG_5(fmt, a, b, c, d) ALogWrite((fmt), 4, (intptr_t)(a), (intptr_t)(b), (intptr_t)(c), (intptr_t)(d))
+
+/**
+ * @brief 异步日志宏
+ * 
+ * 用法与 printf 相同，例如 ALOG("timeout[%d]\n", me->timeout);
+ */
+#define ALOG(...) ALOG_CAT(ALOG_, ALOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !ALOG_H
@@ -0,0 +1,59 @@
+/**
+ * @file barrier.c
+ * @brief 带串行回调的线程屏障实现文件
+ */
+
+#include "barrier.h"
+
+/**
+ * @brief 初始化屏障
+ *
+ * @param me 指向屏障的指针
+ * @param total 线程总数
+ */
+void BarrierCtor(Barrier *me, uint32_t total)
+{
+    pthread_mutex_init(&me->mutex, NULL);
+    pthread_cond_init(&me->cond, NULL);
+    me->count = 0;
+    me->total = total;
+    me->round = 0;
+}
+
+/**
+ * @brief 销毁屏障
+ *
+ * @param me 指向屏障的指针
+ */
+void BarrierDtor(Barrier *me)
+{
+    pthread_mutex_destroy(&me->mutex);
+    pthread_cond_destroy(&me->cond);
+}
+
+/**
+ * @brief 等待所有线程到达屏障
+ *
+ * @param me 指向屏障的指针
+ * @param serial 最后到达的线程在放行前执行的函数，可以为 NULL
+ * @param arg serial 的参数
+ */
+void BarrierWait(Barrier *me, void (*serial)(void *), void *arg)
+{
+    pthread_mutex_lock(&me->mutex);
+    uint32_t round = me->round;
+    if (++me->count == me->total) {
+        if (serial != NULL) {
+            serial(arg);
+        }
+        me->count = 0;
+        me->round++;
+        pthread_cond_broadcast(&me->cond);
+    } else {
+        // 轮次改变才放行，防止虚假唤醒
+        while (round == me->round) {
+            pthread_cond_wait(&me->cond, &me->mutex);
+        }
+    }
+    pthread_mutex_unlock(&me->mutex);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file barrier.h
+ * @brief 带串行回调的线程屏障头文件
+ *
+ * 与 pthread_barrier_t 相同地等待固定数量的线程，区别是最后到达的线程在放行其他线程之前
+ * 执行一个回调，回调的结果对所有线程可见，省去一次额外的屏障。
+ * 用于按阶段同步的并行工具（重放、状态空间检查）。
+ */
+
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 屏障
+ */
+typedef struct BarrierTag {
+    pthread_mutex_t mutex;      ///< 互斥锁
+    pthread_cond_t cond;        ///< 条件变量
+    uint32_t count;             ///< 本轮已到达的线程数
+    uint32_t total;             ///< 线程总数
+    uint32_t round;             ///< 轮次
+} Barrier;
+
+/**
+ * @brief 初始化屏障
+ *
+ * @param me 指向屏障的指针
+ * @param total 线程总数
+ */
+void BarrierCtor(Barrier *me, uint32_t total);
+
+/**
+ * @brief 销毁屏障
+ *
+ * @param me 指向屏障的指针
+ */
+void BarrierDtor(Barrier *me);
+
+/**
+ * @brief 等待所有线程到达屏障
+ *
+ * @param me 指向屏障的指针
+ * @param serial 最后到达的线程在放行前执行的函数，可以为 NULL
+ * @param arg serial 的参数
+ */
+void BarrierWait(Barrier *me, void (*serial)(void *), void *arg);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !BARRIER_H
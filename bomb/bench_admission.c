@@ -0,0 +1,275 @@
+/**
+ * @file bench_admission.c
+ * @brief 准入控制基准测试
+ *
+ * 一个生产者不停地灌事件，另外几个生产者按固定周期发命令事件，一个消费者逐个处理，
+ * 每个事件忙等固定时间模拟处理开销。分别在不限制、限速后拒绝、限速后合并、限速后降级四种配置下运行，
+ * 比较正常生产者的事件丢失数和排队延迟，并打印各生产者和信号的准入统计。
+ *
+ * 用法：bench_admission [durationMs] [floodRatePerSec]
+ */
+
+#include "admission.h"
+#include "timespec_util.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define GOOD_NUM 3              ///< 正常生产者数
+#define SOURCE_NUM (GOOD_NUM + 1) ///< 生产者数，最后一个是灌事件的生产者
+#define FLOOD_SOURCE GOOD_NUM   ///< 灌事件的生产者编号
+#define GOOD_PERIOD_NS 200000   ///< 正常生产者的发送周期
+#define EVENT_WORK_NS 5000      ///< 每个事件的忙等时间（纳秒）
+#define QUEUE_SIZE 256          ///< 主队列容量
+#define LOW_QUEUE_SIZE 1024     ///< 低优先级队列容量
+
+enum { BENCH_SIGNAL_CMD, BENCH_SIGNAL_FLOOD, BENCH_SIGNAL_MAX };
+
+/**
+ * @brief 运行配置
+ */
+typedef enum {
+    MODE_FIFO,                  ///< 不限制
+    MODE_REJECT,                ///< 灌事件的生产者限速，超出拒绝
+    MODE_COALESCE,              ///< 灌事件的生产者限速，超出合并到队列中的同类事件
+    MODE_DEPRIORITIZE,          ///< 灌事件的生产者限速，超出降级
+    MODE_MAX,
+} BenchMode;
+
+static const char *const modeNames[MODE_MAX] = {"fifo", "reject", "coalesce", "deprioritize"};
+
+/**
+ * @brief 基准事件
+ */
+typedef struct BenchItemTag {
+    uint8_t source;             ///< 生产者编号
+    uint8_t signal;             ///< 信号
+    uint64_t postNs;            ///< 投递时间
+} BenchItem;
+
+/**
+ * @brief 正常生产者参数
+ */
+typedef struct ProducerTag {
+    Admission *admission;       ///< 准入控制
+    uint8_t id;                 ///< 生产者编号
+    BenchItem *items;           ///< 预先分配的事件
+    uint32_t itemNum;           ///< 事件数
+    uint32_t dropped;           ///< 未能入队的事件数
+} Producer;
+
+static BenchItem doorbell;      ///< 低优先级队列的门铃
+static BenchItem floodItem = {FLOOD_SOURCE, BENCH_SIGNAL_FLOOD, 0}; ///< 灌入的事件内容都相同，共用一个
+static volatile bool floodStop; ///< 通知灌事件的生产者停止
+
+static void BusyWait(uint64_t ns)
+{
+    uint64_t end = TimespecNowNs() + ns;
+    while (TimespecNowNs() < end) {
+    }
+}
+
+static void SleepUntil(uint64_t ns)
+{
+    struct timespec ts = {(time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL)};
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+/**
+ * @brief 事件的信号，门铃不受限额约束
+ */
+static int BenchSignalOf(const void *item)
+{
+    if (item == &doorbell) {
+        return -1;
+    }
+    return ((const BenchItem *)item)->signal;
+}
+
+/**
+ * @brief 主队列的合并键：只合并灌入的事件
+ */
+static int BenchCoalesceKey(const void *item)
+{
+    if (item == &doorbell || ((const BenchItem *)item)->signal != BENCH_SIGNAL_FLOOD) {
+        return -1;
+    }
+    return 0;
+}
+
+static const uint8_t floodPolicies[1] = {QUEUE_COALESCE_DROP_DUP};
+static uint64_t floodKeySeqs[1];
+
+static void *GoodRun(void *arg)
+{
+    Producer *p = (Producer *)arg;
+    uint64_t next = TimespecNowNs();
+    for (uint32_t i = 0; i < p->itemNum; i++) {
+        next += GOOD_PERIOD_NS;
+        SleepUntil(next);
+        BenchItem *item = &p->items[i];
+        item->source = p->id;
+        item->signal = BENCH_SIGNAL_CMD;
+        item->postNs = TimespecNowNs();
+        if (AdmissionEnqueue(p->admission, p->id, item) != ADMISSION_ADMITTED) {
+            __atomic_add_fetch(&p->dropped, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+static void *FloodRun(void *arg)
+{
+    Admission *admission = (Admission *)arg;
+    while (!floodStop) {
+        AdmissionEnqueue(admission, FLOOD_SOURCE, &floodItem);
+    }
+    return NULL;
+}
+
+static int CompareU64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief 运行一种配置
+ *
+ * @param mode 配置
+ * @param durationMs 运行时间（毫秒）
+ * @param floodRate 灌事件的生产者的限速（每秒）
+ */
+static void RunOnce(BenchMode mode, uint32_t durationMs, uint32_t floodRate)
+{
+    static void *buffer[QUEUE_SIZE];
+    static void *lowBuffer[LOW_QUEUE_SIZE];
+    SyncQueue queue;
+    SyncQueue lowQueue;
+    Admission admission;
+    AdmissionBucket buckets[SOURCE_NUM];
+    AdmissionQuota quotas[BENCH_SIGNAL_MAX];
+
+    QueueCtor(&queue, buffer, QUEUE_SIZE);
+    QueueCtor(&lowQueue, lowBuffer, LOW_QUEUE_SIZE);
+    AdmissionCtor(&admission, &queue, BenchSignalOf, buckets, SOURCE_NUM, quotas, BENCH_SIGNAL_MAX);
+    switch (mode) {
+    case MODE_REJECT:
+        AdmissionSetRate(&admission, FLOOD_SOURCE, floodRate, 32, ADMISSION_REJECT);
+        break;
+    case MODE_COALESCE:
+        QueueSetCoalesce(&queue, BenchCoalesceKey, floodPolicies, 1, NULL, floodKeySeqs);
+        AdmissionSetRate(&admission, FLOOD_SOURCE, floodRate, 32, ADMISSION_COALESCE);
+        break;
+    case MODE_DEPRIORITIZE:
+        AdmissionSetLowQueue(&admission, &lowQueue, &doorbell);
+        AdmissionSetRate(&admission, FLOOD_SOURCE, floodRate, 32, ADMISSION_DEPRIORITIZE);
+        break;
+    default:
+        break;
+    }
+
+    uint32_t perGood = (uint32_t)((uint64_t)durationMs * 1000000ULL / GOOD_PERIOD_NS);
+    Producer producers[GOOD_NUM];
+    pthread_t goodThreads[GOOD_NUM];
+    pthread_t floodThread;
+    for (uint8_t i = 0; i < GOOD_NUM; i++) {
+        producers[i].admission = &admission;
+        producers[i].id = i;
+        producers[i].items = (BenchItem *)calloc(perGood, sizeof(BenchItem));
+        producers[i].itemNum = perGood;
+        producers[i].dropped = 0;
+    }
+    uint64_t *latency = (uint64_t *)calloc((size_t)perGood * GOOD_NUM, sizeof(uint64_t));
+    uint32_t latencyNum = 0;
+    uint64_t floodHandled = 0;
+
+    floodStop = false;
+    pthread_create(&floodThread, NULL, FloodRun, &admission);
+    for (uint8_t i = 0; i < GOOD_NUM; i++) {
+        pthread_create(&goodThreads[i], NULL, GoodRun, &producers[i]);
+    }
+
+    // 消费者在本线程运行，正常生产者的事件都处理或丢弃后停止灌事件，再把队列取空
+    for (;;) {
+        if (!floodStop) {
+            uint32_t dropped = 0;
+            for (uint8_t i = 0; i < GOOD_NUM; i++) {
+                dropped += __atomic_load_n(&producers[i].dropped, __ATOMIC_RELAXED);
+            }
+            if (latencyNum + dropped == perGood * GOOD_NUM) {
+                floodStop = true;
+            }
+        }
+        bool isTimeout = false;
+        BenchItem *item = (BenchItem *)AdmissionDequeueWithTimeout(&admission, 10, &isTimeout);
+        if (item == NULL) {
+            if (floodStop) {
+                break;
+            }
+            continue;
+        }
+        BusyWait(EVENT_WORK_NS);
+        if (item->signal == BENCH_SIGNAL_CMD) {
+            latency[latencyNum++] = TimespecNowNs() - item->postNs;
+        } else {
+            floodHandled++;
+        }
+    }
+
+    for (uint8_t i = 0; i < GOOD_NUM; i++) {
+        pthread_join(goodThreads[i], NULL);
+    }
+    pthread_join(floodThread, NULL);
+
+    uint32_t dropped = 0;
+    for (uint8_t i = 0; i < GOOD_NUM; i++) {
+        dropped += producers[i].dropped;
+    }
+    qsort(latency, latencyNum, sizeof(uint64_t), CompareU64);
+    uint64_t p50 = latencyNum != 0 ? latency[latencyNum / 2] : 0;
+    uint64_t p99 = latencyNum != 0 ? latency[(uint64_t)latencyNum * 99 / 100] : 0;
+    uint64_t max = latencyNum != 0 ? latency[latencyNum - 1] : 0;
+    printf("%-12s good %6u/%-6u dropped %5u  p50 %8.1f us  p99 %8.1f us  max %8.1f us  flood handled %8llu\n",
+           modeNames[mode], latencyNum, perGood * GOOD_NUM, dropped, (double)p50 / 1e3, (double)p99 / 1e3,
+           (double)max / 1e3, (unsigned long long)floodHandled);
+    AdmissionReport(&admission, stdout);
+
+    for (uint8_t i = 0; i < GOOD_NUM; i++) {
+        free(producers[i].items);
+    }
+    free(latency);
+}
+
+/**
+ * @brief 主函数
+ *
+ * @param argc 参数个数
+ * @param argv 参数列表
+ * @return 程序退出码
+ */
+int main(int argc, char *argv[])
+{
+    uint32_t durationMs = 500;
+    uint32_t floodRate = 20000;
+    if (argc > 1) {
+        durationMs = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        floodRate = (uint32_t)strtoul(argv[2], NULL, 0);
+    }
+    if (durationMs == 0 || floodRate == 0) {
+        fprintf(stderr, "usage: %s [durationMs] [floodRatePerSec]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%u good sources every %u us, 1 flooding source limited to %u/s, %u ns/event, %u ms\n", GOOD_NUM,
+           GOOD_PERIOD_NS / 1000, floodRate, EVENT_WORK_NS, durationMs);
+    for (int mode = 0; mode < MODE_MAX; mode++) {
+        RunOnce((BenchMode)mode, durationMs, floodRate);
+    }
+    return 0;
+}
@@ -0,0 +1,287 @@
+// 活动对象策略组合基准测试
+//
+// 同一个生产者事件序列分别投递给 {StateTable 状态表引擎, switch 引擎} × {SyncQueue, 无锁队列}
+// 组成的四种活动对象，业务代码相同，只换模板参数；统计吞吐量并校验四种组合的最终状态一致。
+// 滴答也作为普通信号由生产者投递（SetTick(0) 关闭时间源的滴答），保证结果可重复。
+//
+// 用法：bench_ao [events]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "active_object.hpp"
+
+constexpr uint8_t TIMEOUT_INITIAL = 15U;
+constexpr uint8_t TIMEOUT_MIN = 10U;
+constexpr uint8_t TIMEOUT_MAX = 120U;
+constexpr uint8_t PASSWD = 0xD;
+constexpr uint32_t QUEUE_SIZE = 1024;
+
+enum AoSignal : uint8_t
+{
+    AO_UP = 0,
+    AO_DOWN,
+    AO_ARM,
+    AO_TICK,
+    AO_SIGNAL_MAX
+};
+
+// 最终状态快照
+struct Snapshot
+{
+    uint8_t state;
+    uint8_t timeout;
+    uint8_t curInput;
+    uint8_t fineTime;
+
+    bool operator==(const Snapshot &o) const
+    {
+        return state == o.state && timeout == o.timeout && curInput == o.curInput && fineTime == o.fineTime;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// 引擎1：StateTable 状态表，经 StateTableEngine 适配
+// ---------------------------------------------------------------------------
+struct TableBomb
+{
+    StateTable super;
+    uint8_t timeout;
+    uint8_t passwd;
+    uint8_t curInput;
+    uint8_t fineTime;
+};
+
+enum { TABLE_SETTING, TABLE_TIMING, TABLE_STATE_MAX };
+
+static void TableSettingUp(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->timeout < TIMEOUT_MAX) {
+        me->timeout++;
+    }
+}
+
+static void TableSettingDown(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->timeout > TIMEOUT_MIN) {
+        me->timeout--;
+    }
+}
+
+static void TableSettingArm(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = 0;
+    me->fineTime = 0;
+    TRAN(TABLE_TIMING);
+}
+
+static void TableTimingUp(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = (uint8_t)((me->curInput << 1) | 1);
+}
+
+static void TableTimingDown(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = (uint8_t)(me->curInput << 1);
+}
+
+static void TableTimingArm(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->curInput == me->passwd) {
+        me->curInput = 0;
+        TRAN(TABLE_SETTING);
+    }
+}
+
+static void TableTimingTick(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (++me->fineTime == 10) {
+        me->fineTime = 0;
+        if (--me->timeout == 0) {
+            me->timeout = TIMEOUT_INITIAL;
+            TRAN(TABLE_SETTING);
+        }
+    }
+}
+
+static Tran tableCells[TABLE_STATE_MAX][AO_SIGNAL_MAX] = {
+    {(Tran)TableSettingUp, (Tran)TableSettingDown, (Tran)TableSettingArm, StateTableEmpty},
+    {(Tran)TableTimingUp, (Tran)TableTimingDown, (Tran)TableTimingArm, (Tran)TableTimingTick},
+};
+
+static void TableInitial(StateTable *me)
+{
+    TableBomb *bomb = (TableBomb *)me;
+    bomb->timeout = TIMEOUT_INITIAL;
+    bomb->passwd = PASSWD;
+    bomb->curInput = 0;
+    bomb->fineTime = 0;
+    TRAN(TABLE_SETTING);
+}
+
+class TableBombEngine : public StateTableEngine<TableBomb, AO_TICK>
+{
+public:
+    static constexpr const char *NAME = "StateTable";
+
+    TableBombEngine() : StateTableEngine(&bomb_)
+    {
+        StateTableCtor(&bomb_.super, &tableCells[0][0], TABLE_STATE_MAX, AO_SIGNAL_MAX, TableInitial);
+    }
+
+    Snapshot Snap() const
+    {
+        return {bomb_.super.curState, bomb_.timeout, bomb_.curInput, bomb_.fineTime};
+    }
+
+private:
+    TableBomb bomb_;
+};
+
+// ---------------------------------------------------------------------------
+// 引擎2：switch 分发，直接实现引擎接口
+// ---------------------------------------------------------------------------
+class SwitchBombEngine
+{
+public:
+    static constexpr const char *NAME = "switch";
+
+    void Init()
+    {
+        timing_ = false;
+        timeout_ = TIMEOUT_INITIAL;
+        curInput_ = 0;
+        fineTime_ = 0;
+    }
+
+    void Dispatch(uintptr_t signal)
+    {
+        switch (signal) {
+        case AO_UP:
+            if (timing_) {
+                curInput_ = (uint8_t)((curInput_ << 1) | 1);
+            } else if (timeout_ < TIMEOUT_MAX) {
+                timeout_++;
+            }
+            break;
+        case AO_DOWN:
+            if (timing_) {
+                curInput_ = (uint8_t)(curInput_ << 1);
+            } else if (timeout_ > TIMEOUT_MIN) {
+                timeout_--;
+            }
+            break;
+        case AO_ARM:
+            if (!timing_) {
+                curInput_ = 0;
+                fineTime_ = 0;
+                timing_ = true;
+            } else if (curInput_ == PASSWD) {
+                curInput_ = 0;
+                timing_ = false;
+            }
+            break;
+        case AO_TICK:
+            Tick();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void Tick()
+    {
+        if (timing_ && ++fineTime_ == 10) {
+            fineTime_ = 0;
+            if (--timeout_ == 0) {
+                timeout_ = TIMEOUT_INITIAL;
+                timing_ = false;
+            }
+        }
+    }
+
+    bool NeedTick() const
+    {
+        return timing_;
+    }
+
+    Snapshot Snap() const
+    {
+        return {(uint8_t)(timing_ ? 1 : 0), timeout_, curInput_, fineTime_};
+    }
+
+private:
+    bool timing_ = false;
+    uint8_t timeout_ = TIMEOUT_INITIAL;
+    uint8_t curInput_ = 0;
+    uint8_t fineTime_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// 测量：一个生产者线程投递全部事件，活动对象线程分发
+// ---------------------------------------------------------------------------
+template <typename Queue>
+struct QueueName;
+
+template <>
+struct QueueName<SyncQueuePolicy<QUEUE_SIZE>>
+{
+    static constexpr const char *NAME = "SyncQueue";
+};
+
+template <>
+struct QueueName<LockFreeQueuePolicy<QUEUE_SIZE>>
+{
+    static constexpr const char *NAME = "lock-free";
+};
+
+template <typename Engine, typename Queue>
+static Snapshot Measure(const std::vector<uint8_t> &seq)
+{
+    ActiveObject<Engine, Queue, RealTimer> ao;
+    ao.SetTick(0);
+    auto start = std::chrono::steady_clock::now();
+    std::thread t(&ActiveObject<Engine, Queue, RealTimer>::Run, std::ref(ao));
+    for (uint8_t s : seq) {
+        while (!ao.Post(s)) {
+            std::this_thread::yield();
+        }
+    }
+    while (!ao.Stop()) {
+        std::this_thread::yield();
+    }
+    t.join();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("%-10s + %-9s: %7.2f Mevents/s\n", Engine::NAME, QueueName<Queue>::NAME, seq.size() * 1e3 / ns);
+    return ao.GetEngine().Snap();
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t events = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 0) : 5000000U;
+    std::vector<uint8_t> seq(events);
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < events; i++) {
+        seed = seed * 1103515245U + 12345U;
+        uint32_t pick = (seed >> 16) % 16;
+        seq[i] = pick < 10 ? (uint8_t)AO_TICK : (uint8_t)(pick % 3);
+    }
+
+    Snapshot a = Measure<TableBombEngine, SyncQueuePolicy<QUEUE_SIZE>>(seq);
+    Snapshot b = Measure<TableBombEngine, LockFreeQueuePolicy<QUEUE_SIZE>>(seq);
+    Snapshot c = Measure<SwitchBombEngine, SyncQueuePolicy<QUEUE_SIZE>>(seq);
+    Snapshot d = Measure<SwitchBombEngine, LockFreeQueuePolicy<QUEUE_SIZE>>(seq);
+    bool ok = a == b && a == c && a == d;
+    printf("check %s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file bench_decode.c
+ * @brief 批量按键解码基准测试
+ *
+ * 生成一段随机字节流（按键字节和无关字节混合），分别用演示程序中的逐字节 switch、
+ * 标量查表、SSSE3 和 AVX2 解码，比较吞吐量并校验输出一致；
+ * 再比较逐个 QueueEnqueue 和解码后 QueueEnqueueBatch 批量入队的开销。
+ *
+ * 用法：bench_decode [megabytes] [keyPercent]
+ */
+
+#include "key_decoder.h"
+#include "sync_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS 5          ///< 每种实现的重复次数
+#define BATCH_BYTES 4096        ///< 入队测试每批的输入字节数
+
+/**
+ * @brief 信号编号，与演示程序的按键对应
+ */
+enum {
+    KEY_SIGNAL_UP,              ///< 'u'
+    KEY_SIGNAL_DOWN,            ///< 'd'
+    KEY_SIGNAL_ARM,             ///< 'a'
+    KEY_SIGNAL_EXIT,            ///< ESC
+};
+
+static double NowSec(void)
+{
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief 演示程序 main() 中的写法：每个字节一个 switch
+ */
+__attribute__((noinline)) static size_t DecodeSwitch(const uint8_t *in, size_t n, uint8_t *out)
+{
+    size_t o = 0;
+    for (size_t i = 0; i < n; i++) {
+        switch (in[i]) {
+        case 'u':
+            out[o++] = KEY_SIGNAL_UP;
+            break;
+        case 'd':
+            out[o++] = KEY_SIGNAL_DOWN;
+            break;
+        case 'a':
+            out[o++] = KEY_SIGNAL_ARM;
+            break;
+        case '\33':
+            out[o++] = KEY_SIGNAL_EXIT;
+            break;
+        default:
+            break;
+        }
+    }
+    return o;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = (argc > 1 ? strtoul(argv[1], NULL, 0) : 64) << 20;
+    uint32_t keyPercent = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 10;
+    uint8_t *in = malloc(n);
+    uint8_t *expect = malloc(n + KEY_DECODER_SLACK);
+    uint8_t *out = malloc(n + KEY_DECODER_SLACK);
+    if (in == NULL || expect == NULL || out == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    static const uint8_t keys[] = {'u', 'd', 'a', '\33'};
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245U + 12345U;
+        uint32_t r = seed >> 8;
+        in[i] = r % 100 < keyPercent ? keys[(r >> 8) & 3] : (uint8_t)(r >> 12);
+    }
+
+    KeyDecoder decoder;
+    KeyDecoderCtor(&decoder);
+    KeyDecoderMap(&decoder, 'u', KEY_SIGNAL_UP);
+    KeyDecoderMap(&decoder, 'd', KEY_SIGNAL_DOWN);
+    KeyDecoderMap(&decoder, 'a', KEY_SIGNAL_ARM);
+    KeyDecoderMap(&decoder, '\33', KEY_SIGNAL_EXIT);
+    KeyDecoderIsa best = decoder.best;
+
+    // 基线
+    size_t expectNum = 0;
+    double start = NowSec();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        expectNum = DecodeSwitch(in, n, expect);
+    }
+    double sec = (NowSec() - start) / BENCH_ROUNDS;
+    printf("input %zu MB, %u%% keys, %zu signals\n", n >> 20, keyPercent, expectNum);
+    printf("switch: %7.2f GB/s\n", (double)n / sec / 1e9);
+
+    static const char *const names[] = {"scalar", "SSSE3", "AVX2"};
+    bool ok = true;
+    for (int isa = KEY_DECODER_SCALAR; isa <= KEY_DECODER_AVX2; isa++) {
+        if (KeyDecoderUse(&decoder, (KeyDecoderIsa)isa) != (KeyDecoderIsa)isa) {
+            printf("%-6s: not supported\n", names[isa]);
+            continue;
+        }
+        size_t num = 0;
+        start = NowSec();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            num = KeyDecoderRun(&decoder, in, n, out);
+        }
+        sec = (NowSec() - start) / BENCH_ROUNDS;
+        bool same = num == expectNum && memcmp(out, expect, num) == 0;
+        ok = ok && same;
+        printf("%-6s: %7.2f GB/s %s\n", names[isa], (double)n / sec / 1e9, same ? "" : "MISMATCH");
+    }
+    KeyDecoderUse(&decoder, best);
+
+    // 入队：逐个入队和批量入队，消费端每批清空一次队列
+    static void *buffer[BATCH_BYTES];
+    static void *items[BATCH_BYTES + KEY_DECODER_SLACK];
+    static uint8_t signals[BATCH_BYTES + KEY_DECODER_SLACK];
+    SyncQueue queue;
+    QueueCtor(&queue, buffer, BATCH_BYTES);
+    void *item = NULL;
+    size_t limit = n < (16U << 20) ? n : (16U << 20);
+
+    start = NowSec();
+    for (size_t i = 0; i + BATCH_BYTES <= limit; i += BATCH_BYTES) {
+        size_t num = DecodeSwitch(in + i, BATCH_BYTES, signals);
+        for (size_t k = 0; k < num; k++) {
+            QueueEnqueue(&queue, (void *)(uintptr_t)signals[k]);
+        }
+        while (QueueTryDequeue(&queue, &item)) {
+        }
+    }
+    double oneSec = NowSec() - start;
+
+    start = NowSec();
+    for (size_t i = 0; i + BATCH_BYTES <= limit; i += BATCH_BYTES) {
+        size_t num = KeyDecoderRun(&decoder, in + i, BATCH_BYTES, signals);
+        for (size_t k = 0; k < num; k++) {
+            items[k] = (void *)(uintptr_t)signals[k];
+        }
+        QueueEnqueueBatch(&queue, items, (uint32_t)num);
+        while (QueueTryDequeue(&queue, &item)) {
+        }
+    }
+    double batchSec = NowSec() - start;
+    printf("decode+enqueue %zu MB: per-key %6.2f GB/s, batch %6.2f GB/s\n", limit >> 20,
+           (double)limit / oneSec / 1e9, (double)limit / batchSec / 1e9);
+    printf("check %s\n", ok ? "OK" : "MISMATCH");
+
+    free(in);
+    free(expect);
+    free(out);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+// 处理函数表基准测试
+//
+// 比较 Bomb3 原来的 std::array<std::variant<std::function<void()>, std::function<void(uint8_t)>>>
+// 处理函数表和 Delegate<void(uint8_t)> 处理函数表的分发开销。
+//
+// 用法：bench_delegate [calls]
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <variant>
+#include "delegate.hpp"
+
+constexpr uint8_t HANDLER_NUM = 4;
+constexpr uint8_t HANDLER_TICK = 3;
+
+// 被调用的对象，处理函数只做计数，避免被优化掉
+class Target
+{
+public:
+    void OnUp()
+    {
+        up_++;
+    }
+    void OnDown()
+    {
+        down_++;
+    }
+    void OnArm()
+    {
+        arm_++;
+    }
+    void OnTick(uint8_t fineTime)
+    {
+        tick_ += fineTime;
+    }
+    uint64_t Sum() const
+    {
+        return up_ + down_ + arm_ + tick_;
+    }
+
+private:
+    uint64_t up_ = 0;
+    uint64_t down_ = 0;
+    uint64_t arm_ = 0;
+    uint64_t tick_ = 0;
+};
+
+using VariantFunction = std::variant<std::function<void()>, std::function<void(uint8_t)>>;
+using DelegateFunction = Delegate<void(uint8_t)>;
+
+// 原有方式：std::get_if 判断类型后经 std::function 间接调用
+__attribute__((noinline)) static void RunVariant(std::array<VariantFunction, HANDLER_NUM> &table,
+                                                 const uint8_t *seq, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t h = seq[i];
+        if (h == HANDLER_TICK) {
+            if (auto func = std::get_if<std::function<void(uint8_t)>>(&table[h])) {
+                (*func)((uint8_t)(i % 10));
+            }
+        } else if (auto func = std::get_if<std::function<void()>>(&table[h])) {
+            (*func)();
+        }
+    }
+}
+
+// 委托方式：统一签名，一次间接调用
+__attribute__((noinline)) static void RunDelegate(const std::array<DelegateFunction, HANDLER_NUM> &table,
+                                                  const uint8_t *seq, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        table[seq[i]]((uint8_t)(i % 10));
+    }
+}
+
+template <typename F>
+static double Measure(F &&f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t calls = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 0) : 50000000U;
+    uint8_t *seq = new uint8_t[calls];
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < calls; i++) {
+        seed = seed * 1103515245U + 12345U;
+        seq[i] = (uint8_t)((seed >> 16) % HANDLER_NUM);
+    }
+
+    Target a;
+    std::array<VariantFunction, HANDLER_NUM> variantTable;
+    variantTable[0] = std::function<void()>([&a] { a.OnUp(); });
+    variantTable[1] = std::function<void()>([&a] { a.OnDown(); });
+    variantTable[2] = std::function<void()>([&a] { a.OnArm(); });
+    variantTable[3] = std::function<void(uint8_t)>([&a](uint8_t fineTime) { a.OnTick(fineTime); });
+
+    Target b;
+    const std::array<DelegateFunction, HANDLER_NUM> delegateTable = {
+        DelegateFunction::Bind<&Target::OnUp>(&b),
+        DelegateFunction::Bind<&Target::OnDown>(&b),
+        DelegateFunction::Bind<&Target::OnArm>(&b),
+        DelegateFunction::Bind<&Target::OnTick>(&b),
+    };
+
+    // 预热
+    RunVariant(variantTable, seq, calls / 10);
+    RunDelegate(delegateTable, seq, calls / 10);
+
+    double variantNs = Measure([&] { RunVariant(variantTable, seq, calls); });
+    double delegateNs = Measure([&] { RunDelegate(delegateTable, seq, calls); });
+
+    printf("entry size: variant<function> %zu bytes, Delegate %zu bytes\n", sizeof(VariantFunction),
+           sizeof(DelegateFunction));
+    printf("variant<function> table: %6.2f ns/call\n", variantNs / calls);
+    printf("Delegate table:          %6.2f ns/call\n", delegateNs / calls);
+    printf("check %s\n", a.Sum() == b.Sum() ? "OK" : "MISMATCH");
+
+    delete[] seq;
+    return a.Sum() == b.Sum() ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file bench_jitter.c
+ * @brief 周期滴答抖动基准测试
+ *
+ * 分发线程按固定周期等待绝对截止时间（QueueDequeueUntil），统计每次滴答相对截止时间的
+ * 延迟（迟到时间）；另一个线程随机向队列投递事件，模拟按键打断等待。
+ * 可以长时间运行（小时级），每隔一段时间输出一次阶段统计，结束时输出最坏迟到时间和分布。
+ *
+ * 用法：bench_jitter [seconds] [periodUs] [rt]
+ *   rt 为 1 时使用实时配置（锁定内存、SCHED_FIFO、忙等），需要相应权限
+ */
+
+#include "rt_profile.h"
+#include "timespec_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#define REPORT_INTERVAL_SEC 10  ///< 阶段统计间隔（秒）
+#define HIST_BUCKETS 24         ///< 迟到时间直方图桶数，第 i 桶为 [2^i, 2^(i+1)) 微秒
+
+/**
+ * @brief 迟到时间统计
+ */
+typedef struct JitterStatsTag {
+    uint64_t ticks;             ///< 滴答数
+    uint64_t sumNs;             ///< 迟到时间总和
+    uint64_t maxNs;             ///< 最坏迟到时间
+    uint64_t hist[HIST_BUCKETS + 1]; ///< 直方图，hist[0] 为小于1微秒
+} JitterStats;
+
+static SyncQueue queue;
+static void *queueBuffer[64];
+static uint8_t running = 1;
+static uint64_t events;
+
+static struct timespec ToTimespec(uint64_t ns)
+{
+    struct timespec ts = {(time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL)};
+    return ts;
+}
+
+static void StatsAdd(JitterStats *s, uint64_t lateNs)
+{
+    s->ticks++;
+    s->sumNs += lateNs;
+    if (lateNs > s->maxNs) {
+        s->maxNs = lateNs;
+    }
+    uint64_t us = lateNs / 1000;
+    int bucket = 0;
+    while (us != 0 && bucket < HIST_BUCKETS) {
+        us >>= 1;
+        bucket++;
+    }
+    s->hist[bucket]++;
+}
+
+static void StatsPrint(const char *name, const JitterStats *s)
+{
+    printf("%s ticks %llu  avg %.1f us  max %.1f us\n", name, (unsigned long long)s->ticks,
+           s->ticks == 0 ? 0.0 : (double)s->sumNs / (double)s->ticks / 1000.0, (double)s->maxNs / 1000.0);
+}
+
+/**
+ * @brief 输入线程：随机间隔投递事件
+ */
+static void *InputThread(void *arg)
+{
+    (void)arg;
+    uint32_t seed = 2463534242U;
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        struct timespec ts = {0, (long)(1000000 + seed % 10000000)};
+        nanosleep(&ts, NULL);
+        QueueEnqueue(&queue, (void *)(uintptr_t)1);
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t seconds = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 10U;
+    uint32_t periodUs = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 1000U;
+    int rt = argc > 3 ? atoi(argv[3]) : 0;
+    if (seconds == 0 || periodUs == 0) {
+        fprintf(stderr, "usage: %s [seconds] [periodUs] [rt]\n", argv[0]);
+        return 1;
+    }
+
+    QueueCtor(&queue, queueBuffer, 64);
+    static JitterStats total;
+    static JitterStats window;
+    RtProfile profile = RT_PROFILE_DEFAULT;
+    if (rt) {
+        // 统计数据和队列在启动阶段锁定
+        if (RtProcessInit() != 0 || RtQueueInit(&queue, &profile) != 0 || RtLock(&total, sizeof(total)) != 0 ||
+            RtLock(&window, sizeof(window)) != 0) {
+            perror("rt memory lock");
+        }
+        if (RtThreadInit(&profile) != 0) {
+            perror("rt thread init");
+        }
+    }
+    printf("period %u us, %u s, profile %s\n", periodUs, seconds, rt ? "real-time" : "default");
+
+    // 主线程可能已经是 SCHED_FIFO，输入线程显式使用普通调度，不继承实时优先级
+    pthread_t input;
+    pthread_attr_t attr;
+    struct sched_param param = {0};
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &param);
+    int err = pthread_create(&input, &attr, InputThread, NULL);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        fprintf(stderr, "create input thread failed: %d\n", err);
+        return 1;
+    }
+
+    uint64_t periodNs = (uint64_t)periodUs * 1000;
+    uint64_t start = TimespecNowNs();
+    uint64_t end = start + (uint64_t)seconds * 1000000000ULL;
+    uint64_t nextReport = start + REPORT_INTERVAL_SEC * 1000000000ULL;
+    uint64_t deadline = start + periodNs;
+    while (deadline < end) {
+        bool isTimeout = false;
+        struct timespec ts = ToTimespec(deadline);
+        void *item = QueueDequeueUntil(&queue, &ts, &isTimeout);
+        if (!isTimeout) {
+            // 事件打断等待，截止时间不变
+            if (item != NULL) {
+                events++;
+            }
+            continue;
+        }
+
+        uint64_t now = TimespecNowNs();
+        StatsAdd(&total, now - deadline);
+        StatsAdd(&window, now - deadline);
+        deadline += periodNs;
+
+        if (now >= nextReport) {
+            StatsPrint("  window", &window);
+            fflush(stdout);
+            window = (JitterStats){0};
+            nextReport += REPORT_INTERVAL_SEC * 1000000000ULL;
+        }
+    }
+
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+    pthread_join(input, NULL);
+
+    StatsPrint("total ", &total);
+    printf("events %llu\nlateness histogram:\n", (unsigned long long)events);
+    for (int i = 0; i <= HIST_BUCKETS; i++) {
+        if (total.hist[i] != 0) {
+            printf("  %s%8llu us  %llu\n", i == 0 ? "<" : ">=", i == 0 ? 1ULL : 1ULL << (i - 1),
+                   (unsigned long long)total.hist[i]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,741 @@
+// 端到端流水线基准测试
+//
+// P 个生产者线程 -> 队列 -> C 个状态机线程 -> 分发，覆盖所有队列实现（固定容量、邮箱、分段弹性队列）和三种分发引擎
+// （StateTable 状态表、QFsm 状态函数、Bomb3 风格虚函数），统计吞吐量、排队延迟分位数、
+// 上下文切换次数以及每百万事件的CPU时间，并校验三种引擎在同一事件序列下的最终状态一致。
+//
+// 用法：bench_pipeline [producers] [consumers] [eventsPerProducer]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sched.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+#ifdef __linux__
+#include <sys/resource.h>
+#endif // __linux__
+#include "statetbl.h"
+#include "qfsm.h"
+#include "sync_queue.h"
+#include "mailbox.h"
+#include "seg_queue.h"
+#include "timespec_util.h"
+
+// 与演示程序相同的炸弹参数
+constexpr uint8_t TIMEOUT_INITIAL = 15U;
+constexpr uint8_t TIMEOUT_MIN = 10U;
+constexpr uint8_t TIMEOUT_MAX = 120U;
+constexpr uint8_t PASSWD = 0xD;
+// 每个状态机线程的队列容量
+constexpr uint32_t QUEUE_SIZE = 1024;
+
+// 流水线中的信号
+enum PipeSignal : uint8_t
+{
+    PIPE_UP = 0,
+    PIPE_DOWN,
+    PIPE_ARM,
+    PIPE_TICK,
+    PIPE_SIGNAL_MAX
+};
+
+// 队列中传递的事件，携带入队时间用于统计延迟
+struct PipeEvent
+{
+    MailboxNode link;   // 邮箱模式下的链表节点
+    uint8_t signal;
+    uint64_t enqueueNs;
+};
+
+// 状态机最终状态快照，用于比较不同引擎的结果
+struct Snapshot
+{
+    uint8_t state;     // 0 设置状态，1 计时状态
+    uint8_t timeout;
+    uint8_t curInput;
+    uint8_t fineTime;
+
+    bool operator==(const Snapshot &o) const
+    {
+        return state == o.state && timeout == o.timeout && curInput == o.curInput && fineTime == o.fineTime;
+    }
+};
+
+static uint64_t CpuNs()
+{
+    struct timespec ts = {0, 0};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 进程的上下文切换次数（自愿+非自愿），不支持的平台返回-1
+static int64_t ContextSwitches()
+{
+#ifdef __linux__
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_nvcsw + ru.ru_nivcsw;
+#else
+    return -1;
+#endif // __linux__
+}
+
+// ---------------------------------------------------------------------------
+// 引擎1：StateTable 状态表
+// ---------------------------------------------------------------------------
+struct TableBomb
+{
+    StateTable super;
+    uint8_t timeout;
+    uint8_t passwd;
+    uint8_t curInput;
+    uint8_t fineTime;
+};
+
+enum { TABLE_SETTING, TABLE_TIMING, TABLE_STATE_MAX };
+
+static void TableSettingUp(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->timeout < TIMEOUT_MAX) {
+        me->timeout++;
+    }
+}
+
+static void TableSettingDown(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->timeout > TIMEOUT_MIN) {
+        me->timeout--;
+    }
+}
+
+static void TableSettingArm(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = 0;
+    me->fineTime = 0;
+    TRAN(TABLE_TIMING);
+}
+
+static void TableTimingUp(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = (uint8_t)((me->curInput << 1) | 1);
+}
+
+static void TableTimingDown(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = (uint8_t)(me->curInput << 1);
+}
+
+static void TableTimingArm(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->curInput == me->passwd) {
+        me->curInput = 0;
+        TRAN(TABLE_SETTING);
+    }
+}
+
+static void TableTimingTick(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (++me->fineTime == 10) {
+        me->fineTime = 0;
+        if (--me->timeout == 0) {
+            me->timeout = TIMEOUT_INITIAL;
+            TRAN(TABLE_SETTING);
+        }
+    }
+}
+
+static Tran tableCells[TABLE_STATE_MAX][PIPE_SIGNAL_MAX] = {
+    {(Tran)TableSettingUp, (Tran)TableSettingDown, (Tran)TableSettingArm, StateTableEmpty},
+    {(Tran)TableTimingUp, (Tran)TableTimingDown, (Tran)TableTimingArm, (Tran)TableTimingTick},
+};
+
+static void TableInitial(StateTable *me)
+{
+    TableBomb *bomb = (TableBomb *)me;
+    bomb->timeout = TIMEOUT_INITIAL;
+    bomb->passwd = PASSWD;
+    bomb->curInput = 0;
+    bomb->fineTime = 0;
+    TRAN(TABLE_SETTING);
+}
+
+class TableEngine
+{
+public:
+    static constexpr const char *NAME = "StateTable";
+
+    TableEngine()
+    {
+        StateTableCtor(&bomb_.super, &tableCells[0][0], TABLE_STATE_MAX, PIPE_SIGNAL_MAX, TableInitial);
+        StateTableInit(&bomb_.super);
+    }
+
+    void Dispatch(uint8_t signal)
+    {
+        const Event e = {signal};
+        StateTableDispatch(&bomb_.super, &e);
+    }
+
+    Snapshot Snap() const
+    {
+        return {bomb_.super.curState, bomb_.timeout, bomb_.curInput, bomb_.fineTime};
+    }
+
+private:
+    TableBomb bomb_;
+};
+
+// ---------------------------------------------------------------------------
+// 引擎2：QFsm 状态处理函数
+// ---------------------------------------------------------------------------
+struct QBomb
+{
+    QFsm super;
+    uint8_t timeout;
+    uint8_t passwd;
+    uint8_t curInput;
+    uint8_t fineTime;
+};
+
+static QState QBombTiming(QBomb *me, QEvent *e);
+
+static QState QBombSetting(QBomb *me, QEvent *e)
+{
+    switch (e->signal - Q_USER_SIGNAL) {
+    case PIPE_UP:
+        if (me->timeout < TIMEOUT_MAX) {
+            me->timeout++;
+        }
+        return Q_HANDLED();
+    case PIPE_DOWN:
+        if (me->timeout > TIMEOUT_MIN) {
+            me->timeout--;
+        }
+        return Q_HANDLED();
+    case PIPE_ARM:
+        me->curInput = 0;
+        me->fineTime = 0;
+        return Q_TRAN(QBombTiming);
+    default:
+        break;
+    }
+    return Q_IGNORED();
+}
+
+static QState QBombTiming(QBomb *me, QEvent *e)
+{
+    switch (e->signal - Q_USER_SIGNAL) {
+    case PIPE_UP:
+        me->curInput = (uint8_t)((me->curInput << 1) | 1);
+        return Q_HANDLED();
+    case PIPE_DOWN:
+        me->curInput = (uint8_t)(me->curInput << 1);
+        return Q_HANDLED();
+    case PIPE_ARM:
+        if (me->curInput == me->passwd) {
+            me->curInput = 0;
+            return Q_TRAN(QBombSetting);
+        }
+        return Q_HANDLED();
+    case PIPE_TICK:
+        if (++me->fineTime == 10) {
+            me->fineTime = 0;
+            if (--me->timeout == 0) {
+                me->timeout = TIMEOUT_INITIAL;
+                return Q_TRAN(QBombSetting);
+            }
+        }
+        return Q_HANDLED();
+    default:
+        break;
+    }
+    return Q_IGNORED();
+}
+
+static QState QBombInitial(QBomb *me, QEvent *e)
+{
+    UNUSE(e);
+    me->timeout = TIMEOUT_INITIAL;
+    me->passwd = PASSWD;
+    me->curInput = 0;
+    me->fineTime = 0;
+    return Q_TRAN(QBombSetting);
+}
+
+class QFsmEngine
+{
+public:
+    static constexpr const char *NAME = "QFsm";
+
+    QFsmEngine()
+    {
+        QFsmCtor(&bomb_.super, (QStateHandler)QBombInitial);
+        QFsmInit(&bomb_.super, nullptr);
+    }
+
+    void Dispatch(uint8_t signal)
+    {
+        QEvent e = {(QSignal)(signal + Q_USER_SIGNAL), 0};
+        QFsmDispatch(&bomb_.super, &e);
+    }
+
+    Snapshot Snap() const
+    {
+        uint8_t state = bomb_.super.state == (QStateHandler)QBombTiming ? 1 : 0;
+        return {state, bomb_.timeout, bomb_.curInput, bomb_.fineTime};
+    }
+
+private:
+    QBomb bomb_;
+};
+
+// ---------------------------------------------------------------------------
+// 引擎3：Bomb3 风格的虚函数状态
+// ---------------------------------------------------------------------------
+class VirtualEngine;
+
+class VState
+{
+public:
+    virtual void OnUp(VirtualEngine *bomb) = 0;
+    virtual void OnDown(VirtualEngine *bomb) = 0;
+    virtual void OnArm(VirtualEngine *bomb) = 0;
+    virtual void OnTick(VirtualEngine *bomb) = 0;
+    virtual uint8_t Id() const = 0;
+};
+
+class VSetting final : public VState
+{
+public:
+    void OnUp(VirtualEngine *bomb) override;
+    void OnDown(VirtualEngine *bomb) override;
+    void OnArm(VirtualEngine *bomb) override;
+    void OnTick(VirtualEngine *bomb) override
+    {
+        (void)bomb;
+    }
+    uint8_t Id() const override
+    {
+        return 0;
+    }
+};
+
+class VTiming final : public VState
+{
+public:
+    void OnUp(VirtualEngine *bomb) override;
+    void OnDown(VirtualEngine *bomb) override;
+    void OnArm(VirtualEngine *bomb) override;
+    void OnTick(VirtualEngine *bomb) override;
+    uint8_t Id() const override
+    {
+        return 1;
+    }
+};
+
+class VirtualEngine
+{
+public:
+    static constexpr const char *NAME = "Bomb3";
+
+    void Dispatch(uint8_t signal)
+    {
+        switch (signal) {
+        case PIPE_UP:
+            curState_->OnUp(this);
+            break;
+        case PIPE_DOWN:
+            curState_->OnDown(this);
+            break;
+        case PIPE_ARM:
+            curState_->OnArm(this);
+            break;
+        case PIPE_TICK:
+            curState_->OnTick(this);
+            break;
+        default:
+            break;
+        }
+    }
+
+    Snapshot Snap() const
+    {
+        return {curState_->Id(), timeout_, curInput_, fineTime_};
+    }
+
+private:
+    VState *curState_ = &setting_;
+    uint8_t timeout_ = TIMEOUT_INITIAL;
+    uint8_t passwd_ = PASSWD;
+    uint8_t curInput_ = 0;
+    uint8_t fineTime_ = 0;
+
+    static VSetting setting_;
+    static VTiming timing_;
+
+    friend class VSetting;
+    friend class VTiming;
+};
+
+VSetting VirtualEngine::setting_;
+VTiming VirtualEngine::timing_;
+
+void VSetting::OnUp(VirtualEngine *bomb)
+{
+    if (bomb->timeout_ < TIMEOUT_MAX) {
+        bomb->timeout_++;
+    }
+}
+
+void VSetting::OnDown(VirtualEngine *bomb)
+{
+    if (bomb->timeout_ > TIMEOUT_MIN) {
+        bomb->timeout_--;
+    }
+}
+
+void VSetting::OnArm(VirtualEngine *bomb)
+{
+    bomb->curInput_ = 0;
+    bomb->fineTime_ = 0;
+    bomb->curState_ = &VirtualEngine::timing_;
+}
+
+void VTiming::OnUp(VirtualEngine *bomb)
+{
+    bomb->curInput_ = (uint8_t)((bomb->curInput_ << 1) | 1);
+}
+
+void VTiming::OnDown(VirtualEngine *bomb)
+{
+    bomb->curInput_ = (uint8_t)(bomb->curInput_ << 1);
+}
+
+void VTiming::OnArm(VirtualEngine *bomb)
+{
+    if (bomb->curInput_ == bomb->passwd_) {
+        bomb->curInput_ = 0;
+        bomb->curState_ = &VirtualEngine::setting_;
+    }
+}
+
+void VTiming::OnTick(VirtualEngine *bomb)
+{
+    if (++bomb->fineTime_ == 10) {
+        bomb->fineTime_ = 0;
+        if (--bomb->timeout_ == 0) {
+            bomb->timeout_ = TIMEOUT_INITIAL;
+            bomb->curState_ = &VirtualEngine::setting_;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 队列实现：每种队列提供 Enqueue（失败返回false）和阻塞的 Dequeue
+// ---------------------------------------------------------------------------
+class SyncQueueMode
+{
+public:
+    static constexpr const char *NAME = "SyncQueue";
+
+    SyncQueueMode() : buffer_(QUEUE_SIZE)
+    {
+        QueueCtor(&queue_, buffer_.data(), QUEUE_SIZE);
+    }
+
+    bool Enqueue(PipeEvent *e)
+    {
+        return QueueEnqueue(&queue_, e) == 0;
+    }
+
+    PipeEvent *Dequeue()
+    {
+        return (PipeEvent *)QueueDequeueForever(&queue_);
+    }
+
+private:
+    SyncQueue queue_;
+    std::vector<void *> buffer_;
+};
+
+// 分段弹性队列：段池在所有状态机线程的队列之间共享，突发时按段增长，不会因为队列满而重试
+class SegQueueMode
+{
+public:
+    static constexpr const char *NAME = "SegQueue";
+
+    SegQueueMode()
+    {
+        SegQueueCtor(&queue_, Pool());
+    }
+
+    ~SegQueueMode()
+    {
+        SegQueueDtor(&queue_);
+    }
+
+    bool Enqueue(PipeEvent *e)
+    {
+        return SegQueueEnqueue(&queue_, e) == 0;
+    }
+
+    PipeEvent *Dequeue()
+    {
+        return (PipeEvent *)SegQueueDequeueForever(&queue_);
+    }
+
+    // 打印段池统计：持有段数的最大值、分配次数和超过软上限释放的段数
+    static void PrintPool()
+    {
+        SegPool *pool = Pool();
+        printf("SegQueue pool: segments %u (soft %u, hard %u), high water %u, allocs %u, trimmed %u, rejected %u\n",
+               pool->segments, pool->softCap, pool->hardCap, pool->highWater, pool->allocs, pool->trimmed,
+               pool->rejected);
+    }
+
+private:
+    // 软上限 64 段（约 128KB）预先分配，硬上限 16384 段（约 32MB）
+    static constexpr uint32_t SOFT_CAP = 64;
+    static constexpr uint32_t HARD_CAP = 16384;
+
+    static SegPool *Pool()
+    {
+        static SegPool pool;
+        static bool init = [] {
+            SegPoolCtor(&pool, SOFT_CAP, HARD_CAP);
+            SegPoolReserve(&pool, SOFT_CAP);
+            return true;
+        }();
+        (void)init;
+        return &pool;
+    }
+
+    SegQueue queue_;
+};
+
+// 每个状态机一个侵入式邮箱：生产者入队只做一次原子交换，
+// 邮箱从空变为非空时才通过就绪队列唤醒状态机线程
+class MailboxMode
+{
+public:
+    static constexpr const char *NAME = "Mailbox";
+
+    MailboxMode()
+    {
+        QueueCtor(&ready_, readyBuffer_, READY_SIZE);
+        MailboxCtor(&box_, &ready_);
+    }
+
+    bool Enqueue(PipeEvent *e)
+    {
+        // 事件总是进入邮箱，不能重投同一个侵入式节点
+        MailboxPost(&box_, &e->link);
+        return true;
+    }
+
+    PipeEvent *Dequeue()
+    {
+        for (;;) {
+            MailboxNode *node = MailboxPop(&box_);
+            if (node != nullptr) {
+                return MAILBOX_CONTAINER(node, PipeEvent, link);
+            }
+            // 邮箱为空时停放，等待下一次空→非空通知
+            if (MailboxPark(&box_)) {
+                QueueDequeueForever(&ready_);
+            }
+        }
+    }
+
+private:
+    // 就绪队列只挂一个邮箱，构造后的第一次通知可能早于停放到达，最多同时存在两个通知
+    static constexpr uint32_t READY_SIZE = 2;
+
+    Mailbox box_;
+    SyncQueue ready_;
+    void *readyBuffer_[READY_SIZE];
+};
+
+// ---------------------------------------------------------------------------
+// 流水线运行与统计
+// ---------------------------------------------------------------------------
+struct BenchConfig
+{
+    uint32_t producers;
+    uint32_t consumers;
+    uint32_t eventsPerProducer;
+};
+
+// 每个状态机线程的运行结果
+struct ConsumerResult
+{
+    std::vector<uint8_t> received;   // 实际收到的信号序列，用于跨引擎校验
+    std::vector<uint32_t> latencyNs; // 每个事件的排队延迟
+    Snapshot final;
+};
+
+// 生产者事件序列：xorshift 伪随机，TICK 占一半，使计时状态能走到超时
+static uint8_t NextSignal(uint32_t &seed)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    uint32_t r = seed % 16;
+    if (r < 8) {
+        return PIPE_TICK;
+    }
+    return (uint8_t)(r % 3);
+}
+
+// 用指定引擎重放一个信号序列，返回最终状态
+template <typename Engine>
+static Snapshot Replay(const std::vector<uint8_t> &signals)
+{
+    Engine engine;
+    for (uint8_t s : signals) {
+        engine.Dispatch(s);
+    }
+    return engine.Snap();
+}
+
+template <typename Engine, typename Queue>
+static bool RunPipeline(const BenchConfig &cfg)
+{
+    const uint64_t total = (uint64_t)cfg.producers * cfg.eventsPerProducer;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<ConsumerResult> results(cfg.consumers);
+    std::vector<uint64_t> expected(cfg.consumers, 0);
+    std::vector<std::vector<PipeEvent>> events(cfg.producers);
+
+    // 预先分配所有事件并计算每个状态机线程应收到的事件数
+    for (uint32_t p = 0; p < cfg.producers; p++) {
+        events[p].resize(cfg.eventsPerProducer);
+        uint32_t seed = 0x9E3779B9U ^ (p + 1);
+        for (uint32_t i = 0; i < cfg.eventsPerProducer; i++) {
+            events[p][i].signal = NextSignal(seed);
+            expected[(p + i) % cfg.consumers]++;
+        }
+    }
+    for (uint32_t c = 0; c < cfg.consumers; c++) {
+        queues.emplace_back(new Queue());
+        results[c].received.reserve(expected[c]);
+        results[c].latencyNs.reserve(expected[c]);
+    }
+
+    std::atomic<uint64_t> fullRetries(0);
+    int64_t csBefore = ContextSwitches();
+    uint64_t cpuBefore = CpuNs();
+    uint64_t start = TimespecNowNs();
+
+    std::vector<std::thread> threads;
+    for (uint32_t c = 0; c < cfg.consumers; c++) {
+        threads.emplace_back([&, c] {
+            Engine engine;
+            ConsumerResult &r = results[c];
+            for (uint64_t n = 0; n < expected[c]; n++) {
+                PipeEvent *e = queues[c]->Dequeue();
+                r.latencyNs.push_back((uint32_t)std::min<uint64_t>(TimespecNowNs() - e->enqueueNs, UINT32_MAX));
+                r.received.push_back(e->signal);
+                engine.Dispatch(e->signal);
+            }
+            r.final = engine.Snap();
+        });
+    }
+    for (uint32_t p = 0; p < cfg.producers; p++) {
+        threads.emplace_back([&, p] {
+            uint64_t retries = 0;
+            for (uint32_t i = 0; i < cfg.eventsPerProducer; i++) {
+                PipeEvent *e = &events[p][i];
+                e->enqueueNs = TimespecNowNs();
+                // 队列满时让出CPU后重试，不丢事件
+                while (!queues[(p + i) % cfg.consumers]->Enqueue(e)) {
+                    retries++;
+                    sched_yield();
+                }
+            }
+            fullRetries += retries;
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    uint64_t elapsed = TimespecNowNs() - start;
+    uint64_t cpu = CpuNs() - cpuBefore;
+    int64_t csAfter = ContextSwitches();
+
+    // 校验：三种引擎重放每个线程收到的序列，最终状态必须与流水线结果一致
+    bool ok = true;
+    std::vector<uint32_t> latency;
+    latency.reserve(total);
+    for (uint32_t c = 0; c < cfg.consumers; c++) {
+        const ConsumerResult &r = results[c];
+        if (!(Replay<TableEngine>(r.received) == r.final) || !(Replay<QFsmEngine>(r.received) == r.final) ||
+            !(Replay<VirtualEngine>(r.received) == r.final)) {
+            ok = false;
+        }
+        latency.insert(latency.end(), r.latencyNs.begin(), r.latencyNs.end());
+    }
+    std::sort(latency.begin(), latency.end());
+    auto pct = [&latency](double q) -> uint32_t {
+        return latency.empty() ? 0 : latency[(size_t)(q * (double)(latency.size() - 1))];
+    };
+
+    double seconds = (double)elapsed / 1e9;
+    double millions = (double)total / 1e6;
+    printf("%-10s %-10s %10.0f ev/s  p50 %7u ns  p99 %8u ns  p99.9 %8u ns  max %9u ns  "
+           "cs %8" PRId64 "  cpu/Mev %8.1f ms  full %" PRIu64 "  %s\n",
+           Queue::NAME, Engine::NAME, (double)total / seconds, pct(0.50), pct(0.99), pct(0.999),
+           latency.empty() ? 0 : latency.back(), csBefore < 0 ? (int64_t)-1 : csAfter - csBefore,
+           (double)cpu / 1e6 / millions, fullRetries.load(), ok ? "OK" : "MISMATCH");
+    return ok;
+}
+
+template <typename Queue>
+static bool RunAllEngines(const BenchConfig &cfg)
+{
+    bool ok = RunPipeline<TableEngine, Queue>(cfg);
+    ok = RunPipeline<QFsmEngine, Queue>(cfg) && ok;
+    ok = RunPipeline<VirtualEngine, Queue>(cfg) && ok;
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig cfg = {4, 2, 200000};
+    if (argc > 1) {
+        cfg.producers = (uint32_t)strtoul(argv[1], nullptr, 0);
+    }
+    if (argc > 2) {
+        cfg.consumers = (uint32_t)strtoul(argv[2], nullptr, 0);
+    }
+    if (argc > 3) {
+        cfg.eventsPerProducer = (uint32_t)strtoul(argv[3], nullptr, 0);
+    }
+    if (cfg.producers == 0 || cfg.consumers == 0) {
+        fprintf(stderr, "usage: %s [producers] [consumers] [eventsPerProducer]\n", argv[0]);
+        return 1;
+    }
+
+    printf("producers %u, consumers %u, events/producer %u\n", cfg.producers, cfg.consumers,
+           cfg.eventsPerProducer);
+    bool ok = RunAllEngines<SyncQueueMode>(cfg);
+    ok = RunAllEngines<MailboxMode>(cfg) && ok;
+    ok = RunAllEngines<SegQueueMode>(cfg) && ok;
+    SegQueueMode::PrintPool();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file bench_qk.c
+ * @brief 优先级内核基准测试
+ *
+ * 一个低优先级批处理状态机（QFsm，每个事件忙等固定时间）积压了大量事件，
+ * 同时周期性地向高优先级控制器状态机（StateTable）投递事件，
+ * 比较 QK 内核与单个先进先出队列下控制器事件的等待时间。
+ * 批处理状态机每隔若干步骤还会在自己的步骤内向控制器投递事件，
+ * QK 内核下这些事件嵌套分发，投递返回前就已处理完成。
+ *
+ * 用法：bench_qk [batchEvents] [ctrlEvents]
+ */
+
+#include "qk.h"
+#include "timespec_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BATCH_STEP_NS 20000     ///< 每个批处理步骤的忙等时间（纳秒）
+#define CTRL_PERIOD_NS 200000   ///< 控制器事件投递周期（纳秒）
+#define NESTED_EVERY 64         ///< 批处理状态机每隔多少步骤向控制器投递一次
+
+/**
+ * @brief 控制器事件，携带投递时间
+ */
+typedef struct CtrlEventTag {
+    Event super;                ///< 继承的事件基类
+    uint64_t postNs;            ///< 投递时间
+} CtrlEvent;
+
+/**
+ * @brief 批处理状态机
+ */
+typedef struct BatchFsmTag {
+    QFsm super;                 ///< 继承的状态机基类
+    uint32_t steps;             ///< 已处理的步骤数
+    uint32_t nested;            ///< 步骤内投递的控制器事件数
+    uint32_t nestedInline;      ///< 投递返回前已被处理的控制器事件数
+} BatchFsm;
+
+/**
+ * @brief 控制器状态机
+ */
+typedef struct ControllerTag {
+    StateTable super;           ///< 继承的状态表基类
+    uint32_t handled;           ///< 已处理的事件数
+    uint32_t *latencyNs;        ///< 每个事件的等待时间
+} Controller;
+
+enum { CTRL_STATE_RUN, CTRL_STATE_MAX };
+enum { CTRL_SIGNAL_CMD, CTRL_SIGNAL_MAX };
+
+static BatchFsm batch;
+static Controller ctrl;
+static QEvent batchEvent = {Q_USER_SIGNAL, 0};
+static CtrlEvent *nestedEvents;
+
+/// 当前模式下向控制器投递事件的方法
+static int (*postCtrl)(CtrlEvent *e);
+
+static void BusyWait(uint64_t ns)
+{
+    uint64_t end = TimespecNowNs() + ns;
+    while (TimespecNowNs() < end) {
+    }
+}
+
+static QState BatchWork(BatchFsm *me, QEvent *e)
+{
+    if (e->signal != Q_USER_SIGNAL) {
+        return Q_IGNORED();
+    }
+    BusyWait(BATCH_STEP_NS);
+    if (++me->steps % NESTED_EVERY == 0) {
+        uint32_t before = ctrl.handled;
+        CtrlEvent *ce = &nestedEvents[me->nested++];
+        ce->postNs = TimespecNowNs();
+        postCtrl(ce);
+        if (ctrl.handled != before) {
+            me->nestedInline++;
+        }
+    }
+    return Q_HANDLED();
+}
+
+static QState BatchInitial(BatchFsm *me, QEvent *e)
+{
+    UNUSE(e);
+    return Q_TRAN(BatchWork);
+}
+
+static void CtrlCmd(Controller *me, const Event *e)
+{
+    const CtrlEvent *ce = (const CtrlEvent *)e;
+    me->latencyNs[me->handled++] = (uint32_t)(TimespecNowNs() - ce->postNs);
+}
+
+static void CtrlInitial(StateTable *me)
+{
+    TRAN(CTRL_STATE_RUN);
+}
+
+static Tran ctrlTable[CTRL_STATE_MAX][CTRL_SIGNAL_MAX] = {
+    {(Tran)CtrlCmd},
+};
+
+static void MachinesInit(uint32_t *latency)
+{
+    batch.steps = 0;
+    batch.nested = 0;
+    batch.nestedInline = 0;
+    QFsmCtor(&batch.super, (QStateHandler)BatchInitial);
+    QFsmInit(&batch.super, NULL);
+    ctrl.handled = 0;
+    ctrl.latencyNs = latency;
+    StateTableCtor(&ctrl.super, &ctrlTable[0][0], CTRL_STATE_MAX, CTRL_SIGNAL_MAX, CtrlInitial);
+    StateTableInit(&ctrl.super);
+}
+
+// ---------------------------------------------------------------------------
+// QK 内核
+// ---------------------------------------------------------------------------
+static QkKernel kernel;
+static QkActive batchActive;
+static QkActive ctrlActive;
+
+static int QkPostCtrl(CtrlEvent *e)
+{
+    return QkPost(&kernel, &ctrlActive, e);
+}
+
+static void *QkThread(void *arg)
+{
+    UNUSE(arg);
+    QkRun(&kernel);
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// 先进先出基线：两个状态机共用一个队列
+// ---------------------------------------------------------------------------
+static SyncQueue fifo;
+static uint8_t fifoRunning;
+
+static int FifoPostCtrl(CtrlEvent *e)
+{
+    return QueueEnqueue(&fifo, e);
+}
+
+static void *FifoThread(void *arg)
+{
+    UNUSE(arg);
+    while (__atomic_load_n(&fifoRunning, __ATOMIC_ACQUIRE)) {
+        void *e = QueueDequeueForever(&fifo);
+        if (e == &batchEvent) {
+            QFsmDispatch(&batch.super, e);
+        } else if (e != NULL) {
+            StateTableDispatch(&ctrl.super, e);
+        }
+    }
+    return NULL;
+}
+
+static int CompareU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/**
+ * @brief 运行一种模式：积压批处理事件后周期性投递控制器事件，等待全部处理完成
+ */
+static void RunMode(const char *name, uint32_t batchN, uint32_t ctrlN, int (*postBatch)(void),
+                    CtrlEvent *ctrlEvents, uint32_t *latency, uint32_t expectNested)
+{
+    for (uint32_t i = 0; i < batchN; i++) {
+        postBatch();
+    }
+    for (uint32_t i = 0; i < ctrlN; i++) {
+        BusyWait(CTRL_PERIOD_NS);
+        ctrlEvents[i].postNs = TimespecNowNs();
+        postCtrl(&ctrlEvents[i]);
+    }
+    while (__atomic_load_n(&ctrl.handled, __ATOMIC_ACQUIRE) < ctrlN + expectNested ||
+           __atomic_load_n(&batch.steps, __ATOMIC_ACQUIRE) < batchN) {
+        struct timespec ts = {0, 1000000};
+        nanosleep(&ts, NULL);
+    }
+
+    uint32_t n = ctrl.handled;
+    qsort(latency, n, sizeof(uint32_t), CompareU32);
+    printf("%-5s ctrl latency  p50 %9u ns  p99 %9u ns  max %9u ns  nested inline %u/%u\n", name,
+           latency[n / 2], latency[(uint32_t)((uint64_t)(n - 1) * 99 / 100)], latency[n - 1],
+           batch.nestedInline, batch.nested);
+}
+
+static int QkPostBatch(void)
+{
+    return QkPost(&kernel, &batchActive, &batchEvent);
+}
+
+static int FifoPostBatch(void)
+{
+    return QueueEnqueue(&fifo, &batchEvent);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t batchN = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 5000U;
+    uint32_t ctrlN = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 200U;
+    uint32_t nestedN = batchN / NESTED_EVERY;
+    uint32_t queueSize = batchN + ctrlN + nestedN + 1;
+
+    void **batchBuffer = malloc(sizeof(void *) * queueSize);
+    void **ctrlBuffer = malloc(sizeof(void *) * queueSize);
+    CtrlEvent *ctrlEvents = calloc(ctrlN, sizeof(CtrlEvent));
+    nestedEvents = calloc(nestedN + 1, sizeof(CtrlEvent));
+    uint32_t *latency = malloc(sizeof(uint32_t) * (ctrlN + nestedN + 1));
+    if (batchBuffer == NULL || ctrlBuffer == NULL || ctrlEvents == NULL || nestedEvents == NULL ||
+        latency == NULL || ctrlN == 0) {
+        fprintf(stderr, "usage: %s [batchEvents] [ctrlEvents]\n", argv[0]);
+        return 1;
+    }
+    for (uint32_t i = 0; i < ctrlN; i++) {
+        ctrlEvents[i].super.signal = CTRL_SIGNAL_CMD;
+    }
+    for (uint32_t i = 0; i <= nestedN; i++) {
+        nestedEvents[i].super.signal = CTRL_SIGNAL_CMD;
+    }
+    printf("batch events %u (%u us/step), ctrl events %u every %u us\n", batchN, BATCH_STEP_NS / 1000, ctrlN,
+           CTRL_PERIOD_NS / 1000);
+
+    // 先进先出基线
+    pthread_t t;
+    MachinesInit(latency);
+    QueueCtor(&fifo, batchBuffer, queueSize);
+    postCtrl = FifoPostCtrl;
+    fifoRunning = 1;
+    pthread_create(&t, NULL, FifoThread, NULL);
+    RunMode("FIFO", batchN, ctrlN, FifoPostBatch, ctrlEvents, latency, nestedN);
+    __atomic_store_n(&fifoRunning, 0, __ATOMIC_RELEASE);
+    QueueEnqueue(&fifo, NULL);
+    pthread_join(t, NULL);
+
+    // QK 内核：控制器优先级高于批处理状态机
+    MachinesInit(latency);
+    QkCtor(&kernel);
+    QkActiveCtor(&kernel, &batchActive, 1, &batch, QkDispatchQFsm, batchBuffer, queueSize);
+    QkActiveCtor(&kernel, &ctrlActive, 2, &ctrl, QkDispatchStateTable, ctrlBuffer, queueSize);
+    postCtrl = QkPostCtrl;
+    pthread_create(&t, NULL, QkThread, NULL);
+    RunMode("QK", batchN, ctrlN, QkPostBatch, ctrlEvents, latency, nestedN);
+    QkStop(&kernel);
+    pthread_join(t, NULL);
+
+    free(batchBuffer);
+    free(ctrlBuffer);
+    free(ctrlEvents);
+    free(nestedEvents);
+    free(latency);
+    return 0;
+}
@@ -0,0 +1,251 @@
+/**
+ * @file bench_rcu.c
+ * @brief 状态表热替换压力测试
+ *
+ * 多个分发线程持续向各自的状态机实例分发事件，同时发布线程不断发布新版本的状态表，
+ * 新旧版本的状态编号互换（A 布局：设置=0、计时=1；B 布局：计时=0、设置=1），
+ * 通过状态迁移表换算。被回收的状态表会被填成毒化函数，
+ * 只要有分发线程在回收后还用到旧表就会被统计出来；结束时校验每个实例的状态编号
+ * 与它记录的逻辑状态在当前布局下一致。
+ *
+ * 用法：bench_rcu [readers] [instancesPerReader] [publishes]
+ */
+
+#include "table_rcu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief 逻辑状态，与状态表布局无关
+ */
+enum {
+    LOGICAL_SETTING,            ///< 设置状态
+    LOGICAL_TIMING,             ///< 计时状态
+    STATE_MAX,                  ///< 状态数量
+};
+
+/**
+ * @brief 信号枚举
+ */
+enum {
+    SIGNAL_ARM,                 ///< 启动/停止
+    SIGNAL_TICK,                ///< 滴答
+    SIGNAL_MAX,                 ///< 信号数量
+};
+
+/**
+ * @brief 测试用状态机
+ */
+typedef struct RcuBombTag {
+    StateTable super;           ///< 继承的状态表基类
+    uint8_t logical;            ///< 逻辑状态
+    uint32_t ticks;             ///< 计时状态下收到的滴答数
+} RcuBomb;
+
+/**
+ * @brief 每个分发线程的参数
+ */
+typedef struct ReaderTag {
+    pthread_t thread;           ///< 线程
+    RcuBomb *bombs;             ///< 实例数组
+    uint32_t bombNum;           ///< 实例数
+    uint64_t dispatched;        ///< 已分发事件数
+} Reader;
+
+static TableRcu rcu;
+static uint8_t running = 1;
+static uint32_t poisonHits;
+static StateTableVersion *reclaimed[4096];
+static uint32_t reclaimedNum;
+
+static void ArmToTimingA(RcuBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->logical = LOGICAL_TIMING;
+    TRAN(1);
+}
+
+static void ArmToSettingA(RcuBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->logical = LOGICAL_SETTING;
+    TRAN(0);
+}
+
+static void ArmToTimingB(RcuBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->logical = LOGICAL_TIMING;
+    TRAN(0);
+}
+
+static void ArmToSettingB(RcuBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->logical = LOGICAL_SETTING;
+    TRAN(1);
+}
+
+static void Tick(RcuBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->ticks++;
+}
+
+/// 已回收的状态表被填成这个函数
+static void Poison(StateTable *me, const Event *e)
+{
+    UNUSE(me);
+    UNUSE(e);
+    __atomic_fetch_add(&poisonHits, 1, __ATOMIC_RELAXED);
+}
+
+static Tran layoutA[STATE_MAX][SIGNAL_MAX] = {
+    {(Tran)ArmToTimingA, StateTableEmpty},
+    {(Tran)ArmToSettingA, (Tran)Tick},
+};
+
+static Tran layoutB[STATE_MAX][SIGNAL_MAX] = {
+    {(Tran)ArmToSettingB, (Tran)Tick},
+    {(Tran)ArmToTimingB, StateTableEmpty},
+};
+
+/// 两种布局之间的状态编号互换
+static const uint8_t swapMap[STATE_MAX] = {1, 0};
+
+static void BombInitial(StateTable *me)
+{
+    RcuBomb *bomb = (RcuBomb *)me;
+    bomb->logical = LOGICAL_SETTING;
+    bomb->ticks = 0;
+    // 按当前布局找到设置状态
+    TRAN(me->stateTable[0] == (Tran)ArmToTimingA ? 0 : 1);
+}
+
+/**
+ * @brief 创建一个新版本：状态表复制到新分配的内存，保证每个版本的表指针不同
+ */
+static StateTableVersion *NewVersion(bool layoutIsA, bool first)
+{
+    StateTableVersion *v = calloc(1, sizeof(StateTableVersion));
+    Tran *table = malloc(sizeof(layoutA));
+    memcpy(table, layoutIsA ? &layoutA[0][0] : &layoutB[0][0], sizeof(layoutA));
+    v->stateTable = table;
+    v->stateNum = STATE_MAX;
+    v->signalNum = SIGNAL_MAX;
+    v->stateMap = first ? NULL : swapMap;
+    return v;
+}
+
+/**
+ * @brief 回收函数：毒化状态表，延迟到测试结束再释放内存
+ */
+static void Reclaim(StateTableVersion *v, void *arg)
+{
+    UNUSE(arg);
+    for (int i = 0; i < STATE_MAX * SIGNAL_MAX; i++) {
+        v->stateTable[i] = Poison;
+    }
+    reclaimed[reclaimedNum++] = v;
+}
+
+static void *ReaderThread(void *arg)
+{
+    Reader *r = (Reader *)arg;
+    int id = TableRcuReaderRegister(&rcu);
+    uint32_t seed = (uint32_t)(uintptr_t)r | 1U;
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        for (uint32_t i = 0; i < r->bombNum; i++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            const Event e = {(uint16_t)(seed % 4 == 0 ? SIGNAL_ARM : SIGNAL_TICK)};
+            TableRcuDispatch(&rcu, id, &r->bombs[i].super, &e);
+        }
+        r->dispatched += r->bombNum;
+    }
+    // 退出前把所有实例迁移到最新版本
+    for (uint32_t i = 0; i < r->bombNum; i++) {
+        const Event e = {SIGNAL_TICK};
+        TableRcuDispatch(&rcu, id, &r->bombs[i].super, &e);
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t readerNum = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 4U;
+    uint32_t bombNum = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 1000U;
+    uint32_t publishes = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 0) : 200U;
+    if (readerNum == 0 || readerNum > TABLE_RCU_READERS_MAX || publishes >= 4096) {
+        fprintf(stderr, "usage: %s [readers<=%d] [instancesPerReader] [publishes<4096]\n", argv[0],
+                TABLE_RCU_READERS_MAX);
+        return 1;
+    }
+
+    StateTableVersion *first = NewVersion(true, true);
+    TableRcuCtor(&rcu, first, Reclaim, NULL);
+
+    Reader *readers = calloc(readerNum, sizeof(Reader));
+    for (uint32_t r = 0; r < readerNum; r++) {
+        readers[r].bombs = calloc(bombNum, sizeof(RcuBomb));
+        readers[r].bombNum = bombNum;
+        for (uint32_t i = 0; i < bombNum; i++) {
+            TableRcuBind(&rcu, &readers[r].bombs[i].super, BombInitial);
+        }
+    }
+    for (uint32_t r = 0; r < readerNum; r++) {
+        pthread_create(&readers[r].thread, NULL, ReaderThread, &readers[r]);
+    }
+
+    // 发布线程：交替发布 B/A 布局，每次发布后尝试回收
+    uint32_t collected = 0;
+    bool layoutIsA = true;
+    for (uint32_t p = 0; p < publishes; p++) {
+        struct timespec ts = {0, 1000000};
+        nanosleep(&ts, NULL);
+        layoutIsA = !layoutIsA;
+        TableRcuPublish(&rcu, NewVersion(layoutIsA, false));
+        collected += TableRcuCollect(&rcu);
+    }
+
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+    uint64_t dispatched = 0;
+    for (uint32_t r = 0; r < readerNum; r++) {
+        pthread_join(readers[r].thread, NULL);
+        dispatched += readers[r].dispatched;
+    }
+    collected += TableRcuCollect(&rcu);
+
+    // 校验每个实例的状态编号与逻辑状态在当前布局下一致
+    uint32_t mismatch = 0;
+    for (uint32_t r = 0; r < readerNum; r++) {
+        for (uint32_t i = 0; i < bombNum; i++) {
+            const RcuBomb *b = &readers[r].bombs[i];
+            uint8_t expect = layoutIsA ? b->logical : (uint8_t)(1 - b->logical);
+            if (b->super.stateTable != rcu.current->stateTable || b->super.curState != expect) {
+                mismatch++;
+            }
+        }
+    }
+
+    printf("readers %u, instances %u, dispatched %llu, published %u, reclaimed %u, poison hits %u, mismatch %u\n",
+           readerNum, readerNum * bombNum, (unsigned long long)dispatched, publishes, collected, poisonHits,
+           mismatch);
+    bool ok = poisonHits == 0 && mismatch == 0 && collected == publishes;
+    printf("check %s\n", ok ? "OK" : "FAILED");
+
+    for (uint32_t i = 0; i < reclaimedNum; i++) {
+        free(reclaimed[i]->stateTable);
+        free(reclaimed[i]);
+    }
+    free(rcu.current->stateTable);
+    free(rcu.current);
+    for (uint32_t r = 0; r < readerNum; r++) {
+        free(readers[r].bombs);
+    }
+    free(readers);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file bench_shm.c
+ * @brief 跨进程共享内存队列基准测试
+ *
+ * 父进程作为输入网关向共享内存队列写入按键事件，fork 出的子进程作为状态机引擎
+ * 读取事件并校验顺序，统计吞吐量和排队延迟。子进程退出后父进程通过
+ * 消费者存活锁检测到消费者已不存在。
+ *
+ * 用法：bench_shm [events]
+ */
+
+#include "shm_queue.h"
+#include "timespec_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SHM_NAME "/bench_shm_queue"     ///< memfd 不可用时使用的具名共享内存
+#define SHM_QUEUE_SIZE 1024             ///< 队列容量
+
+/**
+ * @brief 队列中传递的事件记录
+ */
+typedef struct ShmEventTag {
+    uint32_t seq;               ///< 序号，用于校验顺序
+    uint8_t signal;             ///< 按键信号
+    uint64_t postNs;            ///< 入队时间
+} ShmEvent;
+
+static int CompareU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/**
+ * @brief 子进程：消费者
+ */
+static int Consumer(ShmQueue *q, uint32_t n)
+{
+    if (ShmQueueClaimConsumer(q) != 0) {
+        fprintf(stderr, "claim consumer failed\n");
+        return 1;
+    }
+    uint32_t *latency = malloc(sizeof(uint32_t) * n);
+    if (latency == NULL) {
+        return 1;
+    }
+    uint32_t bad = 0;
+    uint32_t counts[3] = {0};
+    uint64_t start = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        ShmEvent e;
+        if (ShmQueueDequeue(q, &e, 0, NULL) != (int)sizeof(e)) {
+            bad++;
+            continue;
+        }
+        if (i == 0) {
+            start = e.postNs;
+        }
+        latency[i] = (uint32_t)(TimespecNowNs() - e.postNs);
+        counts[e.signal % 3]++;
+        if (e.seq != i) {
+            bad++;
+        }
+    }
+    double sec = (double)(TimespecNowNs() - start) / 1e9;
+    qsort(latency, n, sizeof(uint32_t), CompareU32);
+    printf("consumer: %u events, %.0f ev/s, p50 %u ns, p99 %u ns, max %u ns, u/d/a %u/%u/%u, %s\n", n,
+           (double)n / sec, latency[n / 2], latency[(uint32_t)((uint64_t)(n - 1) * 99 / 100)], latency[n - 1],
+           counts[0], counts[1], counts[2], bad == 0 ? "OK" : "MISMATCH");
+    fflush(stdout);
+    free(latency);
+    // 不释放消费者锁直接退出，模拟消费者进程崩溃
+    _exit(bad == 0 ? 0 : 1);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 1000000U;
+    if (n == 0) {
+        fprintf(stderr, "usage: %s [events]\n", argv[0]);
+        return 1;
+    }
+
+    ShmQueue q;
+    const char *name = NULL;
+    if (ShmQueueCreate(&q, NULL, sizeof(ShmEvent), SHM_QUEUE_SIZE) != 0) {
+        name = SHM_NAME;
+        ShmQueueUnlink(name);
+        if (ShmQueueCreate(&q, name, sizeof(ShmEvent), SHM_QUEUE_SIZE) != 0) {
+            perror("ShmQueueCreate");
+            return 1;
+        }
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        return Consumer(&q, n);
+    }
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    // 等待消费者就绪
+    while (!ShmQueueConsumerAlive(&q)) {
+        sched_yield();
+    }
+
+    uint64_t fullRetries = 0;
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < n; i++) {
+        seed = seed * 1103515245U + 12345U;
+        ShmEvent e = {i, (uint8_t)((seed >> 16) % 3), TimespecNowNs()};
+        while (ShmQueueEnqueue(&q, &e, sizeof(e)) != 0) {
+            fullRetries++;
+            sched_yield();
+            e.postNs = TimespecNowNs();
+        }
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    bool alive = ShmQueueConsumerAlive(&q);
+    printf("producer: full retries %llu, consumer %s, owner died %d\n",
+           (unsigned long long)fullRetries, alive ? "still alive (ERROR)" : "exit detected",
+           ShmQueueOwnerDied(&q));
+
+    ShmQueueClose(&q);
+    if (name != NULL) {
+        ShmQueueUnlink(name);
+    }
+    return (!alive && WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+}
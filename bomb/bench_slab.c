@@ -0,0 +1,200 @@
+/**
+ * @file bench_slab.c
+ * @brief 紧凑实例存储基准测试
+ *
+ * 分别用 StateTable（每个实例一份完整的状态表对象）和 FsmSlab（类/实例分离，
+ * 每个实例4字节）保存 N 个炸弹状态机，比较每实例内存占用以及
+ * 向所有实例广播事件时的遍历开销。
+ *
+ * 用法：bench_slab [instances]
+ */
+
+#include "statetbl.h"
+#include "fsm_slab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BOMB_INIT_TIMEOUT 15    ///< 初始超时时间（秒）
+#define BOMB_PASSWD 0xD         ///< 解锁密码
+#define BENCH_ROUNDS 20         ///< 广播轮数
+
+/**
+ * @brief 炸弹状态枚举
+ */
+enum {
+    BOMB_STATE_SETTING,         ///< 设置状态
+    BOMB_STATE_TIMING,          ///< 计时状态
+    BOMB_STATE_MAX,             ///< 状态数量
+};
+
+/**
+ * @brief 炸弹信号枚举
+ */
+enum {
+    BOMB_SIGNAL_ARM,            ///< 启动/停止信号
+    BOMB_SIGNAL_TICK,           ///< 秒滴答信号
+    BOMB_SIGNAL_MAX,            ///< 信号数量
+};
+
+/**
+ * @brief 与 bomb2 相同布局的状态机：完整的 StateTable 加扩展状态
+ */
+typedef struct FatBombTag {
+    StateTable super;           ///< 继承的状态表基类
+    uint32_t timeout;           ///< 超时时间（秒）
+    uint8_t passwd;             ///< 解锁密码
+    uint8_t curInput;           ///< 当前输入的密码
+} FatBomb;
+
+/**
+ * @brief 紧凑实例记录：状态字节加扩展状态，共4字节
+ */
+typedef struct PackedBombTag {
+    FsmInst super;              ///< 实例头部（状态字节）
+    uint8_t timeout;            ///< 超时时间（秒），10~120 用一个字节即可
+    uint8_t passwd;             ///< 解锁密码
+    uint8_t curInput;           ///< 当前输入的密码
+} PackedBomb;
+
+static void FatArm(FatBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = 0;
+    TRAN(BOMB_STATE_TIMING);
+}
+
+static void FatTick(FatBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (--me->timeout == 0) {
+        me->timeout = BOMB_INIT_TIMEOUT;
+        TRAN(BOMB_STATE_SETTING);
+    }
+}
+
+static void FatInitial(StateTable *me)
+{
+    FatBomb *bomb = (FatBomb *)me;
+    bomb->timeout = BOMB_INIT_TIMEOUT;
+    bomb->passwd = BOMB_PASSWD;
+    bomb->curInput = 0;
+    TRAN(BOMB_STATE_SETTING);
+}
+
+static Tran fatTable[BOMB_STATE_MAX][BOMB_SIGNAL_MAX] = {
+    {(Tran)FatArm, StateTableEmpty},
+    {StateTableEmpty, (Tran)FatTick},
+};
+
+static void PackedEmpty(void *me, const Event *e)
+{
+    UNUSE(me);
+    UNUSE(e);
+}
+
+static void PackedArm(PackedBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = 0;
+    SLAB_TRAN(BOMB_STATE_TIMING);
+}
+
+static void PackedTick(PackedBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (--me->timeout == 0) {
+        me->timeout = BOMB_INIT_TIMEOUT;
+        SLAB_TRAN(BOMB_STATE_SETTING);
+    }
+}
+
+static void PackedInitial(void *me)
+{
+    PackedBomb *bomb = (PackedBomb *)me;
+    bomb->timeout = BOMB_INIT_TIMEOUT;
+    bomb->passwd = BOMB_PASSWD;
+    bomb->curInput = 0;
+    SLAB_TRAN(BOMB_STATE_SETTING);
+}
+
+static const SlabTran packedTable[BOMB_STATE_MAX][BOMB_SIGNAL_MAX] = {
+    {(SlabTran)PackedArm, PackedEmpty},
+    {PackedEmpty, (SlabTran)PackedTick},
+};
+
+/// 紧凑炸弹状态机类，所有实例共享
+static const FsmClass packedClass = {
+    &packedTable[0][0], BOMB_STATE_MAX, BOMB_SIGNAL_MAX, FSM_INST_SIZE(PackedBomb), PackedInitial,
+};
+
+static double NowSec(void)
+{
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 4000000U;
+    static const Event armEvent = {BOMB_SIGNAL_ARM};
+    static const Event tickEvent = {BOMB_SIGNAL_TICK};
+
+    FatBomb *fat = malloc(sizeof(FatBomb) * n);
+    void *mem = malloc(FSM_SLAB_BYTES(&packedClass, n));
+    if (fat == NULL || mem == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    // StateTable：每个实例都带一份状态表指针、状态数、信号数和初始化函数
+    for (uint32_t i = 0; i < n; i++) {
+        StateTableCtor(&fat[i].super, &fatTable[0][0], BOMB_STATE_MAX, BOMB_SIGNAL_MAX, FatInitial);
+        StateTableInit(&fat[i].super);
+    }
+    double start = NowSec();
+    for (uint32_t i = 0; i < n; i++) {
+        StateTableDispatch(&fat[i].super, &armEvent);
+    }
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (uint32_t i = 0; i < n; i++) {
+            StateTableDispatch(&fat[i].super, &tickEvent);
+        }
+    }
+    double fatSec = NowSec() - start;
+
+    // FsmSlab：元数据只有一份，实例连续存放
+    FsmSlab slab;
+    FsmSlabCtor(&slab, &packedClass, mem, n);
+    for (uint32_t i = 0; i < n; i++) {
+        FsmSlabAlloc(&slab);
+    }
+    start = NowSec();
+    FsmSlabBroadcast(&slab, &armEvent);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        FsmSlabBroadcast(&slab, &tickEvent);
+    }
+    double slabSec = NowSec() - start;
+
+    // 校验两种存储方式的结果一致
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        PackedBomb *p = FsmSlabAt(&slab, i);
+        if (p->super.state != fat[i].super.curState || p->timeout != fat[i].timeout) {
+            mismatch++;
+        }
+    }
+
+    double events = (double)n * (BENCH_ROUNDS + 1);
+    printf("instances %u\n", n);
+    printf("StateTable: %3zu bytes/instance, %7.1f MB, %6.2f ns/event\n", sizeof(FatBomb),
+           sizeof(FatBomb) * (double)n / 1e6, fatSec * 1e9 / events);
+    printf("FsmSlab:    %3u bytes/instance, %7.1f MB, %6.2f ns/event\n", packedClass.instSize,
+           (double)FSM_SLAB_BYTES(&packedClass, n) / 1e6, slabSec * 1e9 / events);
+    printf("check %s\n", mismatch == 0 ? "OK" : "MISMATCH");
+
+    free(fat);
+    free(mem);
+    return mismatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file bench_worker.c
+ * @brief 状态机迁移与负载均衡基准测试
+ *
+ * 所有实例一开始都放在 0 号工作线程上，四分之一的热点实例收到 80% 的事件，
+ * 每个事件忙等固定时间模拟处理开销，每个实例还有一个周期定时器。
+ * 分别在不均衡和周期性调用 WorkerPoolBalance 两种情况下运行，
+ * 比较耗时、各线程处理的事件数和迁移次数，并校验每个实例收到的同一生产者的事件顺序不变。
+ *
+ * 用法：bench_worker [workers] [actors] [events]
+ */
+
+#include "worker.h"
+#include "timespec_util.h"
+#include "statetbl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PRODUCER_NUM 2          ///< 生产者线程数
+#define EVENT_WORK_NS 2000      ///< 每个事件的忙等时间（纳秒）
+#define TIMER_PERIOD_MS 10      ///< 实例定时器周期
+#define BALANCE_PERIOD_MS 10    ///< 均衡周期
+#define BALANCE_THRESHOLD 20    ///< 触发迁移的负载差（百分比）
+
+/**
+ * @brief 基准事件
+ */
+typedef struct BenchEventTag {
+    Event super;                ///< 继承的事件基类
+    MailboxNode link;           ///< 邮箱节点
+    uint8_t producer;           ///< 生产者编号
+    uint32_t seq;               ///< 该生产者发给该实例的序号
+} BenchEvent;
+
+/**
+ * @brief 基准实例：状态表状态机和可迁移实例
+ */
+typedef struct BenchActorTag {
+    StateTable super;           ///< 继承的状态表基类
+    WorkerActor actor;          ///< 可迁移实例
+    uint32_t nextSeq[PRODUCER_NUM]; ///< 每个生产者下一个应收到的序号
+    uint32_t handled;           ///< 已处理的事件数（原子访问）
+    uint32_t ticks;             ///< 已处理的滴答数
+    uint32_t disorder;          ///< 乱序事件数
+} BenchActor;
+
+enum { BENCH_STATE_RUN, BENCH_STATE_MAX };
+enum { BENCH_SIGNAL_CMD, BENCH_SIGNAL_TICK, BENCH_SIGNAL_MAX };
+
+/**
+ * @brief 生产者参数
+ */
+typedef struct ProducerTag {
+    uint8_t id;                 ///< 生产者编号
+    BenchActor *actors;         ///< 实例
+    uint32_t actorNum;          ///< 实例数
+    BenchEvent *events;         ///< 预先分配的事件
+    uint32_t eventNum;          ///< 事件数
+} Producer;
+
+static void BusyWait(uint64_t ns)
+{
+    uint64_t end = TimespecNowNs() + ns;
+    while (TimespecNowNs() < end) {
+    }
+}
+
+static void BenchCmd(BenchActor *me, const Event *e)
+{
+    const BenchEvent *be = (const BenchEvent *)e;
+    if (be->seq != me->nextSeq[be->producer]) {
+        me->disorder++;
+    }
+    me->nextSeq[be->producer] = be->seq + 1;
+    BusyWait(EVENT_WORK_NS);
+    __atomic_store_n(&me->handled, me->handled + 1, __ATOMIC_RELEASE);
+}
+
+static void BenchTick(BenchActor *me, const Event *e)
+{
+    UNUSE(e);
+    me->ticks++;
+}
+
+static void BenchInitial(StateTable *me)
+{
+    TRAN(BENCH_STATE_RUN);
+}
+
+static Tran benchTable[BENCH_STATE_MAX][BENCH_SIGNAL_MAX] = {
+    {(Tran)BenchCmd, (Tran)BenchTick},
+};
+
+static void ActorDispatch(void *fsm, MailboxNode *node)
+{
+    BenchEvent *e = MAILBOX_CONTAINER(node, BenchEvent, link);
+    StateTableDispatch((StateTable *)fsm, &e->super);
+}
+
+static void ActorTick(void *fsm)
+{
+    static const Event tick = {BENCH_SIGNAL_TICK};
+    StateTableDispatch((StateTable *)fsm, &tick);
+}
+
+/**
+ * @brief 按 80/20 选择目标实例：前四分之一是热点实例
+ */
+static uint32_t PickActor(uint32_t *seed, uint32_t actorNum)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    uint32_t hot = actorNum / 4 != 0 ? actorNum / 4 : 1;
+    if (*seed % 10 < 8) {
+        return (*seed >> 8) % hot;
+    }
+    return (*seed >> 8) % actorNum;
+}
+
+static void *ProducerRun(void *arg)
+{
+    Producer *p = (Producer *)arg;
+    uint32_t seed = 0x9E3779B9U ^ (p->id + 1U);
+    uint32_t *seqs = (uint32_t *)calloc(p->actorNum, sizeof(uint32_t));
+    for (uint32_t i = 0; i < p->eventNum; i++) {
+        uint32_t target = PickActor(&seed, p->actorNum);
+        BenchEvent *e = &p->events[i];
+        e->super.signal = BENCH_SIGNAL_CMD;
+        e->producer = p->id;
+        e->seq = seqs[target]++;
+        WorkerPost(&p->actors[target].actor, &e->link);
+    }
+    free(seqs);
+    return NULL;
+}
+
+/**
+ * @brief 运行一轮
+ *
+ * @param workerNum 工作线程数
+ * @param actorNum 实例数
+ * @param eventNum 总事件数
+ * @param balance 是否周期性均衡
+ * @return true 所有实例的事件顺序正确
+ */
+static bool RunOnce(uint32_t workerNum, uint32_t actorNum, uint32_t eventNum, bool balance)
+{
+    WorkerPool pool;
+    if (WorkerPoolCtor(&pool, workerNum, actorNum) != 0) {
+        fprintf(stderr, "pool init failed\n");
+        return false;
+    }
+    BenchActor *actors = (BenchActor *)calloc(actorNum, sizeof(BenchActor));
+    for (uint32_t i = 0; i < actorNum; i++) {
+        StateTableCtor(&actors[i].super, &benchTable[0][0], BENCH_STATE_MAX, BENCH_SIGNAL_MAX, BenchInitial);
+        StateTableInit(&actors[i].super);
+        // 所有实例都挤在 0 号线程上
+        WorkerActorCtor(&pool, &actors[i].actor, &actors[i], ActorDispatch, ActorTick, 0);
+        WorkerActorSetTimer(&actors[i].actor, TIMER_PERIOD_MS);
+    }
+
+    Producer producers[PRODUCER_NUM];
+    pthread_t threads[PRODUCER_NUM];
+    uint32_t perProducer = eventNum / PRODUCER_NUM;
+    for (uint8_t p = 0; p < PRODUCER_NUM; p++) {
+        producers[p].id = p;
+        producers[p].actors = actors;
+        producers[p].actorNum = actorNum;
+        producers[p].events = (BenchEvent *)calloc(perProducer, sizeof(BenchEvent));
+        producers[p].eventNum = perProducer;
+    }
+
+    uint64_t start = TimespecNowNs();
+    WorkerPoolStart(&pool);
+    for (uint8_t p = 0; p < PRODUCER_NUM; p++) {
+        pthread_create(&threads[p], NULL, ProducerRun, &producers[p]);
+    }
+
+    // 等待所有事件处理完，期间按周期均衡
+    uint32_t total = perProducer * PRODUCER_NUM;
+    for (;;) {
+        uint32_t handled = 0;
+        for (uint32_t i = 0; i < actorNum; i++) {
+            handled += __atomic_load_n(&actors[i].handled, __ATOMIC_ACQUIRE);
+        }
+        if (handled == total) {
+            break;
+        }
+        struct timespec ts = {0, BALANCE_PERIOD_MS * 1000000L};
+        nanosleep(&ts, NULL);
+        if (balance) {
+            WorkerPoolBalance(&pool, BALANCE_THRESHOLD);
+        }
+    }
+    uint64_t elapsed = TimespecNowNs() - start;
+    for (uint8_t p = 0; p < PRODUCER_NUM; p++) {
+        pthread_join(threads[p], NULL);
+    }
+    WorkerPoolStop(&pool);
+
+    uint32_t disorder = 0;
+    uint32_t ticks = 0;
+    for (uint32_t i = 0; i < actorNum; i++) {
+        disorder += actors[i].disorder;
+        ticks += actors[i].ticks;
+    }
+    printf("%-8s %8.1f ms  %9.0f ev/s  migrations %4u  ticks %6u  disorder %u\n", balance ? "balanced" : "pinned",
+           (double)elapsed / 1e6, (double)total / ((double)elapsed / 1e9), pool.migrations, ticks, disorder);
+    for (uint32_t w = 0; w < workerNum; w++) {
+        Worker *worker = &pool.workers[w];
+        printf("  worker %u: events %8llu  busy %8.1f ms  in %3u  out %3u\n", w, (unsigned long long)worker->events,
+               (double)worker->busyNs / 1e6, worker->migratedIn, worker->migratedOut);
+    }
+
+    for (uint8_t p = 0; p < PRODUCER_NUM; p++) {
+        free(producers[p].events);
+    }
+    free(actors);
+    WorkerPoolDtor(&pool);
+    return disorder == 0;
+}
+
+/**
+ * @brief 主函数
+ *
+ * @param argc 参数个数
+ * @param argv 参数列表
+ * @return 程序退出码
+ */
+int main(int argc, char *argv[])
+{
+    uint32_t workerNum = 4;
+    uint32_t actorNum = 16;
+    uint32_t eventNum = 200000;
+    if (argc > 1) {
+        workerNum = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        actorNum = (uint32_t)strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3) {
+        eventNum = (uint32_t)strtoul(argv[3], NULL, 0);
+    }
+    if (workerNum == 0 || actorNum == 0) {
+        fprintf(stderr, "usage: %s [workers] [actors] [events]\n", argv[0]);
+        return 1;
+    }
+
+    printf("workers %u, actors %u, events %u, %u ns/event\n", workerNum, actorNum, eventNum, EVENT_WORK_NS);
+    bool ok = RunOnce(workerNum, actorNum, eventNum, false);
+    ok = RunOnce(workerNum, actorNum, eventNum, true) && ok;
+    return ok ? 0 : 1;
+}
@@ -8,6 +8,15 @@
 
 #include "statetbl.h"
 #include "sync_queue.h"
+#include "vclock.h"
+#include "alog.h"
+#include "statetbl_verify.h"
+#ifdef STATETBL_PROFILE
+#include "statetbl_layout.h"
+#endif // STATETBL_PROFILE
+#ifdef BOMB_RT_PROFILE
+#include "rt_profile.h"
+#endif // BOMB_RT_PROFILE
 #include <stdio.h>
 #include <unistd.h>
 #include <conio.h>
@@ -67,6 +76,23 @@ typedef struct TickEventTag {
     uint16_t fineTime;          ///< 精细时间计数器（0-9）
 } TickEvent;
 
+/**
+ * @brief 按键事件结构体
+ * 
+ * 扩展基础事件结构，增加按键次数；消费者处理不过来时队列中连续的同一按键会合并成一个事件
+ */
+typedef struct KeyEventTag {
+    Event super;                ///< 继承的基础事件
+    uint16_t repeat;            ///< 按键次数
+} KeyEvent;
+
+/**
+ * @brief 队列元素编码：低8位为按键字符，高位为按键次数减一
+ */
+#define KEY_ITEM(key, repeat) ((void *)(((uintptr_t)((repeat) - 1U) << 8) | (uint8_t)(key)))
+#define KEY_ITEM_KEY(item) ((char)((uintptr_t)(item) & 0xFFU))
+#define KEY_ITEM_REPEAT(item) ((uint16_t)(((uintptr_t)(item) >> 8) + 1U))
+
 /**
  * @brief 显示当前超时时间
  * 
@@ -74,7 +100,7 @@ typedef struct TickEventTag {
  */
 static void DisplayTimeout(uint32_t timeout)
 {
-    printf("curTimeout[%d]\n", timeout);
+    ALOG("curTimeout[%d]\n", timeout);
 }
 
 /**
@@ -85,23 +111,23 @@ static void DisplayTimeout(uint32_t timeout)
  */
 static void DisplayCurInput(const char c, uint8_t curInput)
 {
-    printf("%c, curInput[0x%02x]\n", c, curInput);
+    ALOG("%c, curInput[0x%02x]\n", c, curInput);
 }
 
 /**
  * @brief 设置状态下处理UP信号
  * 
- * 增加超时时间（不超过最大值）
+ * 增加超时时间（不超过最大值），合并的多次按键一次处理
  * 
  * @param me 指向炸弹对象的指针
- * @param e 指向事件的指针
+ * @param e 指向按键事件的指针
  */
-void BombSettingUp(Bomb2 *me, const Event *e)
+void BombSettingUp(Bomb2 *me, const KeyEvent *e)
 {
-    UNUSE(e);
-    // 如果未达到最大超时时间，则增加
-    if (me->timeout < BOMB2_MAX_TIMEOUT) {
-        me->timeout++;
+    // 增加按键次数，不超过最大超时时间
+    me->timeout += e->repeat;
+    if (me->timeout > BOMB2_MAX_TIMEOUT) {
+        me->timeout = BOMB2_MAX_TIMEOUT;
     }
     DisplayTimeout(me->timeout);
 }
@@ -109,70 +135,52 @@ void BombSettingUp(Bomb2 *me, const Event *e)
 /**
  * @brief 设置状态下处理DOWN信号
  * 
- * 减少超时时间（不低于最小值）
+ * 减少超时时间（不低于最小值），合并的多次按键一次处理
  * 
  * @param me 指向炸弹对象的指针
- * @param e 指向事件的指针
+ * @param e 指向按键事件的指针
  */
-void BombSettingDown(Bomb2 *me, const Event *e)
+void BombSettingDown(Bomb2 *me, const KeyEvent *e)
 {
-    UNUSE(e);
-    // 如果未达到最小超时时间，则减少
-    if (me->timeout > BOMB2_MIN_TIMEOUT) {
-        me->timeout--;
+    // 减少按键次数，不低于最小超时时间
+    if (me->timeout >= BOMB2_MIN_TIMEOUT + (uint32_t)e->repeat) {
+        me->timeout -= e->repeat;
+    } else {
+        me->timeout = BOMB2_MIN_TIMEOUT;
     }
     DisplayTimeout(me->timeout);
 }
 
-/**
- * @brief 设置状态下处理ARM信号
- * 
- * 启动炸弹计时器，进入计时状态
- * 
- * @param me 指向炸弹对象的指针
- * @param e 指向事件的指针
- */
-void BombSettingArm(Bomb2 *me, const Event *e)
-{
-    UNUSE(e);
-    printf("Bomb2 start\n");
-    DisplayTimeout(me->timeout);
-    // 清空当前输入
-    me->curInput = 0;
-    // 转换到计时状态
-    TRAN(BOMB_STATE_TIMING);
-}
-
 /**
  * @brief 计时状态下处理UP信号
  * 
- * 处理密码输入的"UP"按键
+ * 处理密码输入的"UP"按键，合并的每次按键输入一位
  * 
  * @param me 指向炸弹对象的指针
- * @param e 指向事件的指针
+ * @param e 指向按键事件的指针
  */
-void BombTimingUp(Bomb2 *me, const Event *e)
+void BombTimingUp(Bomb2 *me, const KeyEvent *e)
 {
-    UNUSE(e);
-    // 左移一位并在最低位设置为1
-    me->curInput <<= 1;
-    me->curInput |= 1;
+    // 每次按键左移一位并在最低位设置为1
+    for (uint16_t i = 0; i < e->repeat; i++) {
+        me->curInput <<= 1;
+        me->curInput |= 1;
+    }
     DisplayCurInput('u', me->curInput);
 }
 
 /**
  * @brief 计时状态下处理DOWN信号
  * 
- * 处理密码输入的"DOWN"按键
+ * 处理密码输入的"DOWN"按键，合并的每次按键输入一位
  * 
  * @param me 指向炸弹对象的指针
- * @param e 指向事件的指针
+ * @param e 指向按键事件的指针
  */
-void BombTimingDown(Bomb2 *me, const Event *e)
+void BombTimingDown(Bomb2 *me, const KeyEvent *e)
 {
-    UNUSE(e);
-    // 左移一位，最低位保持为0
-    me->curInput <<= 1;
+    // 每次按键左移一位，最低位保持为0
+    me->curInput = (uint8_t)(e->repeat >= 8 ? 0 : me->curInput << e->repeat);
     DisplayCurInput('d', me->curInput);
 }
 
@@ -187,7 +195,7 @@ void BombTimingDown(Bomb2 *me, const Event *e)
 void BombTimingArm(Bomb2 *me, const Event *e)
 {
     UNUSE(e);
-    printf("Bomb2 stop, curInput[0x%02x]\n", me->curInput);
+    ALOG("Bomb2 stop, curInput[0x%02x]\n", me->curInput);
     // 验证输入密码是否正确
     if (me->curInput == me->passwd) {
         me->curInput = 0;
@@ -210,7 +218,7 @@ void BombTimingTick(Bomb2 *me, const TickEvent *e)
     // 检查超时时间是否有效
     if (me->timeout == 0) {
         // 错误情况：超时时间为0
-        printf("Timing: Tick, error fineTime:%d\n", e->fineTime);
+        ALOG("Timing: Tick, error fineTime:%d\n", e->fineTime);
         return;
     }
 
@@ -222,7 +230,7 @@ void BombTimingTick(Bomb2 *me, const TickEvent *e)
     
     // 如果倒计时结束，触发爆炸
     if (me->timeout == 0) {
-        printf("Bomb2 bomb!!! Reset for again test!\n");
+        ALOG("Bomb2 bomb!!! Reset for again test!\n");
         // 重置超时时间为初始值
         me->timeout = BOMB2_INIT_TIMEOUT;
         // 回到设置状态
@@ -230,17 +238,140 @@ void BombTimingTick(Bomb2 *me, const TickEvent *e)
     }
 }
 
+// 动作列表id
+enum {
+    BOMB_ACTION_NONE,           ///< 无动作
+    BOMB_ACTION_CLEAR_INPUT,    ///< 清空当前输入
+};
+
+// 动作列表池
+static const StateOp bombActions[] = {
+    // BOMB_ACTION_CLEAR_INPUT
+    {STATE_OP_SET, STATE_FIELD(Bomb2, curInput), 0},
+    {STATE_OP_END, 0, 0},
+};
+
+// 自定义处理函数id（旁表下标加1）
+enum {
+    BOMB_CUSTOM_NONE,           ///< 无自定义处理函数
+    BOMB_CUSTOM_SETTING_UP,     ///< BombSettingUp
+    BOMB_CUSTOM_SETTING_DOWN,   ///< BombSettingDown
+    BOMB_CUSTOM_TIMING_UP,      ///< BombTimingUp
+    BOMB_CUSTOM_TIMING_DOWN,    ///< BombTimingDown
+    BOMB_CUSTOM_TIMING_ARM,     ///< BombTimingArm
+    BOMB_CUSTOM_TIMING_TICK,    ///< BombTimingTick
+};
+
+// 自定义处理函数旁表，按id减1排列
+static const Tran bombCustoms[] = {
+    (Tran)BombSettingUp,
+    (Tran)BombSettingDown,
+    (Tran)BombTimingUp,
+    (Tran)BombTimingDown,
+    (Tran)BombTimingArm,
+    (Tran)BombTimingTick,
+};
+
 // 定义状态表：二维数组[state][signal]
-static Tran stateTable[STATE_NUM][SIGNAL_NUM] = {
-    // 设置状态下的各信号处理函数
-    {(Tran)BombSettingUp, (Tran)BombSettingDown, (Tran)BombSettingArm, StateTableEmpty},
+static const StateCell stateCells[STATE_NUM][SIGNAL_NUM] = {
+    // 设置状态：ARM 是纯数据转换，清空输入并进入计时状态；TICK 不做任何处理，都不产生函数调用
+    {
+        STATE_CELL_CUSTOM(BOMB_CUSTOM_SETTING_UP),
+        STATE_CELL_CUSTOM(BOMB_CUSTOM_SETTING_DOWN),
+        STATE_CELL_TRAN(0, BOMB_ACTION_CLEAR_INPUT, BOMB_STATE_TIMING),
+        STATE_CELL_EMPTY,
+    },
     // 计时状态下的各信号处理函数
-    {(Tran)BombTimingUp, (Tran)BombTimingDown, (Tran)BombTimingArm, (Tran)BombTimingTick},
+    {
+        STATE_CELL_CUSTOM(BOMB_CUSTOM_TIMING_UP),
+        STATE_CELL_CUSTOM(BOMB_CUSTOM_TIMING_DOWN),
+        STATE_CELL_CUSTOM(BOMB_CUSTOM_TIMING_ARM),
+        STATE_CELL_CUSTOM(BOMB_CUSTOM_TIMING_TICK),
+    },
 };
 
+// 单元格式的状态表
+static const StateCellTable stateTable = {&stateCells[0][0], NULL, bombActions, bombCustoms};
+
+// 自定义处理函数中的状态转换声明，供状态表校验使用
+static const StateTargetDecl stateTargets[] = {
+    {BOMB_STATE_TIMING, BOMB_SIGNAL_ARM, BOMB_STATE_SETTING},   ///< 密码正确回到设置状态
+    {BOMB_STATE_TIMING, BOMB_SIGNAL_TICK, BOMB_STATE_SETTING},  ///< 倒计时结束回到设置状态
+};
+
+// 事件分发函数，状态表校验通过后换用不做检查的版本
+static void (*bomb2Dispatch)(StateTable *me, const Event *e) = StateTableDispatch;
+
+// 各状态的滴答订阅：只有计时状态需要滴答事件
+static const bool tickRows[STATE_NUM] = {false, true};
+
+#ifdef FSM_HISTORY
+// 转换历史环，按 h 键或崩溃时导出
+static FsmHistory bomb2History;
+#endif // FSM_HISTORY
+
+#ifdef STATETBL_PROFILE
+// 状态表单元命中计数，退出时写入 bomb2.prof，供 tblremap 工具重排状态表
+static uint32_t cellHits[STATE_NUM * SIGNAL_NUM];
+#endif // STATETBL_PROFILE
+
+#ifdef FSM_PERF_PROFILE
+// 硬件计数器统计，退出时写入 bomb2.perf，供 perfreport 工具排序
+static PerfProf bomb2Perf;
+static const char *const perfStateNames[STATE_NUM] = {"setting", "timing"};
+static const char *const perfSignalNames[SIGNAL_NUM] = {"UP", "DOWN", "ARM", "TICK"};
+#endif // FSM_PERF_PROFILE
+
 // 键盘输入队列及相关变量
 static SyncQueue keyQueue;              ///< 键盘输入队列
 static void *keyBuffer[10];             ///< 队列缓冲区
+static VClock runClock;                 ///< 运行循环时钟（真实/虚拟时间）
+#ifdef BOMB_RT_PROFILE
+static const RtProfile rtProfile = RT_PROFILE_DEFAULT; ///< 倒计时线程的实时配置
+#endif // BOMB_RT_PROFILE
+
+// 按键合并键：u/d 只改变计数类的数据，连续按键合并为一个带次数的事件；a 和 ESC 不合并
+enum {
+    KEY_COALESCE_UP,            ///< 'u'
+    KEY_COALESCE_DOWN,          ///< 'd'
+    KEY_COALESCE_MAX,           ///< 合并键数量
+};
+
+static const uint8_t keyPolicies[KEY_COALESCE_MAX] = {QUEUE_COALESCE_MERGE, QUEUE_COALESCE_MERGE};
+
+/**
+ * @brief 按键队列元素的合并键
+ * 
+ * @param item 队列元素
+ * @return 合并键，-1 表示不合并
+ */
+static int KeyCoalesceKey(const void *item)
+{
+    switch (KEY_ITEM_KEY(item)) {
+    case 'u':
+        return KEY_COALESCE_UP;
+    case 'd':
+        return KEY_COALESCE_DOWN;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief 合并两个同键的按键元素：次数累加
+ * 
+ * @param queued 队尾的元素
+ * @param item 新入队的元素
+ * @return 合并后的元素
+ */
+static void *KeyCoalesceMerge(void *queued, void *item)
+{
+    uint32_t repeat = (uint32_t)KEY_ITEM_REPEAT(queued) + KEY_ITEM_REPEAT(item);
+    if (repeat > UINT16_MAX) {
+        repeat = UINT16_MAX;
+    }
+    return KEY_ITEM(KEY_ITEM_KEY(queued), repeat);
+}
 
 /**
  * @brief 炸弹初始状态处理函数
@@ -258,7 +389,7 @@ static void Bomb2Initial(StateTable *me)
     bomb2->passwd = 0xD;
     // 转换到设置状态
     TRAN(BOMB_STATE_SETTING);
-    printf("Bomb2Initial...\n");
+    ALOG("Bomb2Initial...\n");
 }
 
 /**
@@ -272,15 +403,31 @@ static void Bomb2Initial(StateTable *me)
 void* Bomb2Run(void *arg)
 {
     UNUSE(arg);
+#ifdef BOMB_RT_PROFILE
+    // 倒计时线程：绑定CPU、SCHED_FIFO、预先触碰栈
+    if (RtThreadInit(&rtProfile) != 0) {
+        ALOG("rt thread init failed, running without real-time scheduling\n");
+    }
+#endif // BOMB_RT_PROFILE
+#ifdef FSM_PERF_PROFILE
+    // 计数器只属于打开它的线程，在分发线程上初始化
+    if (PerfProfCtor(&bomb2Perf, "bomb2", STATE_NUM, SIGNAL_NUM) == 0) {
+        PerfProfSetNames(&bomb2Perf, perfStateNames, perfSignalNames);
+        StateTableSetPerf((StateTable *)&g_bomb2, &bomb2Perf);
+    }
+#endif // FSM_PERF_PROFILE
     // 初始化状态机
     StateTableInit((StateTable *)&g_bomb2);
 
+    void *item;
     char key;
     // 无限循环处理事件
     for (;;) {
         bool isTimeout = false;
-        // 从队列中获取按键或超时
-        key = (char)(uintptr_t)QueueDequeueWithTimeout(&keyQueue, TICK_INTERVAL_100MS, &isTimeout);
+        // 从队列中获取按键或超时，当前状态不需要滴答时一直等待按键
+        uint32_t tickMs = StateTableNeedTick((StateTable *)&g_bomb2) ? TICK_INTERVAL_100MS : 0;
+        item = VClockDequeue(&runClock, &keyQueue, tickMs, &isTimeout);
+        key = KEY_ITEM_KEY(item);
         
         if (isTimeout) {
             // 超时情况：发送滴答事件
@@ -290,26 +437,33 @@ void* Bomb2Run(void *arg)
                 tickEvent.fineTime = 0;
             }
             // 分发滴答事件
-            StateTableDispatch((StateTable *)&g_bomb2, (Event *)&tickEvent);
+            bomb2Dispatch((StateTable *)&g_bomb2, (Event *)&tickEvent);
         } else {
-            // 按键情况：创建对应事件并分发
-            static const Event upEvent = {BOMB_SIGNAL_UP};
-            static const Event downEvent = {BOMB_SIGNAL_DOWN};
-            static const Event armEvent = {BOMB_SIGNAL_ARM};
+            // 按键情况：创建对应事件并分发，u/d 事件带上合并后的按键次数
+            static KeyEvent upEvent = {{BOMB_SIGNAL_UP}, 1};
+            static KeyEvent downEvent = {{BOMB_SIGNAL_DOWN}, 1};
+            static const KeyEvent armEvent = {{BOMB_SIGNAL_ARM}, 1};
             static const Event *e = NULL;
         
             // 根据按键类型选择对应事件
             switch (key)
             {
             case 'u':
-                e = &upEvent;
+                upEvent.repeat = KEY_ITEM_REPEAT(item);
+                e = (const Event *)&upEvent;
                 break;
             case 'd':
-                e = &downEvent;
+                downEvent.repeat = KEY_ITEM_REPEAT(item);
+                e = (const Event *)&downEvent;
                 break;
             case 'a':
-                e = &armEvent;
+                e = (const Event *)&armEvent;
+                break;
+#ifdef FSM_HISTORY
+            case 'h':  // 导出转换历史
+                FsmHistoryDump(STDOUT_FILENO, "bomb2", &bomb2History);
                 break;
+#endif // FSM_HISTORY
             case '\33':  // ESC键退出
                 return NULL;
             default:
@@ -318,7 +472,7 @@ void* Bomb2Run(void *arg)
 
             // 如果有有效事件，则分发
             if (e != NULL) {
-                StateTableDispatch((StateTable *)&g_bomb2, e);
+                bomb2Dispatch((StateTable *)&g_bomb2, e);
                 e = NULL;
             }
         }
@@ -337,9 +491,45 @@ void* Bomb2Run(void *arg)
 int main()
 {
     // 初始化炸弹状态机
-    StateTableCtor((StateTable *)&g_bomb2, &stateTable[0][0], STATE_NUM, SIGNAL_NUM, Bomb2Initial);
+    StateTableCellCtor((StateTable *)&g_bomb2, &stateTable, STATE_NUM, SIGNAL_NUM, Bomb2Initial);
+    // 校验状态表，校验不通过时打印结果并继续使用带检查的分发
+    StateTableReport report;
+    if (!StateTableVerify((StateTable *)&g_bomb2, BOMB_STATE_SETTING, stateTargets,
+                          sizeof(stateTargets) / sizeof(stateTargets[0]), &report)) {
+        StateTableReportPrint(&report, "bomb2");
+    } else {
+        // 校验通过后换用不做检查的分发；分发的事件都来自 BombSignal，信号不会越界
+        _Static_assert(BOMB_SIGNAL_MAX == SIGNAL_NUM, "bomb2 signals must match the state table width");
+        bomb2Dispatch = StateTableDispatchTrustedCells;
+    }
+#ifdef FSM_HISTORY
+    // 记录转换历史，崩溃时导出
+    StateTableSetHistory((StateTable *)&g_bomb2, &bomb2History);
+    FsmHistoryWatch("bomb2", &bomb2History);
+    FsmHistoryInstallCrashHandler();
+#endif // FSM_HISTORY
+    // 设置滴答订阅，设置状态下不再周期唤醒
+    StateTableSetTickRows((StateTable *)&g_bomb2, tickRows);
+#ifdef STATETBL_PROFILE
+    // 统计状态表单元命中次数
+    StateTableSetProfile((StateTable *)&g_bomb2, cellHits);
+#endif // STATETBL_PROFILE
     // 初始化键盘输入队列
     QueueCtor(&keyQueue, keyBuffer, 10);
+    // 状态机线程处理不过来时合并连续的 u/d 按键，避免队列被占满后丢键
+    QueueSetCoalesce(&keyQueue, KeyCoalesceKey, keyPolicies, KEY_COALESCE_MAX, KeyCoalesceMerge, NULL);
+    // 启动异步日志线程，状态处理函数中不再同步打印
+    ALogStart(ALOG_OVERFLOW_DROP);
+#ifdef BOMB_RT_PROFILE
+    // 锁定内存：队列、状态机对象和状态表都在启动阶段准备好，运行期不再缺页
+    if (RtProcessInit() != 0 || RtQueueInit(&keyQueue, &rtProfile) != 0 ||
+        RtLock(&g_bomb2, sizeof(g_bomb2)) != 0 || RtLock((void *)stateCells, sizeof(stateCells)) != 0) {
+        ALOG("rt memory lock failed, page faults may add jitter\n");
+    }
+#endif // BOMB_RT_PROFILE
+
+    // 初始化运行循环时钟，输入线程会调用 VClockIdle，需在创建运行线程前初始化
+    VClockCtor(&runClock, VCLOCK_DEFAULT_SIMULATED);
 
     // 创建炸弹运行线程
     pthread_t bomb2Thread;
@@ -353,19 +543,29 @@ int main()
         {
         case 'u':
             // UP键入队
-            QueueEnqueue(&keyQueue, (void *)'u');
+            QueueEnqueue(&keyQueue, KEY_ITEM('u', 1));
             break;
         case 'd':
             // DOWN键入队
-            QueueEnqueue(&keyQueue, (void *)'d');
+            QueueEnqueue(&keyQueue, KEY_ITEM('d', 1));
             break;
         case 'a':
             // ARM键入队
-            QueueEnqueue(&keyQueue, (void *)'a');
+            QueueEnqueue(&keyQueue, KEY_ITEM('a', 1));
+            break;
+#ifdef FSM_HISTORY
+        case 'h':
+            // 导出转换历史
+            QueueEnqueue(&keyQueue, KEY_ITEM('h', 1));
+            break;
+#endif // FSM_HISTORY
+        case 't':
+            // 虚拟时间模式下声明空闲1秒，让倒计时前进（真实时间模式下无效）
+            VClockIdle(&runClock, &keyQueue, 10 * TICK_INTERVAL_100MS);
             break;
         case '\33':  // ESC键退出程序
             bombRunning = false;
-            QueueEnqueue(&keyQueue, (void *)'\33');
+            QueueEnqueue(&keyQueue, KEY_ITEM('\33', 1));
             break;
         default:
             break;
@@ -374,6 +574,26 @@ int main()
     
     // 等待炸弹线程结束
     pthread_join(bomb2Thread, NULL);
+    // 写出剩余日志
+    ALogStop();
+#ifdef STATETBL_PROFILE
+    // 保存命中计数和单元描述，tblremap 据此输出重排后的单元表和滴答订阅
+    FILE *prof = fopen("bomb2.prof", "w");
+    if (prof != NULL) {
+        StateTableProfileSave(prof, cellHits, STATE_NUM, SIGNAL_NUM);
+        StateTableCellsSave(prof, &stateCells[0][0], tickRows, STATE_NUM, SIGNAL_NUM);
+        fclose(prof);
+    }
+#endif // STATETBL_PROFILE
+#ifdef FSM_PERF_PROFILE
+    // 保存硬件计数器统计
+    FILE *perf = fopen("bomb2.perf", "w");
+    if (perf != NULL) {
+        PerfProfSave(&bomb2Perf, perf);
+        fclose(perf);
+    }
+    PerfProfDtor(&bomb2Perf);
+#endif // FSM_PERF_PROFILE
     printf("main exit\n");
 
     return 0;
@@ -2,11 +2,13 @@
 #include <cstdint>
 #include <thread>
 #include <array>
-#include <functional>
-#include <variant>
-#include <string>
 #include <conio.h>
-#include "sync_queue.h"
+#include "active_object.hpp"
+#include "alog.h"
+#include "delegate.hpp"
+#ifdef FSM_PERF_PROFILE
+#include "perf_prof.h"
+#endif
 
 // 定义初始超时时间（秒）
 constexpr uint8_t TIMEOUT_INITIAL = 15U;
@@ -18,8 +20,8 @@ constexpr uint8_t TIMEOUT_MAX = 120U;
 constexpr uint32_t TICK100MS = 100;
 // 子状态数量
 constexpr uint8_t SUB_STATE_NUM = 4;
-// 退出状态标识
-constexpr uint8_t STATE_EXIT = 255;
+// 键盘队列容量
+constexpr uint32_t KEY_QUEUE_SIZE = 10;
 
 // 子状态枚举
 enum SubState : uint8_t
@@ -46,6 +48,11 @@ public:
     virtual void OnArm(Bomb3 *bomb) = 0;
     // 纯虚函数，处理计时器滴答
     virtual void OnTick(Bomb3 *bomb, uint8_t fineTime) = 0;
+    // 该状态是否需要周期性的滴答事件，默认不需要
+    virtual bool NeedTick() const
+    {
+        return false;
+    }
 };
 
 // 设置状态类，继承自BombState
@@ -66,97 +73,122 @@ public:
     void OnDown(Bomb3 *bomb) override;
     void OnArm(Bomb3 *bomb) override;
     void OnTick(Bomb3 *bomb, uint8_t fineTime) override;
+    bool NeedTick() const override
+    {
+        return true;
+    }
 };
 
-// 键盘输入队列及相关变量
-static SyncQueue keyQueue;
-static void *keyBuffer[10] = {0};             ///< 队列缓冲区
-
-// 主要的炸弹控制类
+// 主要的炸弹控制类，作为 ActiveObject 的引擎实现 Init/Dispatch/Tick/NeedTick，
+// 运行循环（取事件、产生滴答、退出）由 ActiveObject 提供
 class Bomb3
 {
 public:
-    // 初始化函数
-    void Init(uint8_t passwd)
+    explicit Bomb3(uint8_t passwd) : passwd_(passwd)
+    {
+    }
+
+    // 初始化函数，在运行线程上由 ActiveObject 调用
+    void Init()
     {
         curState_ = &setting_;  // 初始状态为设置状态
         timeout_ = TIMEOUT_INITIAL;  // 设置初始超时时间
-        passwd_ = passwd;  // 设置密码
         curInput_ = 0;  // 初始化当前输入
-
-        // 初始化子状态处理函数表
-        subStateTable_[SubState::SUB_STATE_UP] = [this] {
-            OnUp();
-        };
-        subStateTable_[SubState::SUB_STATE_DOWN] = [this] {
-            OnDown();
-        };
-        subStateTable_[SubState::SUB_STATE_ARM] = [this] {
-            OnArm();
-        };
-        subStateTable_[SubState::SUB_STATE_TICK] = [this] (uint8_t fineTime) {
-            OnTick(fineTime);
-        };
+        fineTime_ = 0;
+#ifdef FSM_PERF_PROFILE
+        // 计数器只属于打开它的线程，在运行线程上初始化
+        static const char *const stateNames[] = {"setting", "timing"};
+        static const char *const signalNames[SUB_STATE_NUM] = {"UP", "DOWN", "ARM", "TICK"};
+        PerfProfCtor(&perf_, "bomb3", 2, SUB_STATE_NUM);
+        PerfProfSetNames(&perf_, stateNames, signalNames);
+#endif
+
+        // 初始化子状态处理函数表，按键处理函数忽略事件参数
+        subStateTable_[SubState::SUB_STATE_UP] = SubStateFunction::Bind<&Bomb3::OnUp>(this);
+        subStateTable_[SubState::SUB_STATE_DOWN] = SubStateFunction::Bind<&Bomb3::OnDown>(this);
+        subStateTable_[SubState::SUB_STATE_ARM] = SubStateFunction::Bind<&Bomb3::OnArm>(this);
+        subStateTable_[SubState::SUB_STATE_TICK] = SubStateFunction::Bind<&Bomb3::OnTick>(this);
     }
 
     // 处理向上操作
     void OnUp()
     {
-        curState_->OnUp(this);
+        Handle(SubState::SUB_STATE_UP, [this] { curState_->OnUp(this); });
     }
 
     // 处理向下操作
     void OnDown()
     {
-        curState_->OnDown(this);
+        Handle(SubState::SUB_STATE_DOWN, [this] { curState_->OnDown(this); });
     }
 
     // 处理武器激活操作
     void OnArm()
     {
-        curState_->OnArm(this);
+        Handle(SubState::SUB_STATE_ARM, [this] { curState_->OnArm(this); });
     }
 
     // 处理计时器滴答
     void OnTick(uint8_t fineTime)
     {
         if (curState_ == &timing_) {
-            curState_->OnTick(this, fineTime);
+            Handle(SubState::SUB_STATE_TICK, [this, fineTime] { curState_->OnTick(this, fineTime); });
         }
     }
 
-    // 主运行循环
-    void Run()
+    // 分发按键事件（SUB_STATE_UP/DOWN/ARM）
+    void Dispatch(uintptr_t key)
     {
-        for (;;) {
-            bool isTimeout = false;
-            // 从队列中取出状态或等待超时
-            uint8_t state = (uint8_t)(uintptr_t)QueueDequeueWithTimeout(&keyQueue, TICK100MS, &isTimeout);
-            if (isTimeout) {
-                // 处理计时器滴答
-                static uint8_t fineTime = 0;
-                if (++fineTime == 10) {
-                    fineTime = 0;
-                }
-                // 调用滴答处理函数
-                if (auto func = std::get_if<std::function<void(uint8_t)>>(&subStateTable_[SubState::SUB_STATE_TICK])) {
-                    (*func)(fineTime);
-                } else {
-                    std::cout << "error type function" << std::endl;
-                }
-            } else if (state == STATE_EXIT) {
-                // 处理退出状态
-                break;
-            } else {
-                // 处理其他状态
-                if (auto func = std::get_if<std::function<void()>>(&subStateTable_[state])) {
-                    (*func)();
-                }
-            }
+        if (key < SubState::SUB_STATE_TICK) {
+            subStateTable_[key](0);
         }
     }
 
+    // 分发计时器滴答
+    void Tick()
+    {
+        if (++fineTime_ == 10) {
+            fineTime_ = 0;
+        }
+        subStateTable_[SubState::SUB_STATE_TICK](fineTime_);
+    }
+
+    // 当前状态是否需要滴答事件
+    bool NeedTick() const
+    {
+        return curState_->NeedTick();
+    }
+
+#ifdef FSM_PERF_PROFILE
+    // 保存硬件计数器统计并关闭计数器，运行线程结束后调用
+    void SavePerf(const char *path)
+    {
+        FILE *out = fopen(path, "w");
+        if (out != nullptr) {
+            PerfProfSave(&perf_, out);
+            fclose(out);
+        }
+        PerfProfDtor(&perf_);
+    }
+#endif
+
 private:
+    // 调用当前状态的处理函数，打开硬件计数器统计时计入分发前的（状态，信号）
+    template <typename Handler>
+    void Handle(SubState signal, Handler handler)
+    {
+#ifdef FSM_PERF_PROFILE
+        PerfProfSample sample;
+        uint32_t state = curState_ == &setting_ ? 0 : 1;
+        PerfProfBegin(&perf_, &sample);
+        handler();
+        PerfProfEnd(&perf_, &sample, state, signal);
+#else
+        (void)signal;
+        handler();
+#endif
+    }
+
     // 状态转换函数
     void Tran(BombState *state)
     {
@@ -168,13 +200,14 @@ private:
     uint8_t timeout_;      // 超时时间
     uint8_t passwd_;       // 密码
     uint8_t curInput_;     // 当前输入
+    uint8_t fineTime_ = 0; // 滴答计数（100ms）
+#ifdef FSM_PERF_PROFILE
+    PerfProf perf_;        // 硬件计数器统计
+#endif
+
+    // 子状态函数类型定义：统一携带一个事件参数（滴答时为精细时间）
+    using SubStateFunction = Delegate<void(uint8_t)>;
 
-    // 子状态函数类型定义
-    using SubStateFunction = std::variant<
-        std::function<void()>,
-        std::function<void(uint8_t)>
-    >;
-    
     // 子状态处理函数表
     std::array<SubStateFunction, SUB_STATE_NUM> subStateTable_;
 
@@ -191,10 +224,13 @@ private:
 SettingState Bomb3::setting_;
 TimingState Bomb3::timing_;
 
+// 炸弹活动对象：互斥锁队列，时间源由 BOMB_SIM_CLOCK 决定
+using Bomb3Active = ActiveObject<Bomb3, SyncQueuePolicy<KEY_QUEUE_SIZE>, DefaultTimer>;
+
 // 打印超时信息的辅助函数
-static void PrintTimeout(const std::string &s, uint8_t timeout)
+static void PrintTimeout(const char *s, uint8_t timeout)
 {
-    std::cout << s << ", Bomb3 timeout[" << timeout << "]" << std::endl;
+    ALOG("%s, Bomb3 timeout[%d]\n", s, timeout);
 }
 
 // 设置状态下处理向上操作
@@ -220,7 +256,7 @@ void SettingState::OnArm(Bomb3 *bomb)
 {
     bomb->Tran(&Bomb3::timing_);
     bomb->curInput_ = 0;
-    std::cout << "Bomb3 start..." << std::endl;
+    ALOG("Bomb3 start...\n");
 }
 
 // 设置状态下处理计时器滴答（空实现）
@@ -235,14 +271,14 @@ void TimingState::OnUp(Bomb3 *bomb)
 {
     bomb->curInput_ <<= 1;
     bomb->curInput_ |= 1;
-    std::cout << "u, curInput[" << bomb->curInput_ << "]" << std::endl;
+    ALOG("u, curInput[%d]\n", bomb->curInput_);
 }
 
 // 计时状态下处理向下操作
 void TimingState::OnDown(Bomb3 *bomb)
 {
     bomb->curInput_ <<= 1;
-    std::cout << "d, curInput[" << bomb->curInput_ << "]" << std::endl;
+    ALOG("d, curInput[%d]\n", bomb->curInput_);
 }
 
 // 计时状态下处理武器激活操作
@@ -250,7 +286,7 @@ void TimingState::OnArm(Bomb3 *bomb)
 {
     if (bomb->curInput_ == bomb->passwd_) {
         bomb->Tran(&Bomb3::setting_);
-        std::cout << "Bomb3 stop" << std::endl;
+        ALOG("Bomb3 stop\n");
     }
 }
 
@@ -258,7 +294,7 @@ void TimingState::OnArm(Bomb3 *bomb)
 void TimingState::OnTick(Bomb3 *bomb, uint8_t fineTime)
 {
     if (bomb->timeout_ == 0) {
-        std::cout << "OnTick error" << std::endl;
+        ALOG("OnTick error\n");
         return;
     }
 
@@ -268,7 +304,7 @@ void TimingState::OnTick(Bomb3 *bomb, uint8_t fineTime)
     }
 
     if (bomb->timeout_ == 0) {
-        std::cout << "Bomb3 bomb!!! Reset for again test!" << std::endl;
+        ALOG("Bomb3 bomb!!! Reset for again test!\n");
         bomb->Tran(&Bomb3::setting_);
         bomb->timeout_ = TIMEOUT_INITIAL;
     }
@@ -277,13 +313,13 @@ void TimingState::OnTick(Bomb3 *bomb, uint8_t fineTime)
 // 主函数
 int main()
 {
-    // 初始化队列
-    QueueCtor(&keyQueue, keyBuffer, 10);
-    Bomb3 bomp3;
-    bomp3.Init(0xD);  // 初始化炸弹，密码为0xD
+    // 启动异步日志线程
+    ALogStart(ALOG_OVERFLOW_DROP);
+    Bomb3Active bomb3(0xD);  // 密码为0xD
+    bomb3.SetTick(TICK100MS);
 
     // 创建运行线程
-    std::thread t(Bomb3::Run, std::ref(bomp3));
+    std::thread t(&Bomb3Active::Run, std::ref(bomb3));
 
     bool bombRunning = true;
     // 主循环处理键盘输入
@@ -291,17 +327,20 @@ int main()
         switch (getch())
         {
         case 'u':
-            QueueEnqueue(&keyQueue, (void *)SubState::SUB_STATE_UP);
+            bomb3.Post(SubState::SUB_STATE_UP);
             break;
         case 'd':
-            QueueEnqueue(&keyQueue, (void *)SubState::SUB_STATE_DOWN);
+            bomb3.Post(SubState::SUB_STATE_DOWN);
             break;
         case 'a':
-            QueueEnqueue(&keyQueue, (void *)SubState::SUB_STATE_ARM);
+            bomb3.Post(SubState::SUB_STATE_ARM);
+            break;
+        case 't':  // 虚拟时间模式下声明空闲1秒（真实时间模式下无效）
+            bomb3.Idle(10 * TICK100MS);
             break;
         case '\33':  // ESC键
             bombRunning = false;
-            QueueEnqueue(&keyQueue, (void *)STATE_EXIT);
+            bomb3.Stop();
             break;
         default:
             break;
@@ -310,6 +349,12 @@ int main()
     
     // 等待线程结束
     t.join();
+    // 写出剩余日志
+    ALogStop();
+#ifdef FSM_PERF_PROFILE
+    // 保存硬件计数器统计，供 perfreport 排序
+    bomb3.GetEngine().SavePerf("bomb3.perf");
+#endif
     std::cout << "main exit" << std::endl;
 
     return 0;
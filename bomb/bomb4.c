@@ -1,5 +1,7 @@
 #include "qfsm.h"
 #include "sync_queue.h"
+#include "vclock.h"
+#include "alog.h"
 #include <pthread.h>
 #include <conio.h>
 #include <stdio.h>
@@ -35,6 +37,18 @@ typedef struct Bomb4Tag {
 // 全局变量声明
 static Bomb4 g_bomb4;              // 全局炸弹状态机实例
 static SyncQueue keyQueue;         // 按键消息队列
+static VClock runClock;            // 运行循环时钟(真实/虚拟时间)
+#ifdef FSM_HISTORY
+static FsmHistory bomb4History;    // 转换历史环，崩溃时导出
+#endif
+#ifdef FSM_PERF_PROFILE
+#define BOMB4_PERF_STATES 2                        // 统计的状态数(设置、计时)
+#define BOMB4_PERF_SIGNALS (BOMB_TICK_SIGNAL + 1)  // 统计的信号数，按信号值索引
+static PerfProf bomb4Perf;         // 硬件计数器统计，退出时写入 bomb4.perf
+static const char *const bomb4SignalNames[BOMB4_PERF_SIGNALS] = {
+    NULL, "ENTRY", "EXIT", "INIT", "UP", "DOWN", "ARM", "TICK",
+};
+#endif
 static void *keyBuffer[10]; // 这里注意，一定要和syncqueue要求的数组元素类型（元素长度）匹配，
                             // 否则QueueEnqueue会给单个元素可能赋值长度更长的元素导致数组越界，
                             // 比如 static char keyBuffer[10]; QueueCtor(&keyQueue, (void **)&keyBuffer, 10);
@@ -47,7 +61,7 @@ static void *keyBuffer[10]; // 这里注意，一定要和syncqueue要求的数
  */
 static void DisplayTimeout(uint8_t timeout)
 {
-    printf("timeout[%d]\n", timeout);
+    ALOG("timeout[%d]\n", timeout);
 }
 
 // 前向声明状态处理函数
@@ -62,10 +76,10 @@ QState Bomb4Setting(Bomb4 *me, QEvent *e)
     switch (e->signal)
     {
     case Q_ENTRY_SIGNAL:
-        printf("setting entry\n");
+        ALOG("setting entry\n");
         return Q_HANDLED();
     case Q_EXIT_SIGNAL:
-        printf("setting exit\n");
+        ALOG("setting exit\n");
         return Q_HANDLED();
     case BOMB_UP_SIGNAL:
         // 增加超时时间，不超过最大值
@@ -104,10 +118,12 @@ QState Bomb4Timing(Bomb4 *me, QEvent *e)
     {
     case Q_ENTRY_SIGNAL:
         needResetFineTime = true;
-        printf("timing enter\n");
+        Q_TICK_ARM();  // 计时状态需要滴答事件
+        ALOG("timing enter\n");
         return Q_HANDLED();
     case Q_EXIT_SIGNAL:
-        printf("timing exit\n");
+        Q_TICK_DISARM();  // 离开计时状态后不再需要滴答
+        ALOG("timing exit\n");
         return Q_HANDLED();
     case BOMB_UP_SIGNAL:
         // 记录输入序列: UP键对应二进制1
@@ -121,7 +137,7 @@ QState Bomb4Timing(Bomb4 *me, QEvent *e)
     case BOMB_ARM_SIGNAL:
         // 检查输入密码是否正确
         if (me->curInput == me->passwd) {
-            printf("Bomb4 pause!\n");
+            ALOG("Bomb4 pause!\n");
             return Q_TRAN(Bomb4Setting);  // 密码正确，暂停炸弹
         }
         break;
@@ -135,7 +151,7 @@ QState Bomb4Timing(Bomb4 *me, QEvent *e)
 
         // 时间到，炸弹爆炸并重置
         if (me->timeout == 0) {
-            printf("Bomb4 bomb! Reset for again test!\n");
+            ALOG("Bomb4 bomb! Reset for again test!\n");
             me->timeout = BOMB_TIMOUT_INIT;  // 重置时间
             return Q_TRAN(Bomb4Setting);     // 返回设置状态
         }
@@ -183,18 +199,29 @@ void *Bomb4Run(void *arg)
     static QEvent armEvent = {BOMB_ARM_SIGNAL, 0};
     static TickEvent tickEvent = {{BOMB_TICK_SIGNAL, 0}, 0};
 
+#ifdef FSM_PERF_PROFILE
+    // 计数器只属于打开它的线程，在分发线程上初始化，并按处理函数登记状态名
+    if (PerfProfCtor(&bomb4Perf, "bomb4", BOMB4_PERF_STATES, BOMB4_PERF_SIGNALS) == 0) {
+        PerfProfSetNames(&bomb4Perf, NULL, bomb4SignalNames);
+        PerfProfStateOf(&bomb4Perf, (const void *)Bomb4Setting, "setting");
+        PerfProfStateOf(&bomb4Perf, (const void *)Bomb4Timing, "timing");
+        QFsmSetPerf(&g_bomb4.super, &bomb4Perf);
+    }
+#endif
+
     for (;;) {
         bool isTimeout = false;
         QEvent *e = NULL;
         
-        // 从按键队列获取输入，超时则产生滴答事件
-        char c = (char)(uintptr_t)QueueDequeueWithTimeout(&keyQueue, TICK_INTERVAL_100MS, &isTimeout);
+        // 从按键队列获取输入，订阅了滴答时超时则产生滴答事件
+        uint32_t tickMs = QFsmNeedTick(&g_bomb4.super) ? TICK_INTERVAL_100MS : 0;
+        char c = (char)(uintptr_t)VClockDequeue(&runClock, &keyQueue, tickMs, &isTimeout);
         if (isTimeout) {
             // 处理超时情况，生成滴答事件
             if (needResetFineTime) {
                 tickEvent.fineTime = 0;
                 needResetFineTime = false;
-                printf("reset tickEvent.fineTime to 0!\n");
+                ALOG("reset tickEvent.fineTime to 0!\n");
             }
 
             // 更新精细时间计数器
@@ -239,9 +266,17 @@ void *Bomb4Run(void *arg)
 int main()
 {
     QueueCtor(&keyQueue, keyBuffer, 10);  // 初始化按键队列
+    ALogStart(ALOG_OVERFLOW_DROP);        // 启动异步日志线程
     Bomb4Ctor(&g_bomb4, 0xD);             // 初始化炸弹状态机(密码0xD)
+#ifdef FSM_HISTORY
+    QFsmSetHistory(&g_bomb4.super, &bomb4History);  // 记录转换历史
+    FsmHistoryWatch("bomb4", &bomb4History);
+    FsmHistoryInstallCrashHandler();
+#endif
     QFsmInit(&g_bomb4.super, NULL);       // 初始化状态机
 
+    VClockCtor(&runClock, VCLOCK_DEFAULT_SIMULATED);  // 初始化运行循环时钟(输入线程会调用 VClockIdle)
+
     bool isRunning = true;
     pthread_t tid;
     pthread_create(&tid, NULL, Bomb4Run, &isRunning);  // 创建控制线程
@@ -249,10 +284,25 @@ int main()
     // 主线程处理键盘输入
     while (isRunning) {
         char c = getch();  // 获取按键输入
+        if (c == 't') {
+            // 虚拟时间模式下声明空闲1秒(真实时间模式下无效)
+            VClockIdle(&runClock, &keyQueue, 10 * TICK_INTERVAL_100MS);
+            continue;
+        }
         QueueEnqueue(&keyQueue, (void *)(uintptr_t)c);  // 加入队列
     }
 
     pthread_join(tid, NULL);  // 等待控制线程结束
+    ALogStop();               // 写出剩余日志
+#ifdef FSM_PERF_PROFILE
+    // 保存硬件计数器统计，供 perfreport 排序
+    FILE *perf = fopen("bomb4.perf", "w");
+    if (perf != NULL) {
+        PerfProfSave(&bomb4Perf, perf);
+        fclose(perf);
+    }
+    PerfProfDtor(&bomb4Perf);
+#endif
     printf("main exit\n");
 
     return 0;
@@ -0,0 +1,276 @@
+#include <iostream>
+#include <cstdint>
+#include <thread>
+#include <optional>
+#include <variant>
+#include <conio.h>
+#include "active_object.hpp"
+#include "alog.h"
+
+// 静态多态版本的炸弹状态机
+// 与 bomb3 的状态写法相同（每个状态一个类，OnUp/OnDown/OnArm/OnTick），
+// 但状态集合在编译期确定，保存在 std::variant 中，通过 std::visit 分发，
+// 没有虚函数调用，处理函数可以内联，状态也可以携带自己的数据。
+// 运行循环由 ActiveObject 提供，Bomb5 只作为引擎实现 Init/Dispatch/Tick/NeedTick。
+
+// 定义初始超时时间（秒）
+constexpr uint8_t TIMEOUT_INITIAL = 15U;
+// 定义最小超时时间（秒）
+constexpr uint8_t TIMEOUT_MIN = 10U;
+// 定义最大超时时间（秒）
+constexpr uint8_t TIMEOUT_MAX = 120U;
+// 定义定时器周期（毫秒）
+constexpr uint32_t TICK100MS = 100;
+// 键盘队列容量
+constexpr uint32_t KEY_QUEUE_SIZE = 16;
+
+// 按键事件枚举
+enum KeyEvent : uint8_t
+{
+    KEY_EVENT_UP = 0,    // 向上调整
+    KEY_EVENT_DOWN,      // 向下调整
+    KEY_EVENT_ARM,       // 武器激活
+};
+
+// 前向声明Bomb5类
+class Bomb5;
+
+// 设置状态，没有自己的数据
+class SettingState final
+{
+public:
+    static constexpr bool NEED_TICK = false;  // 设置状态不需要滴答
+
+    void OnUp(Bomb5 &bomb);
+    void OnDown(Bomb5 &bomb);
+    void OnArm(Bomb5 &bomb);
+    void OnTick(Bomb5 &bomb, uint8_t fineTime)
+    {
+        (void)bomb;
+        (void)fineTime;
+    }
+};
+
+// 计时状态，密码输入只在计时状态有意义，作为状态自己的数据保存
+class TimingState final
+{
+public:
+    static constexpr bool NEED_TICK = true;  // 计时状态需要滴答
+
+    void OnUp(Bomb5 &bomb);
+    void OnDown(Bomb5 &bomb);
+    void OnArm(Bomb5 &bomb);
+    void OnTick(Bomb5 &bomb, uint8_t fineTime);
+
+private:
+    uint8_t curInput_ = 0;  // 当前输入
+};
+
+// 编译期确定的状态集合
+using BombState = std::variant<SettingState, TimingState>;
+
+// 主要的炸弹控制类
+class Bomb5
+{
+public:
+    explicit Bomb5(uint8_t passwd) : passwd_(passwd)
+    {
+    }
+
+    // 初始化函数，在运行线程上由 ActiveObject 调用
+    void Init()
+    {
+        curState_ = SettingState{};  // 初始状态为设置状态
+        timeout_ = TIMEOUT_INITIAL;  // 设置初始超时时间
+        fineTime_ = 0;
+    }
+
+    // 分发一个事件到当前状态，handler 为 [](auto &state, Bomb5 &bomb) 形式的泛型处理函数
+    template <typename Handler>
+    void Visit(Handler &&handler)
+    {
+        std::visit([this, &handler](auto &state) { handler(state, *this); }, curState_);
+        // 处理函数执行完后再切换状态，避免在状态对象的成员函数中销毁自身
+        if (nextState_) {
+            curState_ = std::move(*nextState_);
+            nextState_.reset();
+        }
+    }
+
+    // 分发按键事件
+    void Dispatch(uintptr_t key)
+    {
+        switch (key) {
+        case KEY_EVENT_UP:
+            Visit([](auto &state, Bomb5 &bomb) { state.OnUp(bomb); });
+            break;
+        case KEY_EVENT_DOWN:
+            Visit([](auto &state, Bomb5 &bomb) { state.OnDown(bomb); });
+            break;
+        case KEY_EVENT_ARM:
+            Visit([](auto &state, Bomb5 &bomb) { state.OnArm(bomb); });
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 分发计时器滴答
+    void Tick()
+    {
+        if (++fineTime_ == 10) {
+            fineTime_ = 0;
+        }
+        Visit([fineTime = fineTime_](auto &state, Bomb5 &bomb) { state.OnTick(bomb, fineTime); });
+    }
+
+    // 当前状态是否需要滴答事件
+    bool NeedTick() const
+    {
+        return std::visit([](const auto &state) { return std::decay_t<decltype(state)>::NEED_TICK; }, curState_);
+    }
+
+private:
+    // 状态转换函数，在当前事件处理完成后生效
+    void Tran(BombState state)
+    {
+        nextState_ = std::move(state);
+    }
+
+private:
+    BombState curState_;                   // 当前状态
+    std::optional<BombState> nextState_;   // 待切换的目标状态
+    uint8_t timeout_;                      // 超时时间
+    uint8_t passwd_;                       // 密码
+    uint8_t fineTime_ = 0;                 // 滴答计数（100ms）
+
+    // 友元类声明
+    friend class SettingState;
+    friend class TimingState;
+};
+
+// 炸弹活动对象：互斥锁队列，时间源由 BOMB_SIM_CLOCK 决定
+using Bomb5Active = ActiveObject<Bomb5, SyncQueuePolicy<KEY_QUEUE_SIZE>, DefaultTimer>;
+
+// 打印超时信息的辅助函数
+static void PrintTimeout(const char *s, uint8_t timeout)
+{
+    ALOG("%s, Bomb5 timeout[%d]\n", s, timeout);
+}
+
+// 设置状态下处理向上操作
+void SettingState::OnUp(Bomb5 &bomb)
+{
+    if (bomb.timeout_ < TIMEOUT_MAX) {
+        bomb.timeout_++;
+    }
+    PrintTimeout("u", bomb.timeout_);
+}
+
+// 设置状态下处理向下操作
+void SettingState::OnDown(Bomb5 &bomb)
+{
+    if (bomb.timeout_ > TIMEOUT_MIN) {
+        bomb.timeout_--;
+    }
+    PrintTimeout("d", bomb.timeout_);
+}
+
+// 设置状态下处理武器激活操作，新的计时状态的输入从0开始
+void SettingState::OnArm(Bomb5 &bomb)
+{
+    bomb.Tran(TimingState{});
+    ALOG("Bomb5 start...\n");
+}
+
+// 计时状态下处理向上操作
+void TimingState::OnUp(Bomb5 &bomb)
+{
+    (void)bomb;
+    curInput_ <<= 1;
+    curInput_ |= 1;
+    ALOG("u, curInput[%d]\n", curInput_);
+}
+
+// 计时状态下处理向下操作
+void TimingState::OnDown(Bomb5 &bomb)
+{
+    (void)bomb;
+    curInput_ <<= 1;
+    ALOG("d, curInput[%d]\n", curInput_);
+}
+
+// 计时状态下处理武器激活操作
+void TimingState::OnArm(Bomb5 &bomb)
+{
+    if (curInput_ == bomb.passwd_) {
+        bomb.Tran(SettingState{});
+        ALOG("Bomb5 stop\n");
+    }
+}
+
+// 计时状态下处理计时器滴答
+void TimingState::OnTick(Bomb5 &bomb, uint8_t fineTime)
+{
+    if (bomb.timeout_ == 0) {
+        ALOG("OnTick error\n");
+        return;
+    }
+
+    if (fineTime == 0) {
+        bomb.timeout_--;
+        PrintTimeout("remain", bomb.timeout_);
+    }
+
+    if (bomb.timeout_ == 0) {
+        ALOG("Bomb5 bomb!!! Reset for again test!\n");
+        bomb.Tran(SettingState{});
+        bomb.timeout_ = TIMEOUT_INITIAL;
+    }
+}
+
+// 主函数
+int main()
+{
+    // 启动异步日志线程
+    ALogStart(ALOG_OVERFLOW_DROP);
+    Bomb5Active bomb5(0xD);  // 密码为0xD
+    bomb5.SetTick(TICK100MS);
+
+    // 创建运行线程
+    std::thread t(&Bomb5Active::Run, std::ref(bomb5));
+
+    bool bombRunning = true;
+    // 主循环处理键盘输入
+    while (bombRunning) {
+        switch (getch())
+        {
+        case 'u':
+            bomb5.Post(KEY_EVENT_UP);
+            break;
+        case 'd':
+            bomb5.Post(KEY_EVENT_DOWN);
+            break;
+        case 'a':
+            bomb5.Post(KEY_EVENT_ARM);
+            break;
+        case 't':  // 虚拟时间模式下声明空闲1秒（真实时间模式下无效）
+            bomb5.Idle(10 * TICK100MS);
+            break;
+        case '\33':  // ESC键
+            bombRunning = false;
+            bomb5.Stop();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 等待线程结束
+    t.join();
+    // 写出剩余日志
+    ALogStop();
+    std::cout << "main exit" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file bomb_model.c
+ * @brief 离线工具共用的炸弹状态机模型实现文件
+ */
+
+#include "bomb_model.h"
+
+static BombModelBug injectBug;  ///< 注入的错误
+
+/**
+ * @brief 设置注入的错误
+ *
+ * @param bug 注入的错误
+ */
+void BombModelSetBug(BombModelBug bug)
+{
+    injectBug = bug;
+}
+
+/**
+ * @brief 计时状态下的滴答：注入卡住错误时剩余最后一秒不再计数
+ *
+ * @param timeout 超时时间（秒）
+ * @param fineTime 100ms 计数
+ * @return true 超时，应回到设置状态
+ */
+static bool BombModelTick(uint8_t *timeout, uint8_t *fineTime)
+{
+    if (injectBug == BOMB_MODEL_BUG_STUCK && *timeout == 1 && *fineTime == 5) {
+        return false;
+    }
+    if (++*fineTime == 10) {
+        *fineTime = 0;
+        if (--*timeout == 0) {
+            if (injectBug != BOMB_MODEL_BUG_RESET) {
+                *timeout = BOMB_MODEL_TIMEOUT_INITIAL;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// StateTable 版本
+// ---------------------------------------------------------------------------
+
+static void TableSettingUp(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->timeout < BOMB_MODEL_TIMEOUT_MAX) {
+        me->timeout++;
+    }
+}
+
+static void TableSettingDown(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->timeout > BOMB_MODEL_TIMEOUT_MIN) {
+        me->timeout--;
+    }
+}
+
+static void TableSettingArm(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = 0;
+    me->fineTime = 0;
+    TRAN(BOMB_MODEL_TIMING);
+}
+
+static void TableTimingUp(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = (uint8_t)((me->curInput << 1) | 1);
+}
+
+static void TableTimingDown(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    me->curInput = (uint8_t)(me->curInput << 1);
+}
+
+static void TableTimingArm(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (me->curInput == me->passwd) {
+        me->curInput = 0;
+        TRAN(BOMB_MODEL_SETTING);
+    }
+}
+
+static void TableTimingTick(TableBomb *me, const Event *e)
+{
+    UNUSE(e);
+    if (BombModelTick(&me->timeout, &me->fineTime)) {
+        TRAN(BOMB_MODEL_SETTING);
+    }
+}
+
+static Tran tableCells[BOMB_MODEL_STATE_MAX][BOMB_MODEL_SIGNAL_MAX] = {
+    {(Tran)TableSettingUp, (Tran)TableSettingDown, (Tran)TableSettingArm, StateTableEmpty},
+    {(Tran)TableTimingUp, (Tran)TableTimingDown, (Tran)TableTimingArm, (Tran)TableTimingTick},
+};
+
+static void TableInitial(StateTable *me)
+{
+    TableBomb *bomb = (TableBomb *)me;
+    bomb->timeout = BOMB_MODEL_TIMEOUT_INITIAL;
+    bomb->curInput = 0;
+    bomb->fineTime = 0;
+    TRAN(BOMB_MODEL_SETTING);
+}
+
+/**
+ * @brief 构造并初始化状态表版本的炸弹
+ *
+ * @param me 指向炸弹的指针
+ * @param passwd 解锁密码
+ */
+void TableBombCtor(TableBomb *me, uint8_t passwd)
+{
+    StateTableCtor(&me->super, &tableCells[0][0], BOMB_MODEL_STATE_MAX, BOMB_MODEL_SIGNAL_MAX, TableInitial);
+    me->passwd = passwd;
+    StateTableInit(&me->super);
+}
+
+// ---------------------------------------------------------------------------
+// QFsm 版本
+// ---------------------------------------------------------------------------
+
+static QState QBombTiming(QBomb *me, QEvent *e);
+
+static QState QBombSetting(QBomb *me, QEvent *e)
+{
+    switch (e->signal - Q_USER_SIGNAL) {
+    case BOMB_MODEL_UP:
+        if (me->timeout < BOMB_MODEL_TIMEOUT_MAX) {
+            me->timeout++;
+        }
+        return Q_HANDLED();
+    case BOMB_MODEL_DOWN:
+        if (me->timeout > BOMB_MODEL_TIMEOUT_MIN) {
+            me->timeout--;
+        }
+        return Q_HANDLED();
+    case BOMB_MODEL_ARM:
+        me->curInput = 0;
+        me->fineTime = 0;
+        return Q_TRAN(QBombTiming);
+    default:
+        break;
+    }
+    return Q_IGNORED();
+}
+
+static QState QBombTiming(QBomb *me, QEvent *e)
+{
+    switch (e->signal - Q_USER_SIGNAL) {
+    case BOMB_MODEL_UP:
+        me->curInput = (uint8_t)((me->curInput << 1) | 1);
+        return Q_HANDLED();
+    case BOMB_MODEL_DOWN:
+        me->curInput = (uint8_t)(me->curInput << 1);
+        return Q_HANDLED();
+    case BOMB_MODEL_ARM:
+        if (me->curInput == me->passwd) {
+            me->curInput = 0;
+            return Q_TRAN(QBombSetting);
+        }
+        return Q_HANDLED();
+    case BOMB_MODEL_TICK:
+        if (BombModelTick(&me->timeout, &me->fineTime)) {
+            return Q_TRAN(QBombSetting);
+        }
+        return Q_HANDLED();
+    default:
+        break;
+    }
+    return Q_IGNORED();
+}
+
+static QState QBombInitial(QBomb *me, QEvent *e)
+{
+    UNUSE(e);
+    me->timeout = BOMB_MODEL_TIMEOUT_INITIAL;
+    me->curInput = 0;
+    me->fineTime = 0;
+    return Q_TRAN(QBombSetting);
+}
+
+/**
+ * @brief 构造并初始化 QFsm 版本的炸弹
+ *
+ * @param me 指向炸弹的指针
+ * @param passwd 解锁密码
+ */
+void QBombCtor(QBomb *me, uint8_t passwd)
+{
+    QFsmCtor(&me->super, (QStateHandler)QBombInitial);
+    me->passwd = passwd;
+    QFsmInit(&me->super, NULL);
+}
+
+/**
+ * @brief QFsm 版本的炸弹当前的控制状态
+ *
+ * @param me 指向炸弹的指针
+ * @return BOMB_MODEL_SETTING 或 BOMB_MODEL_TIMING
+ */
+uint8_t QBombState(const QBomb *me)
+{
+    return me->super.state == (QStateHandler)QBombTiming ? BOMB_MODEL_TIMING : BOMB_MODEL_SETTING;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file bomb_model.h
+ * @brief 离线工具共用的炸弹状态机模型头文件
+ *
+ * 与 bomb2 行为相同、没有输出和定时器的炸弹状态机，分别用 StateTable 和 QFsm 实现，
+ * 供日志重放（fsmreplay）和状态空间检查（fsmexplore）使用。
+ * 实例只包含状态变量，可以整块复制和比较。
+ */
+
+#ifndef BOMB_MODEL_H
+#define BOMB_MODEL_H
+
+#include <stdint.h>
+#include "statetbl.h"
+#include "qfsm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define BOMB_MODEL_TIMEOUT_INITIAL 15   ///< 初始超时时间（秒）
+#define BOMB_MODEL_TIMEOUT_MIN 10       ///< 最小超时时间（秒）
+#define BOMB_MODEL_TIMEOUT_MAX 120      ///< 最大超时时间（秒）
+#define BOMB_MODEL_PASSWD 0xD           ///< 默认解锁密码
+
+/**
+ * @brief 用户信号，QFsm 版本分发时加上 Q_USER_SIGNAL
+ */
+enum {
+    BOMB_MODEL_UP,              ///< 向上调整
+    BOMB_MODEL_DOWN,            ///< 向下调整
+    BOMB_MODEL_ARM,             ///< 启动/停止
+    BOMB_MODEL_TICK,            ///< 100ms 滴答
+    BOMB_MODEL_SIGNAL_MAX,      ///< 信号数量
+};
+
+/**
+ * @brief 控制状态
+ */
+enum {
+    BOMB_MODEL_SETTING,         ///< 设置状态
+    BOMB_MODEL_TIMING,          ///< 计时状态
+    BOMB_MODEL_STATE_MAX,       ///< 状态数量
+};
+
+/**
+ * @brief 注入的错误，用来验证检查工具能发现问题
+ */
+typedef enum {
+    BOMB_MODEL_BUG_NONE,        ///< 不注入
+    BOMB_MODEL_BUG_RESET,       ///< 超时回到设置状态时不重置 timeout
+    BOMB_MODEL_BUG_STUCK,       ///< 剩余最后一秒时滴答不再计数，倒计时卡住
+} BombModelBug;
+
+/**
+ * @brief 状态表版本的炸弹
+ */
+typedef struct TableBombTag {
+    StateTable super;           ///< 继承的状态表基类
+    uint8_t timeout;            ///< 超时时间（秒）
+    uint8_t passwd;             ///< 解锁密码
+    uint8_t curInput;           ///< 当前输入的密码
+    uint8_t fineTime;           ///< 100ms 计数
+} TableBomb;
+
+/**
+ * @brief QFsm 版本的炸弹
+ */
+typedef struct QBombTag {
+    QFsm super;                 ///< 继承的 QFsm 基类
+    uint8_t timeout;            ///< 超时时间（秒）
+    uint8_t passwd;             ///< 解锁密码
+    uint8_t curInput;           ///< 当前输入的密码
+    uint8_t fineTime;           ///< 100ms 计数
+} QBomb;
+
+/**
+ * @brief 设置注入的错误，对之后的所有分发生效
+ *
+ * @param bug 注入的错误
+ */
+void BombModelSetBug(BombModelBug bug);
+
+/**
+ * @brief 构造并初始化状态表版本的炸弹
+ *
+ * @param me 指向炸弹的指针
+ * @param passwd 解锁密码
+ */
+void TableBombCtor(TableBomb *me, uint8_t passwd);
+
+/**
+ * @brief 构造并初始化 QFsm 版本的炸弹
+ *
+ * @param me 指向炸弹的指针
+ * @param passwd 解锁密码
+ */
+void QBombCtor(QBomb *me, uint8_t passwd);
+
+/**
+ * @brief QFsm 版本的炸弹当前的控制状态
+ *
+ * @param me 指向炸弹的指针
+ * @return BOMB_MODEL_SETTING 或 BOMB_MODEL_TIMING
+ */
+uint8_t QBombState(const QBomb *me);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !BOMB_MODEL_H
@@ -0,0 +1,93 @@
+// 无分配委托
+//
+// Delegate 只保存一个对象指针和一个桩函数指针（两个指针大小），不做任何堆分配，
+// 调用开销为一次间接调用。可以在编译期由成员函数指针构造，用于替换
+// std::function/std::variant 组成的处理函数表。
+
+#ifndef DELEGATE_HPP
+#define DELEGATE_HPP
+
+#include <type_traits>
+
+template <typename Signature>
+class Delegate;
+
+template <typename R, typename... Args>
+class Delegate<R(Args...)>
+{
+public:
+    // 桩函数类型：第一个参数为绑定的对象
+    using Stub = R (*)(void *, Args...);
+
+    // 默认构造的委托调用时什么也不做（返回值类型的默认值），调用处不需要判空
+    constexpr Delegate() = default;
+
+    // 绑定成员函数，成员函数可以带与委托相同的参数，也可以不带参数（忽略事件参数）
+    template <auto Method, typename T>
+    static constexpr Delegate Bind(T *obj)
+    {
+        return Delegate(obj, &MethodStub<T, Method>);
+    }
+
+    // 绑定自由函数或静态成员函数
+    template <auto Function>
+    static constexpr Delegate Bind()
+    {
+        return Delegate(nullptr, &FunctionStub<Function>);
+    }
+
+    // 调用委托
+    R operator()(Args... args) const
+    {
+        return stub_(obj_, args...);
+    }
+
+    // 是否已经绑定了处理函数
+    constexpr bool IsBound() const
+    {
+        return stub_ != &EmptyStub;
+    }
+
+private:
+    constexpr Delegate(void *obj, Stub stub) : obj_(obj), stub_(stub)
+    {
+    }
+
+    static R EmptyStub(void *obj, Args... args)
+    {
+        (void)obj;
+        ((void)args, ...);
+        if constexpr (!std::is_void_v<R>) {
+            return R();
+        }
+    }
+
+    template <typename T, auto Method>
+    static R MethodStub(void *obj, Args... args)
+    {
+        T *o = static_cast<T *>(obj);
+        if constexpr (std::is_invocable_v<decltype(Method), T *, Args...>) {
+            return (o->*Method)(args...);
+        } else {
+            ((void)args, ...);
+            return (o->*Method)();
+        }
+    }
+
+    template <auto Function>
+    static R FunctionStub(void *obj, Args... args)
+    {
+        (void)obj;
+        if constexpr (std::is_invocable_v<decltype(Function), Args...>) {
+            return Function(args...);
+        } else {
+            ((void)args, ...);
+            return Function();
+        }
+    }
+
+    void *obj_ = nullptr;
+    Stub stub_ = &EmptyStub;
+};
+
+#endif // !DELEGATE_HPP
@@ -0,0 +1,512 @@
+/**
+ * @file fsm_explore.c
+ * @brief 状态机状态空间穷举检查实现文件
+ *
+ * 层同步的广度优先遍历：当前层的实例放在一个连续数组中，工作线程按块从原子游标领取，
+ * 新发现的实例写入各线程自己的缓冲区；一层结束后（屏障）计算各线程缓冲区在下一层数组中的偏移，
+ * 并行拷贝拼接，然后交换两层数组。已访问集合的插入是一次 CAS，不加锁。
+ */
+
+#include "fsm_explore.h"
+#include "barrier.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPLORE_CHUNK 256       ///< 工作线程每次领取的实例数
+
+/**
+ * @brief 工作线程的私有状态
+ */
+typedef struct ExploreThreadTag {
+    struct ExploreJobTag *job;  ///< 共享状态
+    uint8_t *next;              ///< 本线程发现的下一层实例
+    uint64_t nextNum;           ///< 下一层实例数
+    uint64_t nextCap;           ///< 缓冲区容量（实例数）
+    uint64_t offset;            ///< 在下一层数组中的偏移
+    uint64_t states;            ///< 本线程插入的实例数
+    uint64_t transitions;       ///< 转换数
+    uint64_t deadlocks;         ///< 死锁数
+    uint64_t invariantViolations;   ///< 状态不变式违反数
+    uint64_t transitionViolations;  ///< 转换不变式违反数
+    uint8_t failed;             ///< 内存分配失败
+} ExploreThread;
+
+/**
+ * @brief 一次遍历的共享状态
+ */
+typedef struct ExploreJobTag {
+    Explorer *explorer;         ///< 检查器
+    size_t recSize;             ///< 队列记录大小：槽位加实例字节，8字节对齐
+    uint8_t *frontier;          ///< 当前层
+    uint64_t frontierNum;       ///< 当前层实例数
+    uint64_t frontierCap;       ///< 当前层数组容量
+    uint8_t *next;              ///< 下一层
+    uint64_t nextCap;           ///< 下一层数组容量
+    uint64_t cursor;            ///< 当前层领取游标（原子访问）
+    uint64_t states;            ///< 已插入的实例数（层结束时汇总）
+    uint32_t depth;             ///< 已有的层数，正在展开的是第 depth - 1 层
+    uint64_t maxWidth;          ///< 最宽一层
+    uint32_t reported;          ///< 是否已记录第一个违反（原子访问）
+    ExploreReport first;        ///< 第一个违反
+    bool stop;                  ///< 是否停止
+    bool complete;              ///< 是否完整遍历
+    bool failed;                ///< 内存不足或线程创建失败
+    pthread_mutex_t start;      ///< 启动闸门，所有线程创建完成前由主线程持有
+    Barrier barrier;            ///< 层屏障
+    ExploreThread threads[EXPLORE_THREADS_MAX]; ///< 工作线程
+} ExploreJob;
+
+#define EXPLORE_KEY_BUSY 1      ///< 精确模式下槽位已占用、实例字节尚未写完
+
+/**
+ * @brief 实例字节的64位哈希，0 保留给空槽，1 保留给写入中的槽位
+ */
+static uint64_t Hash(const uint8_t *p, size_t n)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ n;
+    while (n >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        h = (h ^ v) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+        p += 8;
+        n -= 8;
+    }
+    uint64_t v = 0;
+    memcpy(&v, p, n);
+    h = (h ^ v) * 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 29;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 32;
+    return h > EXPLORE_KEY_BUSY ? h : EXPLORE_KEY_BUSY + 1;
+}
+
+/**
+ * @brief 插入已访问集合
+ *
+ * 精确模式下先用 EXPLORE_KEY_BUSY 占住槽位，写完实例字节后再发布哈希；
+ * 哈希相同的槽位还要比较实例字节，不同的实例继续探测
+ *
+ * @return 新插入时返回槽位，已存在返回 EXPLORE_SLOT_NONE，表满时返回 EXPLORE_SLOT_NONE - 1
+ */
+static uint64_t Insert(Explorer *me, uint64_t h, const uint8_t *machine)
+{
+    size_t size = me->model->machineSize;
+    uint64_t idx = h & me->mask;
+    uint64_t probe = 0;
+    while (probe <= me->mask) {
+        uint64_t cur = __atomic_load_n(&me->keys[idx], __ATOMIC_ACQUIRE);
+        if (cur == 0) {
+            uint64_t claim = me->store != NULL ? EXPLORE_KEY_BUSY : h;
+            if (__atomic_compare_exchange_n(&me->keys[idx], &cur, claim, false, __ATOMIC_ACQUIRE,
+                                            __ATOMIC_ACQUIRE)) {
+                if (me->store != NULL) {
+                    memcpy(me->store + idx * size, machine, size);
+                    __atomic_store_n(&me->keys[idx], h, __ATOMIC_RELEASE);
+                }
+                return idx;
+            }
+            // 被别的线程抢先，cur 已更新为该槽位的新值
+        }
+        if (cur == EXPLORE_KEY_BUSY) {
+            // 别的线程正在写入这个槽位，等它发布哈希后重新判断
+            continue;
+        }
+        if (cur == h && (me->store == NULL || memcmp(me->store + idx * size, machine, size) == 0)) {
+            return EXPLORE_SLOT_NONE;
+        }
+        idx = (idx + 1) & me->mask;
+        probe++;
+    }
+    return EXPLORE_SLOT_NONE - 1;
+}
+
+/**
+ * @brief 记录第一个违反，同一层中任意一个先到的线程胜出
+ */
+static void Report(ExploreJob *job, ExploreViolation kind, uint64_t slot, uint32_t signal)
+{
+    uint32_t expected = 0;
+    if (__atomic_compare_exchange_n(&job->reported, &expected, 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        job->first.kind = kind;
+        job->first.slot = slot;
+        job->first.signal = signal;
+        job->first.depth = job->depth - 1;
+    }
+}
+
+/**
+ * @brief 把一个新实例追加到本线程的下一层缓冲区
+ */
+static void Push(ExploreThread *t, size_t recSize, uint64_t slot, const uint8_t *machine, size_t machineSize)
+{
+    if (t->nextNum == t->nextCap) {
+        uint64_t cap = t->nextCap == 0 ? 4096 : t->nextCap * 2;
+        uint8_t *p = realloc(t->next, cap * recSize);
+        if (p == NULL) {
+            t->failed = 1;
+            return;
+        }
+        t->next = p;
+        t->nextCap = cap;
+    }
+    uint8_t *rec = t->next + t->nextNum * recSize;
+    memcpy(rec, &slot, sizeof(slot));
+    memcpy(rec + sizeof(slot), machine, machineSize);
+    t->nextNum++;
+}
+
+/**
+ * @brief 展开一个实例的所有后继
+ */
+static void Expand(ExploreJob *job, ExploreThread *t, const uint8_t *rec, uint8_t *scratch)
+{
+    Explorer *me = job->explorer;
+    const ExploreModel *model = me->model;
+    size_t size = model->machineSize;
+    uint64_t slot;
+    memcpy(&slot, rec, sizeof(slot));
+    const uint8_t *src = rec + sizeof(slot);
+    bool moved = false;
+
+    for (uint32_t signal = 0; signal < model->signalNum; signal++) {
+        memcpy(scratch, src, size);
+        model->dispatch(scratch, signal, model->arg);
+        // 自环也要检查转换不变式：不前进的滴答正是进展性质要抓的错误
+        t->transitions++;
+        if (model->transition != NULL && !model->transition(src, signal, scratch, model->arg)) {
+            t->transitionViolations++;
+            Report(job, EXPLORE_TRANSITION, slot, signal);
+        }
+        if (memcmp(scratch, src, size) == 0) {
+            continue;
+        }
+        moved = true;
+
+        uint64_t idx = Insert(me, Hash(scratch, size), scratch);
+        if (idx == EXPLORE_SLOT_NONE) {
+            continue;
+        }
+        if (idx == EXPLORE_SLOT_NONE - 1) {
+            __atomic_store_n(&job->complete, false, __ATOMIC_RELAXED);
+            continue;
+        }
+        me->parents[idx] = slot << 8 | signal;
+        t->states++;
+        if (model->invariant != NULL && !model->invariant(scratch, model->arg)) {
+            t->invariantViolations++;
+            Report(job, EXPLORE_INVARIANT, slot, signal);
+        }
+        Push(t, job->recSize, idx, scratch, size);
+    }
+
+    if (!moved) {
+        t->deadlocks++;
+        Report(job, EXPLORE_DEADLOCK, slot, EXPLORE_SIGNAL_NONE);
+    }
+}
+
+/**
+ * @brief 一层展开结束：汇总统计，计算各线程在下一层数组中的偏移，决定是否继续
+ */
+static void LevelEnd(void *arg)
+{
+    ExploreJob *job = (ExploreJob *)arg;
+    Explorer *me = job->explorer;
+    uint64_t total = 0;
+    uint64_t states = 0;
+    for (uint32_t i = 0; i < me->threads; i++) {
+        ExploreThread *t = &job->threads[i];
+        t->offset = total;
+        total += t->nextNum;
+        states += t->states;
+        if (t->failed) {
+            job->failed = true;
+        }
+    }
+    job->states = states;
+
+    if (total > job->nextCap && !job->failed) {
+        uint8_t *p = realloc(job->next, total * job->recSize);
+        if (p == NULL) {
+            job->failed = true;
+        } else {
+            job->next = p;
+            job->nextCap = total;
+        }
+    }
+
+    job->frontierNum = total;
+    if (total > job->maxWidth) {
+        job->maxWidth = total;
+    }
+    if (total > 0) {
+        job->depth++;
+    }
+    if (states > (me->mask + 1) / 4 * 3) {
+        job->complete = false;
+    }
+    bool limited = me->maxDepth != 0 && job->depth >= me->maxDepth && total > 0;
+    if (limited) {
+        job->complete = false;
+    }
+    job->stop = job->failed || total == 0 || !job->complete || limited ||
+                (me->stopOnViolation && __atomic_load_n(&job->reported, __ATOMIC_RELAXED) != 0);
+    if (job->stop && total > 0) {
+        job->complete = false;
+    }
+}
+
+/**
+ * @brief 下一层拼接完成：交换两层数组
+ */
+static void LevelSwap(void *arg)
+{
+    ExploreJob *job = (ExploreJob *)arg;
+    uint8_t *p = job->frontier;
+    uint64_t cap = job->frontierCap;
+    job->frontier = job->next;
+    job->frontierCap = job->nextCap;
+    job->next = p;
+    job->nextCap = cap;
+    job->cursor = 0;
+}
+
+/**
+ * @brief 工作线程
+ */
+static void *ExploreWorker(void *arg)
+{
+    ExploreThread *t = (ExploreThread *)arg;
+    ExploreJob *job = t->job;
+    // 等所有线程创建完成；有线程创建失败时屏障凑不齐人数，直接退出
+    pthread_mutex_lock(&job->start);
+    pthread_mutex_unlock(&job->start);
+    if (__atomic_load_n(&job->failed, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    size_t recSize = job->recSize;
+    uint8_t *scratch = malloc(job->explorer->model->machineSize);
+    if (scratch == NULL) {
+        t->failed = 1;
+    }
+
+    for (;;) {
+        // 展开当前层
+        uint64_t begin;
+        while (scratch != NULL &&
+               (begin = __atomic_fetch_add(&job->cursor, EXPLORE_CHUNK, __ATOMIC_RELAXED)) < job->frontierNum) {
+            uint64_t end = begin + EXPLORE_CHUNK < job->frontierNum ? begin + EXPLORE_CHUNK : job->frontierNum;
+            for (uint64_t i = begin; i < end; i++) {
+                Expand(job, t, job->frontier + i * recSize, scratch);
+            }
+        }
+        BarrierWait(&job->barrier, LevelEnd, job);
+        if (job->failed || job->frontierNum == 0) {
+            break;
+        }
+
+        // 并行拼接下一层
+        memcpy(job->next + t->offset * recSize, t->next, t->nextNum * recSize);
+        t->nextNum = 0;
+        BarrierWait(&job->barrier, LevelSwap, job);
+        if (job->stop) {
+            break;
+        }
+    }
+    free(scratch);
+    return NULL;
+}
+
+/**
+ * @brief 构造检查器
+ *
+ * @param me 指向检查器的指针
+ * @param model 模型
+ * @param tableBits 已访问集合槽位数的对数，每个槽位16字节
+ * @param threads 工作线程数（1~EXPLORE_THREADS_MAX）
+ * @return 0 成功，-1 参数错误或内存不足
+ */
+int ExplorerCtor(Explorer *me, const ExploreModel *model, uint32_t tableBits, uint32_t threads)
+{
+    memset(me, 0, sizeof(*me));
+    if (model->machineSize == 0 || model->signalNum == 0 || model->signalNum > EXPLORE_SIGNAL_MAX ||
+        model->init == NULL || model->dispatch == NULL || threads == 0 || threads > EXPLORE_THREADS_MAX ||
+        tableBits < 4 || tableBits > 40) {
+        return -1;
+    }
+    uint64_t slots = 1ULL << tableBits;
+    // 大块清零内存由系统按需分配零页，只有被访问的部分占用物理内存
+    me->keys = calloc(slots, sizeof(uint64_t));
+    me->parents = calloc(slots, sizeof(uint64_t));
+    if (me->keys == NULL || me->parents == NULL) {
+        ExplorerDtor(me);
+        return -1;
+    }
+    me->model = model;
+    me->mask = slots - 1;
+    me->threads = threads;
+    return 0;
+}
+
+/**
+ * @brief 已访问集合保存完整实例（精确模式）
+ *
+ * @param me 指向检查器的指针
+ * @return 0 成功，-1 内存不足
+ */
+int ExplorerSetExact(Explorer *me)
+{
+    if (me->store != NULL) {
+        return 0;
+    }
+    uint64_t slots = me->mask + 1;
+    size_t size = me->model->machineSize;
+    if (slots > SIZE_MAX / size) {
+        return -1;
+    }
+    me->store = calloc(slots, size);
+    return me->store != NULL ? 0 : -1;
+}
+
+/**
+ * @brief 析构检查器
+ *
+ * @param me 指向检查器的指针
+ */
+void ExplorerDtor(Explorer *me)
+{
+    free(me->keys);
+    free(me->parents);
+    free(me->store);
+    memset(me, 0, sizeof(*me));
+}
+
+/**
+ * @brief 遍历状态空间
+ *
+ * @param me 指向检查器的指针
+ * @param result 检查结果
+ * @return 0 成功，-1 内存不足或线程创建失败
+ */
+int ExplorerRun(Explorer *me, ExploreResult *result)
+{
+    const ExploreModel *model = me->model;
+    uint32_t initNum = model->initNum == 0 ? 1 : model->initNum;
+    memset(result, 0, sizeof(*result));
+    result->first.kind = EXPLORE_OK;
+    result->first.slot = EXPLORE_SLOT_NONE;
+
+    ExploreJob *job = calloc(1, sizeof(ExploreJob));
+    if (job == NULL) {
+        return -1;
+    }
+    job->explorer = me;
+    job->recSize = (sizeof(uint64_t) + model->machineSize + 7) & ~(size_t)7;
+    job->complete = true;
+    job->frontier = malloc(initNum * job->recSize);
+    job->frontierCap = initNum;
+    if (job->frontier == NULL) {
+        free(job);
+        return -1;
+    }
+
+    // 初始实例：构造前清零，保证填充字节一致；初始实例为第0层，depth 记录已有的层数
+    job->depth = 1;
+    for (uint32_t i = 0; i < initNum; i++) {
+        uint8_t *rec = job->frontier + job->frontierNum * job->recSize;
+        uint8_t *machine = rec + sizeof(uint64_t);
+        memset(rec, 0, job->recSize);
+        model->init(machine, i, model->arg);
+        uint64_t slot = Insert(me, Hash(machine, model->machineSize), machine);
+        if (slot >= EXPLORE_SLOT_NONE - 1) {
+            continue;
+        }
+        me->parents[slot] = EXPLORE_ROOT | i;
+        memcpy(rec, &slot, sizeof(slot));
+        job->frontierNum++;
+        job->states++;
+        if (model->invariant != NULL && !model->invariant(machine, model->arg)) {
+            result->invariantViolations++;
+            Report(job, EXPLORE_INVARIANT, slot, EXPLORE_SIGNAL_NONE);
+        }
+    }
+    job->maxWidth = job->frontierNum;
+    job->threads[0].states = job->states;
+
+    BarrierCtor(&job->barrier, me->threads);
+    pthread_mutex_init(&job->start, NULL);
+
+    pthread_t threads[EXPLORE_THREADS_MAX];
+    uint32_t created = 0;
+    pthread_mutex_lock(&job->start);
+    for (; created < me->threads; created++) {
+        job->threads[created].job = job;
+        if (pthread_create(&threads[created], NULL, ExploreWorker, &job->threads[created]) != 0) {
+            job->failed = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&job->start);
+    for (uint32_t i = 0; i < created; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (uint32_t i = 0; i < me->threads; i++) {
+        ExploreThread *t = &job->threads[i];
+        result->transitions += t->transitions;
+        result->deadlocks += t->deadlocks;
+        result->invariantViolations += t->invariantViolations;
+        result->transitionViolations += t->transitionViolations;
+        free(t->next);
+    }
+    result->states = job->states;
+    result->depth = job->depth;
+    result->maxWidth = job->maxWidth;
+    result->complete = job->complete && !job->failed;
+    result->exact = me->store != NULL;
+    if (job->reported) {
+        result->first = job->first;
+    }
+    int ret = job->failed ? -1 : 0;
+
+    pthread_mutex_destroy(&job->start);
+    BarrierDtor(&job->barrier);
+    free(job->frontier);
+    free(job->next);
+    free(job);
+    return ret;
+}
+
+/**
+ * @brief 回溯从初始实例到 slot 对应实例的信号序列
+ *
+ * @param me 指向检查器的指针
+ * @param slot 槽位
+ * @param init 输出初始实例编号
+ * @param signals 输出信号序列
+ * @param max signals 的容量
+ * @return 信号序列长度，超过 max 时只写入前 max 个
+ */
+uint32_t ExplorerTrace(const Explorer *me, uint64_t slot, uint32_t *init, uint32_t *signals, uint32_t max)
+{
+    uint32_t len = 0;
+    uint64_t cur = slot;
+    while ((me->parents[cur] & EXPLORE_ROOT) == 0) {
+        len++;
+        cur = me->parents[cur] >> 8;
+    }
+    *init = (uint32_t)(me->parents[cur] & ~EXPLORE_ROOT);
+
+    uint32_t pos = len;
+    cur = slot;
+    while ((me->parents[cur] & EXPLORE_ROOT) == 0) {
+        pos--;
+        if (pos < max) {
+            signals[pos] = (uint32_t)(me->parents[cur] & 0xFF);
+        }
+        cur = me->parents[cur] >> 8;
+    }
+    return len;
+}
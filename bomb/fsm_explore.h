@@ -0,0 +1,183 @@
+/**
+ * @file fsm_explore.h
+ * @brief 状态机状态空间穷举检查头文件
+ *
+ * 把状态机实例（控制状态加扩展状态变量）当作一块定长字节，从初始实例出发，
+ * 对每个可达实例复制一份、分发每个信号，用真实的 Tran/QStateHandler 处理函数算出后继，
+ * 多线程按层广度优先遍历整个乘积状态空间。
+ *
+ * 已访问集合是无锁开放寻址哈希表，默认只保存每个实例的64位哈希（哈希压缩）和父节点，
+ * 每个状态16字节，可以容纳数亿个状态；代价是两个不同实例哈希相同时其中一个会被漏掉，
+ * n 个状态的漏检概率约为 n^2 / 2^65，此时 complete 只表示概率意义上的完整覆盖。
+ * ExplorerSetExact 打开精确模式：每个槽位再保存完整的实例字节，哈希相同时比较实例，
+ * 不会漏掉状态，代价是每个槽位多占 machineSize 字节。
+ *
+ * 检查的性质：
+ * - 状态不变式：每个可达实例都要满足；
+ * - 转换不变式：每条（源实例，信号，目标实例）都要满足，包括实例不变的自环，可以表达
+ *   “计时状态下每个滴答都向超时前进一步”这类进展性质；
+ * - 死锁：所有信号分发后实例都不变的可达实例。
+ * 违反时可以从已访问集合回溯出从初始实例开始的最短信号序列。
+ */
+
+#ifndef FSM_EXPLORE_H
+#define FSM_EXPLORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define EXPLORE_THREADS_MAX 64          ///< 最多工作线程数
+#define EXPLORE_SIGNAL_MAX 255          ///< 最多信号数
+#define EXPLORE_SIGNAL_NONE 0xFFFFFFFFU ///< 违反发生在实例本身，没有对应的信号
+#define EXPLORE_SLOT_NONE UINT64_MAX    ///< 无效的槽位
+#define EXPLORE_ROOT (1ULL << 63)       ///< 父节点标记：初始实例
+
+/**
+ * @brief 构造第 index 个初始实例
+ */
+typedef void (*ExploreInit)(void *machine, uint32_t index, void *arg);
+
+/**
+ * @brief 向实例分发一个信号（运行至完成）
+ */
+typedef void (*ExploreDispatch)(void *machine, uint32_t signal, void *arg);
+
+/**
+ * @brief 状态不变式，返回 false 表示违反
+ */
+typedef bool (*ExploreInvariant)(const void *machine, void *arg);
+
+/**
+ * @brief 转换不变式，返回 false 表示违反
+ */
+typedef bool (*ExploreTransition)(const void *src, uint32_t signal, const void *dst, void *arg);
+
+/**
+ * @brief 被检查的状态机模型
+ *
+ * 实例中除了状态变量以外的字节（填充、指向共享常量的指针）在所有实例中必须相同，
+ * 构造前先把实例清零即可保证这一点
+ */
+typedef struct ExploreModelTag {
+    size_t machineSize;         ///< 实例字节数
+    uint32_t signalNum;         ///< 信号数（不超过 EXPLORE_SIGNAL_MAX）
+    uint32_t initNum;           ///< 初始实例数，0 视为1
+    ExploreInit init;           ///< 初始实例构造函数
+    ExploreDispatch dispatch;   ///< 分发函数
+    ExploreInvariant invariant; ///< 状态不变式，可以为 NULL
+    ExploreTransition transition; ///< 转换不变式，可以为 NULL
+    void *arg;                  ///< 回调参数
+} ExploreModel;
+
+/**
+ * @brief 违反的类型
+ */
+typedef enum ExploreViolationTag {
+    EXPLORE_OK,                 ///< 没有违反
+    EXPLORE_INVARIANT,          ///< 状态不变式
+    EXPLORE_TRANSITION,         ///< 转换不变式
+    EXPLORE_DEADLOCK,           ///< 死锁
+} ExploreViolation;
+
+/**
+ * @brief 一次违反：在 slot 对应的实例上分发 signal 后违反，signal 为 EXPLORE_SIGNAL_NONE 时
+ *        是 slot 对应的实例本身违反
+ */
+typedef struct ExploreReportTag {
+    ExploreViolation kind;      ///< 违反类型
+    uint64_t slot;              ///< 实例在已访问集合中的槽位
+    uint32_t signal;            ///< 信号
+    uint32_t depth;             ///< slot 对应实例的层数
+} ExploreReport;
+
+/**
+ * @brief 检查结果
+ */
+typedef struct ExploreResultTag {
+    uint64_t states;            ///< 可达实例数
+    uint64_t transitions;       ///< 检查的转换数（含自环）
+    uint64_t deadlocks;         ///< 死锁实例数
+    uint64_t invariantViolations;   ///< 违反状态不变式的实例数
+    uint64_t transitionViolations;  ///< 违反转换不变式的转换数
+    uint32_t depth;             ///< 遍历的层数
+    uint64_t maxWidth;          ///< 最宽一层的实例数
+    bool complete;              ///< 是否遍历了全部可达实例（哈希压缩模式下是概率意义上的）
+    bool exact;                 ///< 已访问集合是否保存完整实例；false 时可能因哈希冲突漏掉实例
+    ExploreReport first;        ///< 第一个违反（层数最小）
+} ExploreResult;
+
+/**
+ * @brief 检查器
+ */
+typedef struct ExplorerTag {
+    const ExploreModel *model;  ///< 模型
+    uint64_t *keys;             ///< 已访问集合：实例哈希，0 表示空槽
+    uint64_t *parents;          ///< 已访问集合：父槽位 << 8 | 信号，初始实例为 EXPLORE_ROOT | 初始实例编号
+    uint8_t *store;             ///< 已访问集合：各槽位的实例字节，NULL 表示哈希压缩模式
+    uint64_t mask;              ///< 槽位数 - 1
+    uint32_t threads;           ///< 工作线程数
+    uint32_t maxDepth;          ///< 最大层数，0 表示不限
+    bool stopOnViolation;       ///< 发现违反后在当前层结束时停止
+} Explorer;
+
+/**
+ * @brief 构造检查器
+ *
+ * @param me 指向检查器的指针
+ * @param model 模型
+ * @param tableBits 已访问集合槽位数的对数，每个槽位16字节
+ * @param threads 工作线程数（1~EXPLORE_THREADS_MAX）
+ * @return 0 成功，-1 参数错误或内存不足
+ */
+int ExplorerCtor(Explorer *me, const ExploreModel *model, uint32_t tableBits, uint32_t threads);
+
+/**
+ * @brief 已访问集合保存完整实例（精确模式），在 ExplorerRun 之前调用
+ *
+ * 哈希相同的实例再比较字节，遍历结果不受哈希冲突影响；额外占用 2^tableBits * machineSize 字节
+ *
+ * @param me 指向检查器的指针
+ * @return 0 成功，-1 内存不足
+ */
+int ExplorerSetExact(Explorer *me);
+
+/**
+ * @brief 析构检查器
+ *
+ * @param me 指向检查器的指针
+ */
+void ExplorerDtor(Explorer *me);
+
+/**
+ * @brief 遍历状态空间
+ *
+ * 已访问集合装到 3/4 后停止，结果的 complete 为 false
+ *
+ * @param me 指向检查器的指针
+ * @param result 检查结果
+ * @return 0 成功，-1 内存不足或线程创建失败
+ */
+int ExplorerRun(Explorer *me, ExploreResult *result);
+
+/**
+ * @brief 回溯从初始实例到 slot 对应实例的信号序列
+ *
+ * @param me 指向检查器的指针
+ * @param slot 槽位
+ * @param init 输出初始实例编号
+ * @param signals 输出信号序列
+ * @param max signals 的容量
+ * @return 信号序列长度，超过 max 时只写入前 max 个
+ */
+uint32_t ExplorerTrace(const Explorer *me, uint64_t slot, uint32_t *init, uint32_t *signals, uint32_t max);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !FSM_EXPLORE_H
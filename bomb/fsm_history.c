@@ -0,0 +1,151 @@
+/**
+ * @file fsm_history.c
+ * @brief 状态机转换历史环形缓冲区实现文件
+ * 
+ * 导出部分不使用 stdio 和堆内存，数字用栈上缓冲区手工格式化后直接 write()。
+ */
+
+#include "fsm_history.h"
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FSM_HISTORY_WATCH_MAX 32    ///< 最多登记的历史环数量
+
+static const char *watchNames[FSM_HISTORY_WATCH_MAX];       ///< 登记的实例名称
+static const FsmHistory *watchList[FSM_HISTORY_WATCH_MAX];  ///< 登记的历史环
+static uint32_t watchNum;                                   ///< 登记数量
+
+/**
+ * @brief 清空历史环
+ * 
+ * @param me 历史环
+ */
+void FsmHistoryClear(FsmHistory *me)
+{
+    memset(me, 0, sizeof(*me));
+}
+
+/**
+ * @brief 输出字符串
+ */
+static void PutStr(int fd, const char *s)
+{
+    ssize_t ret = write(fd, s, strlen(s));
+    (void)ret;
+}
+
+/**
+ * @brief 输出无符号整数
+ * 
+ * @param fd 输出文件描述符
+ * @param v 数值
+ * @param hex true 按十六进制输出（带0x前缀）
+ */
+static void PutNum(int fd, uint64_t v, bool hex)
+{
+    char buf[24];
+    int i = (int)sizeof(buf);
+    uint32_t base = hex ? 16 : 10;
+    do {
+        buf[--i] = "0123456789abcdef"[v % base];
+        v /= base;
+    } while (v != 0);
+    if (hex) {
+        buf[--i] = 'x';
+        buf[--i] = '0';
+    }
+    ssize_t ret = write(fd, buf + i, sizeof(buf) - (size_t)i);
+    (void)ret;
+}
+
+/**
+ * @brief 导出历史
+ * 
+ * @param fd 输出文件描述符
+ * @param name 实例名称
+ * @param me 历史环
+ */
+void FsmHistoryDump(int fd, const char *name, const FsmHistory *me)
+{
+    uint32_t next = me->next;
+    uint32_t count = next < FSM_HISTORY_DEPTH ? next : FSM_HISTORY_DEPTH;
+    PutStr(fd, "history ");
+    PutStr(fd, name);
+    PutStr(fd, ", ");
+    PutNum(fd, next, false);
+    PutStr(fd, " events\n");
+    for (uint32_t i = next - count; i != next; i++) {
+        const FsmHistoryEntry *e = &me->entries[i & (FSM_HISTORY_DEPTH - 1)];
+        PutStr(fd, "  #");
+        PutNum(fd, i, false);
+        PutStr(fd, " ts ");
+        PutNum(fd, e->ts, false);
+        PutStr(fd, " state ");
+        // 状态号按十进制，状态处理函数地址按十六进制
+        PutNum(fd, e->state, e->state > 0xFF);
+        PutStr(fd, " signal ");
+        PutNum(fd, e->signal, false);
+        PutStr(fd, "\n");
+    }
+}
+
+/**
+ * @brief 登记需要在崩溃时导出的历史环
+ * 
+ * @param name 实例名称
+ * @param me 历史环
+ * @return 0 成功，-1 登记数量已满
+ */
+int FsmHistoryWatch(const char *name, const FsmHistory *me)
+{
+    if (watchNum >= FSM_HISTORY_WATCH_MAX) {
+        return -1;
+    }
+    watchNames[watchNum] = name;
+    watchList[watchNum] = me;
+    watchNum++;
+    return 0;
+}
+
+/**
+ * @brief 导出所有登记的历史环
+ * 
+ * @param fd 输出文件描述符
+ */
+void FsmHistoryDumpAll(int fd)
+{
+    for (uint32_t i = 0; i < watchNum; i++) {
+        FsmHistoryDump(fd, watchNames[i], watchList[i]);
+    }
+}
+
+/**
+ * @brief 崩溃处理函数：导出历史后恢复默认处理并重新触发信号
+ * 
+ * @param sig 信号
+ */
+static void FsmHistoryOnCrash(int sig)
+{
+    PutStr(STDERR_FILENO, "fatal signal ");
+    PutNum(STDERR_FILENO, (uint64_t)sig, false);
+    PutStr(STDERR_FILENO, ", state machine history:\n");
+    FsmHistoryDumpAll(STDERR_FILENO);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/**
+ * @brief 安装崩溃处理函数
+ */
+void FsmHistoryInstallCrashHandler(void)
+{
+    static const int sigs[] = {SIGSEGV, SIGFPE, SIGILL, SIGABRT,
+#ifdef SIGBUS
+                               SIGBUS,
+#endif // SIGBUS
+    };
+    for (uint32_t i = 0; i < sizeof(sigs) / sizeof(sigs[0]); i++) {
+        signal(sigs[i], FsmHistoryOnCrash);
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file fsm_history.h
+ * @brief 状态机转换历史环形缓冲区头文件
+ * 
+ * 每个实例可以挂一个固定大小的历史环，分发时记录最近 FSM_HISTORY_DEPTH 次的
+ * （时间戳，分发前状态，信号），只有几次普通存储，不加锁。
+ * 某个实例最终处于错误状态时，可以按需或在崩溃处理函数中导出它的历史。
+ * 导出接口只使用 write()，可以在信号处理函数中调用。
+ * 
+ * 历史记录由 FSM_HISTORY 编译选项开启，关闭时状态表和 QFsm 不增加任何字段和开销。
+ */
+
+#ifndef FSM_HISTORY_H
+#define FSM_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include "timespec_util.h"
+#endif // __x86_64__ || __i386__
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 历史环深度，必须是2的幂
+ */
+#ifndef FSM_HISTORY_DEPTH
+#define FSM_HISTORY_DEPTH 16
+#endif // !FSM_HISTORY_DEPTH
+
+/**
+ * @brief 是否记录时间戳
+ * 
+ * 在 rdtsc 被虚拟化拦截的环境中读取时间戳可能要几十纳秒，定义为0时只记录状态和信号，
+ * 时间戳恒为0，记录开销只剩几次存储
+ */
+#ifndef FSM_HISTORY_TIMESTAMP
+#define FSM_HISTORY_TIMESTAMP 1
+#endif // !FSM_HISTORY_TIMESTAMP
+
+/**
+ * @brief 一次分发的记录
+ */
+typedef struct FsmHistoryEntryTag {
+    uint64_t ts;                ///< 时间戳（x86 为 TSC 计数，其他平台为单调时钟纳秒）
+    uintptr_t state;            ///< 分发前的状态（状态表为状态号，QFsm 为状态处理函数地址）
+    uint16_t signal;            ///< 信号
+} FsmHistoryEntry;
+
+/**
+ * @brief 历史环
+ */
+typedef struct FsmHistoryTag {
+    uint32_t next;              ///< 下一次写入的序号（只增不减）
+    FsmHistoryEntry entries[FSM_HISTORY_DEPTH]; ///< 记录
+} FsmHistory;
+
+/**
+ * @brief 读取时间戳
+ */
+static inline uint64_t FsmHistoryNow(void)
+{
+#if !FSM_HISTORY_TIMESTAMP
+    return 0;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return TimespecNowNs();
+#endif // __x86_64__ || __i386__
+}
+
+/**
+ * @brief 记录一次分发（由分发函数调用）
+ * 
+ * @param me 历史环
+ * @param state 分发前的状态
+ * @param signal 信号
+ */
+static inline void FsmHistoryRecord(FsmHistory *me, uintptr_t state, uint16_t signal)
+{
+    FsmHistoryEntry *e = &me->entries[me->next++ & (FSM_HISTORY_DEPTH - 1)];
+    e->ts = FsmHistoryNow();
+    e->state = state;
+    e->signal = signal;
+}
+
+/**
+ * @brief 清空历史环
+ * 
+ * @param me 历史环
+ */
+void FsmHistoryClear(FsmHistory *me);
+
+/**
+ * @brief 导出历史（异步信号安全）
+ * 
+ * 按从旧到新的顺序每行输出一条记录：序号、时间戳、分发前状态、信号
+ * 
+ * @param fd 输出文件描述符
+ * @param name 实例名称
+ * @param me 历史环
+ */
+void FsmHistoryDump(int fd, const char *name, const FsmHistory *me);
+
+/**
+ * @brief 登记需要在崩溃时导出的历史环
+ * 
+ * @param name 实例名称（必须一直有效）
+ * @param me 历史环
+ * @return 0 成功，-1 登记数量已满
+ */
+int FsmHistoryWatch(const char *name, const FsmHistory *me);
+
+/**
+ * @brief 导出所有登记的历史环（异步信号安全）
+ * 
+ * @param fd 输出文件描述符
+ */
+void FsmHistoryDumpAll(int fd);
+
+/**
+ * @brief 安装崩溃处理函数
+ * 
+ * 收到 SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT 时把所有登记的历史环导出到 stderr，
+ * 然后按默认方式重新触发该信号
+ */
+void FsmHistoryInstallCrashHandler(void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !FSM_HISTORY_H
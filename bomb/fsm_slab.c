@@ -0,0 +1,176 @@
+/**
+ * @file fsm_slab.c
+ * @brief 紧凑状态机实例存储实现文件
+ * 
+ * 实现实例的分配、释放以及单个实例/全部实例的事件分发。
+ */
+
+#include "fsm_slab.h"
+
+/**
+ * @brief 初始化 slab
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param cls 状态机类
+ * @param mem 存储区
+ * @param capacity 最多实例数
+ */
+void FsmSlabCtor(FsmSlab *me, const FsmClass *cls, void *mem, uint32_t capacity)
+{
+    me->cls = cls;
+    me->mem = (uint8_t *)mem;
+    me->capacity = capacity;
+    me->count = 0;
+    me->freeHead = 0;
+    me->freeNum = 0;
+
+    // 链接保存槽位id+1，找出能表示 capacity 的最少字节数，超过实例剩余字节时不支持释放
+    uint8_t linkBytes = 1;
+    while (linkBytes < sizeof(uint32_t) && (capacity >> (8 * linkBytes)) != 0) {
+        linkBytes++;
+    }
+    me->linkBytes = linkBytes < cls->instSize ? linkBytes : 0;
+}
+
+/**
+ * @brief 读取空闲槽位中的链接
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param inst 空闲槽位
+ * @return 下一个空闲槽位id+1，0 表示链表结束
+ */
+static uint32_t GetLink(const FsmSlab *me, const FsmInst *inst)
+{
+    const uint8_t *p = (const uint8_t *)inst + 1;
+    uint32_t link = 0;
+    for (uint8_t i = 0; i < me->linkBytes; i++) {
+        link |= (uint32_t)p[i] << (8 * i);
+    }
+    return link;
+}
+
+/**
+ * @brief 在空闲槽位中写入链接
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param inst 空闲槽位
+ * @param link 下一个空闲槽位id+1，0 表示链表结束
+ */
+static void SetLink(const FsmSlab *me, FsmInst *inst, uint32_t link)
+{
+    uint8_t *p = (uint8_t *)inst + 1;
+    for (uint8_t i = 0; i < me->linkBytes; i++) {
+        p[i] = (uint8_t)(link >> (8 * i));
+    }
+}
+
+/**
+ * @brief 分配并初始化一个实例
+ * 
+ * @param me 指向 slab 对象的指针
+ * @return 实例id，slab 已满时返回-1
+ */
+int32_t FsmSlabAlloc(FsmSlab *me)
+{
+    uint32_t id;
+    FsmInst *inst;
+    if (me->freeHead != 0) {
+        id = me->freeHead - 1;
+        inst = (FsmInst *)FsmSlabAt(me, id);
+        me->freeHead = GetLink(me, inst);
+        me->freeNum--;
+    } else if (me->count < me->capacity) {
+        id = me->count++;
+        inst = (FsmInst *)FsmSlabAt(me, id);
+    } else {
+        return -1;
+    }
+
+    // 与 StateTableInit 相同，先设置为初始标记再调用初始状态处理函数
+    inst->state = me->cls->stateNum;
+    me->cls->initial(inst);
+    return (int32_t)id;
+}
+
+/**
+ * @brief 释放一个实例
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param id 实例id
+ * @return 0 成功，-1 id 无效、实例已释放或不支持释放
+ */
+int FsmSlabFree(FsmSlab *me, uint32_t id)
+{
+    if (me->linkBytes == 0 || id >= me->count) {
+        return -1;
+    }
+    FsmInst *inst = (FsmInst *)FsmSlabAt(me, id);
+    if (inst->state == FSM_SLAB_FREE) {
+        return -1;
+    }
+
+    inst->state = FSM_SLAB_FREE;
+    SetLink(me, inst, me->freeHead);
+    me->freeHead = id + 1;
+    me->freeNum++;
+    return 0;
+}
+
+/**
+ * @brief 分发事件到实例记录
+ * 
+ * @param cls 状态机类
+ * @param inst 实例记录
+ * @param e 指向事件结构体的指针
+ */
+static inline void DispatchInst(const FsmClass *cls, FsmInst *inst, const Event *e)
+{
+    cls->stateTable[inst->state * cls->signalNum + e->signal](inst, e);
+}
+
+/**
+ * @brief 分发事件到指定实例
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param id 实例id
+ * @param e 指向事件结构体的指针
+ */
+void FsmSlabDispatch(FsmSlab *me, uint32_t id, const Event *e)
+{
+    // 检查实例id和事件信号是否超出范围
+    if (id >= me->count || e->signal >= me->cls->signalNum) {
+        return;
+    }
+    FsmInst *inst = (FsmInst *)FsmSlabAt(me, id);
+    if (inst->state != FSM_SLAB_FREE) {
+        DispatchInst(me->cls, inst, e);
+    }
+}
+
+/**
+ * @brief 分发同一个事件到所有实例
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param e 指向事件结构体的指针
+ */
+void FsmSlabBroadcast(FsmSlab *me, const Event *e)
+{
+    const FsmClass *cls = me->cls;
+    if (e->signal >= cls->signalNum) {
+        return;
+    }
+
+    uint8_t *p = me->mem;
+    if (me->freeNum == 0) {
+        // 没有空闲槽位时不需要逐个检查
+        for (uint32_t i = 0; i < me->count; i++, p += cls->instSize) {
+            DispatchInst(cls, (FsmInst *)p, e);
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < me->count; i++, p += cls->instSize) {
+        if (((FsmInst *)p)->state != FSM_SLAB_FREE) {
+            DispatchInst(cls, (FsmInst *)p, e);
+        }
+    }
+}
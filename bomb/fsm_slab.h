@@ -0,0 +1,167 @@
+/**
+ * @file fsm_slab.h
+ * @brief 紧凑状态机实例存储头文件
+ * 
+ * 把状态机拆分为"类"和"实例"两部分：状态转换表、状态数量、信号数量、
+ * 初始化函数等不可变的元数据每种状态机只保存一份（FsmClass），
+ * 每个实例只保存一个状态字节和紧凑排列的扩展状态，连续存放在 slab 中。
+ * 适合常驻内存数千万个同类型状态机，遍历时缓存密度也更高。
+ * 
+ * 实例可以释放，释放的槽位状态字节写为 FSM_SLAB_FREE，状态字节后面的字节保存
+ * 下一个空闲槽位，组成空闲链表，不需要额外内存；分配时优先复用空闲槽位。
+ */
+
+#ifndef FSM_SLAB_H
+#define FSM_SLAB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "statetbl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 已释放槽位的状态字节，状态机类的状态数量必须小于该值
+ */
+#define FSM_SLAB_FREE 0xFFU
+
+/**
+ * @brief 实例头部
+ * 
+ * 每个实例的第一个字节是当前状态，后面紧跟扩展状态
+ */
+typedef struct FsmInstTag {
+    uint8_t state;              ///< 当前状态
+} FsmInst;
+
+/**
+ * @brief 实例状态处理函数指针类型
+ * 
+ * me 指向实例记录（FsmInst 开头）
+ */
+typedef void (*SlabTran)(void *me, const Event *e);
+
+/**
+ * @brief 实例初始化函数指针类型
+ */
+typedef void (*SlabInitial)(void *me);
+
+/**
+ * @brief 状态机类，每种状态机只有一份
+ */
+typedef struct FsmClassTag {
+    const SlabTran *stateTable; ///< 状态转换函数表（二维数组 [state][signal]）
+    uint8_t stateNum;           ///< 状态数量，小于 FSM_SLAB_FREE
+    uint8_t signalNum;          ///< 信号数量
+    uint16_t instSize;          ///< 每个实例的字节数（含状态字节），用 FSM_INST_SIZE 填写
+    SlabInitial initial;        ///< 初始状态处理函数
+} FsmClass;
+
+/**
+ * @brief 实例 slab，连续存放同一类的所有实例
+ */
+typedef struct FsmSlabTag {
+    const FsmClass *cls;        ///< 实例所属的状态机类
+    uint8_t *mem;               ///< 实例存储区
+    uint32_t capacity;          ///< 最多实例数
+    uint32_t count;             ///< 已使用的槽位数（含已释放的槽位）
+    uint32_t freeHead;          ///< 空闲链表头（槽位id+1），0 表示没有空闲槽位
+    uint32_t freeNum;           ///< 空闲槽位数
+    uint8_t linkBytes;          ///< 空闲槽位中保存链接的字节数，0 表示实例太小不支持释放
+} FsmSlab;
+
+/**
+ * @brief 实例大小宏
+ * 
+ * 用于初始化 FsmClass.instSize，实例结构体超过 UINT16_MAX 字节时编译报错（负长度数组），
+ * 宏仍是常量表达式，可以用在静态初始化中
+ */
+#define FSM_INST_SIZE(type) ((uint16_t)(sizeof(type) + 0 * sizeof(char[sizeof(type) <= UINT16_MAX ? 1 : -1])))
+
+/**
+ * @brief 计算 slab 需要的存储区大小
+ * 
+ * @param cls 状态机类
+ * @param capacity 最多实例数
+ */
+#define FSM_SLAB_BYTES(cls, capacity) ((size_t)(cls)->instSize * (capacity))
+
+/**
+ * @brief 实例状态转换宏
+ * 
+ * 用于在实例状态处理函数中切换到目标状态
+ */
+#define SLAB_TRAN(target) (((FsmInst *)me)->state = (target))
+
+/**
+ * @brief 初始化 slab
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param cls 状态机类
+ * @param mem 存储区，大小至少为 FSM_SLAB_BYTES(cls, capacity)
+ * @param capacity 最多实例数
+ */
+void FsmSlabCtor(FsmSlab *me, const FsmClass *cls, void *mem, uint32_t capacity);
+
+/**
+ * @brief 分配并初始化一个实例
+ * 
+ * 有空闲槽位时优先复用最近释放的槽位
+ * 
+ * @param me 指向 slab 对象的指针
+ * @return 实例id，slab 已满时返回-1
+ */
+int32_t FsmSlabAlloc(FsmSlab *me);
+
+/**
+ * @brief 释放一个实例
+ * 
+ * 槽位挂到空闲链表上，之后的分发和广播跳过该槽位。
+ * 链接保存在状态字节之后的 instSize-1 个字节中（最多4个），
+ * 实例只有状态字节或链接字节数表示不了 capacity 时不支持释放，
+ * 例如4字节的实例用3个字节保存链接，capacity 不能超过 0xFFFFFF
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param id 实例id
+ * @return 0 成功，-1 id 无效、实例已释放或不支持释放
+ */
+int FsmSlabFree(FsmSlab *me, uint32_t id);
+
+/**
+ * @brief 获取实例记录
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param id 实例id
+ * @return 实例记录指针
+ */
+static inline void *FsmSlabAt(const FsmSlab *me, uint32_t id)
+{
+    return me->mem + (size_t)id * me->cls->instSize;
+}
+
+/**
+ * @brief 分发事件到指定实例
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param id 实例id
+ * @param e 指向事件结构体的指针
+ */
+void FsmSlabDispatch(FsmSlab *me, uint32_t id, const Event *e);
+
+/**
+ * @brief 分发同一个事件到所有实例
+ * 
+ * 按存储顺序顺序遍历，适合滴答等广播事件，已释放的槽位被跳过
+ * 
+ * @param me 指向 slab 对象的指针
+ * @param e 指向事件结构体的指针
+ */
+void FsmSlabBroadcast(FsmSlab *me, const Event *e);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !FSM_SLAB_H
@@ -0,0 +1,260 @@
+/**
+ * @file fsmexplore.c
+ * @brief 炸弹状态机状态空间穷举检查工具
+ *
+ * 用真实的 Tran（StateTable）或 QStateHandler（QFsm）处理函数遍历炸弹状态机的乘积状态空间
+ * （控制状态 × timeout × curInput × fineTime，可选再乘以全部256个密码），检查：
+ * - timeout 在 [1, TIMEOUT_MAX]，计时状态下 fineTime < 10。设置状态下 timeout 可能小于 TIMEOUT_MIN：
+ *   计时中输入正确密码回到设置状态时保留剩余时间（与 bomb2 相同），之后 UP 只能加到 TIMEOUT_MAX；
+ * - 计时状态下每个滴答要么回到设置状态，要么使剩余滴答数 timeout * 10 - fineTime 减1，
+ *   按键不改变剩余滴答数，即每条计时路径在有限个滴答内回到设置状态；
+ * - 没有死锁。
+ * 发现违反时打印从初始实例开始的最短信号序列。
+ *
+ * 用法：fsmexplore [threads] [table|qfsm] [--all-passwd] [--bug [reset|stuck]] [--bits N] [--exact]
+ *   --all-passwd  以全部256个密码作为初始实例
+ *   --bug reset   注入错误：超时回到设置状态时不重置 timeout（默认）
+ *   --bug stuck   注入错误：剩余最后一秒时滴答不再计数，倒计时卡住
+ *   --bits N      已访问集合槽位数为 2^N，默认24
+ *   --exact       已访问集合保存完整实例，不因哈希冲突漏掉状态；默认只保存64位哈希，覆盖是概率性的
+ */
+
+#include "fsm_explore.h"
+#include "bomb_model.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRACE_MAX 4096          ///< 打印的最长信号序列
+
+static const char *const signalNames[BOMB_MODEL_SIGNAL_MAX] = {"UP", "DOWN", "ARM", "TICK"};
+
+/**
+ * @brief 与引擎无关的实例视图
+ */
+typedef struct BombViewTag {
+    uint8_t state;              ///< BOMB_MODEL_SETTING 或 BOMB_MODEL_TIMING
+    uint8_t timeout;            ///< 超时时间（秒）
+    uint8_t passwd;             ///< 密码
+    uint8_t curInput;           ///< 当前输入
+    uint8_t fineTime;           ///< 100ms 计数
+} BombView;
+
+/**
+ * @brief 第 index 个初始实例的密码：--all-passwd 时为 index，否则为默认密码
+ */
+static uint8_t InitPasswd(uint32_t index, void *arg)
+{
+    return *(const uint32_t *)arg > 1 ? (uint8_t)index : BOMB_MODEL_PASSWD;
+}
+
+static void TableInit(void *machine, uint32_t index, void *arg)
+{
+    TableBombCtor((TableBomb *)machine, InitPasswd(index, arg));
+}
+
+static void TableDispatch(void *machine, uint32_t signal, void *arg)
+{
+    UNUSE(arg);
+    const Event e = {(uint16_t)signal};
+    StateTableDispatch((StateTable *)machine, &e);
+}
+
+static BombView TableView(const void *machine)
+{
+    const TableBomb *bomb = (const TableBomb *)machine;
+    BombView v = {bomb->super.curState, bomb->timeout, bomb->passwd, bomb->curInput, bomb->fineTime};
+    return v;
+}
+
+static void QBombInit(void *machine, uint32_t index, void *arg)
+{
+    QBombCtor((QBomb *)machine, InitPasswd(index, arg));
+}
+
+static void QBombDispatch(void *machine, uint32_t signal, void *arg)
+{
+    UNUSE(arg);
+    QEvent e = {(QSignal)(signal + Q_USER_SIGNAL), 0};
+    QFsmDispatch((QFsm *)machine, &e);
+}
+
+static BombView QBombView(const void *machine)
+{
+    const QBomb *bomb = (const QBomb *)machine;
+    BombView v = {QBombState(bomb), bomb->timeout, bomb->passwd, bomb->curInput, bomb->fineTime};
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// 性质
+// ---------------------------------------------------------------------------
+
+static BombView (*viewOf)(const void *machine);    ///< 当前引擎的实例视图
+
+static bool BombInvariant(const void *machine, void *arg)
+{
+    UNUSE(arg);
+    BombView v = viewOf(machine);
+    if (v.timeout < 1 || v.timeout > BOMB_MODEL_TIMEOUT_MAX) {
+        return false;
+    }
+    return v.state == BOMB_MODEL_SETTING || v.fineTime < 10;
+}
+
+static bool BombTransition(const void *src, uint32_t signal, const void *dst, void *arg)
+{
+    UNUSE(arg);
+    BombView s = viewOf(src);
+    BombView d = viewOf(dst);
+    if (s.state != BOMB_MODEL_TIMING || d.state != BOMB_MODEL_TIMING) {
+        return true;
+    }
+    // 剩余滴答数
+    int rs = s.timeout * 10 - s.fineTime;
+    int rd = d.timeout * 10 - d.fineTime;
+    return signal == BOMB_MODEL_TICK ? rd == rs - 1 : rd == rs;
+}
+
+static void PrintView(const void *machine)
+{
+    BombView v = viewOf(machine);
+    printf("%s timeout=%u curInput=0x%02X fineTime=%u passwd=0x%02X\n",
+           v.state == BOMB_MODEL_TIMING ? "TIMING " : "SETTING", v.timeout, v.curInput, v.fineTime, v.passwd);
+}
+
+/**
+ * @brief 打印违反的信号序列，并在一个新实例上重放
+ */
+static void PrintTrace(const Explorer *explorer, const ExploreModel *model, const ExploreReport *r)
+{
+    static const char *const kinds[] = {"ok", "invariant violated", "progress violated", "deadlock"};
+    static uint32_t signals[TRACE_MAX];
+    uint32_t init = 0;
+    uint32_t len = ExplorerTrace(explorer, r->slot, &init, signals, TRACE_MAX);
+    if (r->signal != EXPLORE_SIGNAL_NONE && len < TRACE_MAX) {
+        signals[len++] = r->signal;
+    }
+    printf("%s, trace of %u signals from initial instance %u:\n", kinds[r->kind], len, init);
+
+    uint8_t *machine = calloc(1, model->machineSize);
+    model->init(machine, init, model->arg);
+    printf("  %-5s ", "init");
+    PrintView(machine);
+    for (uint32_t i = 0; i < len && i < TRACE_MAX; i++) {
+        model->dispatch(machine, signals[i], model->arg);
+        // 序列较长时只打印开头和结尾
+        if (i < 20 || i + 20 >= len) {
+            printf("  %-5s ", signalNames[signals[i]]);
+            PrintView(machine);
+        } else if (i == 20) {
+            printf("  ...\n");
+        }
+    }
+    free(machine);
+}
+
+static double NowSec(void)
+{
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t threads = 4;
+    uint32_t bits = 24;
+    uint32_t initNum = 1;
+    bool qfsm = false;
+    bool exact = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "qfsm") == 0) {
+            qfsm = true;
+        } else if (strcmp(argv[i], "table") == 0) {
+            qfsm = false;
+        } else if (strcmp(argv[i], "--all-passwd") == 0) {
+            initNum = 256;
+        } else if (strcmp(argv[i], "--bug") == 0) {
+            BombModelBug bug = BOMB_MODEL_BUG_RESET;
+            if (i + 1 < argc && strcmp(argv[i + 1], "stuck") == 0) {
+                bug = BOMB_MODEL_BUG_STUCK;
+                i++;
+            } else if (i + 1 < argc && strcmp(argv[i + 1], "reset") == 0) {
+                i++;
+            }
+            BombModelSetBug(bug);
+        } else if (strcmp(argv[i], "--bits") == 0 && i + 1 < argc) {
+            bits = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--exact") == 0) {
+            exact = true;
+        } else {
+            threads = (uint32_t)strtoul(argv[i], NULL, 0);
+        }
+    }
+
+    ExploreModel model = {0};
+    model.signalNum = BOMB_MODEL_SIGNAL_MAX;
+    model.initNum = initNum;
+    model.invariant = BombInvariant;
+    model.transition = BombTransition;
+    model.arg = &initNum;
+    if (qfsm) {
+        model.machineSize = sizeof(QBomb);
+        model.init = QBombInit;
+        model.dispatch = QBombDispatch;
+        viewOf = QBombView;
+    } else {
+        model.machineSize = sizeof(TableBomb);
+        model.init = TableInit;
+        model.dispatch = TableDispatch;
+        viewOf = TableView;
+    }
+
+    Explorer explorer;
+    if (ExplorerCtor(&explorer, &model, bits, threads) != 0) {
+        fprintf(stderr, "cannot create explorer (threads 1..%d, bits 4..40, memory)\n", EXPLORE_THREADS_MAX);
+        return 1;
+    }
+    if (exact && ExplorerSetExact(&explorer) != 0) {
+        fprintf(stderr, "out of memory for exact state store\n");
+        ExplorerDtor(&explorer);
+        return 1;
+    }
+    explorer.stopOnViolation = true;
+
+    ExploreResult result;
+    double start = NowSec();
+    int ret = ExplorerRun(&explorer, &result);
+    double sec = NowSec() - start;
+    if (ret != 0) {
+        fprintf(stderr, "out of memory or cannot create threads\n");
+        ExplorerDtor(&explorer);
+        return 1;
+    }
+
+    printf("%s, %u threads, %u initial instances, table 2^%u slots\n", qfsm ? "QFsm" : "StateTable", threads,
+           initNum, bits);
+    printf("states %llu, transitions %llu, depth %u, widest level %llu, %s\n",
+           (unsigned long long)result.states, (unsigned long long)result.transitions, result.depth,
+           (unsigned long long)result.maxWidth, result.complete ? "complete" : "INCOMPLETE");
+    if (result.exact) {
+        printf("exact state store, no state lost to hash collisions\n");
+    } else {
+        // 哈希压缩：n 个状态中至少一次64位哈希冲突的概率约为 n^2 / 2^65
+        double n = (double)result.states;
+        printf("hash compaction, coverage is probabilistic (omission probability ~%.1e, use --exact)\n",
+               n * n / 36893488147419103232.0);
+    }
+    printf("%.2f s, %.2f Mstates/s\n", sec, (double)result.states / sec / 1e6);
+    printf("deadlocks %llu, invariant violations %llu, progress violations %llu\n",
+           (unsigned long long)result.deadlocks, (unsigned long long)result.invariantViolations,
+           (unsigned long long)result.transitionViolations);
+    if (result.first.kind != EXPLORE_OK) {
+        PrintTrace(&explorer, &model, &result.first);
+    }
+
+    ExplorerDtor(&explorer);
+    return result.first.kind == EXPLORE_OK && result.complete ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+/**
+ * @file key_decoder.c
+ * @brief 批量按键解码实现文件
+ *
+ * SIMD 实现用 target 属性单独编译，不需要整个程序打开 -mssse3/-mavx2，
+ * 运行时按 CPU 支持情况选择。压缩输出时每8个字节一组，
+ * 由8位掩码查表得到 shuffle 控制字，把保留的字节移到低端后整块写出，再按保留个数前移。
+ */
+
+#include "key_decoder.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KEY_DECODER_X86 1
+#include <immintrin.h>
+#endif
+
+/// 8位掩码到 shuffle 控制字的表：保留的字节下标依次排在前面
+static uint8_t packTable[256][8];
+static pthread_once_t packOnce = PTHREAD_ONCE_INIT;
+
+static void PackTableInit(void)
+{
+    for (uint32_t mask = 0; mask < 256; mask++) {
+        uint32_t k = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            if (mask & (1U << i)) {
+                packTable[mask][k++] = i;
+            }
+        }
+        // 多余的位置填 0x80，shuffle 结果为0
+        while (k < 8) {
+            packTable[mask][k++] = 0x80;
+        }
+    }
+}
+
+/**
+ * @brief 初始化解码器，所有字节都丢弃
+ *
+ * @param me 指向解码器的指针
+ */
+void KeyDecoderCtor(KeyDecoder *me)
+{
+    pthread_once(&packOnce, PackTableInit);
+    memset(me, 0, sizeof(*me));
+    memset(me->map, KEY_DECODER_DROP, sizeof(me->map));
+    me->best = KEY_DECODER_SCALAR;
+#ifdef KEY_DECODER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        me->best = KEY_DECODER_AVX2;
+    } else if (__builtin_cpu_supports("ssse3")) {
+        me->best = KEY_DECODER_SSSE3;
+    }
+#endif // KEY_DECODER_X86
+    me->isa = me->best;
+}
+
+/**
+ * @brief 映射一个字节
+ *
+ * @param me 指向解码器的指针
+ * @param byte 输入字节
+ * @param signal 信号编号，不能是 KEY_DECODER_DROP
+ */
+void KeyDecoderMap(KeyDecoder *me, uint8_t byte, uint8_t signal)
+{
+    uint8_t lo = byte & 0x0F;
+    uint8_t hi = byte >> 4;
+    uint8_t bit = me->loClass[lo] & me->hiClass[hi];
+
+    // 新字节分配下一个类别位，已经映射过的字节沿用原来的类别位
+    if (me->map[byte] == KEY_DECODER_DROP) {
+        if (me->keyNum < KEY_DECODER_VECTOR_KEYS) {
+            bit = (uint8_t)(1U << me->keyNum);
+            me->loClass[lo] |= bit;
+            me->hiClass[hi] |= bit;
+        }
+        me->keyNum++;
+    }
+    me->map[byte] = signal;
+
+    if (bit & 0x0F) {
+        me->loSignal[bit] = signal;
+    } else if (bit != 0) {
+        me->hiSignal[bit >> 4] = signal;
+    }
+    if (me->keyNum > KEY_DECODER_VECTOR_KEYS) {
+        me->isa = KEY_DECODER_SCALAR;
+    }
+}
+
+/**
+ * @brief 指定使用的实现，用于对比测试
+ *
+ * @param me 指向解码器的指针
+ * @param isa 希望使用的实现
+ * @return 实际使用的实现
+ */
+KeyDecoderIsa KeyDecoderUse(KeyDecoder *me, KeyDecoderIsa isa)
+{
+    if (isa > me->best) {
+        isa = me->best;
+    }
+    if (me->keyNum > KEY_DECODER_VECTOR_KEYS) {
+        isa = KEY_DECODER_SCALAR;
+    }
+    me->isa = isa;
+    return isa;
+}
+
+/**
+ * @brief 标量实现：逐字节查表，无分支写出
+ */
+static size_t RunScalar(const KeyDecoder *me, const uint8_t *in, size_t n, uint8_t *out)
+{
+    size_t o = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t signal = me->map[in[i]];
+        out[o] = signal;
+        o += signal != KEY_DECODER_DROP;
+    }
+    return o;
+}
+
+#ifdef KEY_DECODER_X86
+/**
+ * @brief SSSE3 实现：每次分类16个字节
+ */
+__attribute__((target("ssse3"))) static size_t RunSsse3(const KeyDecoder *me, const uint8_t *in, size_t n,
+                                                        uint8_t *out)
+{
+    const __m128i loClass = _mm_loadu_si128((const __m128i *)me->loClass);
+    const __m128i hiClass = _mm_loadu_si128((const __m128i *)me->hiClass);
+    const __m128i loSignal = _mm_loadu_si128((const __m128i *)me->loSignal);
+    const __m128i hiSignal = _mm_loadu_si128((const __m128i *)me->hiSignal);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+    size_t o = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i cls = _mm_and_si128(_mm_shuffle_epi8(loClass, _mm_and_si128(v, nibble)),
+                                    _mm_shuffle_epi8(hiClass, _mm_and_si128(_mm_srli_epi16(v, 4), nibble)));
+        uint32_t mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(cls, zero)) & 0xFFFF;
+        if (mask == 0) {
+            continue;
+        }
+        // 类别位只有一位，低4位和高4位各查一次表后合并
+        __m128i sig = _mm_or_si128(_mm_shuffle_epi8(loSignal, _mm_and_si128(cls, nibble)),
+                                   _mm_shuffle_epi8(hiSignal, _mm_and_si128(_mm_srli_epi16(cls, 4), nibble)));
+        uint32_t m0 = mask & 0xFF;
+        uint32_t m1 = mask >> 8;
+        __m128i p0 = _mm_shuffle_epi8(sig, _mm_loadl_epi64((const __m128i *)packTable[m0]));
+        _mm_storel_epi64((__m128i *)(out + o), p0);
+        o += (size_t)__builtin_popcount(m0);
+        __m128i p1 = _mm_shuffle_epi8(_mm_srli_si128(sig, 8), _mm_loadl_epi64((const __m128i *)packTable[m1]));
+        _mm_storel_epi64((__m128i *)(out + o), p1);
+        o += (size_t)__builtin_popcount(m1);
+    }
+    return o + RunScalar(me, in + i, n - i, out + o);
+}
+
+/**
+ * @brief AVX2 实现：每次分类32个字节，半字节表复制到两个128位通道
+ */
+__attribute__((target("avx2,popcnt"))) static size_t RunAvx2(const KeyDecoder *me, const uint8_t *in, size_t n,
+                                                             uint8_t *out)
+{
+    const __m256i loClass = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)me->loClass));
+    const __m256i hiClass = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)me->hiClass));
+    const __m256i loSignal = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)me->loSignal));
+    const __m256i hiSignal = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)me->hiSignal));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t o = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+        __m256i cls = _mm256_and_si256(_mm256_shuffle_epi8(loClass, _mm256_and_si256(v, nibble)),
+                                       _mm256_shuffle_epi8(hiClass, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(cls, zero));
+        if (mask == 0) {
+            continue;
+        }
+        __m256i sig = _mm256_or_si256(
+            _mm256_shuffle_epi8(loSignal, _mm256_and_si256(cls, nibble)),
+            _mm256_shuffle_epi8(hiSignal, _mm256_and_si256(_mm256_srli_epi16(cls, 4), nibble)));
+        __m128i halves[2] = {_mm256_castsi256_si128(sig), _mm256_extracti128_si256(sig, 1)};
+        for (int h = 0; h < 2; h++) {
+            uint32_t m0 = (mask >> (h * 16)) & 0xFF;
+            uint32_t m1 = (mask >> (h * 16 + 8)) & 0xFF;
+            __m128i p0 = _mm_shuffle_epi8(halves[h], _mm_loadl_epi64((const __m128i *)packTable[m0]));
+            _mm_storel_epi64((__m128i *)(out + o), p0);
+            o += (size_t)__builtin_popcount(m0);
+            __m128i p1 = _mm_shuffle_epi8(_mm_srli_si128(halves[h], 8), _mm_loadl_epi64((const __m128i *)packTable[m1]));
+            _mm_storel_epi64((__m128i *)(out + o), p1);
+            o += (size_t)__builtin_popcount(m1);
+        }
+    }
+    return o + RunScalar(me, in + i, n - i, out + o);
+}
+#endif // KEY_DECODER_X86
+
+/**
+ * @brief 解码一段字节流
+ *
+ * @param me 指向解码器的指针
+ * @param in 输入字节
+ * @param n 输入字节数
+ * @param out 输出信号编号，容量至少为 n + KEY_DECODER_SLACK
+ * @return 输出的信号个数
+ */
+size_t KeyDecoderRun(const KeyDecoder *me, const uint8_t *in, size_t n, uint8_t *out)
+{
+#ifdef KEY_DECODER_X86
+    if (me->isa == KEY_DECODER_AVX2) {
+        return RunAvx2(me, in, n, out);
+    }
+    if (me->isa == KEY_DECODER_SSSE3) {
+        return RunSsse3(me, in, n, out);
+    }
+#endif // KEY_DECODER_X86
+    return RunScalar(me, in, n, out);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file key_decoder.h
+ * @brief 批量按键解码头文件
+ *
+ * 把原始字节流按映射表批量转换为信号编号：没有映射的字节丢弃，输出紧凑的信号数组，
+ * 可以直接批量入队。映射的字节不超过 KEY_DECODER_VECTOR_KEYS 个时，
+ * 用 SIMD 查表一次分类16/32个字节：每个映射字节分配一个类别位，
+ * 低半字节表和高半字节表各做一次 shuffle 查表后按位与得到类别，
+ * 再查表得到信号编号并按掩码左移压缩输出。运行时检测 CPU 支持的指令集，
+ * 不支持或映射字节过多时使用逐字节查表的标量实现。
+ */
+
+#ifndef KEY_DECODER_H
+#define KEY_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define KEY_DECODER_DROP 0xFF           ///< 映射表中表示丢弃的值
+#define KEY_DECODER_VECTOR_KEYS 8       ///< SIMD 实现支持的最多映射字节数
+#define KEY_DECODER_SLACK 32            ///< 输出缓冲区需要比输入多留的字节数
+
+/**
+ * @brief 解码实现
+ */
+typedef enum KeyDecoderIsaTag {
+    KEY_DECODER_SCALAR,         ///< 逐字节查表
+    KEY_DECODER_SSSE3,          ///< SSSE3，每次16字节
+    KEY_DECODER_AVX2,           ///< AVX2，每次32字节
+} KeyDecoderIsa;
+
+/**
+ * @brief 按键解码器
+ */
+typedef struct KeyDecoderTag {
+    uint8_t map[256];           ///< 字节到信号编号的映射，KEY_DECODER_DROP 表示丢弃
+    uint8_t loClass[16];        ///< 低半字节到类别位的表
+    uint8_t hiClass[16];        ///< 高半字节到类别位的表
+    uint8_t loSignal[16];       ///< 类别位（低4位）到信号编号的表
+    uint8_t hiSignal[16];       ///< 类别位（高4位）到信号编号的表
+    uint8_t keyNum;             ///< 已映射的字节数
+    KeyDecoderIsa best;         ///< CPU 支持的最快实现
+    KeyDecoderIsa isa;          ///< 当前使用的实现
+} KeyDecoder;
+
+/**
+ * @brief 初始化解码器，所有字节都丢弃
+ *
+ * @param me 指向解码器的指针
+ */
+void KeyDecoderCtor(KeyDecoder *me);
+
+/**
+ * @brief 映射一个字节
+ *
+ * 映射字节超过 KEY_DECODER_VECTOR_KEYS 个后改用标量实现
+ *
+ * @param me 指向解码器的指针
+ * @param byte 输入字节
+ * @param signal 信号编号，不能是 KEY_DECODER_DROP
+ */
+void KeyDecoderMap(KeyDecoder *me, uint8_t byte, uint8_t signal);
+
+/**
+ * @brief 指定使用的实现，用于对比测试
+ *
+ * @param me 指向解码器的指针
+ * @param isa 希望使用的实现，CPU 不支持或映射字节过多时降级
+ * @return 实际使用的实现
+ */
+KeyDecoderIsa KeyDecoderUse(KeyDecoder *me, KeyDecoderIsa isa);
+
+/**
+ * @brief 解码一段字节流
+ *
+ * SIMD 实现按8字节整块写出，out 的容量至少为 n + KEY_DECODER_SLACK
+ *
+ * @param me 指向解码器的指针
+ * @param in 输入字节
+ * @param n 输入字节数
+ * @param out 输出信号编号
+ * @return 输出的信号个数
+ */
+size_t KeyDecoderRun(const KeyDecoder *me, const uint8_t *in, size_t n, uint8_t *out);
+
+/**
+ * @brief 解码一个字节
+ *
+ * @param me 指向解码器的指针
+ * @param byte 输入字节
+ * @return 信号编号，KEY_DECODER_DROP 表示丢弃
+ */
+static inline uint8_t KeyDecoderByte(const KeyDecoder *me, uint8_t byte)
+{
+    return me->map[byte];
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !KEY_DECODER_H
@@ -0,0 +1,135 @@
+/**
+ * @file mailbox.c
+ * @brief 侵入式多生产者/单消费者邮箱实现文件
+ * 
+ * 入队：节点 next 置空后原子交换 head，再把旧 head 的 next 指向新节点。
+ * 出队：消费者从 tail 开始沿 next 前进，遇到哨兵节点时跳过，
+ * 取最后一个节点之前把哨兵重新入队。
+ * 就绪通知：生产者入队后检查 idle 标志，只有抢到 idle（1→0）的生产者负责通知。
+ */
+
+#include "mailbox.h"
+#include <stddef.h>
+
+/**
+ * @brief 初始化邮箱
+ * 
+ * @param me 指向邮箱对象的指针
+ * @param readyList 就绪队列
+ */
+void MailboxCtor(Mailbox *me, SyncQueue *readyList)
+{
+    me->stub.next = NULL;
+    me->head = &me->stub;
+    me->tail = &me->stub;
+    me->idle = 1;
+    me->readyList = readyList;
+}
+
+/**
+ * @brief 节点入队，不做就绪通知
+ * 
+ * @param me 指向邮箱对象的指针
+ * @param node 节点
+ */
+static inline void Push(Mailbox *me, MailboxNode *node)
+{
+    __atomic_store_n(&node->next, NULL, __ATOMIC_RELAXED);
+    MailboxNode *prev = __atomic_exchange_n(&me->head, node, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 投递事件
+ * 
+ * @param me 指向邮箱对象的指针
+ * @param node 事件中内嵌的节点
+ * @return 0 成功，1 事件已入邮箱但就绪队列已满，通知推迟到下一次投递
+ */
+int MailboxPost(Mailbox *me, MailboxNode *node)
+{
+    Push(me, node);
+
+    // 只在空→非空的边沿通知：邮箱已停放，并且由本生产者抢到了通知权
+    if (__atomic_load_n(&me->idle, __ATOMIC_SEQ_CST) != 0 &&
+        __atomic_exchange_n(&me->idle, 0, __ATOMIC_SEQ_CST) != 0) {
+        if (QueueEnqueue(__atomic_load_n(&me->readyList, __ATOMIC_ACQUIRE), me) != 0) {
+            // 事件已经在邮箱里，不能让调用者重投；交还通知权，由下一次投递重新通知
+            __atomic_store_n(&me->idle, 1, __ATOMIC_SEQ_CST);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 取出一个事件
+ * 
+ * @param me 指向邮箱对象的指针
+ * @return 事件节点，邮箱为空时返回NULL
+ */
+MailboxNode *MailboxPop(Mailbox *me)
+{
+    MailboxNode *tail = me->tail;
+    MailboxNode *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    // 跳过哨兵节点
+    if (tail == &me->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        me->tail = next;
+        tail = next;
+        next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+    if (next != NULL) {
+        me->tail = next;
+        return tail;
+    }
+
+    // tail 不是最后入队的节点，说明有生产者正在入队，稍后再取
+    if (tail != __atomic_load_n(&me->head, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    // tail 是最后一个节点，重新放入哨兵后才能把它取走
+    Push(me, &me->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next != NULL) {
+        me->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 停放邮箱
+ * 
+ * @param me 指向邮箱对象的指针
+ * @return true 已停放，false 仍由当前消费者处理
+ */
+bool MailboxPark(Mailbox *me)
+{
+    __atomic_store_n(&me->idle, 1, __ATOMIC_SEQ_CST);
+
+    // 标记空闲后再检查一次，避免与刚入队但看到 idle 为0的生产者错过通知
+    bool empty = me->tail == &me->stub && __atomic_load_n(&me->stub.next, __ATOMIC_ACQUIRE) == NULL &&
+                 __atomic_load_n(&me->head, __ATOMIC_SEQ_CST) == &me->stub;
+    if (empty) {
+        return true;
+    }
+    // 有新事件：抢回处理权，抢不到说明生产者已经通知了就绪队列
+    return __atomic_exchange_n(&me->idle, 0, __ATOMIC_SEQ_CST) == 0;
+}
+
+/**
+ * @brief 把邮箱改挂到另一个就绪队列
+ * 
+ * @param me 指向邮箱对象的指针
+ * @param readyList 新的就绪队列
+ */
+void MailboxSetReadyList(Mailbox *me, SyncQueue *readyList)
+{
+    // 新的消费者通过就绪队列的锁拿到邮箱，之后的停放和通知都使用新的就绪队列
+    __atomic_store_n(&me->readyList, readyList, __ATOMIC_RELEASE);
+}
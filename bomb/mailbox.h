@@ -0,0 +1,105 @@
+/**
+ * @file mailbox.h
+ * @brief 侵入式多生产者/单消费者邮箱头文件
+ * 
+ * 每个状态机实例内嵌一个邮箱（Vyukov 侵入式链表队列），事件内嵌 MailboxNode。
+ * 入队只需要一次原子交换，不同实例的生产者之间没有任何竞争；
+ * 只有邮箱从空变为非空时才把邮箱放入就绪队列，通知工作线程。
+ */
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sync_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 邮箱节点，内嵌在事件结构体中
+ */
+typedef struct MailboxNodeTag {
+    struct MailboxNodeTag *next;    ///< 下一个节点（原子访问）
+} MailboxNode;
+
+/**
+ * @brief 邮箱结构体
+ * 
+ * head/tail/idle 只能通过邮箱接口访问
+ */
+typedef struct MailboxTag {
+    MailboxNode *head;              ///< 生产者端，最后入队的节点（原子交换）
+    MailboxNode *tail;              ///< 消费者端，只由消费者线程访问
+    MailboxNode stub;               ///< 哨兵节点
+    uint8_t idle;                   ///< 1 表示邮箱已停放（不在就绪队列中）
+    SyncQueue *readyList;           ///< 就绪队列，元素为 Mailbox 指针
+} Mailbox;
+
+/**
+ * @brief 初始化邮箱
+ * 
+ * 就绪队列的容量必须不小于挂在它上面的邮箱数，保证通知不会因为队列满而丢失
+ * 
+ * @param me 指向邮箱对象的指针
+ * @param readyList 就绪队列
+ */
+void MailboxCtor(Mailbox *me, SyncQueue *readyList);
+
+/**
+ * @brief 投递事件（任意线程）
+ * 
+ * 事件总是进入邮箱，任何返回值都不能重投同一个节点（节点是侵入式的，重投会破坏链表）。
+ * 就绪队列已满时交还通知权，邮箱保持停放，下一次投递重新通知；
+ * 就绪队列容量不小于邮箱数时不会发生
+ * 
+ * @param me 指向邮箱对象的指针
+ * @param node 事件中内嵌的节点
+ * @return 0 成功，1 事件已入邮箱但就绪队列已满，通知推迟到下一次投递
+ */
+int MailboxPost(Mailbox *me, MailboxNode *node);
+
+/**
+ * @brief 取出一个事件（只能由当前处理该邮箱的消费者线程调用）
+ * 
+ * @param me 指向邮箱对象的指针
+ * @return 事件节点，邮箱为空（或生产者正在入队）时返回NULL
+ */
+MailboxNode *MailboxPop(Mailbox *me);
+
+/**
+ * @brief 停放邮箱（消费者在 MailboxPop 返回NULL后调用）
+ * 
+ * 标记邮箱空闲，之后的第一次投递会再次把邮箱放入就绪队列。
+ * 如果标记之后发现又有新事件并且抢回了处理权，返回 false，
+ * 消费者应继续处理该邮箱
+ * 
+ * @param me 指向邮箱对象的指针
+ * @return true 已停放，false 仍由当前消费者处理
+ */
+bool MailboxPark(Mailbox *me);
+
+/**
+ * @brief 把邮箱改挂到另一个就绪队列
+ * 
+ * 只能由当前处理该邮箱的消费者在两次分发之间调用：邮箱没有停放，生产者不会读取就绪队列。
+ * 调用后由调用者把邮箱放入新的就绪队列，交给新的消费者继续处理，邮箱中的事件顺序不变
+ * 
+ * @param me 指向邮箱对象的指针
+ * @param readyList 新的就绪队列
+ */
+void MailboxSetReadyList(Mailbox *me, SyncQueue *readyList);
+
+/**
+ * @brief 由节点指针得到内嵌它的事件结构体指针
+ */
+#define MAILBOX_CONTAINER(node, type, member) ((type *)((char *)(node) - offsetof(type, member)))
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !MAILBOX_H
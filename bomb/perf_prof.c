@@ -0,0 +1,401 @@
+/**
+ * @file perf_prof.c
+ * @brief 按（状态，信号）统计硬件性能计数器实现文件
+ *
+ * 计数器以周期为组长打开成一组，保证各计数器在同一时间段内计数。
+ * 内核允许时（映射页的 cap_user_rdpmc）用 rdpmc 在用户态读取，不进内核，
+ * 避免系统调用本身冲掉被测处理函数的缓存和分支预测状态；否则用一次 read 读出整组。
+ * 非 Linux 平台没有 perf_event_open，只用单调时钟统计耗时。
+ */
+
+#include "perf_prof.h"
+#include "timespec_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif // __linux__
+
+#define PERF_PROF_CALIBRATE 1000    ///< 标定开销的 Begin/End 次数
+
+/// 写入结果文件的计数器名
+static const char *const eventNames[PERF_PROF_EVENTS] = {
+    "cycles", "instructions", "branch-misses", "l1d-misses", "llc-misses",
+};
+
+#ifdef __linux__
+/// 各计数器的 perf_event_attr 类型和配置
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} eventConfigs[PERF_PROF_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+};
+
+/**
+ * @brief 在当前线程上打开一个计数器
+ *
+ * @param event 计数器
+ * @param group 组长描述符，-1 表示自己做组长
+ * @return 文件描述符，-1 失败
+ */
+static int PerfProfOpen(PerfProfEvent event, int group)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = eventConfigs[event].type;
+    attr.config = eventConfigs[event].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief 通过映射页和 rdpmc 在用户态读取计数器
+ *
+ * 计数器当前没有调度到硬件上时返回 -1，由调用者改用 read
+ */
+static int PerfProfRdpmc(const struct perf_event_mmap_page *pc, uint64_t *value)
+{
+    uint32_t seq;
+    uint64_t count;
+    do {
+        seq = pc->lock;
+        __asm__ volatile("" ::: "memory");
+        uint32_t index = pc->index;
+        if (!pc->cap_user_rdpmc || index == 0) {
+            return -1;
+        }
+        uint32_t lo;
+        uint32_t hi;
+        __asm__ volatile("rdpmc" : "=a"(lo), "=d"(hi) : "c"(index - 1));
+        // 硬件计数器只有 pmc_width 位，符号扩展后加上内核维护的偏移
+        uint32_t shift = 64 - pc->pmc_width;
+        int64_t pmc = (int64_t)(((uint64_t)hi << 32 | lo) << shift) >> shift;
+        count = pc->offset + (uint64_t)pmc;
+        __asm__ volatile("" ::: "memory");
+    } while (pc->lock != seq);
+    *value = count;
+    return 0;
+}
+#endif // __x86_64__ || __i386__
+
+/**
+ * @brief 读取整组计数器
+ */
+static void PerfProfReadGroup(PerfProf *me, uint64_t *values)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (me->pages[0] != NULL) {
+        int ok = 1;
+        for (int i = 0; i < PERF_PROF_EVENTS && ok; i++) {
+            if (me->pages[i] != NULL) {
+                ok = PerfProfRdpmc((const struct perf_event_mmap_page *)me->pages[i], &values[i]) == 0;
+            }
+        }
+        if (ok) {
+            return;
+        }
+    }
+#endif // __x86_64__ || __i386__
+    // PERF_FORMAT_GROUP：先是计数器个数，后面按打开顺序排列各计数器的值
+    uint64_t buf[1 + PERF_PROF_EVENTS];
+    if (read(me->fds[0], buf, sizeof(buf)) <= 0) {
+        return;
+    }
+    uint64_t k = 1;
+    for (int i = 0; i < PERF_PROF_EVENTS && k <= buf[0]; i++) {
+        if (me->available & (1U << i)) {
+            values[i] = buf[k++];
+        }
+    }
+}
+
+/**
+ * @brief 打开计数器组，周期计数器不可用时整组都不使用
+ */
+static void PerfProfOpenGroup(PerfProf *me)
+{
+    me->fds[0] = PerfProfOpen(PERF_PROF_CYCLES, -1);
+    if (me->fds[0] < 0) {
+        return;
+    }
+    me->available = 1U << PERF_PROF_CYCLES;
+    for (int i = 1; i < PERF_PROF_EVENTS; i++) {
+        me->fds[i] = PerfProfOpen((PerfProfEvent)i, me->fds[0]);
+        if (me->fds[i] >= 0) {
+            me->available |= (uint8_t)(1U << i);
+        }
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    // 所有计数器都允许 rdpmc 时才走用户态读取，否则保留映射也没有意义
+    int rdpmc = 1;
+    for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+        if (me->fds[i] < 0) {
+            continue;
+        }
+        void *page = mmap(NULL, (size_t)sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, me->fds[i], 0);
+        if (page == MAP_FAILED) {
+            rdpmc = 0;
+            break;
+        }
+        me->pages[i] = page;
+        if (!((const struct perf_event_mmap_page *)page)->cap_user_rdpmc) {
+            rdpmc = 0;
+        }
+    }
+    if (!rdpmc) {
+        for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+            if (me->pages[i] != NULL) {
+                munmap(me->pages[i], (size_t)sysconf(_SC_PAGESIZE));
+                me->pages[i] = NULL;
+            }
+        }
+    }
+#endif // __x86_64__ || __i386__
+}
+#endif // __linux__
+
+/**
+ * @brief 读取当前计数器值
+ */
+static inline void PerfProfRead(PerfProf *me, uint64_t *values)
+{
+    if (me->timeFallback) {
+        values[PERF_PROF_CYCLES] = TimespecNowNs();
+        return;
+    }
+#ifdef __linux__
+    PerfProfReadGroup(me, values);
+#endif // __linux__
+}
+
+/**
+ * @brief 标定一对 Begin/End 本身的计数，取多次中的最小值
+ */
+static void PerfProfCalibrate(PerfProf *me)
+{
+    for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+        me->overhead[i] = UINT64_MAX;
+    }
+    for (int n = 0; n < PERF_PROF_CALIBRATE; n++) {
+        PerfProfSample sample;
+        uint64_t end[PERF_PROF_EVENTS] = {0};
+        PerfProfBegin(me, &sample);
+        PerfProfRead(me, end);
+        for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+            uint64_t delta = end[i] - sample.values[i];
+            if (delta < me->overhead[i]) {
+                me->overhead[i] = delta;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 初始化并在当前线程上打开计数器
+ *
+ * @param me 指向统计对象的指针
+ * @param name 名称
+ * @param stateNum 状态数
+ * @param signalNum 信号数
+ * @return 0 成功（部分计数器可能不可用），-1 内存不足
+ */
+int PerfProfCtor(PerfProf *me, const char *name, uint32_t stateNum, uint32_t signalNum)
+{
+    memset(me, 0, sizeof(*me));
+    for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+        me->fds[i] = -1;
+    }
+    me->name = name;
+    me->stateNum = stateNum;
+    me->signalNum = signalNum;
+    me->cells = (PerfProfCell *)calloc((size_t)stateNum * signalNum, sizeof(PerfProfCell));
+    if (me->cells == NULL) {
+        return -1;
+    }
+#ifdef __linux__
+    PerfProfOpenGroup(me);
+#endif // __linux__
+    if (me->available == 0) {
+        me->timeFallback = 1;
+        me->available = 1U << PERF_PROF_CYCLES;
+    }
+    PerfProfCalibrate(me);
+    return 0;
+}
+
+/**
+ * @brief 关闭计数器并释放统计单元
+ *
+ * @param me 指向统计对象的指针
+ */
+void PerfProfDtor(PerfProf *me)
+{
+#ifdef __linux__
+    for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+        if (me->pages[i] != NULL) {
+            munmap(me->pages[i], (size_t)sysconf(_SC_PAGESIZE));
+            me->pages[i] = NULL;
+        }
+    }
+    // 先关组员再关组长
+    for (int i = PERF_PROF_EVENTS - 1; i >= 0; i--) {
+        if (me->fds[i] >= 0) {
+            close(me->fds[i]);
+            me->fds[i] = -1;
+        }
+    }
+#endif // __linux__
+    free(me->cells);
+    me->cells = NULL;
+}
+
+/**
+ * @brief 设置状态名和信号名，用于报告
+ *
+ * @param me 指向统计对象的指针
+ * @param stateNames 状态名数组，长度为 stateNum，可以为 NULL
+ * @param signalNames 信号名数组，长度为 signalNum，可以为 NULL
+ */
+void PerfProfSetNames(PerfProf *me, const char *const *stateNames, const char *const *signalNames)
+{
+    me->stateNames = stateNames;
+    me->signalNames = signalNames;
+}
+
+/**
+ * @brief 把处理函数指针等键映射为状态编号，第一次出现时登记
+ *
+ * @param me 指向统计对象的指针
+ * @param key 状态键
+ * @param name 状态名，第一次登记时保存，可以为 NULL
+ * @return 状态编号
+ */
+uint32_t PerfProfStateOf(PerfProf *me, const void *key, const char *name)
+{
+    for (uint32_t i = 0; i < me->keyNum; i++) {
+        if (me->stateKeys[i] == key) {
+            return i;
+        }
+    }
+    if (me->keyNum < PERF_PROF_STATES_MAX && me->keyNum < me->stateNum) {
+        me->stateKeys[me->keyNum] = key;
+        me->keyNames[me->keyNum] = name;
+        return me->keyNum++;
+    }
+    return me->stateNum - 1;
+}
+
+/**
+ * @brief 分发开始前读取计数器
+ *
+ * @param me 指向统计对象的指针
+ * @param sample 输出的快照
+ */
+void PerfProfBegin(PerfProf *me, PerfProfSample *sample)
+{
+    memset(sample, 0, sizeof(*sample));
+    PerfProfRead(me, sample->values);
+}
+
+/**
+ * @brief 分发结束后读取计数器，差值累加到（state, signal）单元
+ *
+ * @param me 指向统计对象的指针
+ * @param sample PerfProfBegin 得到的快照
+ * @param state 分发前的状态编号
+ * @param signal 信号编号
+ */
+void PerfProfEnd(PerfProf *me, const PerfProfSample *sample, uint32_t state, uint32_t signal)
+{
+    uint64_t end[PERF_PROF_EVENTS] = {0};
+    PerfProfRead(me, end);
+    if (me->cells == NULL || state >= me->stateNum || signal >= me->signalNum) {
+        return;
+    }
+    PerfProfCell *cell = &me->cells[state * me->signalNum + signal];
+    cell->calls++;
+    for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+        cell->counts[i] += end[i] - sample->values[i];
+    }
+}
+
+/**
+ * @brief 状态名，没有设置时返回 "-"
+ */
+static const char *PerfProfStateName(const PerfProf *me, uint32_t state)
+{
+    if (me->stateNames != NULL && me->stateNames[state] != NULL) {
+        return me->stateNames[state];
+    }
+    if (state < me->keyNum && me->keyNames[state] != NULL) {
+        return me->keyNames[state];
+    }
+    return "-";
+}
+
+/**
+ * @brief 写出统计结果
+ *
+ * 格式：
+ *   perf <name> <stateNum> <signalNum> <cycles|ns>
+ *   events <各计数器名>
+ *   available <各计数器是否可用 0/1>
+ *   overhead <一对 Begin/End 本身的计数>
+ *   <state> <signal> <状态名> <信号名> <calls> <各计数器累计值>
+ * 只写出分发过的单元
+ *
+ * @param me 指向统计对象的指针
+ * @param out 输出文件
+ * @return 0 成功，-1 写入失败
+ */
+int PerfProfSave(const PerfProf *me, FILE *out)
+{
+    fprintf(out, "perf %s %u %u %s\n", me->name != NULL ? me->name : "-", me->stateNum, me->signalNum,
+            me->timeFallback ? "ns" : "cycles");
+    fprintf(out, "events");
+    for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+        fprintf(out, " %s", eventNames[i]);
+    }
+    fprintf(out, "\navailable");
+    for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+        fprintf(out, " %d", (me->available >> i) & 1);
+    }
+    fprintf(out, "\noverhead");
+    for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+        fprintf(out, " %llu", (unsigned long long)me->overhead[i]);
+    }
+    fprintf(out, "\n");
+    for (uint32_t s = 0; me->cells != NULL && s < me->stateNum; s++) {
+        for (uint32_t g = 0; g < me->signalNum; g++) {
+            const PerfProfCell *cell = &me->cells[s * me->signalNum + g];
+            if (cell->calls == 0) {
+                continue;
+            }
+            const char *signalName = "-";
+            if (me->signalNames != NULL && me->signalNames[g] != NULL) {
+                signalName = me->signalNames[g];
+            }
+            fprintf(out, "%u %u %s %s %llu", s, g, PerfProfStateName(me, s), signalName,
+                    (unsigned long long)cell->calls);
+            for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+                fprintf(out, " %llu", (unsigned long long)cell->counts[i]);
+            }
+            fprintf(out, "\n");
+        }
+    }
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file perf_prof.h
+ * @brief 按（状态，信号）统计硬件性能计数器头文件
+ *
+ * 用 perf_event_open 在分发线程上打开一组计数器（周期、指令、分支预测失败、
+ * L1 数据缓存读缺失、末级缓存缺失），每次分发前后各读一次，差值累加到
+ * 分发前所在的（状态，信号）单元，不需要外部 profiler。
+ * 计数器只统计用户态；支持时用 rdpmc 在用户态直接读取，否则用 read 读取整个计数器组。
+ * 读取本身的开销在初始化时标定，保存结果时一起写出，由报告工具扣除。
+ * 没有权限或虚拟机没有 PMU 时，周期计数改用单调时钟纳秒，其余计数器标记为不可用。
+ *
+ * 计数器只属于打开它的线程，必须在分发线程上初始化，每个分发线程使用自己的对象。
+ */
+
+#ifndef PERF_PROF_H
+#define PERF_PROF_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define PERF_PROF_STATES_MAX 32     ///< 按处理函数指针登记的最多状态数
+
+/**
+ * @brief 计数器
+ */
+typedef enum PerfProfEventTag {
+    PERF_PROF_CYCLES,           ///< CPU 周期（不可用时为纳秒）
+    PERF_PROF_INSTRUCTIONS,     ///< 指令数
+    PERF_PROF_BRANCH_MISSES,    ///< 分支预测失败
+    PERF_PROF_L1D_MISSES,       ///< L1 数据缓存读缺失
+    PERF_PROF_LLC_MISSES,       ///< 末级缓存缺失
+    PERF_PROF_EVENTS,           ///< 计数器数量
+} PerfProfEvent;
+
+/**
+ * @brief 一个（状态，信号）单元的累计值
+ */
+typedef struct PerfProfCellTag {
+    uint64_t calls;                     ///< 分发次数
+    uint64_t counts[PERF_PROF_EVENTS];  ///< 各计数器累计值
+} PerfProfCell;
+
+/**
+ * @brief 一次分发开始时的计数器快照，放在调用者的栈上，嵌套分发互不影响
+ */
+typedef struct PerfProfSampleTag {
+    uint64_t values[PERF_PROF_EVENTS];  ///< 计数器值
+} PerfProfSample;
+
+/**
+ * @brief 性能计数器统计对象
+ */
+typedef struct PerfProfTag {
+    const char *name;           ///< 名称，写入结果文件
+    int fds[PERF_PROF_EVENTS];  ///< 计数器文件描述符，-1 表示不可用，fds[0] 为组长
+    void *pages[PERF_PROF_EVENTS];  ///< rdpmc 用的映射页，NULL 表示用 read 读取
+    uint8_t available;          ///< 可用计数器的位图
+    uint8_t timeFallback;       ///< 1 表示周期计数改用纳秒
+    uint32_t stateNum;          ///< 状态数
+    uint32_t signalNum;         ///< 信号数
+    PerfProfCell *cells;        ///< 统计单元，按 state * signalNum + signal 排列
+    const char *const *stateNames;  ///< 状态名，可以为 NULL
+    const char *const *signalNames; ///< 信号名，可以为 NULL
+    const void *stateKeys[PERF_PROF_STATES_MAX];    ///< 按处理函数指针登记的状态
+    const char *keyNames[PERF_PROF_STATES_MAX];     ///< 登记状态的名字
+    uint32_t keyNum;            ///< 已登记的状态数
+    uint64_t overhead[PERF_PROF_EVENTS];    ///< 一对 Begin/End 本身的平均计数
+} PerfProf;
+
+/**
+ * @brief 初始化并在当前线程上打开计数器
+ *
+ * @param me 指向统计对象的指针
+ * @param name 名称
+ * @param stateNum 状态数
+ * @param signalNum 信号数
+ * @return 0 成功（部分计数器可能不可用），-1 内存不足
+ */
+int PerfProfCtor(PerfProf *me, const char *name, uint32_t stateNum, uint32_t signalNum);
+
+/**
+ * @brief 关闭计数器并释放统计单元
+ *
+ * @param me 指向统计对象的指针
+ */
+void PerfProfDtor(PerfProf *me);
+
+/**
+ * @brief 设置状态名和信号名，用于报告
+ *
+ * @param me 指向统计对象的指针
+ * @param stateNames 状态名数组，长度为 stateNum，可以为 NULL
+ * @param signalNames 信号名数组，长度为 signalNum，可以为 NULL
+ */
+void PerfProfSetNames(PerfProf *me, const char *const *stateNames, const char *const *signalNames);
+
+/**
+ * @brief 把处理函数指针等键映射为状态编号，第一次出现时登记
+ *
+ * 用于 QFsm 这类没有状态编号的状态机，超过 PERF_PROF_STATES_MAX 或 stateNum 的归入最后一个编号
+ *
+ * @param me 指向统计对象的指针
+ * @param key 状态键
+ * @param name 状态名，第一次登记时保存，可以为 NULL
+ * @return 状态编号
+ */
+uint32_t PerfProfStateOf(PerfProf *me, const void *key, const char *name);
+
+/**
+ * @brief 分发开始前读取计数器
+ *
+ * @param me 指向统计对象的指针
+ * @param sample 输出的快照
+ */
+void PerfProfBegin(PerfProf *me, PerfProfSample *sample);
+
+/**
+ * @brief 分发结束后读取计数器，差值累加到（state, signal）单元
+ *
+ * @param me 指向统计对象的指针
+ * @param sample PerfProfBegin 得到的快照
+ * @param state 分发前的状态编号
+ * @param signal 信号编号
+ */
+void PerfProfEnd(PerfProf *me, const PerfProfSample *sample, uint32_t state, uint32_t signal);
+
+/**
+ * @brief 写出统计结果（文本格式，供 perfreport 读取）
+ *
+ * @param me 指向统计对象的指针
+ * @param out 输出文件
+ * @return 0 成功，-1 写入失败
+ */
+int PerfProfSave(const PerfProf *me, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !PERF_PROF_H
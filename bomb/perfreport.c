@@ -0,0 +1,204 @@
+/**
+ * @file perfreport.c
+ * @brief 硬件计数器统计报告工具
+ *
+ * 读取 PerfProfSave 写出的一个或多个统计文件，扣除 Begin/End 本身的开销后，
+ * 按指定计数器的累计值从高到低排列所有（状态，信号）处理函数，
+ * 输出每次调用的平均值、IPC 以及分支预测失败和缓存缺失。
+ *
+ * 用法：perfreport [-s cycles|instructions|branch-misses|l1d-misses|llc-misses] [-n top] <perf>...
+ */
+
+#include "perf_prof.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PERFREPORT_MAX_ROWS 4096    ///< 最多读取的单元数
+#define PERFREPORT_NAME_LEN 32      ///< 名字最大长度
+
+/**
+ * @brief 一个处理函数的统计
+ */
+typedef struct PerfRowTag {
+    char file[PERFREPORT_NAME_LEN];     ///< 统计对象名
+    char state[PERFREPORT_NAME_LEN];    ///< 状态名
+    char signal[PERFREPORT_NAME_LEN];   ///< 信号名
+    const char *unit;                   ///< 周期计数器单位
+    uint8_t available;                  ///< 可用计数器的位图
+    PerfProfCell cell;                  ///< 扣除开销后的累计值
+} PerfRow;
+
+static PerfRow rows[PERFREPORT_MAX_ROWS];
+static uint32_t rowNum;
+static int sortEvent = PERF_PROF_CYCLES;
+
+static const char *const eventNames[PERF_PROF_EVENTS] = {
+    "cycles", "instructions", "branch-misses", "l1d-misses", "llc-misses",
+};
+
+/**
+ * @brief 读取一个统计文件
+ *
+ * @param path 文件路径
+ * @return 0 成功，-1 失败
+ */
+static int LoadPerf(const char *path)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL) {
+        return -1;
+    }
+    char name[PERFREPORT_NAME_LEN];
+    char unit[8];
+    unsigned stateNum;
+    unsigned signalNum;
+    int available[PERF_PROF_EVENTS];
+    unsigned long long overhead[PERF_PROF_EVENTS];
+    if (fscanf(in, "perf %31s %u %u %7s events %*s %*s %*s %*s %*s available %d %d %d %d %d "
+                   "overhead %llu %llu %llu %llu %llu",
+               name, &stateNum, &signalNum, unit, &available[0], &available[1], &available[2], &available[3],
+               &available[4], &overhead[0], &overhead[1], &overhead[2], &overhead[3], &overhead[4]) != 14) {
+        fclose(in);
+        return -1;
+    }
+    const char *unitName = strcmp(unit, "ns") == 0 ? "ns" : "cycles";
+
+    unsigned state;
+    unsigned signal;
+    char stateName[PERFREPORT_NAME_LEN];
+    char signalName[PERFREPORT_NAME_LEN];
+    unsigned long long calls;
+    unsigned long long counts[PERF_PROF_EVENTS];
+    while (rowNum < PERFREPORT_MAX_ROWS &&
+           fscanf(in, "%u %u %31s %31s %llu %llu %llu %llu %llu %llu", &state, &signal, stateName, signalName,
+                  &calls, &counts[0], &counts[1], &counts[2], &counts[3], &counts[4]) == 10) {
+        PerfRow *row = &rows[rowNum++];
+        memcpy(row->file, name, sizeof(row->file));
+        // 没有名字时用编号
+        if (strcmp(stateName, "-") == 0) {
+            snprintf(row->state, sizeof(row->state), "#%u", state);
+        } else {
+            memcpy(row->state, stateName, sizeof(row->state));
+        }
+        if (strcmp(signalName, "-") == 0) {
+            snprintf(row->signal, sizeof(row->signal), "#%u", signal);
+        } else {
+            memcpy(row->signal, signalName, sizeof(row->signal));
+        }
+        row->unit = unitName;
+        row->available = 0;
+        row->cell.calls = calls;
+        for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+            if (available[i]) {
+                row->available |= (uint8_t)(1U << i);
+            }
+            // 扣除每次调用中 Begin/End 自身的计数
+            unsigned long long cost = overhead[i] * calls;
+            row->cell.counts[i] = counts[i] > cost ? counts[i] - cost : 0;
+        }
+    }
+    fclose(in);
+    return 0;
+}
+
+/**
+ * @brief 按选定计数器的累计值从高到低排序
+ */
+static int CompareRows(const void *a, const void *b)
+{
+    uint64_t x = ((const PerfRow *)a)->cell.counts[sortEvent];
+    uint64_t y = ((const PerfRow *)b)->cell.counts[sortEvent];
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+/**
+ * @brief 打印每次调用的平均值，计数器不可用时打印 "-"
+ */
+static void PrintPerCall(const PerfRow *row, int event)
+{
+    if (!(row->available & (1U << event))) {
+        printf(" %10s", "-");
+        return;
+    }
+    printf(" %10.1f", (double)row->cell.counts[event] / (double)row->cell.calls);
+}
+
+/**
+ * @brief 主函数
+ *
+ * @param argc 参数个数
+ * @param argv 参数列表
+ * @return 程序退出码
+ */
+int main(int argc, char *argv[])
+{
+    uint32_t top = PERFREPORT_MAX_ROWS;
+    int argi = 1;
+    for (; argi < argc && argv[argi][0] == '-'; argi++) {
+        if (strcmp(argv[argi], "-s") == 0 && argi + 1 < argc) {
+            argi++;
+            sortEvent = -1;
+            for (int i = 0; i < PERF_PROF_EVENTS; i++) {
+                if (strcmp(argv[argi], eventNames[i]) == 0) {
+                    sortEvent = i;
+                }
+            }
+            if (sortEvent < 0) {
+                fprintf(stderr, "unknown event %s\n", argv[argi]);
+                return 1;
+            }
+        } else if (strcmp(argv[argi], "-n") == 0 && argi + 1 < argc) {
+            top = (uint32_t)strtoul(argv[++argi], NULL, 0);
+        } else {
+            break;
+        }
+    }
+    if (argi >= argc) {
+        fprintf(stderr, "usage: %s [-s cycles|instructions|branch-misses|l1d-misses|llc-misses] [-n top] <perf>...\n",
+                argv[0]);
+        return 1;
+    }
+    for (; argi < argc; argi++) {
+        if (LoadPerf(argv[argi]) != 0) {
+            fprintf(stderr, "bad perf file %s\n", argv[argi]);
+            return 1;
+        }
+    }
+
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < rowNum; i++) {
+        total += rows[i].cell.counts[sortEvent];
+    }
+    qsort(rows, rowNum, sizeof(rows[0]), CompareRows);
+
+    printf("%4s %-8s %-10s %-8s %10s %6s %10s %10s %6s %10s %10s %10s\n", "rank", "fsm", "state", "signal", "calls",
+           "share", "cost/call", "instr/call", "ipc", "brmis/call", "l1d/call", "llc/call");
+    for (uint32_t i = 0; i < rowNum && i < top; i++) {
+        const PerfRow *row = &rows[i];
+        double share = total != 0 ? 100.0 * (double)row->cell.counts[sortEvent] / (double)total : 0.0;
+        printf("%4u %-8s %-10s %-8s %10llu %5.1f%%", i + 1, row->file, row->state, row->signal,
+               (unsigned long long)row->cell.calls, share);
+        PrintPerCall(row, PERF_PROF_CYCLES);
+        PrintPerCall(row, PERF_PROF_INSTRUCTIONS);
+        // IPC 需要周期和指令都是真实的硬件计数
+        if (strcmp(row->unit, "cycles") == 0 && (row->available & (1U << PERF_PROF_INSTRUCTIONS)) &&
+            row->cell.counts[PERF_PROF_CYCLES] != 0) {
+            printf(" %6.2f", (double)row->cell.counts[PERF_PROF_INSTRUCTIONS] /
+                                 (double)row->cell.counts[PERF_PROF_CYCLES]);
+        } else {
+            printf(" %6s", "-");
+        }
+        PrintPerCall(row, PERF_PROF_BRANCH_MISSES);
+        PrintPerCall(row, PERF_PROF_L1D_MISSES);
+        PrintPerCall(row, PERF_PROF_LLC_MISSES);
+        printf("\n");
+    }
+    // 周期计数器不可用时 cost 列是纳秒
+    for (uint32_t i = 0; i < rowNum; i++) {
+        if (strcmp(rows[i].unit, "ns") == 0) {
+            printf("note: %s had no hardware counters, cost is wall-clock ns\n", rows[i].file);
+            break;
+        }
+    }
+    return 0;
+}
@@ -27,6 +27,19 @@ void QFsmInit(QFsm *me, QEvent *e)
 void QFsmDispatch(QFsm *me, QEvent *e)
 {
     QStateHandler oldState = me->state;  // 保存当前状态
+#ifdef FSM_HISTORY
+    // 记录分发前的状态和信号
+    if (me->history != 0) {
+        FsmHistoryRecord(me->history, (uintptr_t)oldState, e->signal);
+    }
+#endif
+#ifdef FSM_PERF_PROFILE
+    // 处理函数及转换引起的退出/进入一起计入分发前的（状态，信号）
+    PerfProfSample sample;
+    if (me->perf != 0) {
+        PerfProfBegin(me->perf, &sample);
+    }
+#endif
     QState r = oldState(me, e);          // 调用当前状态处理函数
     
     // 如果发生了状态转换
@@ -35,4 +48,9 @@ void QFsmDispatch(QFsm *me, QEvent *e)
         QStateHandler newState = me->state;             // 获取新状态
         newState(me, &QEP_reservedEvt[Q_ENTRY_SIGNAL]); // 发送进入新状态事件
     }
+#ifdef FSM_PERF_PROFILE
+    if (me->perf != 0) {
+        PerfProfEnd(me->perf, &sample, PerfProfStateOf(me->perf, (const void *)oldState, 0), e->signal);
+    }
+#endif
 }
\ No newline at end of file
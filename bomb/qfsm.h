@@ -2,6 +2,12 @@
 #define QFSM_H
 
 #include <stdint.h>
+#ifdef FSM_HISTORY
+#include "fsm_history.h"
+#endif // FSM_HISTORY
+#ifdef FSM_PERF_PROFILE
+#include "perf_prof.h"
+#endif // FSM_PERF_PROFILE
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,11 +27,32 @@ typedef QState (*QStateHandler)(void *me, QEvent *e);  // 状态处理函数指
 // 状态机结构体
 typedef struct QFsmTag {
     QStateHandler state;  // 当前状态处理函数
+    uint8_t needTick;     // 当前状态是否订阅滴答事件
+#ifdef FSM_HISTORY
+    FsmHistory *history;  // 转换历史环，NULL 表示不记录
+#endif
+#ifdef FSM_PERF_PROFILE
+    PerfProf *perf;       // 硬件计数器统计，NULL 表示不统计
+#endif
 } QFsm;
 
 // 工具宏定义
 #define UNUSE(arg) (void)(arg)  // 未使用参数标记宏
-#define QFsmCtor(me, initial) ((me)->state = (initial))  // 状态机构造宏
+#ifdef FSM_HISTORY
+#define QFSM_CTOR_HISTORY(me) , (me)->history = 0
+#define QFsmSetHistory(me, h) ((me)->history = (h))  // 设置转换历史环
+#else
+#define QFSM_CTOR_HISTORY(me)
+#endif
+#ifdef FSM_PERF_PROFILE
+#define QFSM_CTOR_PERF(me) , (me)->perf = 0
+#define QFsmSetPerf(me, p) ((me)->perf = (p))  // 设置硬件计数器统计，状态按处理函数指针登记
+#else
+#define QFSM_CTOR_PERF(me)
+#endif
+#define QFsmCtor(me, initial) \
+    ((me)->state = (initial), (me)->needTick = 0 QFSM_CTOR_HISTORY(me) QFSM_CTOR_PERF(me))  // 状态机构造宏
+#define QFsmNeedTick(me) ((me)->needTick != 0)  // 当前状态是否需要滴答事件
 
 // 函数声明
 void QFsmInit(QFsm *me, QEvent *e);      // 状态机初始化
@@ -41,6 +68,10 @@ void QFsmDispatch(QFsm *me, QEvent *e);  // 事件分发
 #define Q_IGNORED() (Q_RET_IGNORED)
 #define Q_TRAN(target) (((QFsm *)me)->state = (QStateHandler)(target), Q_RET_TRAN)
 
+// 滴答订阅宏，一般在状态的 ENTRY/EXIT 中调用，运行循环只在订阅期间产生滴答
+#define Q_TICK_ARM() (((QFsm *)me)->needTick = 1)
+#define Q_TICK_DISARM() (((QFsm *)me)->needTick = 0)
+
 // 预定义信号枚举
 enum QReservedSignals {
     Q_ENTRY_SIGNAL = 1,  // 进入状态信号
@@ -0,0 +1,155 @@
+/**
+ * @file qk.c
+ * @brief 单线程优先级运行至完成内核实现文件
+ * 
+ * 投递：先入队，再置位就绪位图；位图由空变为非空时向唤醒队列投递令牌。
+ * 调度：取位图最高位对应的活动对象处理一个事件；队列为空时先清位再检查一次队列，
+ * 避免与刚入队还未置位的投递者错过事件。
+ */
+
+#include "qk.h"
+#include <stddef.h>
+
+/**
+ * @brief 优先级对应的就绪位
+ */
+#define QK_BIT(prio) (1U << ((prio) - 1U))
+
+/**
+ * @brief 就绪位图中的最高优先级，位图为空时返回0
+ */
+static inline uint8_t QkHighest(uint32_t set)
+{
+    return set == 0 ? 0 : (uint8_t)(32 - __builtin_clz(set));
+}
+
+/**
+ * @brief 初始化内核
+ * 
+ * @param me 指向内核对象的指针
+ */
+void QkCtor(QkKernel *me)
+{
+    for (int i = 0; i <= QK_PRIO_MAX; i++) {
+        me->actives[i] = NULL;
+    }
+    me->readySet = 0;
+    me->curPrio = 0;
+    me->running = 0;
+    me->owner = pthread_self();
+    QueueCtor(&me->wake, me->wakeBuffer, sizeof(me->wakeBuffer) / sizeof(me->wakeBuffer[0]));
+}
+
+/**
+ * @brief 注册活动对象
+ * 
+ * @param me 指向内核对象的指针
+ * @param a 活动对象
+ * @param prio 优先级
+ * @param fsm 状态机对象
+ * @param dispatch 分发函数
+ * @param buffer 事件队列缓冲区
+ * @param size 事件队列容量
+ * @return 0 成功，-1 优先级非法或已被占用
+ */
+int QkActiveCtor(QkKernel *me, QkActive *a, uint8_t prio, void *fsm, QkDispatch dispatch, void **buffer,
+                 uint32_t size)
+{
+    if (prio == 0 || prio > QK_PRIO_MAX || me->actives[prio] != NULL) {
+        return -1;
+    }
+    a->fsm = fsm;
+    a->dispatch = dispatch;
+    a->prio = prio;
+    QueueCtor(&a->queue, buffer, size);
+    me->actives[prio] = a;
+    return 0;
+}
+
+/**
+ * @brief 处理所有高于 ceiling 的就绪优先级，每个事件之后重新选择最高优先级
+ * 
+ * @param me 指向内核对象的指针
+ * @param ceiling 优先级上限，只有更高的优先级才会被处理
+ */
+static void QkSchedule(QkKernel *me, uint8_t ceiling)
+{
+    for (;;) {
+        uint8_t prio = QkHighest(__atomic_load_n(&me->readySet, __ATOMIC_ACQUIRE));
+        if (prio <= ceiling) {
+            return;
+        }
+
+        QkActive *a = me->actives[prio];
+        void *e = NULL;
+        if (!QueueTryDequeue(&a->queue, &e)) {
+            // 队列已空：清位后再检查一次，投递者是先入队后置位的
+            __atomic_fetch_and(&me->readySet, ~QK_BIT(prio), __ATOMIC_SEQ_CST);
+            if (!QueueTryDequeue(&a->queue, &e)) {
+                continue;
+            }
+            __atomic_fetch_or(&me->readySet, QK_BIT(prio), __ATOMIC_SEQ_CST);
+        }
+
+        // 运行一个步骤，期间在本线程内向更高优先级的投递会嵌套分发
+        uint8_t prevPrio = me->curPrio;
+        me->curPrio = prio;
+        a->dispatch(a->fsm, e);
+        me->curPrio = prevPrio;
+    }
+}
+
+/**
+ * @brief 投递事件
+ * 
+ * @param me 指向内核对象的指针
+ * @param a 目标活动对象
+ * @param e 事件
+ * @return 0 成功，-1 事件队列已满
+ */
+int QkPost(QkKernel *me, QkActive *a, void *e)
+{
+    if (QueueEnqueue(&a->queue, e) != 0) {
+        return -1;
+    }
+    uint32_t prev = __atomic_fetch_or(&me->readySet, QK_BIT(a->prio), __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&me->running, __ATOMIC_ACQUIRE) && pthread_equal(pthread_self(), me->owner)) {
+        // 内核线程内投递：目标优先级更高时立即嵌套分发，否则留到当前步骤结束后处理
+        if (a->prio > me->curPrio) {
+            QkSchedule(me, me->curPrio);
+        }
+    } else if (prev == 0) {
+        // 位图由空变为非空才唤醒内核线程；唤醒队列满说明已有未处理的令牌
+        (void)QueueEnqueue(&me->wake, NULL);
+    }
+    return 0;
+}
+
+/**
+ * @brief 在调用线程上运行内核
+ * 
+ * @param me 指向内核对象的指针
+ */
+void QkRun(QkKernel *me)
+{
+    me->owner = pthread_self();
+    __atomic_store_n(&me->running, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&me->running, __ATOMIC_ACQUIRE)) {
+        QkSchedule(me, 0);
+        if (__atomic_load_n(&me->readySet, __ATOMIC_SEQ_CST) == 0) {
+            QueueDequeueForever(&me->wake);
+        }
+    }
+}
+
+/**
+ * @brief 停止内核
+ * 
+ * @param me 指向内核对象的指针
+ */
+void QkStop(QkKernel *me)
+{
+    __atomic_store_n(&me->running, 0, __ATOMIC_RELEASE);
+    (void)QueueEnqueue(&me->wake, NULL);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file qk.h
+ * @brief 单线程优先级运行至完成内核头文件
+ * 
+ * 参考 QK 抢占式内核：每个状态机（活动对象）有唯一优先级和自己的事件队列，
+ * 内核用一个32位就绪位图记录哪些优先级有待处理事件，通过前导零计数 O(1) 选出最高优先级。
+ * 每次只处理一个事件（一个运行至完成步骤），步骤之间重新选择，
+ * 因此高优先级事件最多等待一个低优先级步骤；在内核线程内向更高优先级投递事件时，
+ * 直接嵌套分发，立即抢占当前步骤。
+ */
+
+#ifndef QK_H
+#define QK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "sync_queue.h"
+#include "qfsm.h"
+#include "statetbl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define QK_PRIO_MAX 32      ///< 最大优先级（优先级范围 1~32，数值越大优先级越高）
+
+/**
+ * @brief 状态机分发函数，fsm 为状态机对象，e 为事件
+ */
+typedef void (*QkDispatch)(void *fsm, void *e);
+
+/**
+ * @brief 活动对象：状态机、分发函数和事件队列
+ */
+typedef struct QkActiveTag {
+    void *fsm;                  ///< 状态机对象
+    QkDispatch dispatch;        ///< 分发函数
+    SyncQueue queue;            ///< 事件队列
+    uint8_t prio;               ///< 优先级
+} QkActive;
+
+/**
+ * @brief 内核结构体
+ */
+typedef struct QkKernelTag {
+    QkActive *actives[QK_PRIO_MAX + 1]; ///< 按优先级索引的活动对象，0 不使用
+    uint32_t readySet;          ///< 就绪位图，第 prio-1 位表示该优先级有事件（原子访问）
+    uint8_t curPrio;            ///< 内核线程当前运行的优先级，0 表示空闲
+    uint8_t running;            ///< 运行标志（原子访问）
+    pthread_t owner;            ///< 内核线程
+    SyncQueue wake;             ///< 唤醒队列，就绪位图由空变为非空时投递
+    void *wakeBuffer[4];        ///< 唤醒队列缓冲区
+} QkKernel;
+
+/**
+ * @brief 初始化内核
+ * 
+ * @param me 指向内核对象的指针
+ */
+void QkCtor(QkKernel *me);
+
+/**
+ * @brief 注册活动对象
+ * 
+ * @param me 指向内核对象的指针
+ * @param a 活动对象
+ * @param prio 优先级（1~QK_PRIO_MAX，不能重复）
+ * @param fsm 状态机对象
+ * @param dispatch 分发函数
+ * @param buffer 事件队列缓冲区
+ * @param size 事件队列容量
+ * @return 0 成功，-1 优先级非法或已被占用
+ */
+int QkActiveCtor(QkKernel *me, QkActive *a, uint8_t prio, void *fsm, QkDispatch dispatch, void **buffer,
+                 uint32_t size);
+
+/**
+ * @brief 投递事件（任意线程）
+ * 
+ * 在内核线程内投递给比当前优先级更高的活动对象时，返回前已经嵌套处理完该事件
+ * 
+ * @param me 指向内核对象的指针
+ * @param a 目标活动对象
+ * @param e 事件
+ * @return 0 成功，-1 事件队列已满
+ */
+int QkPost(QkKernel *me, QkActive *a, void *e);
+
+/**
+ * @brief 在调用线程上运行内核，直到 QkStop 被调用
+ * 
+ * @param me 指向内核对象的指针
+ */
+void QkRun(QkKernel *me);
+
+/**
+ * @brief 停止内核（任意线程）
+ * 
+ * @param me 指向内核对象的指针
+ */
+void QkStop(QkKernel *me);
+
+/**
+ * @brief QFsm 状态机分发函数
+ */
+static inline void QkDispatchQFsm(void *fsm, void *e)
+{
+    QFsmDispatch((QFsm *)fsm, (QEvent *)e);
+}
+
+/**
+ * @brief StateTable 状态机分发函数
+ */
+static inline void QkDispatchStateTable(void *fsm, void *e)
+{
+    StateTableDispatch((StateTable *)fsm, (const Event *)e);
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !QK_H
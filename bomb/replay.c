@@ -0,0 +1,333 @@
+/**
+ * @file replay.c
+ * @brief 事件日志并行重放实现文件
+ * 
+ * 每个工作线程依次执行三个阶段，阶段之间用屏障同步：
+ * 1. 统计自己负责的日志分块中属于各工作线程的记录数；
+ * 2. 按（工作线程，分块）顺序计算写入偏移，把分块中的记录稳定地分散到各工作线程的区间，
+ *    同时在本线程上分配和构造自己拥有的实例；
+ * 3. 按批分发自己区间内的记录。
+ * 分块按日志顺序编号、分散时保持分块内顺序，所以同一实例的记录顺序不变。
+ */
+
+#include "replay.h"
+#include "statetbl.h"
+#include "qfsm.h"
+#include "barrier.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __unix__
+
+/**
+ * @brief 一次重放的共享状态
+ */
+typedef struct ReplayJobTag {
+    const ReplayLog *log;       ///< 日志
+    const ReplayConfig *cfg;    ///< 配置
+    ReplayWorker *workers;      ///< 工作线程
+    ReplayRecord *sorted;       ///< 按工作线程分区后的记录
+    uint64_t *counts;           ///< counts[chunk * workers + worker]
+    uint64_t *starts;           ///< 各工作线程区间的起始位置，长度 workers + 1
+    Barrier barrier;            ///< 阶段屏障
+    pthread_mutex_t start;      ///< 启动闸门，所有线程创建完成前由主线程持有
+    uint8_t failed;             ///< 内存分配或线程创建失败
+} ReplayJob;
+
+/**
+ * @brief 传给工作线程的参数
+ */
+typedef struct ReplayThreadArgTag {
+    ReplayJob *job;             ///< 共享状态
+    uint32_t id;                ///< 工作线程编号
+} ReplayThreadArg;
+
+/**
+ * @brief 打开日志
+ * 
+ * @param me 指向日志对象的指针
+ * @param path 日志文件路径
+ * @return 0 成功，-1 失败
+ */
+int ReplayLogOpen(ReplayLog *me, const char *path)
+{
+    memset(me, 0, sizeof(*me));
+#if defined(__unix__)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            // 顺序扫描，提示内核预读
+            madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+            me->base = addr;
+            me->size = (size_t)st.st_size;
+            me->mapped = true;
+        }
+    }
+    close(fd);
+#endif // __unix__
+
+    // 不支持 mmap 时整个读入内存
+    if (me->base == NULL) {
+        FILE *fp = fopen(path, "rb");
+        if (fp == NULL) {
+            return -1;
+        }
+        fseek(fp, 0, SEEK_END);
+        long size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        me->base = size > 0 ? malloc((size_t)size) : NULL;
+        if (me->base == NULL || fread(me->base, 1, (size_t)size, fp) != (size_t)size) {
+            fclose(fp);
+            free(me->base);
+            me->base = NULL;
+            return -1;
+        }
+        fclose(fp);
+        me->size = (size_t)size;
+    }
+
+    // 检查文件头和长度，记录数来自文件，先除后比较，避免乘法溢出
+    me->header = (const ReplayLogHeader *)me->base;
+    me->records = (const ReplayRecord *)(me->header + 1);
+    if (me->size < sizeof(ReplayLogHeader) || me->header->magic != REPLAY_LOG_MAGIC ||
+        me->header->version != REPLAY_LOG_VERSION ||
+        me->header->records > (me->size - sizeof(ReplayLogHeader)) / sizeof(ReplayRecord)) {
+        ReplayLogClose(me);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 关闭日志
+ * 
+ * @param me 指向日志对象的指针
+ */
+void ReplayLogClose(ReplayLog *me)
+{
+    if (me->base != NULL) {
+#if defined(__unix__)
+        if (me->mapped) {
+            munmap(me->base, me->size);
+        } else {
+            free(me->base);
+        }
+#else
+        free(me->base);
+#endif // __unix__
+    }
+    memset(me, 0, sizeof(*me));
+}
+
+/**
+ * @brief 阶段1结束时由最后到达屏障的线程计算各工作线程区间的起点
+ */
+static void ReplayComputeStarts(void *arg)
+{
+    ReplayJob *job = (ReplayJob *)arg;
+    uint32_t workers = job->cfg->workers;
+    job->starts[0] = 0;
+    for (uint32_t w = 0; w < workers; w++) {
+        uint64_t sum = 0;
+        for (uint32_t c = 0; c < workers; c++) {
+            sum += job->counts[(size_t)c * workers + w];
+        }
+        job->starts[w + 1] = job->starts[w] + sum;
+    }
+}
+
+/**
+ * @brief 工作线程
+ */
+static void *ReplayThread(void *p)
+{
+    ReplayThreadArg *a = (ReplayThreadArg *)p;
+    ReplayJob *job = a->job;
+
+    // 等所有线程创建完成，有线程创建失败时不进入屏障，直接退出
+    pthread_mutex_lock(&job->start);
+    pthread_mutex_unlock(&job->start);
+    if (__atomic_load_n(&job->failed, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+
+    const ReplayConfig *cfg = job->cfg;
+    uint32_t workers = cfg->workers;
+    uint32_t id = a->id;
+    uint64_t total = job->log->header->records;
+    const ReplayRecord *records = job->log->records;
+
+    // 阶段1：统计本分块中各工作线程的记录数
+    uint64_t begin = total * id / workers;
+    uint64_t end = total * (id + 1) / workers;
+    uint64_t *counts = &job->counts[(size_t)id * workers];
+    for (uint64_t i = begin; i < end; i++) {
+        counts[records[i].instance % workers]++;
+    }
+    BarrierWait(&job->barrier, ReplayComputeStarts, job);
+
+    // 阶段2：计算本分块写入各区间的偏移并分散记录
+    uint64_t offsets[REPLAY_WORKERS_MAX];
+    for (uint32_t w = 0; w < workers; w++) {
+        offsets[w] = job->starts[w];
+        for (uint32_t c = 0; c < id; c++) {
+            offsets[w] += job->counts[(size_t)c * workers + w];
+        }
+    }
+    for (uint64_t i = begin; i < end; i++) {
+        job->sorted[offsets[records[i].instance % workers]++] = records[i];
+    }
+
+    // 在本线程上分配和构造自己拥有的实例
+    ReplayWorker *me = &job->workers[id];
+    uint32_t instances = job->log->header->instances;
+    me->id = id;
+    me->workers = workers;
+    me->stride = cfg->machineSize;
+    me->machineNum = instances > id ? (instances - id + workers - 1) / workers : 0;
+    me->dispatched = 0;
+    me->machines = malloc(me->stride * (me->machineNum == 0 ? 1 : me->machineNum));
+    if (me->machines == NULL) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+    } else {
+        for (uint32_t i = 0; i < me->machineNum; i++) {
+            cfg->init(me->machines + (size_t)i * me->stride, i * workers + id, cfg->arg);
+        }
+    }
+    BarrierWait(&job->barrier, NULL, NULL);
+
+    // 阶段3：按批分发本线程区间内的记录
+    if (me->machines != NULL) {
+        uint32_t batch = cfg->batchSize != 0 ? cfg->batchSize : REPLAY_BATCH_DEFAULT;
+        uint64_t pos = job->starts[id];
+        uint64_t stop = job->starts[id + 1];
+        while (pos < stop) {
+            uint32_t n = stop - pos < batch ? (uint32_t)(stop - pos) : batch;
+            cfg->batch(me, &job->sorted[pos], n, cfg->arg);
+            pos += n;
+        }
+        me->dispatched = stop - job->starts[id];
+    }
+    return NULL;
+}
+
+/**
+ * @brief 重放日志
+ * 
+ * @param log 日志
+ * @param cfg 重放配置
+ * @param workers 工作线程数组
+ * @return 0 成功，-1 失败
+ */
+int ReplayRun(const ReplayLog *log, const ReplayConfig *cfg, ReplayWorker *workers)
+{
+    uint32_t n = cfg->workers;
+    if (n == 0 || n > REPLAY_WORKERS_MAX || cfg->machineSize == 0 || cfg->init == NULL || cfg->batch == NULL) {
+        return -1;
+    }
+    for (uint64_t i = 0; i < log->header->records; i++) {
+        if (log->records[i].instance >= log->header->instances) {
+            return -1;
+        }
+    }
+
+    ReplayJob job;
+    memset(&job, 0, sizeof(job));
+    memset(workers, 0, sizeof(ReplayWorker) * n);
+    job.log = log;
+    job.cfg = cfg;
+    job.workers = workers;
+    job.sorted = malloc(sizeof(ReplayRecord) * (log->header->records == 0 ? 1 : log->header->records));
+    job.counts = calloc((size_t)n * n, sizeof(uint64_t));
+    job.starts = calloc(n + 1, sizeof(uint64_t));
+    if (job.sorted == NULL || job.counts == NULL || job.starts == NULL) {
+        free(job.sorted);
+        free(job.counts);
+        free(job.starts);
+        return -1;
+    }
+
+    BarrierCtor(&job.barrier, n);
+    pthread_mutex_init(&job.start, NULL);
+
+    // 屏障需要全部 n 个线程，先持有启动闸门，全部创建成功后再放行；
+    // 中途创建失败时标记失败后放行，已创建的线程直接退出
+    pthread_t threads[REPLAY_WORKERS_MAX];
+    ReplayThreadArg args[REPLAY_WORKERS_MAX];
+    uint32_t created = 0;
+    pthread_mutex_lock(&job.start);
+    for (; created < n; created++) {
+        args[created].job = &job;
+        args[created].id = created;
+        if (pthread_create(&threads[created], NULL, ReplayThread, &args[created]) != 0) {
+            job.failed = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&job.start);
+    for (uint32_t i = 0; i < created; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&job.start);
+    BarrierDtor(&job.barrier);
+    free(job.sorted);
+    free(job.counts);
+    free(job.starts);
+    if (job.failed) {
+        ReplayFree(workers, n);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 释放工作线程拥有的实例
+ * 
+ * @param workers 工作线程数组
+ * @param n 工作线程数
+ */
+void ReplayFree(ReplayWorker *workers, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        free(workers[i].machines);
+        workers[i].machines = NULL;
+        workers[i].machineNum = 0;
+    }
+}
+
+/**
+ * @brief StateTable 实例的批分发函数
+ */
+void ReplayBatchStateTable(ReplayWorker *w, const ReplayRecord *records, uint32_t n, void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 0; i < n; i++) {
+        Event e = {records[i].signal};
+        StateTableDispatch((StateTable *)REPLAY_MACHINE(w, records[i].instance), &e);
+    }
+}
+
+/**
+ * @brief QFsm 实例的批分发函数，信号加上 Q_USER_SIGNAL 后分发
+ */
+void ReplayBatchQFsm(ReplayWorker *w, const ReplayRecord *records, uint32_t n, void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 0; i < n; i++) {
+        QEvent e = {(QSignal)(records[i].signal + Q_USER_SIGNAL), 0};
+        QFsmDispatch((QFsm *)REPLAY_MACHINE(w, records[i].instance), &e);
+    }
+}
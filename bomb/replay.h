@@ -0,0 +1,150 @@
+/**
+ * @file replay.h
+ * @brief 事件日志并行重放头文件
+ * 
+ * 事件日志是固定头部加定长记录（实例号，信号）的二进制文件。重放时把日志映射到内存，
+ * 按实例号对工作线程数取模分区：实例 i 只属于工作线程 i % workers，
+ * 在该线程上构造和访问（缓存本地），同一实例的事件按日志顺序分发。
+ * 分区用并行的稳定计数排序完成，随后各工作线程按批次调用分发函数，
+ * 吞吐量随核数增加。
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define REPLAY_LOG_MAGIC 0x4A4D5346U    ///< "FSMJ"
+#define REPLAY_LOG_VERSION 1            ///< 日志格式版本
+#define REPLAY_WORKERS_MAX 64           ///< 最多工作线程数
+#define REPLAY_BATCH_DEFAULT 256        ///< 默认批大小
+
+/**
+ * @brief 日志文件头
+ */
+typedef struct ReplayLogHeaderTag {
+    uint32_t magic;             ///< REPLAY_LOG_MAGIC
+    uint32_t version;           ///< REPLAY_LOG_VERSION
+    uint32_t instances;         ///< 实例数，记录中的实例号小于该值
+    uint32_t reserved;          ///< 保留
+    uint64_t records;           ///< 记录数
+} ReplayLogHeader;
+
+/**
+ * @brief 日志记录
+ */
+typedef struct ReplayRecordTag {
+    uint32_t instance;          ///< 实例号
+    uint16_t signal;            ///< 用户信号编号，从0开始
+    uint16_t arg;               ///< 事件参数
+} ReplayRecord;
+
+/**
+ * @brief 打开的日志
+ */
+typedef struct ReplayLogTag {
+    const ReplayLogHeader *header;  ///< 文件头
+    const ReplayRecord *records;    ///< 记录数组
+    void *base;                 ///< 映射或读入的内存
+    size_t size;                ///< 内存大小
+    bool mapped;                ///< true 为 mmap 映射，false 为 read 读入
+} ReplayLog;
+
+/**
+ * @brief 工作线程
+ */
+typedef struct ReplayWorkerTag {
+    uint32_t id;                ///< 工作线程编号
+    uint32_t workers;           ///< 工作线程数
+    uint8_t *machines;          ///< 本线程拥有的实例，由本线程分配和构造
+    size_t stride;              ///< 每个实例占用的字节数
+    uint32_t machineNum;        ///< 本线程拥有的实例数
+    uint64_t dispatched;        ///< 已分发的记录数
+} ReplayWorker;
+
+/**
+ * @brief 本线程上实例号对应的实例
+ */
+#define REPLAY_MACHINE(w, instance) \
+    ((void *)((w)->machines + (size_t)((instance) / (w)->workers) * (w)->stride))
+
+/**
+ * @brief 在工作线程上构造一个实例
+ */
+typedef void (*ReplayInit)(void *machine, uint32_t instance, void *arg);
+
+/**
+ * @brief 分发一批记录，记录都属于该工作线程，按日志顺序排列
+ */
+typedef void (*ReplayBatch)(ReplayWorker *w, const ReplayRecord *records, uint32_t n, void *arg);
+
+/**
+ * @brief 重放配置
+ */
+typedef struct ReplayConfigTag {
+    uint32_t workers;           ///< 工作线程数（1~REPLAY_WORKERS_MAX）
+    size_t machineSize;         ///< 每个实例占用的字节数
+    uint32_t batchSize;         ///< 批大小，0 使用默认值
+    ReplayInit init;            ///< 实例构造函数
+    ReplayBatch batch;          ///< 批分发函数
+    void *arg;                  ///< 回调参数
+} ReplayConfig;
+
+/**
+ * @brief 打开日志：优先 mmap，不支持时读入内存
+ * 
+ * @param me 指向日志对象的指针
+ * @param path 日志文件路径
+ * @return 0 成功，-1 打开失败或格式错误
+ */
+int ReplayLogOpen(ReplayLog *me, const char *path);
+
+/**
+ * @brief 关闭日志
+ * 
+ * @param me 指向日志对象的指针
+ */
+void ReplayLogClose(ReplayLog *me);
+
+/**
+ * @brief 重放日志
+ * 
+ * 成功返回后工作线程拥有的实例仍然保留，可以检查最终状态，用 ReplayFree 释放；
+ * 失败时（包括工作线程创建失败）已分配的实例在返回前释放
+ * 
+ * @param log 日志
+ * @param cfg 重放配置
+ * @param workers 工作线程数组，长度为 cfg->workers
+ * @return 0 成功，-1 参数错误、内存不足或线程创建失败
+ */
+int ReplayRun(const ReplayLog *log, const ReplayConfig *cfg, ReplayWorker *workers);
+
+/**
+ * @brief 释放工作线程拥有的实例
+ * 
+ * @param workers 工作线程数组
+ * @param n 工作线程数
+ */
+void ReplayFree(ReplayWorker *workers, uint32_t n);
+
+/**
+ * @brief StateTable 实例的批分发函数
+ */
+void ReplayBatchStateTable(ReplayWorker *w, const ReplayRecord *records, uint32_t n, void *arg);
+
+/**
+ * @brief QFsm 实例的批分发函数，信号加上 Q_USER_SIGNAL 后分发
+ */
+void ReplayBatchQFsm(ReplayWorker *w, const ReplayRecord *records, uint32_t n, void *arg);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !REPLAY_H
@@ -0,0 +1,137 @@
+/**
+ * @file rt_profile.c
+ * @brief 实时低抖动运行配置实现文件
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // !_GNU_SOURCE
+
+#include "rt_profile.h"
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__unix__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // __unix__
+
+/**
+ * @brief 锁定进程全部内存
+ * 
+ * @return 0 成功，-1 失败
+ */
+int RtProcessInit(void)
+{
+#if defined(__unix__)
+    return mlockall(MCL_CURRENT | MCL_FUTURE);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif // __unix__
+}
+
+/**
+ * @brief 预先触碰并锁定一块内存
+ * 
+ * @param mem 内存起始地址
+ * @param size 内存大小
+ * @return 0 成功，-1 锁定失败
+ */
+int RtLock(void *mem, size_t size)
+{
+    if (mem == NULL || size == 0) {
+        return 0;
+    }
+    // 每页读写一次，把页面真正映射进来（不改变内容）
+    volatile uint8_t *p = (volatile uint8_t *)mem;
+    for (size_t i = 0; i < size; i += 4096) {
+        p[i] = p[i];
+    }
+    p[size - 1] = p[size - 1];
+#if defined(__unix__)
+    return mlock(mem, size);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif // __unix__
+}
+
+/**
+ * @brief 按实时配置准备队列
+ * 
+ * @param queue 已经构造好的队列
+ * @param profile 实时配置
+ * @return 0 成功，-1 锁定失败
+ */
+int RtQueueInit(SyncQueue *queue, const RtProfile *profile)
+{
+    QueueSetSpin(queue, profile->spinNs);
+    int ret = RtLock(queue, sizeof(*queue));
+    if (RtLock(queue->buffer, sizeof(void *) * queue->maxSize) != 0) {
+        ret = -1;
+    }
+    return ret;
+}
+
+/**
+ * @brief 预先触碰栈，noinline 保证栈帧真的分配在当前栈上
+ * 
+ * @param bytes 栈大小
+ */
+static __attribute__((noinline)) void RtPrefaultStack(size_t bytes)
+{
+    uint8_t stack[bytes];
+    volatile uint8_t *touch = stack;
+    long page = sysconf(_SC_PAGESIZE);
+    size_t step = page > 0 ? (size_t)page : 4096;
+    // 通过 volatile 指针逐页写入，编译器不能把写入当作死存储删掉
+    for (size_t i = 0; i < bytes; i += step) {
+        touch[i] = 0;
+    }
+    touch[bytes - 1] = 0;
+}
+
+/**
+ * @brief 分发线程实时初始化
+ * 
+ * @param profile 实时配置
+ * @return 0 成功，-1 有步骤失败
+ */
+int RtThreadInit(const RtProfile *profile)
+{
+    int ret = 0;
+#ifdef __linux__
+    if (profile->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(profile->cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            ret = -1;
+        }
+    }
+#endif // __linux__
+#if defined(__unix__)
+    if (profile->priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = profile->priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            errno = err;
+            ret = -1;
+        }
+    }
+#else
+    if (profile->priority > 0 || profile->cpu >= 0) {
+        errno = ENOSYS;
+        ret = -1;
+    }
+#endif // __unix__
+    if (profile->stackBytes != 0) {
+        RtPrefaultStack(profile->stackBytes);
+    }
+    return ret;
+}
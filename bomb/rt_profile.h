@@ -0,0 +1,79 @@
+/**
+ * @file rt_profile.h
+ * @brief 实时低抖动运行配置头文件
+ * 
+ * 对时间敏感的分发线程（如炸弹倒计时）的抖动主要来自缺页、线程调度和等待方式。
+ * 实时配置在启动阶段锁定并预先触碰所有内存（进程内存、队列、对象池、状态表和线程栈），
+ * 把分发线程绑定到固定CPU并使用 SCHED_FIFO 调度，队列出队先忙等再阻塞，
+ * 周期等待使用 CLOCK_MONOTONIC 上的绝对截止时间（见 QueueDequeueUntil）。
+ * 
+ * 需要相应权限（CAP_IPC_LOCK/CAP_SYS_NICE 或 rlimit），权限不足时接口返回失败，
+ * 程序可以继续以普通方式运行。非 Linux 平台只支持忙等配置。
+ */
+
+#ifndef RT_PROFILE_H
+#define RT_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sync_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 实时运行配置
+ */
+typedef struct RtProfileTag {
+    int priority;               ///< SCHED_FIFO 优先级（1~99），0 表示不修改调度策略
+    int cpu;                    ///< 绑定的CPU编号，-1 表示不绑定
+    uint32_t spinNs;            ///< 队列出队的忙等时间（纳秒）
+    size_t stackBytes;          ///< 线程启动时预先触碰的栈大小（字节）
+} RtProfile;
+
+/**
+ * @brief 默认实时配置：SCHED_FIFO 80，不绑定CPU，忙等50微秒，预触碰256KB栈
+ */
+#define RT_PROFILE_DEFAULT {80, -1, 50000, 256 * 1024}
+
+/**
+ * @brief 锁定进程当前和以后分配的全部内存，避免运行期缺页
+ * 
+ * @return 0 成功，-1 失败（errno 指示原因）
+ */
+int RtProcessInit(void);
+
+/**
+ * @brief 预先触碰并锁定一块内存
+ * 
+ * 用于队列缓冲区、对象池、状态表等启动时分配好的内存
+ * 
+ * @param mem 内存起始地址
+ * @param size 内存大小
+ * @return 0 成功，-1 锁定失败（内存已经被触碰）
+ */
+int RtLock(void *mem, size_t size);
+
+/**
+ * @brief 按实时配置准备队列：锁定队列对象和缓冲区，设置忙等时间
+ * 
+ * @param queue 已经构造好的队列
+ * @param profile 实时配置
+ * @return 0 成功，-1 锁定失败
+ */
+int RtQueueInit(SyncQueue *queue, const RtProfile *profile);
+
+/**
+ * @brief 在分发线程开始处调用：绑定CPU、设置 SCHED_FIFO、预先触碰栈
+ * 
+ * @param profile 实时配置
+ * @return 0 成功，-1 有步骤失败（其余步骤仍然执行）
+ */
+int RtThreadInit(const RtProfile *profile);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !RT_PROFILE_H
@@ -0,0 +1,478 @@
+/**
+ * @file seg_queue.c
+ * @brief 分段弹性队列实现文件
+ *
+ * 队列锁内只做下标移动和段的挂接/摘除，不进段池的锁，也不分配或释放内存：
+ * 需要新段时先用队列缓存的空段，没有时解开队列锁向段池取（段池也没有空闲段时在段池锁外向系统分配），
+ * 再加锁重新检查；取空的段在解开队列锁之后才还给段池。两把锁从不同时持有。
+ */
+
+#include "seg_queue.h"
+#include "timespec_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/**
+ * @brief 初始化段池
+ *
+ * @param me 指向段池的指针
+ * @param softCap 软上限（段数）
+ * @param hardCap 硬上限（段数）
+ */
+void SegPoolCtor(SegPool *me, uint32_t softCap, uint32_t hardCap)
+{
+    me->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    me->free = NULL;
+    me->freeNum = 0;
+    me->segments = 0;
+    me->softCap = softCap;
+    me->hardCap = hardCap < softCap ? softCap : hardCap;
+    me->highWater = 0;
+    me->allocs = 0;
+    me->trimmed = 0;
+    me->rejected = 0;
+}
+
+/**
+ * @brief 预先分配空闲段
+ *
+ * @param me 指向段池的指针
+ * @param n 希望持有的空闲段数
+ * @return 实际持有的空闲段数
+ */
+uint32_t SegPoolReserve(SegPool *me, uint32_t n)
+{
+    pthread_mutex_lock(&me->mutex);
+    while (me->freeNum < n && me->segments < me->softCap) {
+        SegQueueSegment *seg = (SegQueueSegment *)malloc(sizeof(SegQueueSegment));
+        if (seg == NULL) {
+            break;
+        }
+        seg->next = me->free;
+        me->free = seg;
+        me->freeNum++;
+        me->segments++;
+        me->allocs++;
+    }
+    if (me->segments > me->highWater) {
+        me->highWater = me->segments;
+    }
+    uint32_t freeNum = me->freeNum;
+    pthread_mutex_unlock(&me->mutex);
+    return freeNum;
+}
+
+/**
+ * @brief 释放段池的空闲段
+ *
+ * @param me 指向段池的指针
+ */
+void SegPoolDtor(SegPool *me)
+{
+    pthread_mutex_lock(&me->mutex);
+    while (me->free != NULL) {
+        SegQueueSegment *seg = me->free;
+        me->free = seg->next;
+        free(seg);
+        me->segments--;
+    }
+    me->freeNum = 0;
+    pthread_mutex_unlock(&me->mutex);
+}
+
+/**
+ * @brief 从段池取一个段，没有空闲段且未达到硬上限时向系统分配
+ *
+ * @param me 指向段池的指针
+ * @return 段，达到硬上限或内存不足时返回NULL
+ */
+static SegQueueSegment *SegPoolGet(SegPool *me)
+{
+    SegQueueSegment *seg = NULL;
+    bool alloc = false;
+
+    pthread_mutex_lock(&me->mutex);
+    if (me->free != NULL) {
+        seg = me->free;
+        me->free = seg->next;
+        me->freeNum--;
+    } else if (me->segments < me->hardCap) {
+        // 先占住名额，在锁外分配
+        me->segments++;
+        if (me->segments > me->highWater) {
+            me->highWater = me->segments;
+        }
+        me->allocs++;
+        alloc = true;
+    } else {
+        me->rejected++;
+    }
+    pthread_mutex_unlock(&me->mutex);
+
+    if (alloc) {
+        seg = (SegQueueSegment *)malloc(sizeof(SegQueueSegment));
+        if (seg == NULL) {
+            pthread_mutex_lock(&me->mutex);
+            me->segments--;
+            me->rejected++;
+            pthread_mutex_unlock(&me->mutex);
+        }
+    }
+    return seg;
+}
+
+/**
+ * @brief 把段还给段池，超过软上限时释放给系统
+ *
+ * @param me 指向段池的指针
+ * @param seg 段
+ */
+static void SegPoolPut(SegPool *me, SegQueueSegment *seg)
+{
+    pthread_mutex_lock(&me->mutex);
+    if (me->segments > me->softCap) {
+        me->segments--;
+        me->trimmed++;
+        pthread_mutex_unlock(&me->mutex);
+        free(seg);
+        return;
+    }
+    seg->next = me->free;
+    me->free = seg;
+    me->freeNum++;
+    pthread_mutex_unlock(&me->mutex);
+}
+
+/**
+ * @brief 初始化分段队列
+ *
+ * @param me 指向分段队列的指针
+ * @param pool 段池
+ */
+void SegQueueCtor(SegQueue *me, SegPool *pool)
+{
+    me->head = NULL;
+    me->tail = NULL;
+    me->spare = NULL;
+    me->pool = pool;
+    me->currentSize = 0;
+    me->highWater = 0;
+    me->rejected = 0;
+    me->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    // 超时等待使用单调时钟，不受系统时间调整影响
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    me->clockId = CLOCK_REALTIME;
+#ifndef _WIN32
+    if (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0) {
+        me->clockId = CLOCK_MONOTONIC;
+    }
+#endif // !_WIN32
+    pthread_cond_init(&me->cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * @brief 把队列持有的段还给段池
+ *
+ * @param me 指向分段队列的指针
+ */
+void SegQueueDtor(SegQueue *me)
+{
+    pthread_mutex_lock(&me->mutex);
+    SegQueueSegment *segs = me->head;
+    SegQueueSegment *spare = me->spare;
+    me->head = NULL;
+    me->tail = NULL;
+    me->spare = NULL;
+    me->currentSize = 0;
+    pthread_mutex_unlock(&me->mutex);
+
+    while (segs != NULL) {
+        SegQueueSegment *seg = segs;
+        segs = seg->next;
+        SegPoolPut(me->pool, seg);
+    }
+    if (spare != NULL) {
+        SegPoolPut(me->pool, spare);
+    }
+    pthread_cond_destroy(&me->cond);
+}
+
+/**
+ * @brief 放入一个元素（调用者持有锁）
+ *
+ * 队尾段写满时依次使用队列缓存的空段和调用者预先取到的段
+ *
+ * @param me 指向分段队列的指针
+ * @param item 元素
+ * @param fresh 调用者在锁外取到的段，用掉后置为NULL
+ * @return 0 成功，-1 需要新段
+ */
+static int SegQueuePush(SegQueue *me, void *item, SegQueueSegment **fresh)
+{
+    SegQueueSegment *tail = me->tail;
+    if (tail == NULL || tail->tail == SEG_QUEUE_SLOTS) {
+        SegQueueSegment *seg = me->spare;
+        if (seg != NULL) {
+            me->spare = NULL;
+        } else if (*fresh != NULL) {
+            seg = *fresh;
+            *fresh = NULL;
+        } else {
+            return -1;
+        }
+        // 新段接在队尾，已有元素不搬移
+        seg->next = NULL;
+        seg->head = 0;
+        seg->tail = 0;
+        if (tail == NULL) {
+            me->head = seg;
+        } else {
+            tail->next = seg;
+        }
+        me->tail = seg;
+        tail = seg;
+    }
+    tail->slots[tail->tail++] = item;
+    if (++me->currentSize > me->highWater) {
+        me->highWater = me->currentSize;
+    }
+    return 0;
+}
+
+/**
+ * @brief 放入一个元素，需要新段时解开队列锁向段池取（调用者持有锁，返回时仍持有锁）
+ *
+ * 解锁期间其他线程可能已经接上新段或者留下缓存段，重新加锁后再试一次；
+ * 取到的段没有用上时留在 fresh 中，调用者解锁后处理
+ *
+ * @param me 指向分段队列的指针
+ * @param item 元素
+ * @param fresh 输入输出参数，调用者持有、尚未挂到队列上的段
+ * @return 0 成功，-1 段池达到硬上限或内存不足
+ */
+static int SegQueuePushRefill(SegQueue *me, void *item, SegQueueSegment **fresh)
+{
+    if (SegQueuePush(me, item, fresh) == 0) {
+        return 0;
+    }
+    pthread_mutex_unlock(&me->mutex);
+    *fresh = SegPoolGet(me->pool);
+    pthread_mutex_lock(&me->mutex);
+    if (SegQueuePush(me, item, fresh) == 0) {
+        return 0;
+    }
+    me->rejected++;
+    return -1;
+}
+
+/**
+ * @brief 处理没有用上的段（调用者持有锁）
+ *
+ * 队列没有缓存段时留作缓存，否则由调用者解锁后还给段池
+ *
+ * @param me 指向分段队列的指针
+ * @param seg 段，可以为NULL
+ * @return 需要还给段池的段，没有时返回NULL
+ */
+static SegQueueSegment *SegQueueKeep(SegQueue *me, SegQueueSegment *seg)
+{
+    if (seg != NULL && me->spare == NULL) {
+        me->spare = seg;
+        return NULL;
+    }
+    return seg;
+}
+
+/**
+ * @brief 取出一个元素（调用者持有锁，队列不为空）
+ *
+ * @param me 指向分段队列的指针
+ * @param released 输出参数，取空后需要还给段池的段，调用者解锁后归还
+ * @return 元素
+ */
+static void *SegQueuePop(SegQueue *me, SegQueueSegment **released)
+{
+    SegQueueSegment *head = me->head;
+    void *item = head->slots[head->head++];
+    me->currentSize--;
+    if (head->head == head->tail) {
+        if (head == me->tail) {
+            // 只剩这一个段，原地从头复用
+            head->head = 0;
+            head->tail = 0;
+        } else {
+            // 取空的段先留作缓存，已有缓存时交给调用者还给段池
+            me->head = head->next;
+            *released = SegQueueKeep(me, head);
+        }
+    }
+    return item;
+}
+
+/**
+ * @brief 元素入队操作
+ *
+ * @param me 指向分段队列的指针
+ * @param item 要入队的元素指针
+ * @return 0 成功入队，-1 段池达到硬上限
+ */
+int SegQueueEnqueue(SegQueue *me, void *item)
+{
+    SegQueueSegment *fresh = NULL;
+    pthread_mutex_lock(&me->mutex);
+    int ret = SegQueuePushRefill(me, item, &fresh);
+    // 队列从空变为非空时唤醒等待的消费者，放入后只有一个元素说明放入前队列为空
+    if (ret == 0 && me->currentSize == 1) {
+        pthread_cond_signal(&me->cond);
+    }
+    fresh = SegQueueKeep(me, fresh);
+    pthread_mutex_unlock(&me->mutex);
+    if (fresh != NULL) {
+        SegPoolPut(me->pool, fresh);
+    }
+    return ret;
+}
+
+/**
+ * @brief 批量入队操作
+ *
+ * @param me 指向分段队列的指针
+ * @param items 要入队的元素指针数组
+ * @param n 元素个数
+ * @return 已入队的元素数
+ */
+uint32_t SegQueueEnqueueBatch(SegQueue *me, void *const *items, uint32_t n)
+{
+    uint32_t done = 0;
+    SegQueueSegment *fresh = NULL;
+    pthread_mutex_lock(&me->mutex);
+    bool isNotify = false;
+    while (done < n && SegQueuePushRefill(me, items[done], &fresh) == 0) {
+        // 放入后只有一个元素说明放入前队列为空（取段时解开过锁，不能只看开始时的状态）
+        isNotify = isNotify || me->currentSize == 1;
+        done++;
+    }
+    // 整批只通知一次
+    if (isNotify) {
+        pthread_cond_signal(&me->cond);
+    }
+    fresh = SegQueueKeep(me, fresh);
+    pthread_mutex_unlock(&me->mutex);
+    if (fresh != NULL) {
+        SegPoolPut(me->pool, fresh);
+    }
+    return done;
+}
+
+/**
+ * @brief 阻塞式出队操作
+ *
+ * @param me 指向分段队列的指针
+ * @return 取出的元素指针
+ */
+void *SegQueueDequeueForever(SegQueue *me)
+{
+    SegQueueSegment *released = NULL;
+    pthread_mutex_lock(&me->mutex);
+    while (me->currentSize == 0) {
+        pthread_cond_wait(&me->cond, &me->mutex);
+    }
+    void *item = SegQueuePop(me, &released);
+    pthread_mutex_unlock(&me->mutex);
+    if (released != NULL) {
+        SegPoolPut(me->pool, released);
+    }
+    return item;
+}
+
+/**
+ * @brief 带超时的出队操作
+ *
+ * @param me 指向分段队列的指针
+ * @param timeoutMs 超时时间（毫秒）
+ * @param isTimeout 输出参数，标识是否超时
+ * @return 取出的元素指针，超时或失败时返回NULL
+ */
+void *SegQueueDequeueWithTimeout(SegQueue *me, uint32_t timeoutMs, bool *isTimeout)
+{
+    int ret = 0;
+    void *item = NULL;
+    SegQueueSegment *released = NULL;
+    struct timespec ts = {0};
+    *isTimeout = false;
+    clock_gettime(me->clockId, &ts);
+    TimespecAddNs(&ts, (int64_t)timeoutMs * 1000000);
+
+    pthread_mutex_lock(&me->mutex);
+    while (me->currentSize == 0) {
+        ret = pthread_cond_timedwait(&me->cond, &me->mutex, &ts);
+        if (ret == 0) {
+            continue;
+        } else if (ret == ETIMEDOUT) {
+            *isTimeout = true;
+            break;
+        } else {
+            printf("pthread_cond_timedwait ret[%d]\n", ret);
+            break;
+        }
+    }
+    if (me->currentSize != 0) {
+        item = SegQueuePop(me, &released);
+    }
+    pthread_mutex_unlock(&me->mutex);
+    if (released != NULL) {
+        SegPoolPut(me->pool, released);
+    }
+    return item;
+}
+
+/**
+ * @brief 非阻塞出队操作
+ *
+ * @param me 指向分段队列的指针
+ * @param item 输出参数，取出的元素指针
+ * @return true 成功取出元素，false 队列为空
+ */
+bool SegQueueTryDequeue(SegQueue *me, void **item)
+{
+    bool ret = false;
+    SegQueueSegment *released = NULL;
+    pthread_mutex_lock(&me->mutex);
+    if (me->currentSize != 0) {
+        *item = SegQueuePop(me, &released);
+        ret = true;
+    }
+    pthread_mutex_unlock(&me->mutex);
+    if (released != NULL) {
+        SegPoolPut(me->pool, released);
+    }
+    return ret;
+}
+
+/**
+ * @brief 获取队列当前元素数量
+ *
+ * @param me 指向分段队列的指针
+ * @return 元素数量
+ */
+uint32_t SegQueueSize(SegQueue *me)
+{
+    pthread_mutex_lock(&me->mutex);
+    uint32_t size = me->currentSize;
+    pthread_mutex_unlock(&me->mutex);
+    return size;
+}
+
+/**
+ * @brief 检查队列是否为空
+ *
+ * @param me 指向分段队列的指针
+ * @return true 队列为空，false 队列不为空
+ */
+bool SegQueueIsEmpty(SegQueue *me)
+{
+    return SegQueueSize(me) == 0;
+}
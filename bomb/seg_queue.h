@@ -0,0 +1,184 @@
+/**
+ * @file seg_queue.h
+ * @brief 分段弹性队列头文件
+ *
+ * SyncQueue 使用调用者提供的固定缓冲区，突发超过容量时入队失败。分段队列由固定大小的段串成链表：
+ * 队尾的段写满时从段池取一个新段接在后面，已有元素不搬移；队头的段取空后还给段池，
+ * 稳定运行时不分配内存，入队也不会按元素分配。
+ *
+ * 段池可以由多个队列共享，有两个上限（单位都是段）：
+ * - 软上限：段池持有的段数超过软上限时，还回来的段直接释放给系统，突发过后内存回落到软上限；
+ * - 硬上限：段池持有的段数达到硬上限后不再分配，队尾段写满时入队失败，与 SyncQueue 队列满的语义相同。
+ *
+ * 接口与 SyncQueue 对应，都是互斥锁加条件变量，一个或多个生产者、一个或多个消费者。
+ */
+
+#ifndef SEG_QUEUE_H
+#define SEG_QUEUE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef SEG_QUEUE_SLOTS
+#define SEG_QUEUE_SLOTS 254     ///< 每段的元素数，加上链表指针和下标一段约 2KB
+#endif // !SEG_QUEUE_SLOTS
+
+/**
+ * @brief 队列段
+ */
+typedef struct SegQueueSegmentTag {
+    struct SegQueueSegmentTag *next;    ///< 下一个段（队列中或段池空闲链表中）
+    uint32_t head;                      ///< 段内出队下标
+    uint32_t tail;                      ///< 段内入队下标
+    void *slots[SEG_QUEUE_SLOTS];       ///< 元素
+} SegQueueSegment;
+
+/**
+ * @brief 段池
+ */
+typedef struct SegPoolTag {
+    pthread_mutex_t mutex;      ///< 互斥锁，保护空闲链表和计数
+    SegQueueSegment *free;      ///< 空闲段链表
+    uint32_t freeNum;           ///< 空闲段数
+    uint32_t segments;          ///< 段池持有的段数（空闲的加上借给队列的）
+    uint32_t softCap;           ///< 软上限，超过时还回来的段直接释放
+    uint32_t hardCap;           ///< 硬上限，达到后不再分配
+    uint32_t highWater;         ///< 持有段数的最大值
+    uint32_t allocs;            ///< 向系统分配段的次数
+    uint32_t trimmed;           ///< 超过软上限释放的段数
+    uint32_t rejected;          ///< 达到硬上限拒绝的次数
+} SegPool;
+
+/**
+ * @brief 分段队列
+ */
+typedef struct SegQueueTag {
+    SegQueueSegment *head;      ///< 出队的段
+    SegQueueSegment *tail;      ///< 入队的段
+    SegQueueSegment *spare;     ///< 缓存的一个空段，元素数在段边界附近来回时不访问段池
+    SegPool *pool;              ///< 段池
+    uint32_t currentSize;       ///< 队列当前元素数量
+    uint32_t highWater;         ///< 元素数量的最大值
+    uint32_t rejected;          ///< 因硬上限入队失败的次数
+    pthread_mutex_t mutex;      ///< 互斥锁，保护队列访问
+    pthread_cond_t cond;        ///< 条件变量，用于线程间同步
+    clockid_t clockId;          ///< 条件变量等待使用的时钟，优先使用 CLOCK_MONOTONIC
+} SegQueue;
+
+/**
+ * @brief 初始化段池
+ *
+ * @param me 指向段池的指针
+ * @param softCap 软上限（段数）
+ * @param hardCap 硬上限（段数），不小于软上限
+ */
+void SegPoolCtor(SegPool *me, uint32_t softCap, uint32_t hardCap);
+
+/**
+ * @brief 预先分配空闲段，之后在这个范围内增长不再分配内存
+ *
+ * @param me 指向段池的指针
+ * @param n 希望持有的空闲段数，不超过软上限
+ * @return 实际持有的空闲段数
+ */
+uint32_t SegPoolReserve(SegPool *me, uint32_t n);
+
+/**
+ * @brief 释放段池的空闲段，使用该段池的队列必须先析构
+ *
+ * @param me 指向段池的指针
+ */
+void SegPoolDtor(SegPool *me);
+
+/**
+ * @brief 初始化分段队列，第一次入队时才从段池取段
+ *
+ * @param me 指向分段队列的指针
+ * @param pool 段池
+ */
+void SegQueueCtor(SegQueue *me, SegPool *pool);
+
+/**
+ * @brief 把队列持有的段还给段池，队列中剩余的元素丢弃
+ *
+ * @param me 指向分段队列的指针
+ */
+void SegQueueDtor(SegQueue *me);
+
+/**
+ * @brief 元素入队操作
+ *
+ * 队尾段写满时接上一个新段，段池达到硬上限时返回错误
+ *
+ * @param me 指向分段队列的指针
+ * @param item 要入队的元素指针
+ * @return 0 成功入队，-1 段池达到硬上限
+ */
+int SegQueueEnqueue(SegQueue *me, void *item);
+
+/**
+ * @brief 批量入队操作
+ *
+ * 一次加锁按顺序入队多个元素，段池达到硬上限时停止
+ *
+ * @param me 指向分段队列的指针
+ * @param items 要入队的元素指针数组
+ * @param n 元素个数
+ * @return 已入队的元素数
+ */
+uint32_t SegQueueEnqueueBatch(SegQueue *me, void *const *items, uint32_t n);
+
+/**
+ * @brief 阻塞式出队操作
+ *
+ * @param me 指向分段队列的指针
+ * @return 取出的元素指针
+ */
+void *SegQueueDequeueForever(SegQueue *me);
+
+/**
+ * @brief 带超时的出队操作
+ *
+ * @param me 指向分段队列的指针
+ * @param timeoutMs 超时时间（毫秒）
+ * @param isTimeout 输出参数，标识是否超时
+ * @return 取出的元素指针，超时或失败时返回NULL
+ */
+void *SegQueueDequeueWithTimeout(SegQueue *me, uint32_t timeoutMs, bool *isTimeout);
+
+/**
+ * @brief 非阻塞出队操作
+ *
+ * @param me 指向分段队列的指针
+ * @param item 输出参数，取出的元素指针
+ * @return true 成功取出元素，false 队列为空
+ */
+bool SegQueueTryDequeue(SegQueue *me, void **item);
+
+/**
+ * @brief 获取队列当前元素数量
+ *
+ * @param me 指向分段队列的指针
+ * @return 元素数量
+ */
+uint32_t SegQueueSize(SegQueue *me);
+
+/**
+ * @brief 检查队列是否为空
+ *
+ * @param me 指向分段队列的指针
+ * @return true 队列为空，false 队列不为空
+ */
+bool SegQueueIsEmpty(SegQueue *me);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !SEG_QUEUE_H
@@ -0,0 +1,611 @@
+/**
+ * @file shm_queue.c
+ * @brief 跨进程共享内存事件队列实现文件
+ * 
+ * 段布局：[ShmQueueHeader][槽0][槽1]...，每个槽为4字节记录长度加 recordSize 字节内容，
+ * 按8字节对齐。head/tail 是出队/入队计数，在 [0, 2 * maxSize) 内循环，
+ * 这样满和空可以区分，回绕时槽位下标也连续，容量不必是2的幂；
+ * 记录先拷贝进槽位，再用一次写入推进计数发布。
+ * 
+ * 段头中的几何参数在打开时校验一次并缓存在句柄中，之后只用缓存的值定位槽位；
+ * 共享内存中的计数和记录长度每次使用前都检查，越界视为段被破坏。
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // !_GNU_SOURCE
+
+#include "shm_queue.h"
+#include <errno.h>
+#include <string.h>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_QUEUE_MAGIC 0x53484D51U     ///< "SHMQ"，段初始化完成标志
+
+/**
+ * @brief 共享内存段头，所有进程共享同一份
+ */
+typedef struct ShmQueueHeaderTag {
+    uint32_t magic;             ///< 初始化完成后写入 SHM_QUEUE_MAGIC
+    uint32_t recordSize;        ///< 单条记录最大字节数
+    uint32_t slotSize;          ///< 槽大小（含长度字段，8字节对齐）
+    uint32_t maxSize;           ///< 容量（槽数）
+    uint32_t head;              ///< 已出队计数
+    uint32_t tail;              ///< 已入队计数
+    uint32_t ownerDied;         ///< 检测到持锁进程崩溃
+    uint32_t dataOffset;        ///< 第一个槽相对段起始的偏移
+    int32_t consumerPid;        ///< 持有消费者锁的进程，0 表示没有（原子访问）
+    pthread_mutex_t mutex;      ///< 队列锁（进程间共享、健壮）
+    pthread_cond_t notEmpty;    ///< 队列非空条件（进程间共享、单调时钟）
+    pthread_mutex_t consumer;   ///< 消费者存活锁（进程间共享、健壮）
+} ShmQueueHeader;
+
+/**
+ * @brief 计数对应槽位的地址
+ * 
+ * @param me 指向队列句柄的指针
+ * @param count 计数，在 [0, 2 * maxSize) 内
+ */
+static inline uint8_t *Slot(const ShmQueue *me, uint32_t count)
+{
+    uint32_t index = count < me->maxSize ? count : count - me->maxSize;
+    return (uint8_t *)me->hdr + me->dataOffset + (size_t)index * me->slotSize;
+}
+
+/**
+ * @brief 计数加一，到 2 * maxSize 时回到0
+ */
+static inline uint32_t NextCount(const ShmQueue *me, uint32_t count)
+{
+    return count + 1 == 2 * me->maxSize ? 0 : count + 1;
+}
+
+/**
+ * @brief 读取并检查共享内存中的计数（调用者持有队列锁）
+ * 
+ * @param me 指向队列句柄的指针
+ * @param head 输出参数，出队计数
+ * @param tail 输出参数，入队计数
+ * @param size 输出参数，队列长度
+ * @return 0 成功，-1 计数越界（段被破坏），errno 为 EBADMSG
+ */
+static int LoadCounts(const ShmQueue *me, uint32_t *head, uint32_t *tail, uint32_t *size)
+{
+    *head = me->hdr->head;
+    *tail = me->hdr->tail;
+    if (*head >= 2 * me->maxSize || *tail >= 2 * me->maxSize) {
+        errno = EBADMSG;
+        return -1;
+    }
+    *size = *tail >= *head ? *tail - *head : *tail + 2 * me->maxSize - *head;
+    if (*size > me->maxSize) {
+        errno = EBADMSG;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 由记录大小和容量计算段的几何参数
+ * 
+ * @param recordSize 单条记录最大字节数
+ * @param maxSize 容量，不超过 2^31，计数需要 2 * maxSize 个值
+ * @param slotSize 输出参数，槽大小
+ * @param dataOffset 输出参数，第一个槽的偏移
+ * @param size 输出参数，段大小
+ * @return 0 成功，-1 参数无效
+ */
+static int Geometry(uint32_t recordSize, uint32_t maxSize, uint32_t *slotSize, uint32_t *dataOffset, size_t *size)
+{
+    if (recordSize == 0 || maxSize == 0 || maxSize > 0x80000000U || recordSize > UINT32_MAX - 16U) {
+        return -1;
+    }
+    uint64_t bytes = ((uint64_t)sizeof(uint32_t) + recordSize + 7U) & ~(uint64_t)7U;
+    *slotSize = (uint32_t)bytes;
+    *dataOffset = (uint32_t)((sizeof(ShmQueueHeader) + 63U) & ~63U);
+    if (bytes * maxSize > SIZE_MAX - *dataOffset) {
+        return -1;
+    }
+    *size = *dataOffset + (size_t)(bytes * maxSize);
+    return 0;
+}
+
+/**
+ * @brief 处理健壮互斥锁的返回值，持锁者崩溃时恢复锁的一致性
+ * 
+ * @param mutex 互斥锁
+ * @param ret 加锁/等待的返回值
+ * @param died 检测到崩溃时置1的标志，可以为NULL
+ * @return 0 已持有锁，其他为错误码
+ */
+static int Recover(pthread_mutex_t *mutex, int ret, uint32_t *died)
+{
+    if (ret == EOWNERDEAD) {
+        if (died != NULL) {
+            __atomic_store_n(died, 1, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_consistent(mutex);
+        ret = 0;
+    }
+    return ret;
+}
+
+/**
+ * @brief 初始化进程间共享的健壮互斥锁
+ */
+static void RobustMutexInit(pthread_mutex_t *mutex)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/**
+ * @brief 映射共享内存并检查段头
+ * 
+ * @param me 指向队列句柄的指针
+ * @param fd 共享内存文件描述符
+ * @param size 段大小，0 表示从 fd 读取
+ * @return 0 成功，-1 失败
+ */
+static int Map(ShmQueue *me, int fd, size_t size)
+{
+    if (size == 0) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            return -1;
+        }
+        size = (size_t)st.st_size;
+    }
+    if (size < sizeof(ShmQueueHeader)) {
+        errno = EINVAL;
+        return -1;
+    }
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        return -1;
+    }
+    me->hdr = (ShmQueueHeader *)addr;
+    me->mapSize = size;
+    me->fd = fd;
+    return 0;
+}
+
+/**
+ * @brief 创建共享内存队列
+ * 
+ * @param me 指向队列句柄的指针
+ * @param name shm_open 名称，或 NULL
+ * @param recordSize 单个事件记录的最大字节数
+ * @param maxSize 队列容量
+ * @return 0 成功，-1 失败
+ */
+int ShmQueueCreate(ShmQueue *me, const char *name, uint32_t recordSize, uint32_t maxSize)
+{
+    uint32_t slotSize = 0;
+    uint32_t dataOffset = 0;
+    size_t size = 0;
+    if (Geometry(recordSize, maxSize, &slotSize, &dataOffset, &size) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int fd = -1;
+    if (name != NULL) {
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    } else {
+#ifdef __linux__
+        fd = memfd_create("shm_queue", 0);
+#else
+        errno = ENOSYS;
+#endif // __linux__
+    }
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (ftruncate(fd, (off_t)size) != 0 || Map(me, fd, size) != 0) {
+        int err = errno;
+        close(fd);
+        if (name != NULL) {
+            shm_unlink(name);
+        }
+        errno = err;
+        return -1;
+    }
+
+    ShmQueueHeader *hdr = me->hdr;
+    hdr->recordSize = recordSize;
+    hdr->slotSize = slotSize;
+    hdr->maxSize = maxSize;
+    hdr->head = 0;
+    hdr->tail = 0;
+    hdr->ownerDied = 0;
+    hdr->dataOffset = dataOffset;
+    hdr->consumerPid = 0;
+    me->recordSize = recordSize;
+    me->slotSize = slotSize;
+    me->maxSize = maxSize;
+    me->dataOffset = dataOffset;
+    RobustMutexInit(&hdr->mutex);
+    RobustMutexInit(&hdr->consumer);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&hdr->notEmpty, &attr);
+    pthread_condattr_destroy(&attr);
+
+    // 最后写入标志，其他进程看到标志时段头已经初始化完成
+    __atomic_store_n(&hdr->magic, SHM_QUEUE_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief 通过 fd 打开队列
+ * 
+ * @param me 指向队列句柄的指针
+ * @param fd 共享内存文件描述符
+ * @return 0 成功，-1 失败
+ */
+int ShmQueueOpenFd(ShmQueue *me, int fd)
+{
+    if (Map(me, fd, 0) != 0) {
+        return -1;
+    }
+    if (__atomic_load_n(&me->hdr->magic, __ATOMIC_ACQUIRE) != SHM_QUEUE_MAGIC) {
+        munmap(me->hdr, me->mapSize);
+        me->hdr = NULL;
+        errno = EAGAIN;
+        return -1;
+    }
+
+    // 段头由其他进程写入，按同样的公式重新计算几何参数并与映射大小比较，之后只使用缓存的值
+    const ShmQueueHeader *hdr = me->hdr;
+    uint32_t slotSize = 0;
+    uint32_t dataOffset = 0;
+    size_t size = 0;
+    if (Geometry(hdr->recordSize, hdr->maxSize, &slotSize, &dataOffset, &size) != 0 ||
+        slotSize != hdr->slotSize || dataOffset != hdr->dataOffset || size > me->mapSize) {
+        munmap(me->hdr, me->mapSize);
+        me->hdr = NULL;
+        errno = EBADMSG;
+        return -1;
+    }
+    me->recordSize = hdr->recordSize;
+    me->slotSize = slotSize;
+    me->maxSize = hdr->maxSize;
+    me->dataOffset = dataOffset;
+    return 0;
+}
+
+/**
+ * @brief 按名称打开队列
+ * 
+ * @param me 指向队列句柄的指针
+ * @param name shm_open 名称
+ * @return 0 成功，-1 失败
+ */
+int ShmQueueOpen(ShmQueue *me, const char *name)
+{
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ShmQueueOpenFd(me, fd) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 解除映射并关闭 fd
+ * 
+ * @param me 指向队列句柄的指针
+ */
+void ShmQueueClose(ShmQueue *me)
+{
+    if (me->hdr != NULL) {
+        munmap(me->hdr, me->mapSize);
+        me->hdr = NULL;
+    }
+    if (me->fd >= 0) {
+        close(me->fd);
+        me->fd = -1;
+    }
+}
+
+/**
+ * @brief 删除具名共享内存对象
+ * 
+ * @param name shm_open 名称
+ * @return 0 成功，-1 失败
+ */
+int ShmQueueUnlink(const char *name)
+{
+    return shm_unlink(name);
+}
+
+/**
+ * @brief 事件记录入队
+ * 
+ * @param me 指向队列句柄的指针
+ * @param record 事件记录
+ * @param len 记录长度
+ * @return 0 成功，-1 队列已满或记录过长
+ */
+int ShmQueueEnqueue(ShmQueue *me, const void *record, uint32_t len)
+{
+    ShmQueueHeader *hdr = me->hdr;
+    if (len > me->recordSize) {
+        return -1;
+    }
+    if (Recover(&hdr->mutex, pthread_mutex_lock(&hdr->mutex), &hdr->ownerDied) != 0) {
+        return -1;
+    }
+
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t size = 0;
+    if (LoadCounts(me, &head, &tail, &size) != 0 || size == me->maxSize) {
+        pthread_mutex_unlock(&hdr->mutex);
+        return -1;
+    }
+
+    // 先写槽位，再推进 tail 发布
+    uint8_t *slot = Slot(me, tail);
+    memcpy(slot, &len, sizeof(len));
+    memcpy(slot + sizeof(len), record, len);
+    hdr->tail = NextCount(me, tail);
+
+    // 队列由空变为非空时唤醒消费者
+    if (size == 0) {
+        pthread_cond_signal(&hdr->notEmpty);
+    }
+    pthread_mutex_unlock(&hdr->mutex);
+    return 0;
+}
+
+/**
+ * @brief 事件记录出队
+ * 
+ * @param me 指向队列句柄的指针
+ * @param record 输出缓冲区
+ * @param timeoutMs 超时时间（毫秒），0 表示一直等待
+ * @param isTimeout 输出参数，标识是否超时
+ * @return 记录长度，超时或失败返回-1
+ */
+int ShmQueueDequeue(ShmQueue *me, void *record, uint32_t timeoutMs, bool *isTimeout)
+{
+    ShmQueueHeader *hdr = me->hdr;
+    struct timespec deadline = {0, 0};
+    if (timeoutMs != 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+    if (isTimeout != NULL) {
+        *isTimeout = false;
+    }
+
+    int ret = Recover(&hdr->mutex, pthread_mutex_lock(&hdr->mutex), &hdr->ownerDied);
+    if (ret != 0) {
+        return -1;
+    }
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t size = 0;
+    while ((ret = LoadCounts(me, &head, &tail, &size)) == 0 && size == 0) {
+        if (timeoutMs == 0) {
+            ret = pthread_cond_wait(&hdr->notEmpty, &hdr->mutex);
+        } else {
+            ret = pthread_cond_timedwait(&hdr->notEmpty, &hdr->mutex, &deadline);
+        }
+        ret = Recover(&hdr->mutex, ret, &hdr->ownerDied);
+        if (ret == ETIMEDOUT) {
+            if (isTimeout != NULL) {
+                *isTimeout = true;
+            }
+            pthread_mutex_unlock(&hdr->mutex);
+            return -1;
+        } else if (ret != 0) {
+            pthread_mutex_unlock(&hdr->mutex);
+            return -1;
+        }
+    }
+
+    if (ret != 0) {
+        pthread_mutex_unlock(&hdr->mutex);
+        return -1;
+    }
+
+    // 先拷贝出记录，再推进 head 释放槽位；长度超过 recordSize 说明槽位被破坏，丢弃该记录
+    uint32_t len = 0;
+    const uint8_t *slot = Slot(me, head);
+    memcpy(&len, slot, sizeof(len));
+    if (len <= me->recordSize) {
+        memcpy(record, slot + sizeof(len), len);
+    }
+    hdr->head = NextCount(me, head);
+    pthread_mutex_unlock(&hdr->mutex);
+    if (len > me->recordSize) {
+        errno = EBADMSG;
+        return -1;
+    }
+    return (int)len;
+}
+
+/**
+ * @brief 进程是否存在
+ * 
+ * @param pid 进程号
+ * @return true 进程存在
+ */
+static bool PidAlive(int32_t pid)
+{
+    return pid != 0 && (kill((pid_t)pid, 0) == 0 || errno == EPERM);
+}
+
+/**
+ * @brief 声明调用线程为消费者
+ * 
+ * 消费者锁被占用时，如果登记的消费者进程还在则失败；否则占用者只能是正在回收已崩溃消费者的
+ * 生产者（只持锁很短时间），让出CPU后重试
+ * 
+ * @param me 指向队列句柄的指针
+ * @return 0 成功，-1 已有存活的消费者
+ */
+int ShmQueueClaimConsumer(ShmQueue *me)
+{
+    ShmQueueHeader *hdr = me->hdr;
+    for (;;) {
+        int ret = Recover(&hdr->consumer, pthread_mutex_trylock(&hdr->consumer), NULL);
+        if (ret == 0) {
+            __atomic_store_n(&hdr->consumerPid, (int32_t)getpid(), __ATOMIC_RELEASE);
+            return 0;
+        }
+        if (ret != EBUSY || PidAlive(__atomic_load_n(&hdr->consumerPid, __ATOMIC_ACQUIRE))) {
+            return -1;
+        }
+        sched_yield();
+    }
+}
+
+/**
+ * @brief 消费者是否存活
+ * 
+ * 先看登记的消费者进程是否存在，存在时不碰消费者锁，不会让 ShmQueueClaimConsumer 失败；
+ * 进程不存在时才加锁回收
+ * 
+ * @param me 指向队列句柄的指针
+ * @return true 有存活的消费者
+ */
+bool ShmQueueConsumerAlive(ShmQueue *me)
+{
+    ShmQueueHeader *hdr = me->hdr;
+    int32_t pid = __atomic_load_n(&hdr->consumerPid, __ATOMIC_ACQUIRE);
+    if (pid == 0) {
+        return false;
+    }
+    if (PidAlive(pid)) {
+        return true;
+    }
+    // 消费者进程已退出：恢复消费者锁后释放，留给新的消费者；
+    // 锁被占用说明其他生产者正在回收或者新的消费者正在接管
+    int ret = Recover(&hdr->consumer, pthread_mutex_trylock(&hdr->consumer), NULL);
+    if (ret == 0) {
+        __atomic_compare_exchange_n(&hdr->consumerPid, &pid, 0, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&hdr->consumer);
+    }
+    return false;
+}
+
+/**
+ * @brief 是否有进程在持有队列锁时崩溃过
+ * 
+ * @param me 指向队列句柄的指针
+ * @return true 检测到持锁进程崩溃
+ */
+bool ShmQueueOwnerDied(ShmQueue *me)
+{
+    return __atomic_load_n(&me->hdr->ownerDied, __ATOMIC_RELAXED) != 0;
+}
+
+#else // !__unix__
+
+int ShmQueueCreate(ShmQueue *me, const char *name, uint32_t recordSize, uint32_t maxSize)
+{
+    (void)me;
+    (void)name;
+    (void)recordSize;
+    (void)maxSize;
+    errno = ENOSYS;
+    return -1;
+}
+
+int ShmQueueOpen(ShmQueue *me, const char *name)
+{
+    (void)me;
+    (void)name;
+    errno = ENOSYS;
+    return -1;
+}
+
+int ShmQueueOpenFd(ShmQueue *me, int fd)
+{
+    (void)me;
+    (void)fd;
+    errno = ENOSYS;
+    return -1;
+}
+
+void ShmQueueClose(ShmQueue *me)
+{
+    (void)me;
+}
+
+int ShmQueueUnlink(const char *name)
+{
+    (void)name;
+    errno = ENOSYS;
+    return -1;
+}
+
+int ShmQueueEnqueue(ShmQueue *me, const void *record, uint32_t len)
+{
+    (void)me;
+    (void)record;
+    (void)len;
+    return -1;
+}
+
+int ShmQueueDequeue(ShmQueue *me, void *record, uint32_t timeoutMs, bool *isTimeout)
+{
+    (void)me;
+    (void)record;
+    (void)timeoutMs;
+    if (isTimeout != NULL) {
+        *isTimeout = false;
+    }
+    return -1;
+}
+
+int ShmQueueClaimConsumer(ShmQueue *me)
+{
+    (void)me;
+    return -1;
+}
+
+bool ShmQueueConsumerAlive(ShmQueue *me)
+{
+    (void)me;
+    return false;
+}
+
+bool ShmQueueOwnerDied(ShmQueue *me)
+{
+    (void)me;
+    return false;
+}
+
+#endif // __unix__
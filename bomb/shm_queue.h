@@ -0,0 +1,143 @@
+/**
+ * @file shm_queue.h
+ * @brief 跨进程共享内存事件队列头文件
+ * 
+ * 队列整体放在 shm_open/memfd 创建的共享内存段中：段头保存进程间共享的健壮互斥锁、
+ * 条件变量和环形缓冲区索引，事件记录按固定大小内联存放在段头之后，
+ * 只使用相对段起始地址的偏移，不同进程映射到不同地址也能正常工作。
+ * 事件入队/出队只在用户态拷贝，不经过管道或套接字。
+ * 持锁进程崩溃通过健壮互斥锁（EOWNERDEAD）检测；消费者在整个生命周期内持有
+ * 另一把健壮互斥锁，并在段头登记进程号，生产者按进程号判断消费者是否存活，
+ * 进程不存在后才通过这把锁回收（所有进程须在同一个 PID 命名空间中）。
+ * 
+ * 只支持 POSIX 平台，其他平台所有接口返回失败。
+ */
+
+#ifndef SHM_QUEUE_H
+#define SHM_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 共享内存队列句柄（每个进程一份）
+ */
+typedef struct ShmQueueTag {
+    struct ShmQueueHeaderTag *hdr;  ///< 映射后的段头
+    size_t mapSize;                 ///< 映射大小
+    int fd;                         ///< 共享内存文件描述符
+    uint32_t recordSize;            ///< 单条记录最大字节数（打开时校验后缓存）
+    uint32_t slotSize;              ///< 槽大小（打开时校验后缓存）
+    uint32_t maxSize;               ///< 容量（打开时校验后缓存）
+    uint32_t dataOffset;            ///< 第一个槽的偏移（打开时校验后缓存）
+} ShmQueue;
+
+/**
+ * @brief 创建共享内存队列
+ * 
+ * name 为 NULL 时使用匿名 memfd（仅Linux），通过 fork 继承或传递 fd 共享
+ * 
+ * @param me 指向队列句柄的指针
+ * @param name shm_open 名称（以'/'开头），或 NULL
+ * @param recordSize 单个事件记录的最大字节数
+ * @param maxSize 队列容量（记录数），不必是2的幂，最大 2^31
+ * @return 0 成功，-1 失败（errno 指示原因）
+ */
+int ShmQueueCreate(ShmQueue *me, const char *name, uint32_t recordSize, uint32_t maxSize);
+
+/**
+ * @brief 按名称打开其他进程创建的队列
+ * 
+ * @param me 指向队列句柄的指针
+ * @param name shm_open 名称
+ * @return 0 成功，-1 失败
+ */
+int ShmQueueOpen(ShmQueue *me, const char *name);
+
+/**
+ * @brief 通过继承或传递得到的 fd 打开队列
+ * 
+ * 段头的几何参数与映射大小不符时拒绝打开（errno 为 EBADMSG）
+ * 
+ * @param me 指向队列句柄的指针
+ * @param fd 共享内存文件描述符，成功后由句柄持有
+ * @return 0 成功，-1 失败
+ */
+int ShmQueueOpenFd(ShmQueue *me, int fd);
+
+/**
+ * @brief 解除映射并关闭 fd，不删除共享内存对象
+ * 
+ * @param me 指向队列句柄的指针
+ */
+void ShmQueueClose(ShmQueue *me);
+
+/**
+ * @brief 删除具名共享内存对象，已映射的进程不受影响
+ * 
+ * @param name shm_open 名称
+ * @return 0 成功，-1 失败
+ */
+int ShmQueueUnlink(const char *name);
+
+/**
+ * @brief 事件记录入队（拷贝到共享内存）
+ * 
+ * @param me 指向队列句柄的指针
+ * @param record 事件记录
+ * @param len 记录长度，不能超过 recordSize
+ * @return 0 成功，-1 队列已满或记录过长
+ */
+int ShmQueueEnqueue(ShmQueue *me, const void *record, uint32_t len);
+
+/**
+ * @brief 事件记录出队（从共享内存拷贝出来）
+ * 
+ * @param me 指向队列句柄的指针
+ * @param record 输出缓冲区，至少 recordSize 字节
+ * @param timeoutMs 超时时间（毫秒），0 表示一直等待
+ * @param isTimeout 输出参数，标识是否超时，可以为NULL
+ * @return 记录长度，超时或失败返回-1；记录长度或计数越界（段被破坏）时丢弃并返回-1，errno 为 EBADMSG
+ */
+int ShmQueueDequeue(ShmQueue *me, void *record, uint32_t timeoutMs, bool *isTimeout);
+
+/**
+ * @brief 声明调用线程为消费者，在线程/进程结束前一直持有消费者锁
+ * 
+ * @param me 指向队列句柄的指针
+ * @return 0 成功，-1 已有存活的消费者
+ */
+int ShmQueueClaimConsumer(ShmQueue *me);
+
+/**
+ * @brief 消费者是否存活（生产者调用）
+ * 
+ * 消费者存活时只读登记的进程号，不占用消费者锁；消费者进程退出后返回 false，
+ * 并释放消费者锁以便新的消费者接管；已退出但还没被回收的子进程仍算存活
+ * 
+ * @param me 指向队列句柄的指针
+ * @return true 有存活的消费者，false 没有消费者或消费者已崩溃
+ */
+bool ShmQueueConsumerAlive(ShmQueue *me);
+
+/**
+ * @brief 是否有进程在持有队列锁时崩溃过
+ * 
+ * 队列索引每次只用一次写入更新，持锁进程崩溃不会破坏队列，
+ * 崩溃时正在入队的那条记录不会被发布，应用层可以据此决定是否重发
+ * 
+ * @param me 指向队列句柄的指针
+ * @return true 检测到持锁进程崩溃
+ */
+bool ShmQueueOwnerDied(ShmQueue *me);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !SHM_QUEUE_H
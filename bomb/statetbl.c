@@ -7,6 +7,10 @@
  */
 
 #include "statetbl.h"
+#include <stdio.h>
+
+// 单元只有4个字节，一条缓存行可以放下16个单元
+_Static_assert(sizeof(StateCell) == 4, "StateCell must stay 4 bytes");
 
 /**
  * @brief 初始化状态表对象
@@ -23,12 +27,166 @@ void StateTableCtor(StateTable *me, Tran *stateTable, uint8_t stateNum, uint8_t
 {
     // 设置状态转换表
     me->stateTable = stateTable;
+    me->cellTable = NULL;
     // 设置状态数量
     me->stateNum = stateNum;
     // 设置信号数量
     me->signalNum = signalNum;
     // 设置初始状态处理函数
     me->initial = Initial;
+    // 默认所有状态都需要滴答事件
+    me->tickRows = NULL;
+#ifdef STATETBL_PROFILE
+    // 默认不统计命中计数
+    me->cellHits = NULL;
+    me->sampleSeq = 0;
+#endif // STATETBL_PROFILE
+#ifdef FSM_HISTORY
+    // 默认不记录转换历史
+    me->history = NULL;
+#endif // FSM_HISTORY
+#ifdef FSM_PERF_PROFILE
+    // 默认不统计硬件计数器
+    me->perf = NULL;
+#endif // FSM_PERF_PROFILE
+}
+
+/**
+ * @brief 使用单元格式的状态表初始化状态表对象
+ * 
+ * @param me 指向状态表对象的指针
+ * @param cellTable 单元格式的状态表
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param initState 初始状态处理函数指针
+ */
+void StateTableCellCtor(StateTable *me, const StateCellTable *cellTable, uint8_t stateNum, uint8_t signalNum,
+                        Initial initState)
+{
+    StateTableCtor(me, NULL, stateNum, signalNum, initState);
+    me->cellTable = cellTable;
+}
+
+/**
+ * @brief 执行守卫
+ * 
+ * @param base 实例起始地址
+ * @param op 守卫
+ * @return true 守卫通过，false 不通过
+ */
+static inline bool StateGuardPass(const uint8_t *base, const StateOp *op)
+{
+    uint8_t field = base[op->offset];
+    switch (op->op) {
+    case STATE_OP_EQ:
+        return field == op->value;
+    case STATE_OP_NE:
+        return field != op->value;
+    case STATE_OP_LT:
+        return field < op->value;
+    case STATE_OP_GT:
+        return field > op->value;
+    case STATE_OP_EQ_FIELD:
+        return field == base[op->value];
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 执行动作列表
+ * 
+ * @param base 实例起始地址
+ * @param op 动作列表的第一个动作
+ */
+static inline void StateRunActions(uint8_t *base, const StateOp *op)
+{
+    for (; op->op != STATE_OP_END; op++) {
+        switch (op->op) {
+        case STATE_OP_SET:
+            base[op->offset] = op->value;
+            break;
+        case STATE_OP_ADD:
+            base[op->offset] += op->value;
+            break;
+        case STATE_OP_SUB:
+            base[op->offset] -= op->value;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 执行一个状态表单元
+ * 
+ * 纯数据转换直接在这里完成，只有设置了 custom 的单元才有间接调用
+ * 
+ * @param me 指向状态表对象的指针
+ * @param cell 单元
+ * @param e 指向事件结构体的指针
+ */
+static inline void StateCellRun(StateTable *me, const StateCell *cell, const Event *e)
+{
+    const StateCellTable *tbl = me->cellTable;
+    if (cell->guard != 0 && !StateGuardPass((const uint8_t *)me, &tbl->guards[cell->guard - 1])) {
+        return;
+    }
+    if (cell->action != 0) {
+        StateRunActions((uint8_t *)me, &tbl->actions[cell->action - 1]);
+    }
+    if (cell->custom != 0) {
+        tbl->customs[cell->custom - 1](me, e);
+    }
+    if (cell->target != STATE_TARGET_NONE) {
+        me->curState = cell->target;
+    }
+}
+
+/**
+ * @brief 执行当前状态下事件对应的单元
+ * 
+ * cells 为常量时编译器去掉表格式的分支
+ * 
+ * @param me 指向状态表对象的指针
+ * @param e 指向事件结构体的指针
+ * @param cells 是否使用单元表（me->cellTable != NULL）
+ */
+static inline void StateTableRunCell(StateTable *me, const Event *e, bool cells)
+{
+    // 索引计算公式: currentState * signalNum + signal
+    uint32_t cell = me->curState * me->signalNum + e->signal;
+#ifdef STATETBL_PROFILE
+    // 按采样间隔统计单元命中次数
+    if (me->cellHits != NULL && (me->sampleSeq++ & ((1U << STATETBL_PROFILE_SAMPLE_SHIFT) - 1)) == 0) {
+        me->cellHits[cell]++;
+    }
+#endif // STATETBL_PROFILE
+#ifdef FSM_HISTORY
+    // 记录分发前的状态和信号
+    if (me->history != NULL) {
+        FsmHistoryRecord(me->history, me->curState, e->signal);
+    }
+#endif // FSM_HISTORY
+#ifdef FSM_PERF_PROFILE
+    // 处理函数前后读取计数器，计入分发前的（状态，信号）
+    PerfProfSample sample;
+    uint8_t state = me->curState;
+    if (me->perf != NULL) {
+        PerfProfBegin(me->perf, &sample);
+    }
+#endif // FSM_PERF_PROFILE
+    if (cells) {
+        StateCellRun(me, &me->cellTable->cells[cell], e);
+    } else {
+        me->stateTable[cell](me, e);
+    }
+#ifdef FSM_PERF_PROFILE
+    if (me->perf != NULL) {
+        PerfProfEnd(me->perf, &sample, state, e->signal);
+    }
+#endif // FSM_PERF_PROFILE
 }
 
 /**
@@ -57,23 +215,113 @@ void StateTableInit(StateTable *me)
  */
 void StateTableDispatch(StateTable *me, const Event *e)
 {
-    // 检查事件信号是否超出范围
-    if (e->signal >= me->signalNum) {
-        // 信号超出范围，直接返回
+    // 检查事件信号和当前状态是否超出范围（未初始化的状态机 curState == stateNum）
+    if (e->signal >= me->signalNum || me->curState >= me->stateNum) {
+        // 超出范围，直接返回
         return;
     }
 
     // 计算状态转换表中的索引并调用相应的转换函数
-    // 索引计算公式: currentState * signalNum + signal
-    me->stateTable[me->curState * me->signalNum + e->signal](me, e);
+    uint8_t prev = me->curState;
+    StateTableRunCell(me, e, me->cellTable != NULL);
 
     // 检查状态转换后当前状态是否合法
     if (me->curState >= me->stateNum) {
-        // 当前状态超出有效范围，发生错误
-        // 错误处理逻辑应在此处添加
+        // 转换目标超出有效范围，报告并拒绝这次转换，停留在原状态
+        fprintf(stderr, "statetbl: state %u signal %u -> invalid state %u, transition rejected\n",
+                (unsigned)prev, (unsigned)e->signal, (unsigned)me->curState);
+        me->curState = prev;
     }
 }
 
+/**
+ * @brief 不做检查的事件分发（函数表）
+ * 
+ * @param me 指向状态表对象的指针
+ * @param e 指向事件结构体的指针
+ */
+void StateTableDispatchTrusted(StateTable *me, const Event *e)
+{
+    StateTableRunCell(me, e, false);
+}
+
+/**
+ * @brief 不做检查的事件分发（单元表）
+ * 
+ * @param me 指向状态表对象的指针
+ * @param e 指向事件结构体的指针
+ */
+void StateTableDispatchTrustedCells(StateTable *me, const Event *e)
+{
+    StateTableRunCell(me, e, true);
+}
+
+/**
+ * @brief 设置各状态的滴答订阅
+ * 
+ * @param me 指向状态表对象的指针
+ * @param tickRows 每个状态的滴答订阅标志数组，长度为 stateNum，NULL 表示所有状态都需要
+ */
+void StateTableSetTickRows(StateTable *me, const bool *tickRows)
+{
+    me->tickRows = tickRows;
+}
+
+/**
+ * @brief 当前状态是否需要滴答事件
+ * 
+ * @param me 指向状态表对象的指针
+ * @return true 需要滴答，false 不需要
+ */
+bool StateTableNeedTick(const StateTable *me)
+{
+    // 未设置订阅表或者状态未初始化时，保持原有的周期滴答行为
+    if (me->tickRows == NULL || me->curState >= me->stateNum) {
+        return true;
+    }
+    return me->tickRows[me->curState];
+}
+
+#ifdef STATETBL_PROFILE
+/**
+ * @brief 设置单元命中计数数组
+ * 
+ * @param me 指向状态表对象的指针
+ * @param cellHits 计数数组，长度为 stateNum * signalNum，NULL 表示停止统计
+ */
+void StateTableSetProfile(StateTable *me, uint32_t *cellHits)
+{
+    me->cellHits = cellHits;
+    me->sampleSeq = 0;
+}
+#endif // STATETBL_PROFILE
+
+#ifdef FSM_HISTORY
+/**
+ * @brief 设置转换历史环
+ * 
+ * @param me 指向状态表对象的指针
+ * @param history 历史环，NULL 表示停止记录
+ */
+void StateTableSetHistory(StateTable *me, FsmHistory *history)
+{
+    me->history = history;
+}
+#endif // FSM_HISTORY
+
+#ifdef FSM_PERF_PROFILE
+/**
+ * @brief 设置硬件计数器统计
+ * 
+ * @param me 指向状态表对象的指针
+ * @param perf 统计对象，NULL 表示停止统计
+ */
+void StateTableSetPerf(StateTable *me, PerfProf *perf)
+{
+    me->perf = perf;
+}
+#endif // FSM_PERF_PROFILE
+
 /**
  * @brief 空状态处理函数
  * 
@@ -11,6 +11,17 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#ifdef FSM_HISTORY
+#include "fsm_history.h"
+#endif // FSM_HISTORY
+#ifdef FSM_PERF_PROFILE
+#include "perf_prof.h"
+#endif // FSM_PERF_PROFILE
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
 
 /**
  * @brief 事件结构体
@@ -38,6 +49,60 @@ typedef void (*Tran)(struct StateTableTag *me, const Event *e);
  */
 typedef void (*Initial)(struct StateTableTag *me);
 
+/**
+ * @brief 数据操作码
+ * 
+ * 守卫和动作直接读写实例中的 uint8_t 字段，字段用相对实例起始地址的
+ * 字节偏移表示（见 STATE_FIELD），由 StateTableDispatch 内联执行
+ */
+typedef enum {
+    STATE_OP_END,               ///< 动作列表结束
+    STATE_OP_SET,               ///< 动作：field = value
+    STATE_OP_ADD,               ///< 动作：field += value
+    STATE_OP_SUB,               ///< 动作：field -= value
+    STATE_OP_EQ,                ///< 守卫：field == value
+    STATE_OP_NE,                ///< 守卫：field != value
+    STATE_OP_LT,                ///< 守卫：field < value
+    STATE_OP_GT,                ///< 守卫：field > value
+    STATE_OP_EQ_FIELD,          ///< 守卫：field == 偏移为 value 的字段
+} StateOpCode;
+
+/**
+ * @brief 守卫或动作
+ */
+typedef struct StateOpTag {
+    uint8_t op;                 ///< 操作码，见 StateOpCode
+    uint8_t offset;             ///< uint8_t 字段在实例中的字节偏移
+    uint8_t value;              ///< 立即数，或 STATE_OP_EQ_FIELD 的第二个字段偏移
+} StateOp;
+
+/**
+ * @brief 状态表单元
+ * 
+ * 纯数据转换由 {守卫id, 动作列表id, 目标状态} 描述，不需要调用处理函数；
+ * 只有需要自定义代码（例如打印）时才设置 custom，处理函数放在 StateCellTable 的
+ * customs 旁表中，单元只保存一个字节的id，每个单元4字节。执行顺序为：
+ * 守卫不通过则什么也不做，否则执行动作列表，再调用 custom，最后切换到目标状态
+ */
+typedef struct StateCellTag {
+    uint8_t guard;              ///< 守卫id（guards 中的下标加1），0 表示无守卫
+    uint8_t action;             ///< 动作列表id（actions 中起始下标加1），0 表示无动作
+    uint8_t target;             ///< 目标状态，STATE_TARGET_NONE 表示不转换
+    uint8_t custom;             ///< 自定义处理函数id（customs 中的下标加1），0 表示没有
+} StateCell;
+
+/**
+ * @brief 单元格式的状态表
+ */
+typedef struct StateCellTableTag {
+    const StateCell *cells;     ///< 单元数组（二维数组 [state][signal]）
+    const StateOp *guards;      ///< 守卫数组
+    const StateOp *actions;     ///< 动作列表池，每个列表以 STATE_OP_END 结束
+    const Tran *customs;        ///< 自定义处理函数旁表
+} StateCellTable;
+
+#define STATE_TARGET_NONE 0xFF  ///< 单元不做状态转换
+
 /**
  * @brief 状态表结构体
  * 
@@ -47,11 +112,34 @@ typedef void (*Initial)(struct StateTableTag *me);
 typedef struct StateTableTag {
     uint8_t curState;           ///< 当前状态
     Tran *stateTable;           ///< 状态转换函数表（二维数组）
+    const StateCellTable *cellTable; ///< 单元格式的状态表，非NULL时代替 stateTable
     uint8_t stateNum;           ///< 状态数量
     uint8_t signalNum;          ///< 信号数量
     Initial initial;            ///< 初始状态处理函数
+    const bool *tickRows;       ///< 每个状态是否需要滴答事件，NULL 表示所有状态都需要
+#ifdef STATETBL_PROFILE
+    uint32_t *cellHits;         ///< 每个(state, signal)单元的命中计数，NULL 表示不统计
+    uint32_t sampleSeq;         ///< 采样序号
+#endif // STATETBL_PROFILE
+#ifdef FSM_HISTORY
+    FsmHistory *history;        ///< 转换历史环，NULL 表示不记录
+#endif // FSM_HISTORY
+#ifdef FSM_PERF_PROFILE
+    PerfProf *perf;             ///< 硬件计数器统计，NULL 表示不统计
+#endif // FSM_PERF_PROFILE
 } StateTable;
 
+#ifdef STATETBL_PROFILE
+/**
+ * @brief 命中计数采样间隔
+ * 
+ * 每 2^STATETBL_PROFILE_SAMPLE_SHIFT 个事件统计一次，默认每个事件都统计
+ */
+#ifndef STATETBL_PROFILE_SAMPLE_SHIFT
+#define STATETBL_PROFILE_SAMPLE_SHIFT 0
+#endif // !STATETBL_PROFILE_SAMPLE_SHIFT
+#endif // STATETBL_PROFILE
+
 /**
  * @brief 初始化状态表对象
  * 
@@ -65,6 +153,18 @@ typedef struct StateTableTag {
  */
 void StateTableCtor(StateTable *me, Tran *stateTable, uint8_t stateNum, uint8_t signalNum, Initial initState);
 
+/**
+ * @brief 使用单元格式的状态表初始化状态表对象
+ * 
+ * @param me 指向状态表对象的指针
+ * @param cellTable 单元格式的状态表
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param initState 初始状态处理函数指针
+ */
+void StateTableCellCtor(StateTable *me, const StateCellTable *cellTable, uint8_t stateNum, uint8_t signalNum,
+                        Initial initState);
+
 /**
  * @brief 初始化状态机
  * 
@@ -78,13 +178,86 @@ void StateTableInit(StateTable *me);
  * @brief 分发事件到相应的状态处理函数
  * 
  * 根据当前状态和接收到的事件信号，在状态表中查找并执行相应
- * 的状态转换函数
+ * 的状态转换函数。信号或当前状态越界时忽略事件；转换目标越界时
+ * 输出错误并停留在原状态
  * 
  * @param me 指向状态表对象的指针
  * @param e 指向事件结构体的指针
  */
 void StateTableDispatch(StateTable *me, const Event *e);
 
+/**
+ * @brief 不做检查的事件分发（函数表）
+ * 
+ * 省略信号范围检查和表格式的判断，只能用于通过 StateTableVerify
+ * 校验（report.trusted 为 true）的函数状态表，并且调用者保证 e->signal < signalNum
+ * 
+ * @param me 指向状态表对象的指针
+ * @param e 指向事件结构体的指针
+ */
+void StateTableDispatchTrusted(StateTable *me, const Event *e);
+
+/**
+ * @brief 不做检查的事件分发（单元表）
+ * 
+ * 与 StateTableDispatchTrusted 相同，用于 StateTableCellCtor 构造的状态表
+ * 
+ * @param me 指向状态表对象的指针
+ * @param e 指向事件结构体的指针
+ */
+void StateTableDispatchTrustedCells(StateTable *me, const Event *e);
+
+/**
+ * @brief 设置各状态的滴答订阅
+ * 
+ * tickRows[state] 为 true 表示该状态需要周期性的滴答事件，
+ * 运行循环只在这类状态下设置滴答超时，其余状态无限期等待事件
+ * 
+ * @param me 指向状态表对象的指针
+ * @param tickRows 每个状态的滴答订阅标志数组，长度为 stateNum，NULL 表示所有状态都需要
+ */
+void StateTableSetTickRows(StateTable *me, const bool *tickRows);
+
+/**
+ * @brief 当前状态是否需要滴答事件
+ * 
+ * @param me 指向状态表对象的指针
+ * @return true 需要滴答，false 不需要
+ */
+bool StateTableNeedTick(const StateTable *me);
+
+#ifdef STATETBL_PROFILE
+/**
+ * @brief 设置单元命中计数数组
+ * 
+ * @param me 指向状态表对象的指针
+ * @param cellHits 计数数组，长度为 stateNum * signalNum，按状态表的下标排列，NULL 表示停止统计
+ */
+void StateTableSetProfile(StateTable *me, uint32_t *cellHits);
+#endif // STATETBL_PROFILE
+
+#ifdef FSM_HISTORY
+/**
+ * @brief 设置转换历史环
+ * 
+ * @param me 指向状态表对象的指针
+ * @param history 历史环，NULL 表示停止记录
+ */
+void StateTableSetHistory(StateTable *me, FsmHistory *history);
+#endif // FSM_HISTORY
+
+#ifdef FSM_PERF_PROFILE
+/**
+ * @brief 设置硬件计数器统计
+ * 
+ * 统计对象的状态数和信号数与状态表相同，必须在分发线程上初始化
+ * 
+ * @param me 指向状态表对象的指针
+ * @param perf 统计对象，NULL 表示停止统计
+ */
+void StateTableSetPerf(StateTable *me, PerfProf *perf);
+#endif // FSM_PERF_PROFILE
+
 /**
  * @brief 空状态处理函数
  * 
@@ -110,4 +283,27 @@ void StateTableEmpty(StateTable *me, const Event *e);
  */
 #define TRAN(target) (((StateTable *)me)->curState = (target))
 
+/**
+ * @brief 字段偏移宏
+ * 
+ * 用于 StateOp 中描述实例的 uint8_t 字段，例如 STATE_FIELD(Bomb2, curInput)。
+ * 偏移只有一个字节，字段偏移超过 UINT8_MAX 或字段不是单字节时编译报错（负长度数组），
+ * 宏仍是常量表达式，可以用在静态初始化中
+ */
+#define STATE_FIELD(type, field)                                                        \
+    ((uint8_t)(offsetof(type, field) +                                                  \
+               0 * sizeof(char[(offsetof(type, field) <= UINT8_MAX &&                   \
+                                sizeof(((type *)0)->field) == 1) ? 1 : -1])))
+
+/**
+ * @brief 单元构造宏
+ */
+#define STATE_CELL_EMPTY {0, 0, STATE_TARGET_NONE, 0}                           ///< 什么也不做
+#define STATE_CELL_CUSTOM(id) {0, 0, STATE_TARGET_NONE, (id)}                    ///< 只调用 id 对应的处理函数
+#define STATE_CELL_TRAN(guard, action, target) {(guard), (action), (target), 0} ///< 纯数据转换
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
 #endif // !STATETBL_H
\ No newline at end of file
@@ -0,0 +1,341 @@
+/**
+ * @file statetbl_layout.c
+ * @brief 状态表布局优化实现文件
+ * 
+ * 实现命中计数文件的读写、状态/信号重编号以及重排后状态表的生成，
+ * 状态表可以是函数指针表，也可以是单元格式的状态表（目标状态和滴答订阅一起重编号）。
+ */
+
+#include "statetbl_layout.h"
+#include <string.h>
+
+/**
+ * @brief 写出命中计数文件
+ * 
+ * @param out 输出文件
+ * @param cellHits 命中计数数组
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @return 0 成功，-1 写文件失败
+ */
+int StateTableProfileSave(FILE *out, const uint32_t *cellHits, uint8_t stateNum, uint8_t signalNum)
+{
+    if (fprintf(out, "%u %u\n", stateNum, signalNum) < 0) {
+        return -1;
+    }
+    for (uint8_t s = 0; s < stateNum; s++) {
+        for (uint8_t g = 0; g < signalNum; g++) {
+            fprintf(out, g == 0 ? "%u" : " %u", cellHits[s * signalNum + g]);
+        }
+        fputc('\n', out);
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+/**
+ * @brief 读取命中计数文件
+ * 
+ * @param in 输入文件
+ * @param cellHits 输出的命中计数数组
+ * @param maxCells 计数数组容量
+ * @param stateNum 输出参数，状态数量
+ * @param signalNum 输出参数，信号数量
+ * @return 0 成功，-1 文件格式错误或容量不足
+ */
+int StateTableProfileLoad(FILE *in, uint32_t *cellHits, uint32_t maxCells, uint8_t *stateNum, uint8_t *signalNum)
+{
+    unsigned states = 0;
+    unsigned signals = 0;
+
+    if (fscanf(in, "%u %u", &states, &signals) != 2 || states == 0 || signals == 0 ||
+        states > UINT8_MAX || signals > UINT8_MAX || states * signals > maxCells) {
+        return -1;
+    }
+    for (unsigned i = 0; i < states * signals; i++) {
+        if (fscanf(in, "%u", &cellHits[i]) != 1) {
+            return -1;
+        }
+    }
+    *stateNum = (uint8_t)states;
+    *signalNum = (uint8_t)signals;
+    return 0;
+}
+
+/**
+ * @brief 在命中计数之后追加单元格式状态表的描述
+ * 
+ * @param out 输出文件
+ * @param cells 单元数组
+ * @param tickRows 每个状态的滴答订阅标志
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @return 0 成功，-1 写文件失败
+ */
+int StateTableCellsSave(FILE *out, const StateCell *cells, const bool *tickRows, uint8_t stateNum, uint8_t signalNum)
+{
+    fprintf(out, "cells\n");
+    for (uint8_t s = 0; s < stateNum; s++) {
+        for (uint8_t g = 0; g < signalNum; g++) {
+            const StateCell *cell = &cells[s * signalNum + g];
+            fprintf(out, g == 0 ? "%u %u %u %u" : "  %u %u %u %u", cell->guard, cell->action, cell->target,
+                    cell->custom);
+        }
+        fputc('\n', out);
+    }
+    fprintf(out, "ticks\n");
+    for (uint8_t s = 0; s < stateNum; s++) {
+        fprintf(out, s == 0 ? "%u" : " %u", tickRows == NULL || tickRows[s]);
+    }
+    fputc('\n', out);
+    return ferror(out) ? -1 : 0;
+}
+
+/**
+ * @brief 读取命中计数之后的单元格式状态表描述
+ * 
+ * @param in 输入文件，已经读完命中计数
+ * @param cells 输出的单元数组
+ * @param tickRows 输出的滴答订阅标志
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @return 0 成功，1 文件中没有单元描述，-1 格式错误
+ */
+int StateTableCellsLoad(FILE *in, StateCell *cells, bool *tickRows, uint8_t stateNum, uint8_t signalNum)
+{
+    char tag[8];
+
+    if (fscanf(in, "%7s", tag) != 1) {
+        return 1;
+    }
+    if (strcmp(tag, "cells") != 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < (uint32_t)stateNum * signalNum; i++) {
+        unsigned guard = 0;
+        unsigned action = 0;
+        unsigned target = 0;
+        unsigned custom = 0;
+        if (fscanf(in, "%u %u %u %u", &guard, &action, &target, &custom) != 4 || guard > UINT8_MAX ||
+            action > UINT8_MAX || (target >= stateNum && target != STATE_TARGET_NONE) || custom > UINT8_MAX) {
+            return -1;
+        }
+        cells[i].guard = (uint8_t)guard;
+        cells[i].action = (uint8_t)action;
+        cells[i].target = (uint8_t)target;
+        cells[i].custom = (uint8_t)custom;
+    }
+    if (fscanf(in, "%7s", tag) != 1 || strcmp(tag, "ticks") != 0) {
+        return -1;
+    }
+    for (uint8_t s = 0; s < stateNum; s++) {
+        unsigned tick = 0;
+        if (fscanf(in, "%u", &tick) != 1) {
+            return -1;
+        }
+        tickRows[s] = tick != 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief 按权重从高到低排序编号，并生成旧编号到新编号的映射
+ * 
+ * 权重相同时保持原有顺序，数量最多255，使用插入排序即可
+ * 
+ * @param weight 每个编号的权重
+ * @param num 编号数量
+ * @param map 输出参数，map[旧编号] = 新编号
+ */
+static void RankByWeight(const uint64_t *weight, uint8_t num, uint8_t *map)
+{
+    uint8_t order[UINT8_MAX];
+
+    for (uint8_t i = 0; i < num; i++) {
+        uint8_t j = i;
+        while (j > 0 && weight[order[j - 1]] < weight[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    for (uint8_t i = 0; i < num; i++) {
+        map[order[i]] = i;
+    }
+}
+
+/**
+ * @brief 根据命中计数计算新的状态和信号编号
+ * 
+ * @param cellHits 命中计数数组
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 输出参数，stateMap[旧状态] = 新状态
+ * @param signalMap 输出参数，signalMap[旧信号] = 新信号
+ */
+void StateTableComputeLayout(const uint32_t *cellHits, uint8_t stateNum, uint8_t signalNum,
+                             uint8_t *stateMap, uint8_t *signalMap)
+{
+    uint64_t rowHits[UINT8_MAX] = {0};
+    uint64_t colHits[UINT8_MAX] = {0};
+
+    // 统计每行（状态）和每列（信号）的总命中次数
+    for (uint8_t s = 0; s < stateNum; s++) {
+        for (uint8_t g = 0; g < signalNum; g++) {
+            rowHits[s] += cellHits[s * signalNum + g];
+            colHits[g] += cellHits[s * signalNum + g];
+        }
+    }
+
+    RankByWeight(rowHits, stateNum, stateMap);
+    RankByWeight(colHits, signalNum, signalMap);
+}
+
+/**
+ * @brief 按新编号重排状态表
+ * 
+ * @param src 原状态表
+ * @param dst 输出的重排后状态表
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 状态编号映射
+ * @param signalMap 信号编号映射
+ */
+void StateTableRemap(const Tran *src, Tran *dst, uint8_t stateNum, uint8_t signalNum,
+                     const uint8_t *stateMap, const uint8_t *signalMap)
+{
+    for (uint8_t s = 0; s < stateNum; s++) {
+        for (uint8_t g = 0; g < signalNum; g++) {
+            dst[stateMap[s] * signalNum + signalMap[g]] = src[s * signalNum + g];
+        }
+    }
+}
+
+/**
+ * @brief 输出一个编号映射数组
+ * 
+ * @param out 输出文件
+ * @param name 数组名前缀
+ * @param suffix 数组名后缀
+ * @param map 映射数组
+ * @param num 数组长度
+ */
+static void EmitMap(FILE *out, const char *name, const char *suffix, const uint8_t *map, uint8_t num)
+{
+    fprintf(out, "static const uint8_t %s%s[%u] = {", name, suffix, num);
+    for (uint8_t i = 0; i < num; i++) {
+        fprintf(out, i == 0 ? "%u" : ", %u", map[i]);
+    }
+    fprintf(out, "};\n");
+}
+
+/**
+ * @brief 计算新编号到旧编号的逆映射，并输出两个编号映射数组
+ * 
+ * @param out 输出文件
+ * @param name 数组名前缀
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 状态编号映射
+ * @param signalMap 信号编号映射
+ * @param stateInv 输出参数，stateInv[新状态] = 旧状态
+ * @param signalInv 输出参数，signalInv[新信号] = 旧信号
+ */
+static void EmitMaps(FILE *out, const char *name, uint8_t stateNum, uint8_t signalNum, const uint8_t *stateMap,
+                     const uint8_t *signalMap, uint8_t *stateInv, uint8_t *signalInv)
+{
+    for (uint8_t i = 0; i < stateNum; i++) {
+        stateInv[stateMap[i]] = i;
+    }
+    for (uint8_t i = 0; i < signalNum; i++) {
+        signalInv[signalMap[i]] = i;
+    }
+
+    fprintf(out, "// 旧编号 -> 新编号，状态枚举和信号枚举需要按此重新编号\n");
+    EmitMap(out, name, "StateRemap", stateMap, stateNum);
+    EmitMap(out, name, "SignalRemap", signalMap, signalNum);
+}
+
+/**
+ * @brief 生成重排后的状态表和编号映射数组的C源码
+ * 
+ * @param out 输出文件
+ * @param name 生成的数组名前缀
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 状态编号映射
+ * @param signalMap 信号编号映射
+ * @param cellNames 原状态表每个单元的处理函数名，NULL 时输出 TBL_CELL(state, signal)
+ */
+void StateTableLayoutEmit(FILE *out, const char *name, uint8_t stateNum, uint8_t signalNum,
+                          const uint8_t *stateMap, const uint8_t *signalMap, const char *const *cellNames)
+{
+    uint8_t stateInv[UINT8_MAX];
+    uint8_t signalInv[UINT8_MAX];
+
+    EmitMaps(out, name, stateNum, signalNum, stateMap, signalMap, stateInv, signalInv);
+    fprintf(out, "\n// 重排后的状态表：[新状态][新信号]\n");
+    fprintf(out, "static Tran %sTable[%u][%u] = {\n", name, stateNum, signalNum);
+    for (uint8_t s = 0; s < stateNum; s++) {
+        fprintf(out, "    // 原状态 %u\n    {", stateInv[s]);
+        for (uint8_t g = 0; g < signalNum; g++) {
+            uint32_t oldCell = stateInv[s] * signalNum + signalInv[g];
+            if (g != 0) {
+                fprintf(out, ", ");
+            }
+            if (cellNames != NULL) {
+                fprintf(out, "(Tran)%s", cellNames[oldCell]);
+            } else {
+                fprintf(out, "TBL_CELL(%u, %u)", stateInv[s], signalInv[g]);
+            }
+        }
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "};\n");
+}
+
+/**
+ * @brief 生成重排后的单元格式状态表、滴答订阅和编号映射数组的C源码
+ * 
+ * @param out 输出文件
+ * @param name 生成的数组名前缀
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 状态编号映射
+ * @param signalMap 信号编号映射
+ * @param cells 原单元数组
+ * @param tickRows 原滴答订阅标志，NULL 表示所有状态都需要
+ */
+void StateTableLayoutEmitCells(FILE *out, const char *name, uint8_t stateNum, uint8_t signalNum,
+                               const uint8_t *stateMap, const uint8_t *signalMap, const StateCell *cells,
+                               const bool *tickRows)
+{
+    uint8_t stateInv[UINT8_MAX];
+    uint8_t signalInv[UINT8_MAX];
+
+    EmitMaps(out, name, stateNum, signalNum, stateMap, signalMap, stateInv, signalInv);
+    fprintf(out, "\n// 重排后的单元表：[新状态][新信号]，目标状态已改为新编号，守卫、动作和自定义处理函数id不变\n");
+    fprintf(out, "static const StateCell %sCells[%u][%u] = {\n", name, stateNum, signalNum);
+    for (uint8_t s = 0; s < stateNum; s++) {
+        fprintf(out, "    // 原状态 %u\n    {\n", stateInv[s]);
+        for (uint8_t g = 0; g < signalNum; g++) {
+            uint32_t oldCell = stateInv[s] * signalNum + signalInv[g];
+            const StateCell *cell = &cells[oldCell];
+            fprintf(out, "        {%u, %u, ", cell->guard, cell->action);
+            if (cell->target == STATE_TARGET_NONE) {
+                fprintf(out, "STATE_TARGET_NONE, ");
+            } else {
+                fprintf(out, "%u, ", stateMap[cell->target]);
+            }
+            fprintf(out, "%u},\n", cell->custom);
+        }
+        fprintf(out, "    },\n");
+    }
+    fprintf(out, "};\n");
+
+    fprintf(out, "\n// 重排后的滴答订阅：[新状态]\n");
+    fprintf(out, "static const bool %sTickRows[%u] = {", name, stateNum);
+    for (uint8_t s = 0; s < stateNum; s++) {
+        fprintf(out, s == 0 ? "%s" : ", %s", tickRows == NULL || tickRows[stateInv[s]] ? "true" : "false");
+    }
+    fprintf(out, "};\n");
+}
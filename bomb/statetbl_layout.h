@@ -0,0 +1,135 @@
+/**
+ * @file statetbl_layout.h
+ * @brief 状态表布局优化头文件
+ * 
+ * 根据运行时统计的单元命中计数（见 STATETBL_PROFILE），重新编号状态和信号，
+ * 使命中次数多的单元集中在状态表的前几条缓存行中，并生成重排后的
+ * 状态表和新旧编号映射数组。单元格式的状态表（StateCell）还需要
+ * 改写单元中的目标状态和滴答订阅数组，见 StateTableLayoutEmitCells。
+ */
+
+#ifndef STATETBL_LAYOUT_H
+#define STATETBL_LAYOUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "statetbl.h"
+
+/**
+ * @brief 写出命中计数文件
+ * 
+ * 文件格式：第一行为 "stateNum signalNum"，随后每个状态一行，
+ * 每行 signalNum 个命中计数
+ * 
+ * @param out 输出文件
+ * @param cellHits 命中计数数组，长度为 stateNum * signalNum
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @return 0 成功，-1 写文件失败
+ */
+int StateTableProfileSave(FILE *out, const uint32_t *cellHits, uint8_t stateNum, uint8_t signalNum);
+
+/**
+ * @brief 读取命中计数文件
+ * 
+ * @param in 输入文件
+ * @param cellHits 输出的命中计数数组，容量至少为 maxCells
+ * @param maxCells 计数数组容量
+ * @param stateNum 输出参数，状态数量
+ * @param signalNum 输出参数，信号数量
+ * @return 0 成功，-1 文件格式错误或容量不足
+ */
+int StateTableProfileLoad(FILE *in, uint32_t *cellHits, uint32_t maxCells, uint8_t *stateNum, uint8_t *signalNum);
+
+/**
+ * @brief 在命中计数之后追加单元格式状态表的描述
+ * 
+ * 格式：一行 "cells"，随后每个状态一行，每个单元为 "守卫id 动作id 目标状态 自定义处理函数id"；
+ * 再一行 "ticks"，随后一行 stateNum 个滴答订阅标志
+ * 
+ * @param out 输出文件
+ * @param cells 单元数组，长度为 stateNum * signalNum
+ * @param tickRows 每个状态的滴答订阅标志，NULL 表示所有状态都需要
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @return 0 成功，-1 写文件失败
+ */
+int StateTableCellsSave(FILE *out, const StateCell *cells, const bool *tickRows, uint8_t stateNum, uint8_t signalNum);
+
+/**
+ * @brief 读取命中计数之后的单元格式状态表描述
+ * 
+ * 自定义处理函数按id保存，读出的单元与原状态表共用同一个 customs 旁表
+ * 
+ * @param in 输入文件，已经读完命中计数
+ * @param cells 输出的单元数组，长度为 stateNum * signalNum
+ * @param tickRows 输出的滴答订阅标志，长度为 stateNum
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @return 0 成功，1 文件中没有单元描述，-1 格式错误
+ */
+int StateTableCellsLoad(FILE *in, StateCell *cells, bool *tickRows, uint8_t stateNum, uint8_t signalNum);
+
+/**
+ * @brief 根据命中计数计算新的状态和信号编号
+ * 
+ * 状态按整行命中次数、信号按整列命中次数从高到低重新编号，
+ * 热点单元因此集中在状态表的起始位置
+ * 
+ * @param cellHits 命中计数数组，长度为 stateNum * signalNum
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 输出参数，stateMap[旧状态] = 新状态
+ * @param signalMap 输出参数，signalMap[旧信号] = 新信号
+ */
+void StateTableComputeLayout(const uint32_t *cellHits, uint8_t stateNum, uint8_t signalNum,
+                             uint8_t *stateMap, uint8_t *signalMap);
+
+/**
+ * @brief 按新编号重排状态表
+ * 
+ * @param src 原状态表，长度为 stateNum * signalNum
+ * @param dst 输出的重排后状态表，长度为 stateNum * signalNum
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 状态编号映射
+ * @param signalMap 信号编号映射
+ */
+void StateTableRemap(const Tran *src, Tran *dst, uint8_t stateNum, uint8_t signalNum,
+                     const uint8_t *stateMap, const uint8_t *signalMap);
+
+/**
+ * @brief 生成重排后的状态表和编号映射数组的C源码
+ * 
+ * @param out 输出文件
+ * @param name 生成的数组名前缀
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 状态编号映射
+ * @param signalMap 信号编号映射
+ * @param cellNames 原状态表每个单元的处理函数名，按原下标排列；NULL 时输出 TBL_CELL(state, signal)
+ */
+void StateTableLayoutEmit(FILE *out, const char *name, uint8_t stateNum, uint8_t signalNum,
+                          const uint8_t *stateMap, const uint8_t *signalMap, const char *const *cellNames);
+
+/**
+ * @brief 生成重排后的单元格式状态表、滴答订阅和编号映射数组的C源码
+ * 
+ * 单元按新编号重排，单元中的目标状态改为新编号，滴答订阅数组按新状态编号重排；
+ * 守卫、动作列表和自定义处理函数按id引用，不受重编号影响
+ * 
+ * @param out 输出文件
+ * @param name 生成的数组名前缀，输出 nameCells 和 nameTickRows
+ * @param stateNum 状态数量
+ * @param signalNum 信号数量
+ * @param stateMap 状态编号映射
+ * @param signalMap 信号编号映射
+ * @param cells 原单元数组，长度为 stateNum * signalNum
+ * @param tickRows 原滴答订阅标志，NULL 表示所有状态都需要
+ */
+void StateTableLayoutEmitCells(FILE *out, const char *name, uint8_t stateNum, uint8_t signalNum,
+                               const uint8_t *stateMap, const uint8_t *signalMap, const StateCell *cells,
+                               const bool *tickRows);
+
+#endif // !STATETBL_LAYOUT_H
@@ -0,0 +1,179 @@
+/**
+ * @file statetbl_verify.c
+ * @brief 状态表校验实现文件
+ * 
+ * 从初始状态出发做广度优先搜索求可达状态，统计各类问题单元，并生成修剪后的状态表。
+ */
+
+#include "statetbl_verify.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief 设置状态可达
+ * 
+ * @param rep 校验结果
+ * @param state 状态
+ */
+static void SetReachable(StateTableReport *rep, uint8_t state)
+{
+    rep->reachable[state >> 6] |= 1ULL << (state & 63);
+}
+
+/**
+ * @brief 单元是否什么也不做
+ * 
+ * @param me 指向状态表对象的指针
+ * @param cell 单元下标
+ * @return true 空单元
+ */
+static bool CellIsEmpty(const StateTable *me, uint32_t cell)
+{
+    if (me->cellTable != NULL) {
+        const StateCell *c = &me->cellTable->cells[cell];
+        return c->action == 0 && c->custom == 0 && c->target == STATE_TARGET_NONE;
+    }
+    return me->stateTable[cell] == NULL || me->stateTable[cell] == StateTableEmpty;
+}
+
+/**
+ * @brief 校验状态表
+ * 
+ * @param me 指向已构造的状态表对象的指针
+ * @param initState 初始处理函数进入的状态
+ * @param decls 自定义处理函数的状态转换声明
+ * @param declNum 声明个数
+ * @param rep 输出参数，校验结果
+ * @return true 校验通过，false 存在越界目标或空指针单元
+ */
+bool StateTableVerify(const StateTable *me, uint8_t initState, const StateTargetDecl *decls, uint16_t declNum,
+                      StateTableReport *rep)
+{
+    uint8_t queue[UINT8_MAX];
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    memset(rep, 0, sizeof(*rep));
+    if (initState >= me->stateNum) {
+        rep->badTargets++;
+        return false;
+    }
+
+    // 检查空单元和单元表中的目标状态
+    for (uint32_t cell = 0; cell < (uint32_t)me->stateNum * me->signalNum; cell++) {
+        if (me->cellTable != NULL) {
+            const StateCell *c = &me->cellTable->cells[cell];
+            if (c->target != STATE_TARGET_NONE && c->target >= me->stateNum) {
+                rep->badTargets++;
+            }
+            // 自定义处理函数id指向空的旁表项
+            if (c->custom != 0 && (me->cellTable->customs == NULL || me->cellTable->customs[c->custom - 1] == NULL)) {
+                rep->nullCells++;
+            }
+        } else if (me->stateTable[cell] == NULL) {
+            rep->nullCells++;
+        }
+    }
+    // 检查自定义处理函数的转换声明
+    for (uint16_t i = 0; i < declNum; i++) {
+        if (decls[i].state >= me->stateNum || decls[i].signal >= me->signalNum || decls[i].target >= me->stateNum) {
+            rep->badTargets++;
+        }
+    }
+
+    // 从初始状态出发广度优先搜索
+    SetReachable(rep, initState);
+    queue[tail++] = initState;
+    while (head < tail) {
+        uint8_t s = queue[head++];
+        for (uint8_t g = 0; g < me->signalNum; g++) {
+            uint8_t target = STATE_TARGET_NONE;
+            if (me->cellTable != NULL) {
+                target = me->cellTable->cells[s * me->signalNum + g].target;
+            }
+            if (target < me->stateNum && !STATE_REPORT_REACHABLE(rep, target)) {
+                SetReachable(rep, target);
+                queue[tail++] = target;
+            }
+        }
+        for (uint16_t i = 0; i < declNum; i++) {
+            uint8_t target = decls[i].target;
+            if (decls[i].state == s && target < me->stateNum && !STATE_REPORT_REACHABLE(rep, target)) {
+                SetReachable(rep, target);
+                queue[tail++] = target;
+            }
+        }
+    }
+
+    // 统计不可达状态、死单元和空单元
+    for (uint8_t s = 0; s < me->stateNum; s++) {
+        bool reachable = STATE_REPORT_REACHABLE(rep, s);
+        if (reachable) {
+            rep->prunedStateNum = (uint8_t)(s + 1);
+        } else {
+            rep->unreachableStates++;
+        }
+        for (uint8_t g = 0; g < me->signalNum; g++) {
+            uint32_t cell = (uint32_t)s * me->signalNum + g;
+            if (!reachable) {
+                rep->deadCells++;
+            } else if (CellIsEmpty(me, cell)) {
+                rep->emptyCells++;
+            }
+        }
+    }
+
+    // 原表中的空指针单元会被不做检查的分发直接调用，必须没有空指针单元且目标状态都在范围内
+    rep->trusted = rep->badTargets == 0 && rep->nullCells == 0;
+    return rep->trusted;
+}
+
+/**
+ * @brief 生成修剪后的函数状态表
+ * 
+ * @param me 指向使用函数表构造的状态表对象的指针
+ * @param rep StateTableVerify 的结果
+ * @param out 输出的状态表
+ */
+void StateTablePruneFunctions(const StateTable *me, const StateTableReport *rep, Tran *out)
+{
+    for (uint8_t s = 0; s < rep->prunedStateNum; s++) {
+        for (uint8_t g = 0; g < me->signalNum; g++) {
+            uint32_t cell = (uint32_t)s * me->signalNum + g;
+            Tran tran = me->stateTable[cell];
+            out[cell] = (STATE_REPORT_REACHABLE(rep, s) && tran != NULL) ? tran : StateTableEmpty;
+        }
+    }
+}
+
+/**
+ * @brief 生成修剪后的单元状态表
+ * 
+ * @param me 指向使用单元表构造的状态表对象的指针
+ * @param rep StateTableVerify 的结果
+ * @param out 输出的单元数组
+ */
+void StateTablePruneCells(const StateTable *me, const StateTableReport *rep, StateCell *out)
+{
+    static const StateCell emptyCell = STATE_CELL_EMPTY;
+
+    for (uint8_t s = 0; s < rep->prunedStateNum; s++) {
+        for (uint8_t g = 0; g < me->signalNum; g++) {
+            uint32_t cell = (uint32_t)s * me->signalNum + g;
+            out[cell] = STATE_REPORT_REACHABLE(rep, s) ? me->cellTable->cells[cell] : emptyCell;
+        }
+    }
+}
+
+/**
+ * @brief 打印校验结果
+ * 
+ * @param rep 校验结果
+ * @param name 状态表名称
+ */
+void StateTableReportPrint(const StateTableReport *rep, const char *name)
+{
+    printf("%s: null[%u] badTarget[%u] empty[%u] dead[%u] unreachable[%u] pruned[%u] %s\n", name,
+           rep->nullCells, rep->badTargets, rep->emptyCells, rep->deadCells, rep->unreachableStates,
+           rep->prunedStateNum, rep->trusted ? "trusted" : "untrusted");
+}
@@ -0,0 +1,104 @@
+/**
+ * @file statetbl_verify.h
+ * @brief 状态表校验头文件
+ * 
+ * 在构造时（或离线）对状态表做一次静态分析：检查空单元、目标状态越界，
+ * 找出从初始状态不可达的状态和永远不会执行的单元，并生成修剪后的状态表。
+ * 校验通过（没有空指针单元、目标状态都在范围内）的状态表可以使用不做逐事件检查的
+ * StateTableDispatchTrusted/StateTableDispatchTrustedCells，调用者还要保证分发的信号都小于 signalNum。
+ * 
+ * 自定义处理函数内部的 TRAN 无法静态分析，需要通过 StateTargetDecl 声明，
+ * 未声明的自定义处理函数视为不做状态转换。
+ */
+
+#ifndef STATETBL_VERIFY_H
+#define STATETBL_VERIFY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "statetbl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 自定义处理函数可能的状态转换声明
+ */
+typedef struct StateTargetDeclTag {
+    uint8_t state;              ///< 单元所在状态
+    uint8_t signal;             ///< 单元对应信号
+    uint8_t target;             ///< 处理函数可能转换到的目标状态
+} StateTargetDecl;
+
+/**
+ * @brief 校验结果
+ */
+typedef struct StateTableReportTag {
+    uint16_t nullCells;         ///< 函数表中的空指针单元数
+    uint16_t badTargets;        ///< 目标状态越界的单元/声明数
+    uint16_t emptyCells;        ///< 可达状态中什么也不做的单元数
+    uint16_t deadCells;         ///< 不可达状态中的单元数
+    uint8_t unreachableStates;  ///< 不可达的状态数
+    uint8_t prunedStateNum;     ///< 修剪后的状态数（去掉末尾的不可达状态）
+    uint64_t reachable[4];      ///< 可达状态位图
+    bool trusted;               ///< 状态表可以使用不做检查的分发
+} StateTableReport;
+
+/**
+ * @brief 判断状态是否可达
+ * 
+ * @param rep 校验结果
+ * @param state 状态
+ */
+#define STATE_REPORT_REACHABLE(rep, state) ((((rep)->reachable[(state) >> 6] >> ((state) & 63)) & 1) != 0)
+
+/**
+ * @brief 校验状态表
+ * 
+ * @param me 指向已构造的状态表对象的指针
+ * @param initState 初始处理函数进入的状态
+ * @param decls 自定义处理函数的状态转换声明，可以为NULL
+ * @param declNum 声明个数
+ * @param rep 输出参数，校验结果
+ * @return true 校验通过（rep->trusted），false 存在越界目标或空指针单元
+ */
+bool StateTableVerify(const StateTable *me, uint8_t initState, const StateTargetDecl *decls, uint16_t declNum,
+                      StateTableReport *rep);
+
+/**
+ * @brief 生成修剪后的函数状态表
+ * 
+ * 空指针单元和不可达状态中的单元替换为 StateTableEmpty，
+ * 末尾的不可达状态被去掉，状态编号不变
+ * 
+ * @param me 指向使用函数表构造的状态表对象的指针
+ * @param rep StateTableVerify 的结果
+ * @param out 输出的状态表，长度至少为 rep->prunedStateNum * signalNum
+ */
+void StateTablePruneFunctions(const StateTable *me, const StateTableReport *rep, Tran *out);
+
+/**
+ * @brief 生成修剪后的单元状态表
+ * 
+ * 不可达状态中的单元替换为 STATE_CELL_EMPTY，末尾的不可达状态被去掉，状态编号不变
+ * 
+ * @param me 指向使用单元表构造的状态表对象的指针
+ * @param rep StateTableVerify 的结果
+ * @param out 输出的单元数组，长度至少为 rep->prunedStateNum * signalNum
+ */
+void StateTablePruneCells(const StateTable *me, const StateTableReport *rep, StateCell *out);
+
+/**
+ * @brief 打印校验结果
+ * 
+ * @param rep 校验结果
+ * @param name 状态表名称
+ */
+void StateTableReportPrint(const StateTableReport *rep, const char *name);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !STATETBL_VERIFY_H
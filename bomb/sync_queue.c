@@ -7,7 +7,49 @@
  */
 
 #include "sync_queue.h"
+#include "timespec_util.h"
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+/**
+ * @brief 在锁内修改元素数量
+ * 
+ * 元素数量会在锁外被读取作为提示（忙等、准入控制），所以写入也用原子操作，
+ * 锁内的读取只与同样持锁的写入竞争，保持普通读取
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param size 新的元素数量
+ */
+static inline void QueueSetSize(SyncQueue *me, uint32_t size)
+{
+    __atomic_store_n(&me->currentSize, size, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 队列为空时忙等，直到有元素、超过忙等时间或到达截止时间
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param deadline CLOCK_MONOTONIC 上的截止时间，NULL 表示没有截止时间
+ */
+static void QueueSpin(SyncQueue *me, const struct timespec *deadline)
+{
+    if (me->spinNs == 0) {
+        return;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    struct timespec end = now;
+    TimespecAddNs(&end, me->spinNs);
+    if (deadline != NULL && TimespecDiffNs(deadline, &end) < 0) {
+        end = *deadline;
+    }
+    // 不加锁读取元素数量，只作为提示，真正出队时仍在锁内检查
+    while (__atomic_load_n(&me->currentSize, __ATOMIC_RELAXED) == 0 && TimespecDiffNs(&end, &now) > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+}
 
 /**
  * @brief 初始化同步队列
@@ -33,8 +75,128 @@ void QueueCtor(SyncQueue *me, void **buffer, uint32_t maxSize)
     me->currentSize = 0;
     // 初始化互斥锁
     me->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
-    // 初始化条件变量
-    me->cond = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    // 初始化条件变量，超时等待使用单调时钟，不受系统时间调整影响
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    me->clockId = CLOCK_REALTIME;
+#ifndef _WIN32
+    if (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0) {
+        me->clockId = CLOCK_MONOTONIC;
+    }
+#endif // !_WIN32
+    pthread_cond_init(&me->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    // 默认不忙等
+    me->spinNs = 0;
+    // 默认不合并
+    me->keyOf = NULL;
+    me->policies = NULL;
+    me->keyNum = 0;
+    me->merge = NULL;
+    me->keySeqs = NULL;
+    me->enqueued = 0;
+    me->coalesced = 0;
+}
+
+/**
+ * @brief 设置入队合并策略
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param keyOf 合并键函数
+ * @param policies 每个键的合并策略数组
+ * @param keyNum 策略数组长度
+ * @param merge 合并函数
+ * @param keySeqs 键索引数组
+ */
+void QueueSetCoalesce(SyncQueue *me, QueueKeyOf keyOf, const uint8_t *policies, uint32_t keyNum, QueueMerge merge,
+                      uint64_t *keySeqs)
+{
+    pthread_mutex_lock(&me->mutex);
+    me->keyOf = keyOf;
+    me->policies = policies;
+    me->keyNum = keyNum;
+    me->merge = merge;
+    // 设置之前已在队列中的元素不在索引中，REPLACE/DROP_DUP 不会合并到它们
+    if (keySeqs != NULL) {
+        memset(keySeqs, 0, keyNum * sizeof(keySeqs[0]));
+    }
+    me->keySeqs = keySeqs;
+    pthread_mutex_unlock(&me->mutex);
+}
+
+/**
+ * @brief 元素的合并键（调用者持有锁）
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param item 元素指针
+ * @return 合并键，-1 表示不参与合并
+ */
+static inline int QueueKey(SyncQueue *me, const void *item)
+{
+    if (me->keyOf == NULL) {
+        return -1;
+    }
+    int key = me->keyOf(item);
+    return key >= 0 && (uint32_t)key < me->keyNum ? key : -1;
+}
+
+/**
+ * @brief 元素放入队尾并登记到键索引（调用者持有锁，队列未满）
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param item 元素指针
+ * @param key 元素的合并键，-1 表示不参与合并
+ */
+static inline void QueuePut(SyncQueue *me, void *item, int key)
+{
+    me->buffer[me->tail] = item;
+    me->tail = (me->tail + 1) % me->maxSize;
+    QueueSetSize(me, me->currentSize + 1);
+    me->enqueued++;
+    if (key >= 0 && me->keySeqs != NULL) {
+        me->keySeqs[key] = me->enqueued;
+    }
+}
+
+/**
+ * @brief 尝试把元素合并到队列中已有的元素（调用者持有锁）
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param item 要入队的元素指针
+ * @param key 元素的合并键，-1 表示不参与合并
+ * @return true 已合并，不需要再入队
+ */
+static bool QueueCoalesce(SyncQueue *me, void *item, int key)
+{
+    if (key < 0 || me->currentSize == 0) {
+        return false;
+    }
+
+    uint8_t policy = me->policies[key];
+    if (policy == QUEUE_COALESCE_MERGE) {
+        // 只和队尾合并，不改变与其他元素的先后顺序
+        uint32_t last = (me->tail + me->maxSize - 1) % me->maxSize;
+        if (me->merge == NULL || me->keyOf(me->buffer[last]) != key) {
+            return false;
+        }
+        me->buffer[last] = me->merge(me->buffer[last], item);
+        me->coalesced++;
+        return true;
+    }
+    if ((policy == QUEUE_COALESCE_REPLACE || policy == QUEUE_COALESCE_DROP_DUP) && me->keySeqs != NULL) {
+        // 同键最近入队的元素距队尾的距离（1 为队尾），超过队列长度说明已经出队
+        uint64_t seq = me->keySeqs[key];
+        uint64_t back = me->enqueued - seq + 1;
+        if (seq == 0 || back > me->currentSize) {
+            return false;
+        }
+        if (policy == QUEUE_COALESCE_REPLACE) {
+            me->buffer[(me->tail + me->maxSize - (uint32_t)back) % me->maxSize] = item;
+        }
+        me->coalesced++;
+        return true;
+    }
+    return false;
 }
 
 /**
@@ -47,6 +209,19 @@ void QueueCtor(SyncQueue *me, void **buffer, uint32_t maxSize)
  * @return 0 成功入队，-1 队列已满
  */
 int QueueEnqueue(SyncQueue *me, void *item)
+{
+    return QueueEnqueueCoalesce(me, item, false) < 0 ? -1 : 0;
+}
+
+/**
+ * @brief 入队并返回是否被合并
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param item 要入队的元素指针
+ * @param coalesceOnly 只尝试合并
+ * @return 1 已合并，0 已入队，-1 队列已满或没有可合并的元素
+ */
+int QueueEnqueueCoalesce(SyncQueue *me, void *item, bool coalesceOnly)
 {
     bool isNotify = false;
     // 加锁保护临界区
@@ -57,19 +232,22 @@ int QueueEnqueue(SyncQueue *me, void *item)
         isNotify = true;
     }
 
-    // 检查队列是否已满
-    if (me->currentSize == me->maxSize) {
+    // 先尝试合并，合并成功时队列长度不变，不需要通知
+    int key = QueueKey(me, item);
+    if (QueueCoalesce(me, item, key)) {
+        pthread_mutex_unlock(&me->mutex);
+        return 1;
+    }
+
+    // 只合并时不入队；否则检查队列是否已满
+    if (coalesceOnly || me->currentSize == me->maxSize) {
         // 解锁并返回错误
         pthread_mutex_unlock(&me->mutex);
         return -1; // Queue full
     }
     
-    // 将元素放入队列尾部
-    me->buffer[me->tail] = item;
-    // 更新尾指针（循环队列）
-    me->tail = (me->tail + 1) % me->maxSize;
-    // 增加当前队列大小
-    me->currentSize++;
+    // 将元素放入队列尾部，更新尾指针、队列大小和键索引
+    QueuePut(me, item, key);
     
     // 如果之前队列为空，唤醒等待的线程
     if (isNotify) {
@@ -81,6 +259,39 @@ int QueueEnqueue(SyncQueue *me, void *item)
     return 0; // Success
 }
 
+/**
+ * @brief 批量入队操作
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param items 要入队的元素指针数组
+ * @param n 元素个数
+ * @return 已入队（或合并）的元素数
+ */
+uint32_t QueueEnqueueBatch(SyncQueue *me, void *const *items, uint32_t n)
+{
+    uint32_t done = 0;
+    pthread_mutex_lock(&me->mutex);
+    bool isNotify = me->currentSize == 0;
+
+    for (; done < n; done++) {
+        int key = QueueKey(me, items[done]);
+        if (QueueCoalesce(me, items[done], key)) {
+            continue;
+        }
+        if (me->currentSize == me->maxSize) {
+            break;
+        }
+        QueuePut(me, items[done], key);
+    }
+
+    // 整批只通知一次
+    if (isNotify && me->currentSize > 0) {
+        pthread_cond_signal(&me->cond);
+    }
+    pthread_mutex_unlock(&me->mutex);
+    return done;
+}
+
 /**
  * @brief 阻塞式出队操作
  * 
@@ -91,6 +302,8 @@ int QueueEnqueue(SyncQueue *me, void *item)
  */
 void *QueueDequeueForever(SyncQueue *me)
 {
+    // 先忙等一段时间
+    QueueSpin(me, NULL);
     // 加锁保护临界区
     pthread_mutex_lock(&me->mutex);
     
@@ -104,7 +317,7 @@ void *QueueDequeueForever(SyncQueue *me)
     // 更新头指针（循环队列）
     me->head = (me->head + 1) % me->maxSize;
     // 减少当前队列大小
-    me->currentSize--;
+    QueueSetSize(me, me->currentSize - 1);
     
     // 解锁
     pthread_mutex_unlock(&me->mutex);
@@ -123,19 +336,42 @@ void *QueueDequeueForever(SyncQueue *me)
  * @return 取出的元素指针，超时或失败时返回NULL
  */
 void *QueueDequeueWithTimeout(SyncQueue *me, uint32_t timeoutMs, bool *isTimeout)
+{
+    // 获取当前单调时钟时间并计算截止时间
+    struct timespec deadline = {0};
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    TimespecAddNs(&deadline, (int64_t)timeoutMs * 1000000);
+    return QueueDequeueUntil(me, &deadline, isTimeout);
+}
+
+/**
+ * @brief 等待到绝对截止时间的出队操作
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param deadline CLOCK_MONOTONIC 上的绝对截止时间
+ * @param isTimeout 输出参数，标识是否超时
+ * @return 取出的元素指针，超时或失败时返回NULL
+ */
+void *QueueDequeueUntil(SyncQueue *me, const struct timespec *deadline, bool *isTimeout)
 {
     int ret = 0;
-    struct timespec ts = {0};
     void *item = NULL;
+    struct timespec ts = *deadline;
+
+    // 条件变量不支持单调时钟时，换算成系统时间上的截止时间
+    if (me->clockId != CLOCK_MONOTONIC) {
+        struct timespec mono = {0};
+        clock_gettime(CLOCK_MONOTONIC, &mono);
+        clock_gettime(me->clockId, &ts);
+        TimespecAddNs(&ts, TimespecDiffNs(deadline, &mono));
+    }
+
+    // 先忙等一段时间
+    QueueSpin(me, deadline);
 
     // 加锁保护临界区
     pthread_mutex_lock(&me->mutex);
     
-    // 获取当前时间并计算超时时间点
-    clock_gettime(CLOCK_REALTIME, &ts);
-    ts.tv_sec += timeoutMs / 1000;
-    ts.tv_nsec += (timeoutMs % 1000) * 1000000;
-    
     // 如果队列为空，则等待直到有元素或超时
     while (me->currentSize == 0) {
         ret = pthread_cond_timedwait(&me->cond, &me->mutex, &ts);
@@ -149,6 +385,7 @@ void *QueueDequeueWithTimeout(SyncQueue *me, uint32_t timeoutMs, bool *isTimeout
         } else {
             // 其他错误情况
             printf("pthread_cond_timedwait ret[%d]\n", ret);
+            break;
         }
     }
 
@@ -156,7 +393,7 @@ void *QueueDequeueWithTimeout(SyncQueue *me, uint32_t timeoutMs, bool *isTimeout
     if (ret == 0) {
         item = me->buffer[me->head];
         me->head = (me->head + 1) % me->maxSize;
-        me->currentSize--;
+        QueueSetSize(me, me->currentSize - 1);
     }
     
     // 解锁
@@ -165,6 +402,56 @@ void *QueueDequeueWithTimeout(SyncQueue *me, uint32_t timeoutMs, bool *isTimeout
     return item;
 }
 
+/**
+ * @brief 设置出队忙等时间
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param spinNs 忙等时间（纳秒）
+ */
+void QueueSetSpin(SyncQueue *me, uint32_t spinNs)
+{
+    me->spinNs = spinNs;
+}
+
+/**
+ * @brief 非阻塞出队操作
+ * 
+ * 队列不为空时取出头部元素，队列为空时立即返回，不等待
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param item 输出参数，取出的元素指针
+ * @return true 成功取出元素，false 队列为空
+ */
+bool QueueTryDequeue(SyncQueue *me, void **item)
+{
+    bool ret = false;
+    // 加锁保护临界区
+    pthread_mutex_lock(&me->mutex);
+    if (me->currentSize != 0) {
+        *item = me->buffer[me->head];
+        me->head = (me->head + 1) % me->maxSize;
+        QueueSetSize(me, me->currentSize - 1);
+        ret = true;
+    }
+    // 解锁
+    pthread_mutex_unlock(&me->mutex);
+    return ret;
+}
+
+/**
+ * @brief 获取被合并的元素数
+ * 
+ * @param me 指向同步队列对象的指针
+ * @return 被合并的元素数
+ */
+uint32_t QueueCoalescedCount(SyncQueue *me)
+{
+    pthread_mutex_lock(&me->mutex);
+    uint32_t count = me->coalesced;
+    pthread_mutex_unlock(&me->mutex);
+    return count;
+}
+
 /**
  * @brief 检查队列是否为空
  * 
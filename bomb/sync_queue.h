@@ -12,11 +12,34 @@
 #include <stdint.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <time.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
 
+/**
+ * @brief 入队合并策略
+ * 
+ * 消费者处理不过来时，幂等或计数类的事件可以在入队时合并，减少队列占用和分发次数
+ */
+typedef enum {
+    QUEUE_COALESCE_NONE,        ///< 不合并
+    QUEUE_COALESCE_REPLACE,     ///< 队列中已有同键元素时用新元素替换它（保留原位置），按键索引查找，O(1)
+    QUEUE_COALESCE_MERGE,       ///< 队尾是同键元素时调用合并函数合成一个元素（如累加次数）
+    QUEUE_COALESCE_DROP_DUP,    ///< 队列中已有同键元素时丢弃新元素，按键索引查找，O(1)
+} QueueCoalescePolicy;
+
+/**
+ * @brief 取元素的合并键，返回-1表示该元素不参与合并
+ */
+typedef int (*QueueKeyOf)(const void *item);
+
+/**
+ * @brief 合并两个同键元素，返回放回队列的元素
+ */
+typedef void *(*QueueMerge)(void *queued, void *item);
+
 /**
  * @brief 同步队列结构体
  * 
@@ -27,9 +50,18 @@ typedef struct {
     uint32_t head;              ///< 队列头部索引
     uint32_t tail;              ///< 队列尾部索引
     uint32_t maxSize;           ///< 队列最大容量
-    uint32_t currentSize;       ///< 队列当前元素数量
+    uint32_t currentSize;       ///< 队列当前元素数量（锁内修改，原子写入，可以在锁外原子读取作为提示）
     pthread_mutex_t mutex;      ///< 互斥锁，保护队列访问
     pthread_cond_t cond;        ///< 条件变量，用于线程间同步
+    clockid_t clockId;          ///< 条件变量等待使用的时钟，优先使用 CLOCK_MONOTONIC
+    uint32_t spinNs;            ///< 出队时先忙等的时间（纳秒），0 表示直接阻塞
+    QueueKeyOf keyOf;           ///< 合并键函数，NULL 表示不合并
+    const uint8_t *policies;    ///< 每个键的合并策略（QueueCoalescePolicy）
+    uint32_t keyNum;            ///< 策略数组长度
+    QueueMerge merge;           ///< 合并函数，QUEUE_COALESCE_MERGE 使用
+    uint64_t *keySeqs;          ///< 每个键最近一次入队元素的入队序号，0 表示没有，NULL 表示不索引
+    uint64_t enqueued;          ///< 累计入队元素数（入队序号）
+    uint32_t coalesced;         ///< 被合并（替换、累加或丢弃）的元素数
 } SyncQueue;
 
 /**
@@ -43,10 +75,29 @@ typedef struct {
  */
 void QueueCtor(SyncQueue *me, void **buffer, uint32_t maxSize);
 
+/**
+ * @brief 设置入队合并策略
+ * 
+ * 合并在检查队列是否已满之前进行，队列满时可以合并的元素仍然会被接受。
+ * REPLACE/DROP_DUP 通过 keySeqs 记录每个键最近入队元素的位置，入队时不扫描队列；
+ * 同键元素按先进先出出队，最近入队的那个已经出队说明队列中没有同键元素
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param keyOf 合并键函数，NULL 表示关闭合并
+ * @param policies 每个键的合并策略数组，按键索引
+ * @param keyNum 策略数组长度，超出范围的键不合并
+ * @param merge 合并函数，没有键使用 QUEUE_COALESCE_MERGE 时可以为NULL
+ * @param keySeqs 键索引数组，长度为 keyNum，由调用者提供并在队列使用期间保持有效；
+ *                没有键使用 REPLACE/DROP_DUP 时可以为NULL
+ */
+void QueueSetCoalesce(SyncQueue *me, QueueKeyOf keyOf, const uint8_t *policies, uint32_t keyNum, QueueMerge merge,
+                      uint64_t *keySeqs);
+
 /**
  * @brief 元素入队操作
  * 
- * 将指定元素加入队列尾部，如果队列已满则返回错误
+ * 将指定元素加入队列尾部，如果队列已满则返回错误；
+ * 设置了合并策略时元素可能被合并到已有元素中，同样视为成功
  * 
  * @param me 指向同步队列对象的指针
  * @param item 要入队的元素指针
@@ -54,6 +105,32 @@ void QueueCtor(SyncQueue *me, void **buffer, uint32_t maxSize);
  */
 int QueueEnqueue(SyncQueue *me, void *item);
 
+/**
+ * @brief 入队并返回是否被合并
+ * 
+ * 与 QueueEnqueue 相同，但区分合并和实际入队；coalesceOnly 为 true 时只尝试合并，
+ * 没有可合并的元素时不入队，用于准入控制的合并动作
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param item 要入队的元素指针
+ * @param coalesceOnly 只尝试合并
+ * @return 1 已合并到队列中的元素，0 已入队，-1 队列已满或（coalesceOnly 时）没有可合并的元素
+ */
+int QueueEnqueueCoalesce(SyncQueue *me, void *item, bool coalesceOnly);
+
+/**
+ * @brief 批量入队操作
+ * 
+ * 一次加锁按顺序入队多个元素，合并策略对每个元素同样生效；队列满时停止，
+ * 返回已经入队（或合并）的元素数，调用者可以稍后从该位置继续
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param items 要入队的元素指针数组
+ * @param n 元素个数
+ * @return 已入队（或合并）的元素数
+ */
+uint32_t QueueEnqueueBatch(SyncQueue *me, void *const *items, uint32_t n);
+
 /**
  * @brief 阻塞式出队操作
  * 
@@ -77,6 +154,49 @@ void *QueueDequeueForever(SyncQueue *me);
  */
 void *QueueDequeueWithTimeout(SyncQueue *me, uint32_t timeoutMs, bool *isTimeout);
 
+/**
+ * @brief 等待到绝对截止时间的出队操作
+ * 
+ * 截止时间基于 CLOCK_MONOTONIC，周期性的等待可以用上一次截止时间加周期得到下一次截止时间，
+ * 不会因为处理时间和唤醒延迟而累积漂移，也不受系统时间调整影响
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param deadline CLOCK_MONOTONIC 上的绝对截止时间
+ * @param isTimeout 输出参数，标识是否超时
+ * @return 取出的元素指针，超时或失败时返回NULL
+ */
+void *QueueDequeueUntil(SyncQueue *me, const struct timespec *deadline, bool *isTimeout);
+
+/**
+ * @brief 设置出队忙等时间
+ * 
+ * 队列为空时出队操作先在用户态忙等指定时间，期间有元素入队可以立即取走，
+ * 省去一次线程休眠和唤醒；超过忙等时间后再阻塞在条件变量上
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param spinNs 忙等时间（纳秒），0 表示直接阻塞
+ */
+void QueueSetSpin(SyncQueue *me, uint32_t spinNs);
+
+/**
+ * @brief 非阻塞出队操作
+ * 
+ * 队列不为空时取出头部元素，队列为空时立即返回，不等待
+ * 
+ * @param me 指向同步队列对象的指针
+ * @param item 输出参数，取出的元素指针
+ * @return true 成功取出元素，false 队列为空
+ */
+bool QueueTryDequeue(SyncQueue *me, void **item);
+
+/**
+ * @brief 获取被合并的元素数
+ * 
+ * @param me 指向同步队列对象的指针
+ * @return 被合并（替换、累加或丢弃）的元素数
+ */
+uint32_t QueueCoalescedCount(SyncQueue *me);
+
 /**
  * @brief 检查队列是否为空
  * 
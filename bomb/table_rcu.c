@@ -0,0 +1,241 @@
+/**
+ * @file table_rcu.c
+ * @brief 状态表热替换实现文件
+ * 
+ * 分发线程进入分发时记录当前纪元，退出时清零；发布者替换版本指针后推进纪元，
+ * 旧版本记下替换时的纪元。一个旧版本在以下条件都满足时可以回收：
+ * 它是最旧的未回收版本，没有实例还停留在它上面，
+ * 并且所有分发线程都不在分发中或者进入分发时的纪元不早于它的替换纪元。
+ */
+
+#include "table_rcu.h"
+#include <stddef.h>
+
+/**
+ * @brief 实例当前的状态表是否属于该版本
+ */
+static inline bool VersionOwns(const StateTableVersion *v, const StateTable *fsm)
+{
+    return v->stateTable == fsm->stateTable && v->cellTable == fsm->cellTable;
+}
+
+/**
+ * @brief 把实例的状态表切换到指定版本（不改变当前状态）
+ */
+static void VersionApply(const StateTableVersion *v, StateTable *fsm)
+{
+    fsm->stateTable = v->stateTable;
+    fsm->cellTable = v->cellTable;
+    fsm->stateNum = v->stateNum;
+    fsm->signalNum = v->signalNum;
+    StateTableSetTickRows(fsm, v->tickRows);
+}
+
+/**
+ * @brief 初始化版本发布点
+ * 
+ * @param me 指向发布点对象的指针
+ * @param first 第一个版本
+ * @param reclaim 回收函数
+ * @param arg 回收函数参数
+ */
+void TableRcuCtor(TableRcu *me, StateTableVersion *first, TableRcuReclaim reclaim, void *arg)
+{
+    first->prev = NULL;
+    first->next = NULL;
+    first->stateMap = NULL;
+    first->retireEpoch = 0;
+    first->users = 0;
+    me->current = first;
+    me->oldest = first;
+    me->epoch = 1;
+    for (int i = 0; i < TABLE_RCU_READERS_MAX; i++) {
+        me->readerEpoch[i] = 0;
+    }
+    me->readerNum = 0;
+    me->writer = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    me->reclaim = reclaim;
+    me->reclaimArg = arg;
+}
+
+/**
+ * @brief 注册分发线程
+ * 
+ * @param me 指向发布点对象的指针
+ * @return 分发线程编号，-1 超过上限
+ */
+int TableRcuReaderRegister(TableRcu *me)
+{
+    uint32_t id = __atomic_fetch_add(&me->readerNum, 1, __ATOMIC_RELAXED);
+    if (id >= TABLE_RCU_READERS_MAX) {
+        __atomic_fetch_sub(&me->readerNum, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+    return (int)id;
+}
+
+/**
+ * @brief 用当前版本构造并初始化状态机实例
+ * 
+ * @param me 指向发布点对象的指针
+ * @param fsm 状态机实例
+ * @param initState 初始状态处理函数
+ */
+void TableRcuBind(TableRcu *me, StateTable *fsm, Initial initState)
+{
+    // 持有发布锁，当前版本在绑定期间不会被替换和回收
+    pthread_mutex_lock(&me->writer);
+    StateTableVersion *v = me->current;
+    StateTableCtor(fsm, v->stateTable, v->stateNum, v->signalNum, initState);
+    VersionApply(v, fsm);
+    __atomic_fetch_add(&v->users, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&me->writer);
+    StateTableInit(fsm);
+}
+
+/**
+ * @brief 实例不再使用时解除绑定
+ * 
+ * @param me 指向发布点对象的指针
+ * @param fsm 状态机实例
+ */
+void TableRcuUnbind(TableRcu *me, StateTable *fsm)
+{
+    pthread_mutex_lock(&me->writer);
+    for (StateTableVersion *v = me->current; v != NULL; v = v->prev) {
+        if (VersionOwns(v, fsm)) {
+            __atomic_fetch_sub(&v->users, 1, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&me->writer);
+}
+
+/**
+ * @brief 发布新版本
+ * 
+ * @param me 指向发布点对象的指针
+ * @param version 新版本
+ * @return 0 成功，-1 状态表指针重复
+ */
+int TableRcuPublish(TableRcu *me, StateTableVersion *version)
+{
+    pthread_mutex_lock(&me->writer);
+    for (StateTableVersion *v = me->current; v != NULL; v = v->prev) {
+        if (v->stateTable == version->stateTable && v->cellTable == version->cellTable) {
+            pthread_mutex_unlock(&me->writer);
+            return -1;
+        }
+    }
+
+    StateTableVersion *old = me->current;
+    version->prev = old;
+    version->next = NULL;
+    version->retireEpoch = 0;
+    version->users = 0;
+    // 先链入新版本，迁移时才能从旧版本走到新版本
+    __atomic_store_n(&old->next, version, __ATOMIC_RELEASE);
+    __atomic_store_n(&me->current, version, __ATOMIC_SEQ_CST);
+    old->retireEpoch = __atomic_add_fetch(&me->epoch, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&me->writer);
+    return 0;
+}
+
+/**
+ * @brief 所有分发线程是否都已越过指定纪元
+ */
+static bool ReadersPast(TableRcu *me, uint64_t epoch)
+{
+    uint32_t n = __atomic_load_n(&me->readerNum, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < n && i < TABLE_RCU_READERS_MAX; i++) {
+        uint64_t e = __atomic_load_n(&me->readerEpoch[i], __ATOMIC_SEQ_CST);
+        if (e != 0 && e < epoch) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 回收已经不可能被引用的旧版本
+ * 
+ * @param me 指向发布点对象的指针
+ * @return 本次回收的版本数
+ */
+uint32_t TableRcuCollect(TableRcu *me)
+{
+    uint32_t count = 0;
+    pthread_mutex_lock(&me->writer);
+    // 只从最旧的一端回收，保证未回收的版本始终连成一条链
+    while (me->oldest != me->current) {
+        StateTableVersion *v = me->oldest;
+        if (__atomic_load_n(&v->users, __ATOMIC_ACQUIRE) != 0 || !ReadersPast(me, v->retireEpoch)) {
+            break;
+        }
+        me->oldest = v->next;
+        __atomic_store_n(&me->oldest->prev, NULL, __ATOMIC_RELAXED);
+        if (me->reclaim != NULL) {
+            me->reclaim(v, me->reclaimArg);
+        }
+        count++;
+    }
+    pthread_mutex_unlock(&me->writer);
+    return count;
+}
+
+/**
+ * @brief 把实例迁移到指定版本
+ * 
+ * 从目标版本向旧版本查找实例所在的版本，再沿新版本方向逐个应用状态映射
+ * 
+ * @param cur 目标版本
+ * @param fsm 状态机实例
+ */
+static void Migrate(StateTableVersion *cur, StateTable *fsm)
+{
+    StateTableVersion *from = cur;
+    while (from != NULL && !VersionOwns(from, fsm)) {
+        from = __atomic_load_n(&from->prev, __ATOMIC_ACQUIRE);
+    }
+    if (from == NULL) {
+        // 实例不属于这个发布点，保持原样
+        return;
+    }
+
+    uint8_t state = fsm->curState;
+    for (StateTableVersion *v = from; v != cur;) {
+        v = __atomic_load_n(&v->next, __ATOMIC_ACQUIRE);
+        if (v->stateMap != NULL) {
+            state = v->stateMap[state];
+        }
+    }
+
+    __atomic_fetch_add(&cur->users, 1, __ATOMIC_RELAXED);
+    VersionApply(cur, fsm);
+    fsm->curState = state;
+    __atomic_fetch_sub(&from->users, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 分发事件
+ * 
+ * @param me 指向发布点对象的指针
+ * @param reader 调用线程的分发线程编号
+ * @param fsm 状态机实例
+ * @param e 事件
+ */
+void TableRcuDispatch(TableRcu *me, int reader, StateTable *fsm, const Event *e)
+{
+    // 进入读侧：记录纪元后再读取当前版本
+    uint64_t epoch = __atomic_load_n(&me->epoch, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&me->readerEpoch[reader], epoch, __ATOMIC_SEQ_CST);
+
+    StateTableVersion *cur = __atomic_load_n(&me->current, __ATOMIC_SEQ_CST);
+    if (!VersionOwns(cur, fsm)) {
+        Migrate(cur, fsm);
+    }
+    StateTableDispatch(fsm, e);
+
+    // 退出读侧
+    __atomic_store_n(&me->readerEpoch[reader], 0, __ATOMIC_RELEASE);
+}
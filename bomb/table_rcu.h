@@ -0,0 +1,131 @@
+/**
+ * @file table_rcu.h
+ * @brief 状态表热替换头文件
+ * 
+ * 同一类型的所有状态机实例共享一个 TableRcu：发布新版本状态表只是一次原子指针替换，
+ * 分发线程在下一个运行至完成边界（下一次分发之前）发现版本变化，
+ * 按状态迁移表把实例的当前状态换算到新版本后继续分发，分发路径上不加锁。
+ * 旧版本在没有实例再引用它、并且所有分发线程都越过了它被替换时的纪元之后才回收。
+ */
+
+#ifndef TABLE_RCU_H
+#define TABLE_RCU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "statetbl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define TABLE_RCU_READERS_MAX 16    ///< 最多分发线程数
+
+/**
+ * @brief 状态表版本
+ * 
+ * 不同版本必须使用不同的状态表指针（stateTable 或 cellTable），
+ * 迁移时按实例当前的状态表指针找到它所在的版本
+ */
+typedef struct StateTableVersionTag {
+    Tran *stateTable;           ///< 状态转换函数表，与 cellTable 二选一
+    const StateCellTable *cellTable; ///< 单元格式的状态表
+    uint8_t stateNum;           ///< 状态数量
+    uint8_t signalNum;          ///< 信号数量
+    const bool *tickRows;       ///< 滴答订阅，NULL 表示所有状态都需要
+    const uint8_t *stateMap;    ///< 上一版本状态号到本版本状态号的映射，NULL 表示不变
+    struct StateTableVersionTag *prev;  ///< 上一（更旧）版本
+    struct StateTableVersionTag *next;  ///< 下一（更新）版本
+    uint64_t retireEpoch;       ///< 被替换时的纪元
+    uint32_t users;             ///< 仍在使用该版本的实例数（原子访问）
+} StateTableVersion;
+
+/**
+ * @brief 旧版本回收函数，在版本不再被引用后调用
+ */
+typedef void (*TableRcuReclaim)(StateTableVersion *version, void *arg);
+
+/**
+ * @brief 一个状态机类型的版本发布点
+ */
+typedef struct TableRcuTag {
+    StateTableVersion *current; ///< 当前版本（原子访问）
+    StateTableVersion *oldest;  ///< 最旧的未回收版本
+    uint64_t epoch;             ///< 全局纪元（原子访问）
+    uint64_t readerEpoch[TABLE_RCU_READERS_MAX]; ///< 各分发线程进入分发时的纪元，0 表示不在分发中
+    uint32_t readerNum;         ///< 已注册的分发线程数
+    pthread_mutex_t writer;     ///< 发布/回收互斥锁，不在分发路径上
+    TableRcuReclaim reclaim;    ///< 回收函数
+    void *reclaimArg;           ///< 回收函数参数
+} TableRcu;
+
+/**
+ * @brief 初始化版本发布点
+ * 
+ * @param me 指向发布点对象的指针
+ * @param first 第一个版本，stateMap 被忽略
+ * @param reclaim 回收函数，可以为NULL
+ * @param arg 回收函数参数
+ */
+void TableRcuCtor(TableRcu *me, StateTableVersion *first, TableRcuReclaim reclaim, void *arg);
+
+/**
+ * @brief 注册分发线程
+ * 
+ * @param me 指向发布点对象的指针
+ * @return 分发线程编号，-1 超过 TABLE_RCU_READERS_MAX
+ */
+int TableRcuReaderRegister(TableRcu *me);
+
+/**
+ * @brief 用当前版本构造并初始化状态机实例
+ * 
+ * @param me 指向发布点对象的指针
+ * @param fsm 状态机实例
+ * @param initState 初始状态处理函数
+ */
+void TableRcuBind(TableRcu *me, StateTable *fsm, Initial initState);
+
+/**
+ * @brief 实例不再使用时解除绑定
+ * 
+ * @param me 指向发布点对象的指针
+ * @param fsm 状态机实例
+ */
+void TableRcuUnbind(TableRcu *me, StateTable *fsm);
+
+/**
+ * @brief 发布新版本
+ * 
+ * 只替换版本指针，实例在下一次分发时迁移
+ * 
+ * @param me 指向发布点对象的指针
+ * @param version 新版本，stateMap 长度为上一版本的 stateNum
+ * @return 0 成功，-1 新版本的状态表指针与未回收的版本重复
+ */
+int TableRcuPublish(TableRcu *me, StateTableVersion *version);
+
+/**
+ * @brief 回收已经不可能被引用的旧版本
+ * 
+ * @param me 指向发布点对象的指针
+ * @return 本次回收的版本数
+ */
+uint32_t TableRcuCollect(TableRcu *me);
+
+/**
+ * @brief 分发事件，必要时先把实例迁移到当前版本
+ * 
+ * @param me 指向发布点对象的指针
+ * @param reader 调用线程的分发线程编号
+ * @param fsm 状态机实例
+ * @param e 事件
+ */
+void TableRcuDispatch(TableRcu *me, int reader, StateTable *fsm, const Event *e);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !TABLE_RCU_H
@@ -0,0 +1,104 @@
+/**
+ * @file tblremap.c
+ * @brief 状态表重编号工具
+ * 
+ * 读取运行时保存的单元命中计数文件，计算热点优先的状态/信号编号，
+ * 输出重排后的状态表和新旧编号映射数组（C源码）。
+ * 命中计数之后带有单元描述（StateTableCellsSave，例如 bomb2.prof）时输出重排后的
+ * 单元表和滴答订阅数组，否则输出函数指针表。
+ * 
+ * 用法：tblremap <profile> [name] [cellNames]
+ *   profile    StateTableProfileSave 写出的命中计数文件
+ *   name       生成的数组名前缀，默认 "remap"
+ *   cellNames  可选，按原状态表顺序列出的处理函数名（空白分隔），只用于函数指针表；
+ *              单元表中的自定义处理函数按id引用，不需要函数名
+ */
+
+#include "statetbl_layout.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TBLREMAP_MAX_CELLS (UINT8_MAX * UINT8_MAX)  ///< 最大单元数
+#define TBLREMAP_NAME_LEN 64                         ///< 处理函数名最大长度
+
+/**
+ * @brief 读取处理函数名文件
+ * 
+ * @param path 文件路径
+ * @param cellNum 单元数量
+ * @param names 输出的函数名指针数组
+ * @param storage 函数名存储区
+ * @return 0 成功，-1 失败
+ */
+static int LoadCellNames(const char *path, uint32_t cellNum, const char **names, char (*storage)[TBLREMAP_NAME_LEN])
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < cellNum; i++) {
+        if (fscanf(in, "%63s", storage[i]) != 1) {
+            fclose(in);
+            return -1;
+        }
+        names[i] = storage[i];
+    }
+    fclose(in);
+    return 0;
+}
+
+/**
+ * @brief 主函数
+ * 
+ * @param argc 参数个数
+ * @param argv 参数列表
+ * @return 程序退出码
+ */
+int main(int argc, char *argv[])
+{
+    static uint32_t cellHits[TBLREMAP_MAX_CELLS];
+    static const char *names[TBLREMAP_MAX_CELLS];
+    static char storage[TBLREMAP_MAX_CELLS][TBLREMAP_NAME_LEN];
+    static StateCell cells[TBLREMAP_MAX_CELLS];
+    bool tickRows[UINT8_MAX];
+    uint8_t stateMap[UINT8_MAX];
+    uint8_t signalMap[UINT8_MAX];
+    uint8_t stateNum = 0;
+    uint8_t signalNum = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <profile> [name] [cellNames]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "r");
+    if (in == NULL) {
+        fprintf(stderr, "open %s failed\n", argv[1]);
+        return 1;
+    }
+    int ret = StateTableProfileLoad(in, cellHits, TBLREMAP_MAX_CELLS, &stateNum, &signalNum);
+    int cellRet = ret == 0 ? StateTableCellsLoad(in, cells, tickRows, stateNum, signalNum) : 0;
+    fclose(in);
+    if (ret != 0 || cellRet < 0) {
+        fprintf(stderr, "bad profile %s\n", argv[1]);
+        return 1;
+    }
+
+    const char *const *cellNames = NULL;
+    if (argc > 3) {
+        if (LoadCellNames(argv[3], (uint32_t)stateNum * signalNum, names, storage) != 0) {
+            fprintf(stderr, "bad cell names %s\n", argv[3]);
+            return 1;
+        }
+        cellNames = names;
+    }
+
+    StateTableComputeLayout(cellHits, stateNum, signalNum, stateMap, signalMap);
+    const char *name = argc > 2 ? argv[2] : "remap";
+    if (cellRet == 0) {
+        StateTableLayoutEmitCells(stdout, name, stateNum, signalNum, stateMap, signalMap, cells, tickRows);
+    } else {
+        StateTableLayoutEmit(stdout, name, stateNum, signalNum, stateMap, signalMap, cellNames);
+    }
+    return 0;
+}
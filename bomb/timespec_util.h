@@ -0,0 +1,71 @@
+/**
+ * @file timespec_util.h
+ * @brief timespec 运算辅助函数头文件
+ *
+ * 队列的超时等待都要把毫秒/纳秒超时换算成条件变量使用的绝对时间，
+ * 这里的函数供各个队列实现共用；单调时钟纳秒读数也统一由这里提供。
+ */
+
+#ifndef TIMESPEC_UTIL_H
+#define TIMESPEC_UTIL_H
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef NSEC_PER_SEC
+#define NSEC_PER_SEC 1000000000L  ///< 每秒纳秒数
+#endif // !NSEC_PER_SEC
+
+/**
+ * @brief 时间加上纳秒数，并规范化 tv_nsec
+ *
+ * @param ts 时间
+ * @param ns 纳秒数，可以为负
+ */
+static inline void TimespecAddNs(struct timespec *ts, int64_t ns)
+{
+    int64_t nsec = (int64_t)ts->tv_nsec + ns % NSEC_PER_SEC;
+    ts->tv_sec += (time_t)(ns / NSEC_PER_SEC);
+    if (nsec >= NSEC_PER_SEC) {
+        nsec -= NSEC_PER_SEC;
+        ts->tv_sec++;
+    } else if (nsec < 0) {
+        nsec += NSEC_PER_SEC;
+        ts->tv_sec--;
+    }
+    ts->tv_nsec = (long)nsec;
+}
+
+/**
+ * @brief 时间差（纳秒）
+ *
+ * @param a 被减数
+ * @param b 减数
+ * @return a - b（纳秒）
+ */
+static inline int64_t TimespecDiffNs(const struct timespec *a, const struct timespec *b)
+{
+    return (int64_t)(a->tv_sec - b->tv_sec) * NSEC_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+/**
+ * @brief 当前单调时钟（CLOCK_MONOTONIC）时间（纳秒）
+ *
+ * @return 纳秒数
+ */
+static inline uint64_t TimespecNowNs(void)
+{
+    struct timespec ts = {0, 0};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !TIMESPEC_UTIL_H
@@ -0,0 +1,159 @@
+/**
+ * @file vclock.c
+ * @brief 运行循环时钟实现文件
+ * 
+ * 实现真实时间和虚拟时间两种模式下的取事件/滴答逻辑。
+ */
+
+#include "vclock.h"
+#include <time.h>
+
+/**
+ * @brief 读取单调时钟（毫秒）
+ * 
+ * @return 单调时钟时间（毫秒）
+ */
+static uint64_t MonotonicMs(void)
+{
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief 初始化时钟
+ * 
+ * @param me 指向时钟对象的指针
+ * @param simulated true 使用虚拟时间，false 使用真实时间
+ */
+void VClockCtor(VClock *me, bool simulated)
+{
+    me->simulated = simulated;
+    // 虚拟时间从0开始，真实时间从当前单调时钟开始
+    me->nowMs = simulated ? 0 : MonotonicMs();
+    me->deadlineMs = 0;
+    me->idleUntilMs = me->nowMs;
+    me->idleMs = 0;
+}
+
+/**
+ * @brief 取走生产者声明的空闲时长，延长虚拟时间可以推进到的时间
+ * 
+ * @param me 指向时钟对象的指针
+ */
+static void VClockTakeIdle(VClock *me)
+{
+    // 空闲标记经过队列的互斥锁传递，空闲时长的读写不需要更强的内存序
+    uint32_t ms = __atomic_exchange_n(&me->idleMs, 0, __ATOMIC_RELAXED);
+    if (me->idleUntilMs < me->nowMs) {
+        me->idleUntilMs = me->nowMs;
+    }
+    me->idleUntilMs += ms;
+}
+
+/**
+ * @brief 获取当前时间
+ * 
+ * @param me 指向时钟对象的指针
+ * @return 当前时间（毫秒）
+ */
+uint64_t VClockNow(VClock *me)
+{
+    if (!me->simulated) {
+        me->nowMs = MonotonicMs();
+    }
+    return me->nowMs;
+}
+
+/**
+ * @brief 从队列取事件或等待下一个滴答
+ * 
+ * @param me 指向时钟对象的指针
+ * @param queue 事件队列
+ * @param tickMs 滴答间隔（毫秒），0 表示不订阅滴答
+ * @param isTimeout 输出参数，标识是否超时（产生滴答）
+ * @return 取出的元素指针，超时时返回NULL
+ */
+void *VClockDequeue(VClock *me, SyncQueue *queue, uint32_t tickMs, bool *isTimeout)
+{
+    void *item = NULL;
+
+    // 没有订阅滴答：取消截止时间，阻塞等待直到有事件，不产生空闲唤醒
+    if (tickMs == 0) {
+        me->deadlineMs = 0;
+        item = QueueDequeueForever(queue);
+        // 空闲标记只出现在虚拟时间模式：没有滴答要产生，时间直接走完空闲时长
+        while (item == VCLOCK_IDLE) {
+            VClockTakeIdle(me);
+            me->nowMs = me->idleUntilMs;
+            item = QueueDequeueForever(queue);
+        }
+        if (!me->simulated) {
+            me->nowMs = MonotonicMs();
+        }
+        return item;
+    }
+
+    // 真实时间模式：等待到单调时钟上的绝对截止时间
+    if (!me->simulated) {
+        if (me->deadlineMs == 0) {
+            me->deadlineMs = MonotonicMs() + tickMs;
+        }
+        struct timespec deadline = {(time_t)(me->deadlineMs / 1000), (long)(me->deadlineMs % 1000) * 1000000L};
+        item = QueueDequeueUntil(queue, &deadline, isTimeout);
+        me->nowMs = MonotonicMs();
+        if (*isTimeout) {
+            me->deadlineMs += tickMs;
+        }
+        return item;
+    }
+
+    // 虚拟时间模式：首次调用时设置滴答截止时间
+    if (me->deadlineMs == 0) {
+        me->deadlineMs = me->nowMs + tickMs;
+    }
+
+    for (;;) {
+        // 有待处理事件时立即返回，事件处理不消耗虚拟时间
+        if (QueueTryDequeue(queue, &item)) {
+            if (item != VCLOCK_IDLE) {
+                return item;
+            }
+            VClockTakeIdle(me);
+            continue;
+        }
+
+        // 没有事件且截止时间在生产者声明的空闲时间内：时间直接跳到截止时间，产生一次滴答
+        if (me->deadlineMs <= me->idleUntilMs) {
+            me->nowMs = me->deadlineMs;
+            me->deadlineMs += tickMs;
+            *isTimeout = true;
+            return NULL;
+        }
+
+        // 生产者没有声明空闲，队列只是暂时为空：等待事件或下一次 VClockIdle，时间不前进
+        item = QueueDequeueForever(queue);
+        if (item != VCLOCK_IDLE) {
+            return item;
+        }
+        VClockTakeIdle(me);
+    }
+}
+
+/**
+ * @brief 声明生产者空闲，允许虚拟时间推进
+ * 
+ * @param me 指向时钟对象的指针
+ * @param queue 运行循环使用的事件队列
+ * @param ms 空闲时长（毫秒）
+ * @return 0 成功，-1 队列已满
+ */
+int VClockIdle(VClock *me, SyncQueue *queue, uint32_t ms)
+{
+    if (!me->simulated) {
+        return 0;
+    }
+    // 先登记时长再投递标记，运行线程取到标记时一定能看到这次的时长
+    __atomic_fetch_add(&me->idleMs, ms, __ATOMIC_RELAXED);
+    return QueueEnqueue(queue, VCLOCK_IDLE);
+}
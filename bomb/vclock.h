@@ -0,0 +1,104 @@
+/**
+ * @file vclock.h
+ * @brief 运行循环时钟头文件
+ * 
+ * 为各个状态机的运行循环提供统一的取事件/产生滴答接口，
+ * 支持真实时间和虚拟时间两种模式。虚拟时间模式下，时间只在
+ * 场景驱动（生产者）调用 VClockIdle 声明空闲后才推进，推进时直接
+ * 跳到下一个滴答截止时间，不做真实等待，用于快速回归测试和容量仿真。
+ */
+
+#ifndef VCLOCK_H
+#define VCLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sync_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief 默认时钟模式
+ * 
+ * 编译时定义 BOMB_SIM_CLOCK（CMake 选项 -DBOMB_SIM_CLOCK=ON）时，
+ * 各演示程序默认使用虚拟时间
+ */
+#ifdef BOMB_SIM_CLOCK
+#define VCLOCK_DEFAULT_SIMULATED true
+#else
+#define VCLOCK_DEFAULT_SIMULATED false
+#endif // BOMB_SIM_CLOCK
+
+/**
+ * @brief VClockIdle 投递到队列中的空闲标记，由 VClockDequeue 消费，不会返回给调用者
+ */
+#define VCLOCK_IDLE ((void *)(UINTPTR_MAX - 1))
+
+/**
+ * @brief 运行循环时钟结构体
+ */
+typedef struct VClockTag {
+    bool simulated;             ///< true 虚拟时间模式，false 真实时间模式
+    uint64_t nowMs;             ///< 当前时间（毫秒）
+    uint64_t deadlineMs;        ///< 下一个滴答截止时间（毫秒），0 表示未设置
+    uint64_t idleUntilMs;       ///< 虚拟时间可以推进到的时间（毫秒），只由运行线程访问
+    uint32_t idleMs;            ///< 已声明但运行线程尚未取走的空闲时长（毫秒），原子访问
+} VClock;
+
+/**
+ * @brief 初始化时钟
+ * 
+ * @param me 指向时钟对象的指针
+ * @param simulated true 使用虚拟时间，false 使用真实时间
+ */
+void VClockCtor(VClock *me, bool simulated);
+
+/**
+ * @brief 获取当前时间
+ * 
+ * 真实时间模式下返回单调时钟时间，虚拟时间模式下返回已推进到的虚拟时间
+ * 
+ * @param me 指向时钟对象的指针
+ * @return 当前时间（毫秒）
+ */
+uint64_t VClockNow(VClock *me);
+
+/**
+ * @brief 从队列取事件或等待下一个滴答
+ * 
+ * 两种模式都按绝对截止时间产生滴答，截止时间每次加一个滴答间隔，不随事件处理漂移。
+ * 真实时间模式下用 QueueDequeueUntil 等待到截止时间；虚拟时间模式下，
+ * 队列有事件则立即返回该事件（时间不前进）；队列为空时，若截止时间在
+ * VClockIdle 声明的空闲时间内则时间跳到截止时间并返回超时，否则阻塞等待
+ * 事件或下一次 VClockIdle。队列暂时为空不会让虚拟时间前进。
+ * tickMs 为0表示当前状态不需要滴答，此时一直阻塞等待事件，不会产生超时
+ * 
+ * @param me 指向时钟对象的指针
+ * @param queue 事件队列
+ * @param tickMs 滴答间隔（毫秒），0 表示不订阅滴答
+ * @param isTimeout 输出参数，标识是否超时（产生滴答）
+ * @return 取出的元素指针，超时时返回NULL
+ */
+void *VClockDequeue(VClock *me, SyncQueue *queue, uint32_t tickMs, bool *isTimeout);
+
+/**
+ * @brief 声明生产者空闲，允许虚拟时间推进
+ * 
+ * 由场景驱动（生产者线程）在投递完当前事件、接下来 ms 毫秒内不再产生事件时调用。
+ * 空闲标记和事件走同一个队列，之前投递的事件都处理完后虚拟时间才开始推进。
+ * 真实时间模式下不做任何事
+ * 
+ * @param me 指向时钟对象的指针
+ * @param queue 运行循环使用的事件队列
+ * @param ms 空闲时长（毫秒）
+ * @return 0 成功，-1 队列已满（空闲时长推迟到下一个空闲标记被取走时生效）
+ */
+int VClockIdle(VClock *me, SyncQueue *queue, uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !VCLOCK_H
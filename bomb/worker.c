@@ -0,0 +1,428 @@
+/**
+ * @file worker.c
+ * @brief 可迁移状态机的工作线程池实现文件
+ *
+ * 实例在三种情况之一：停放在邮箱中（空闲）、在某个线程的就绪队列中、正在被所属线程处理，
+ * 因此每个就绪队列最多同时放下全部实例和一个停止标记，入队不会失败。
+ * 迁移时实例的邮箱保持未停放状态，直接放入目标线程的就绪队列，生产者投递的事件只入邮箱不通知，
+ * 目标线程取到邮箱后接着处理。
+ */
+
+#include "worker.h"
+#include "timespec_util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief 初始化线程池
+ *
+ * @param me 指向线程池的指针
+ * @param workerNum 工作线程数
+ * @param maxActors 最多实例数
+ * @return 0 成功，-1 参数非法或内存不足
+ */
+int WorkerPoolCtor(WorkerPool *me, uint32_t workerNum, uint32_t maxActors)
+{
+    memset(me, 0, sizeof(*me));
+    if (workerNum == 0 || maxActors == 0) {
+        return -1;
+    }
+    me->workers = (Worker *)calloc(workerNum, sizeof(Worker));
+    me->actors = (WorkerActor **)calloc(maxActors, sizeof(WorkerActor *));
+    me->load = (uint64_t *)calloc(workerNum, sizeof(uint64_t));
+    if (me->workers == NULL || me->actors == NULL || me->load == NULL) {
+        WorkerPoolDtor(me);
+        return -1;
+    }
+    me->workerNum = workerNum;
+    me->maxActors = maxActors;
+    for (uint32_t i = 0; i < workerNum; i++) {
+        Worker *w = &me->workers[i];
+        w->pool = me;
+        w->id = i;
+        // 所有实例都可能迁到同一个线程，再加一个停止标记
+        w->readyBuffer = (void **)calloc(maxActors + 1, sizeof(void *));
+        w->timers = (WorkerActor **)calloc(maxActors, sizeof(WorkerActor *));
+        if (w->readyBuffer == NULL || w->timers == NULL) {
+            WorkerPoolDtor(me);
+            return -1;
+        }
+        QueueCtor(&w->ready, w->readyBuffer, maxActors + 1);
+    }
+    return 0;
+}
+
+/**
+ * @brief 释放线程池
+ *
+ * @param me 指向线程池的指针
+ */
+void WorkerPoolDtor(WorkerPool *me)
+{
+    if (me->workers != NULL) {
+        for (uint32_t i = 0; i < me->workerNum; i++) {
+            free(me->workers[i].readyBuffer);
+            free(me->workers[i].timers);
+        }
+    }
+    free(me->workers);
+    free(me->actors);
+    free(me->load);
+    me->workers = NULL;
+    me->actors = NULL;
+    me->load = NULL;
+}
+
+/**
+ * @brief 注册实例
+ *
+ * @param me 指向线程池的指针
+ * @param a 实例
+ * @param fsm 状态机对象
+ * @param dispatch 事件分发函数
+ * @param tick 定时器处理函数
+ * @param worker 初始所属线程
+ * @return 0 成功，-1 实例数已满或线程编号非法
+ */
+int WorkerActorCtor(WorkerPool *me, WorkerActor *a, void *fsm, WorkerDispatch dispatch, WorkerTick tick,
+                    uint32_t worker)
+{
+    if (me->actorNum == me->maxActors || worker >= me->workerNum) {
+        return -1;
+    }
+    MailboxCtor(&a->mailbox, &me->workers[worker].ready);
+    a->fsm = fsm;
+    a->dispatch = dispatch;
+    a->tick = tick;
+    a->id = me->actorNum;
+    a->worker = worker;
+    a->target = WORKER_NONE;
+    a->timerQueued = 0;
+    a->timerSlot = -1;
+    a->periodMs = 0;
+    a->deadlineNs = 0;
+    a->events = 0;
+    a->lastEvents = 0;
+    a->rate = 0;
+    a->migrations = 0;
+    me->actors[me->actorNum++] = a;
+    return 0;
+}
+
+/**
+ * @brief 启动或停止实例的周期定时器
+ *
+ * @param a 实例
+ * @param periodMs 周期（毫秒），0 表示停止
+ */
+void WorkerActorSetTimer(WorkerActor *a, uint32_t periodMs)
+{
+    a->periodMs = periodMs;
+    a->deadlineNs = periodMs != 0 ? TimespecNowNs() + (uint64_t)periodMs * 1000000 : 0;
+}
+
+/**
+ * @brief 投递事件
+ *
+ * @param a 实例
+ * @param node 事件中内嵌的邮箱节点
+ * @return 0 成功，1 就绪队列已满、通知推迟（就绪队列按实例数分配，不会发生）；事件总是已入邮箱，不要重投
+ */
+int WorkerPost(WorkerActor *a, MailboxNode *node)
+{
+    return MailboxPost(&a->mailbox, node);
+}
+
+/**
+ * @brief 请求把实例迁移到指定线程
+ *
+ * @param me 指向线程池的指针
+ * @param a 实例
+ * @param worker 目标线程
+ * @return 0 成功，-1 线程编号非法
+ */
+int WorkerMigrate(WorkerPool *me, WorkerActor *a, uint32_t worker)
+{
+    if (worker >= me->workerNum) {
+        return -1;
+    }
+    __atomic_store_n(&a->target, worker, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief 把实例从所属线程的定时器列表中摘下，最后一个元素补到空位
+ */
+static void WorkerUnlinkTimer(Worker *me, WorkerActor *a)
+{
+    if (a->timerSlot < 0) {
+        return;
+    }
+    WorkerActor *last = me->timers[--me->timerNum];
+    me->timers[a->timerSlot] = last;
+    last->timerSlot = a->timerSlot;
+    a->timerSlot = -1;
+}
+
+/**
+ * @brief 步骤结束或迁入后，按实例的定时器设置更新所属线程的定时器列表
+ */
+static void WorkerSyncTimer(Worker *me, WorkerActor *a)
+{
+    if (a->periodMs != 0 && a->timerSlot < 0) {
+        // 迁入的实例保留原来的到期时间
+        a->timerSlot = (int32_t)me->timerNum;
+        me->timers[me->timerNum++] = a;
+    } else if (a->periodMs == 0 && a->timerSlot >= 0) {
+        WorkerUnlinkTimer(me, a);
+    }
+}
+
+/**
+ * @brief 处理到期的定时器，向实例的邮箱投递滴答
+ *
+ * @param me 工作线程
+ * @return 最近的到期时间，0 表示没有定时器
+ */
+static uint64_t WorkerFireTimers(Worker *me)
+{
+    uint64_t now = TimespecNowNs();
+    uint64_t next = 0;
+    for (uint32_t i = 0; i < me->timerNum; i++) {
+        WorkerActor *a = me->timers[i];
+        if (a->deadlineNs <= now) {
+            // 上一次滴答还在邮箱中时合并，不重复投递
+            if (!a->timerQueued) {
+                a->timerQueued = 1;
+                MailboxPost(&a->mailbox, &a->timerNode);
+            }
+            uint64_t period = (uint64_t)a->periodMs * 1000000;
+            a->deadlineNs += period;
+            // 落后超过一个周期时不追赶，从现在重新计时
+            if (a->deadlineNs <= now) {
+                a->deadlineNs = now + period;
+            }
+        }
+        if (next == 0 || a->deadlineNs < next) {
+            next = a->deadlineNs;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief 在步骤边界检查迁移请求，需要迁移时把实例交给目标线程
+ *
+ * @param me 当前所属线程
+ * @param a 实例
+ * @return true 已迁出，当前线程不能再访问该实例
+ */
+static bool WorkerHandOff(Worker *me, WorkerActor *a)
+{
+    uint32_t target = __atomic_load_n(&a->target, __ATOMIC_ACQUIRE);
+    if (target == WORKER_NONE) {
+        return false;
+    }
+    __atomic_store_n(&a->target, WORKER_NONE, __ATOMIC_RELAXED);
+    if (target == me->id) {
+        return false;
+    }
+    Worker *to = &me->pool->workers[target];
+    WorkerUnlinkTimer(me, a);
+    a->migrations++;
+    me->migratedOut++;
+    __atomic_fetch_add(&to->migratedIn, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&a->worker, target, __ATOMIC_RELEASE);
+    // 邮箱保持未停放，直接交给目标线程，就绪队列的锁保证目标线程看到之前的所有修改
+    MailboxSetReadyList(&a->mailbox, &to->ready);
+    QueueEnqueue(&to->ready, &a->mailbox);
+    return true;
+}
+
+/**
+ * @brief 处理一个就绪的实例，最多 WORKER_BUDGET 个事件
+ */
+static void WorkerServe(Worker *me, WorkerActor *a)
+{
+    // 刚迁入的实例在这里接管定时器
+    WorkerSyncTimer(me, a);
+    if (WorkerHandOff(me, a)) {
+        return;
+    }
+
+    uint64_t start = TimespecNowNs();
+    uint32_t n = 0;
+    for (;;) {
+        MailboxNode *node = MailboxPop(&a->mailbox);
+        if (node == NULL) {
+            // 停放失败说明又有事件并且处理权还在本线程
+            if (MailboxPark(&a->mailbox)) {
+                break;
+            }
+            continue;
+        }
+        if (node == &a->timerNode) {
+            a->timerQueued = 0;
+            if (a->tick != NULL) {
+                a->tick(a->fsm);
+            }
+        } else {
+            a->dispatch(a->fsm, node);
+        }
+        n++;
+        __atomic_store_n(&a->events, a->events + 1, __ATOMIC_RELAXED);
+        // 步骤边界：更新定时器、检查迁移
+        WorkerSyncTimer(me, a);
+        if (WorkerHandOff(me, a)) {
+            break;
+        }
+        if (n == WORKER_BUDGET) {
+            // 让出给其他实例，邮箱保持未停放，重新排到本线程就绪队列末尾
+            QueueEnqueue(&me->ready, &a->mailbox);
+            break;
+        }
+    }
+    __atomic_fetch_add(&me->events, n, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&me->busyNs, TimespecNowNs() - start, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 工作线程主循环
+ */
+static void *WorkerRun(void *arg)
+{
+    Worker *me = (Worker *)arg;
+    WorkerPool *pool = me->pool;
+
+    // 接管启动前就设置了定时器的实例
+    for (uint32_t i = 0; i < pool->actorNum; i++) {
+        WorkerActor *a = pool->actors[i];
+        if (a->worker == me->id) {
+            WorkerSyncTimer(me, a);
+        }
+    }
+
+    for (;;) {
+        uint64_t next = WorkerFireTimers(me);
+        void *item;
+        if (next == 0) {
+            item = QueueDequeueForever(&me->ready);
+        } else {
+            struct timespec deadline = {(time_t)(next / 1000000000ULL), (long)(next % 1000000000ULL)};
+            bool isTimeout = false;
+            item = QueueDequeueUntil(&me->ready, &deadline, &isTimeout);
+            if (isTimeout) {
+                continue;
+            }
+        }
+        if (item == NULL) {
+            break;
+        }
+        WorkerServe(me, MAILBOX_CONTAINER(item, WorkerActor, mailbox));
+    }
+    return NULL;
+}
+
+/**
+ * @brief 启动所有工作线程
+ *
+ * @param me 指向线程池的指针
+ * @return 0 成功，-1 创建线程失败
+ */
+int WorkerPoolStart(WorkerPool *me)
+{
+    for (uint32_t i = 0; i < me->workerNum; i++) {
+        if (pthread_create(&me->workers[i].thread, NULL, WorkerRun, &me->workers[i]) != 0) {
+            // 已经启动的线程停止后返回
+            for (uint32_t j = 0; j < i; j++) {
+                QueueEnqueue(&me->workers[j].ready, NULL);
+                pthread_join(me->workers[j].thread, NULL);
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 停止并等待所有工作线程
+ *
+ * @param me 指向线程池的指针
+ */
+void WorkerPoolStop(WorkerPool *me)
+{
+    for (uint32_t i = 0; i < me->workerNum; i++) {
+        QueueEnqueue(&me->workers[i].ready, NULL);
+    }
+    for (uint32_t i = 0; i < me->workerNum; i++) {
+        pthread_join(me->workers[i].thread, NULL);
+    }
+}
+
+/**
+ * @brief 按上一次调用以来的事件数均衡负载
+ *
+ * @param me 指向线程池的指针
+ * @param thresholdPct 触发迁移的负载差（百分比）
+ * @return 本次发起的迁移数
+ */
+uint32_t WorkerPoolBalance(WorkerPool *me, uint32_t thresholdPct)
+{
+    // 统计周期内每个实例的事件数，计入迁移完成后的所属线程
+    memset(me->load, 0, me->workerNum * sizeof(uint64_t));
+    for (uint32_t i = 0; i < me->actorNum; i++) {
+        WorkerActor *a = me->actors[i];
+        uint64_t events = __atomic_load_n(&a->events, __ATOMIC_RELAXED);
+        a->rate = events - a->lastEvents;
+        a->lastEvents = events;
+        uint32_t owner = __atomic_load_n(&a->target, __ATOMIC_ACQUIRE);
+        if (owner == WORKER_NONE) {
+            owner = __atomic_load_n(&a->worker, __ATOMIC_ACQUIRE);
+        }
+        me->load[owner] += a->rate;
+    }
+
+    uint32_t moves = 0;
+    for (uint32_t round = 0; round < me->workerNum; round++) {
+        uint32_t hot = 0;
+        uint32_t cold = 0;
+        for (uint32_t w = 1; w < me->workerNum; w++) {
+            if (me->load[w] > me->load[hot]) {
+                hot = w;
+            }
+            if (me->load[w] < me->load[cold]) {
+                cold = w;
+            }
+        }
+        uint64_t gap = me->load[hot] - me->load[cold];
+        if (gap == 0 || gap * 100 <= me->load[hot] * thresholdPct) {
+            break;
+        }
+
+        // 迁走事件数为 r 的实例后负载差变为 |gap - 2r|，选使它最小的实例，只剩一个热点实例时不迁移
+        WorkerActor *best = NULL;
+        uint64_t bestDiff = gap;
+        for (uint32_t i = 0; i < me->actorNum; i++) {
+            WorkerActor *a = me->actors[i];
+            if (a->rate == 0 || a->rate >= gap || __atomic_load_n(&a->target, __ATOMIC_ACQUIRE) != WORKER_NONE ||
+                __atomic_load_n(&a->worker, __ATOMIC_ACQUIRE) != hot) {
+                continue;
+            }
+            uint64_t diff = gap > 2 * a->rate ? gap - 2 * a->rate : 2 * a->rate - gap;
+            if (diff < bestDiff) {
+                best = a;
+                bestDiff = diff;
+            }
+        }
+        if (best == NULL) {
+            break;
+        }
+        WorkerMigrate(me, best, cold);
+        me->load[hot] -= best->rate;
+        me->load[cold] += best->rate;
+        me->migrations++;
+        moves++;
+    }
+    return moves;
+}
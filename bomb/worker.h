@@ -0,0 +1,193 @@
+/**
+ * @file worker.h
+ * @brief 可迁移状态机的工作线程池头文件
+ *
+ * 每个状态机实例（WorkerActor）内嵌一个邮箱和一个周期定时器，任意时刻只属于一个工作线程。
+ * 工作线程从自己的就绪队列取出邮箱，处理其中的事件（每个事件一个运行至完成步骤），
+ * 并为自己名下的实例维护定时器，到期时向实例的邮箱投递滴答。
+ *
+ * 迁移只发生在两个步骤之间：所属线程发现实例的目标线程被设置后，把定时器从自己的列表中摘下，
+ * 把邮箱改挂到目标线程的就绪队列并交给目标线程；还没处理的事件和已经投递的滴答都留在邮箱里一起迁移，
+ * 定时器保留原来的到期时间，由目标线程在第一次处理时接管。邮箱是先进先出的，
+ * 任意时刻只有一个线程处理它，因此迁移前后同一个实例的事件顺序不变。
+ *
+ * 均衡器按统计周期内每个实例处理的事件数计算各线程的负载，把最忙线程上的实例迁到最闲的线程，
+ * 选择迁移后两者负载最接近的实例。
+ */
+
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "mailbox.h"
+#include "sync_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define WORKER_NONE UINT32_MAX  ///< 没有迁移目标
+#define WORKER_BUDGET 32        ///< 每次取到实例后最多处理的事件数，超过后让出给其他实例
+
+/**
+ * @brief 事件分发函数，fsm 为状态机对象，node 为事件中内嵌的邮箱节点
+ */
+typedef void (*WorkerDispatch)(void *fsm, MailboxNode *node);
+
+/**
+ * @brief 定时器到期时的处理函数
+ */
+typedef void (*WorkerTick)(void *fsm);
+
+/**
+ * @brief 可迁移的状态机实例
+ */
+typedef struct WorkerActorTag {
+    Mailbox mailbox;            ///< 邮箱，就绪队列中放的是它的指针
+    void *fsm;                  ///< 状态机对象
+    WorkerDispatch dispatch;    ///< 事件分发函数
+    WorkerTick tick;            ///< 定时器处理函数，可以为 NULL
+    uint32_t id;                ///< 在线程池中的编号
+    uint32_t worker;            ///< 所属线程（原子访问）
+    uint32_t target;            ///< 迁移目标线程，WORKER_NONE 表示不迁移（原子访问）
+    MailboxNode timerNode;      ///< 滴答事件节点
+    uint8_t timerQueued;        ///< 滴答已投递还未处理，期间到期的滴答合并
+    int32_t timerSlot;          ///< 在所属线程定时器列表中的下标，-1 表示不在列表中
+    uint32_t periodMs;          ///< 定时器周期（毫秒），0 表示未启动
+    uint64_t deadlineNs;        ///< 下一次到期时间（CLOCK_MONOTONIC）
+    uint64_t events;            ///< 已处理的事件数（原子访问）
+    uint64_t lastEvents;        ///< 上一次均衡时的事件数，只由均衡器访问
+    uint64_t rate;              ///< 上一个统计周期的事件数，只由均衡器访问
+    uint32_t migrations;        ///< 迁移次数
+} WorkerActor;
+
+struct WorkerPoolTag;
+
+/**
+ * @brief 工作线程
+ */
+typedef struct WorkerTag {
+    struct WorkerPoolTag *pool; ///< 所属线程池
+    uint32_t id;                ///< 编号
+    SyncQueue ready;            ///< 就绪队列，元素为邮箱指针，NULL 表示停止
+    void **readyBuffer;         ///< 就绪队列缓冲区，容量为实例数加一
+    WorkerActor **timers;       ///< 定时器已启动的实例，只由本线程访问
+    uint32_t timerNum;          ///< 定时器列表长度
+    pthread_t thread;           ///< 线程
+    uint64_t events;            ///< 已处理的事件数（原子访问）
+    uint64_t busyNs;            ///< 处理事件的时间（原子访问）
+    uint32_t migratedIn;        ///< 迁入的实例数（原子访问）
+    uint32_t migratedOut;       ///< 迁出的实例数
+} Worker;
+
+/**
+ * @brief 工作线程池
+ */
+typedef struct WorkerPoolTag {
+    Worker *workers;            ///< 工作线程
+    uint32_t workerNum;         ///< 工作线程数
+    WorkerActor **actors;       ///< 已注册的实例
+    uint32_t actorNum;          ///< 已注册的实例数
+    uint32_t maxActors;         ///< 最多实例数
+    uint64_t *load;             ///< 均衡器使用的各线程负载
+    uint32_t migrations;        ///< 均衡器发起的迁移次数
+} WorkerPool;
+
+/**
+ * @brief 初始化线程池，不启动线程
+ *
+ * @param me 指向线程池的指针
+ * @param workerNum 工作线程数
+ * @param maxActors 最多实例数，决定就绪队列和定时器列表的容量
+ * @return 0 成功，-1 参数非法或内存不足
+ */
+int WorkerPoolCtor(WorkerPool *me, uint32_t workerNum, uint32_t maxActors);
+
+/**
+ * @brief 释放线程池，必须先调用 WorkerPoolStop
+ *
+ * @param me 指向线程池的指针
+ */
+void WorkerPoolDtor(WorkerPool *me);
+
+/**
+ * @brief 注册实例，必须在 WorkerPoolStart 之前调用
+ *
+ * 状态机应当已经初始化，之后的事件都通过 WorkerPost 投递
+ *
+ * @param me 指向线程池的指针
+ * @param a 实例
+ * @param fsm 状态机对象
+ * @param dispatch 事件分发函数
+ * @param tick 定时器处理函数，不使用定时器时可以为 NULL
+ * @param worker 初始所属线程
+ * @return 0 成功，-1 实例数已满或线程编号非法
+ */
+int WorkerActorCtor(WorkerPool *me, WorkerActor *a, void *fsm, WorkerDispatch dispatch, WorkerTick tick,
+                    uint32_t worker);
+
+/**
+ * @brief 启动或停止实例的周期定时器
+ *
+ * 只能在实例的处理函数中（或 WorkerPoolStart 之前）调用，所属线程在步骤结束后更新定时器列表
+ *
+ * @param a 实例
+ * @param periodMs 周期（毫秒），0 表示停止
+ */
+void WorkerActorSetTimer(WorkerActor *a, uint32_t periodMs);
+
+/**
+ * @brief 投递事件（任意线程）
+ *
+ * @param a 实例
+ * @param node 事件中内嵌的邮箱节点
+ * @return 0 成功，1 就绪队列已满、通知推迟（就绪队列按实例数分配，不会发生）；事件总是已入邮箱，不要重投
+ */
+int WorkerPost(WorkerActor *a, MailboxNode *node);
+
+/**
+ * @brief 请求把实例迁移到指定线程（任意线程）
+ *
+ * 所属线程在实例的下一个步骤边界完成迁移；实例没有事件也没有定时器时迁移推迟到下一次投递
+ *
+ * @param me 指向线程池的指针
+ * @param a 实例
+ * @param worker 目标线程
+ * @return 0 成功，-1 线程编号非法
+ */
+int WorkerMigrate(WorkerPool *me, WorkerActor *a, uint32_t worker);
+
+/**
+ * @brief 启动所有工作线程
+ *
+ * @param me 指向线程池的指针
+ * @return 0 成功，-1 创建线程失败
+ */
+int WorkerPoolStart(WorkerPool *me);
+
+/**
+ * @brief 停止并等待所有工作线程，邮箱中还未处理的事件保留
+ *
+ * @param me 指向线程池的指针
+ */
+void WorkerPoolStop(WorkerPool *me);
+
+/**
+ * @brief 按上一次调用以来的事件数均衡负载（任意一个线程周期性调用）
+ *
+ * 最忙线程的负载比最闲线程高出 thresholdPct 百分比以上时，选出迁移后两者负载最接近的实例迁走，
+ * 重复直到不再需要迁移或每个线程都迁移过一次
+ *
+ * @param me 指向线程池的指针
+ * @param thresholdPct 触发迁移的负载差（百分比）
+ * @return 本次发起的迁移数
+ */
+uint32_t WorkerPoolBalance(WorkerPool *me, uint32_t thresholdPct);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // !WORKER_H